@@ -1,6 +1,10 @@
 #include "AudioUtils.h"
+#include "Kernels.h"
+#include <juce_dsp/juce_dsp.h>
 #include <cmath>
 #include <algorithm>
+#include <complex>
+#include <limits>
 
 juce::AudioBuffer<float> generateSine(double freq, double amp, double duration, double sampleRate)
 {
@@ -25,21 +29,132 @@ juce::AudioBuffer<float> crossfade(const juce::AudioBuffer<float>& a, const juce
     int n = static_cast<int>(duration * sampleRate);
     n = std::min({ n, a.getNumSamples(), b.getNumSamples() });
     juce::AudioBuffer<float> result(2, n);
-
     for (int ch = 0; ch < 2; ++ch)
+        result.copyFrom(ch, 0, a, ch, 0, n);
+
+    CrossfadeTable table(parseCrossfadeCurve(curve));
+    crossfadeInPlace(result, 0, b, 0, n, table);
+    return result;
+}
+
+CrossfadeCurve parseCrossfadeCurve(const juce::String& name)
+{
+    if (name == "equal_power")
+        return CrossfadeCurve::equalPower;
+    if (name == "s_curve")
+        return CrossfadeCurve::sCurve;
+    if (name == "constant_power")
+        return CrossfadeCurve::constantPower;
+    return CrossfadeCurve::linear;
+}
+
+void CrossfadeTable::prepare(int numSamples)
+{
+    if (numSamples == size())
+        return;
+
+    fadeInGains.resize(static_cast<size_t>(std::max(0, numSamples)));
+    fadeOutGains.resize(fadeInGains.size());
+    for (int i = 0; i < numSamples; ++i)
     {
-        const float* pa = a.getReadPointer(ch);
-        const float* pb = b.getReadPointer(ch);
-        float* pr = result.getWritePointer(ch);
-        for (int i = 0; i < n; ++i)
+        double alpha = static_cast<double>(i) / static_cast<double>(numSamples);
+        double in = alpha;
+        double out = 1.0 - alpha;
+        if (curve == CrossfadeCurve::equalPower)
         {
-            double alpha = static_cast<double>(i) / static_cast<double>(n);
-            if (curve == "equal_power")
-                alpha = std::sin(alpha * juce::MathConstants<double>::halfPi);
-            pr[i] = pa[i] * (1.0 - alpha) + pb[i] * alpha;
+            in = std::sin(alpha * juce::MathConstants<double>::halfPi);
         }
+        else if (curve == CrossfadeCurve::constantPower)
+        {
+            in = std::sin(alpha * juce::MathConstants<double>::halfPi);
+            out = std::cos(alpha * juce::MathConstants<double>::halfPi);
+        }
+        else if (curve == CrossfadeCurve::sCurve)
+        {
+            in = alpha * alpha * (3.0 - 2.0 * alpha);
+            out = 1.0 - in;
+        }
+        fadeInGains[static_cast<size_t>(i)] = static_cast<float>(in);
+        fadeOutGains[static_cast<size_t>(i)] = static_cast<float>(out);
     }
-    return result;
+}
+
+void crossfadeInPlace(juce::AudioBuffer<float>& dest, int destStart,
+                      const juce::AudioBuffer<float>& incoming, int incomingStart,
+                      int numSamples, CrossfadeTable& table)
+{
+    numSamples = std::min({ numSamples, dest.getNumSamples() - destStart,
+                            incoming.getNumSamples() - incomingStart });
+    if (numSamples <= 0)
+        return;
+
+    table.prepare(numSamples);
+    for (int ch = 0; ch < dest.getNumChannels(); ++ch)
+    {
+        float* d = dest.getWritePointer(ch, destStart);
+        const float* src = incoming.getReadPointer(ch % incoming.getNumChannels(), incomingStart);
+        getKernels().crossfade(d, src, table.fadeOut(), table.fadeIn(), numSamples);
+    }
+}
+
+int findSpliceOffset(const juce::AudioBuffer<float>& outgoing, int outgoingStart,
+                     const juce::AudioBuffer<float>& incoming, int length, int maxOffset)
+{
+    // Correlating more than a few thousand samples buys no extra accuracy.
+    length = std::min({ length, 8192, outgoing.getNumSamples() - outgoingStart });
+    maxOffset = std::min({ maxOffset, 1 << 16, incoming.getNumSamples() - length });
+    if (length <= 0 || maxOffset <= 0)
+        return 0;
+
+    const int searchLength = length + maxOffset;
+    int order = 1;
+    while ((1 << order) < searchLength + length)
+        ++order;
+    const int fftSize = 1 << order;
+
+    // Mono sums of the two signals, zero padded.
+    std::vector<std::complex<float>> a(static_cast<size_t>(fftSize)), b(a.size());
+    std::vector<std::complex<float>> fa(a.size()), fb(a.size());
+    auto monoSample = [](const juce::AudioBuffer<float>& buf, int index) {
+        float sum = 0.0f;
+        for (int ch = 0; ch < buf.getNumChannels(); ++ch)
+            sum += buf.getSample(ch, index);
+        return sum;
+    };
+    for (int i = 0; i < length; ++i)
+        a[static_cast<size_t>(i)] = monoSample(outgoing, outgoingStart + i);
+    for (int i = 0; i < searchLength; ++i)
+        b[static_cast<size_t>(i)] = monoSample(incoming, i);
+
+    juce::dsp::FFT fft(order);
+    fft.perform(a.data(), fa.data(), false);
+    fft.perform(b.data(), fb.data(), false);
+    for (size_t k = 0; k < fa.size(); ++k)
+        fb[k] *= std::conj(fa[k]);
+    fft.perform(fb.data(), b.data(), true); // b[k] = sum_i a[i] * b[i + k]
+
+    // Normalise by the energy of each incoming window so loud sections do
+    // not win on level alone.
+    std::vector<double> energy(static_cast<size_t>(searchLength) + 1, 0.0);
+    for (int i = 0; i < searchLength; ++i)
+    {
+        double v = monoSample(incoming, i);
+        energy[static_cast<size_t>(i) + 1] = energy[static_cast<size_t>(i)] + v * v;
+    }
+
+    int best = 0;
+    double bestScore = -std::numeric_limits<double>::infinity();
+    for (int k = 0; k <= maxOffset; ++k)
+    {
+        double windowEnergy = energy[static_cast<size_t>(k + length)] - energy[static_cast<size_t>(k)];
+        double score = b[static_cast<size_t>(k)].real() / std::sqrt(windowEnergy + 1.0e-12);
+        if (score > bestScore)
+        {
+            bestScore = score;
+            best = k;
+        }
+    }
+    return best;
 }
 
 std::pair<float, float> getPanGains(double pan)
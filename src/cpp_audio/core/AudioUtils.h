@@ -10,6 +10,47 @@ juce::AudioBuffer<float> crossfade(const juce::AudioBuffer<float>& a,
                                    double sampleRate,
                                    juce::String curve);
 
+/** equalPower fades in along a quarter sine and out linearly, as it always
+    has; constantPower fades out along the matching cosine, so the summed
+    power of two uncorrelated signals stays level. */
+enum class CrossfadeCurve { linear, equalPower, sCurve, constantPower };
+
+/** Maps a "crossfade_curve" setting ("linear", "equal_power", "s_curve",
+    "constant_power") to a curve; unknown names fall back to linear. */
+CrossfadeCurve parseCrossfadeCurve(const juce::String& name);
+
+/** Fade-in and fade-out gains for one crossfade length, computed once and
+    reused while the length stays the same. */
+class CrossfadeTable
+{
+public:
+    explicit CrossfadeTable(CrossfadeCurve c = CrossfadeCurve::linear) : curve(c) {}
+
+    /** Recomputes the gains if @p numSamples differs from the current size. */
+    void prepare(int numSamples);
+
+    int size() const noexcept { return static_cast<int>(fadeInGains.size()); }
+    const float* fadeIn() const noexcept { return fadeInGains.data(); }
+    const float* fadeOut() const noexcept { return fadeOutGains.data(); }
+
+private:
+    CrossfadeCurve curve;
+    std::vector<float> fadeInGains, fadeOutGains;
+};
+
+/** Crossfades @p numSamples of @p incoming (from @p incomingStart) into
+    @p dest (from @p destStart), writing the result over @p dest. */
+void crossfadeInPlace(juce::AudioBuffer<float>& dest, int destStart,
+                      const juce::AudioBuffer<float>& incoming, int incomingStart,
+                      int numSamples, CrossfadeTable& table);
+
+/** Finds the offset in [0, maxOffset] into @p incoming at which it best
+    lines up with @p outgoing from @p outgoingStart, by normalised FFT
+    cross-correlation over (up to) @p length samples. Starting the incoming
+    audio at that offset puts the two in phase across the crossfade. */
+int findSpliceOffset(const juce::AudioBuffer<float>& outgoing, int outgoingStart,
+                     const juce::AudioBuffer<float>& incoming, int length, int maxOffset);
+
 std::pair<float, float> getPanGains(double pan);
 std::vector<double> calculateTransitionAlpha(double totalDuration,
                                              double sampleRate,
@@ -0,0 +1,71 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <cmath>
+
+/** The per-sample oscillator of binauralBeat(): a carrier per ear, a beat
+    apart, with vibrato, amplitude modulation and a phase wobble between the
+    ears. binauralBeat(), its transition variant and LiveBinauralVoice all
+    render through it and differ only in where the settings and the LFO
+    angles come from, so the live preview cannot drift from the render.
+
+    The carriers are running phases, advanced before each sample is taken
+    and kept in [0, 2 pi). The LFOs are passed in as angles, so the offline
+    synths can take them from the sample time and the live voice can keep
+    them as running phases.
+*/
+struct BinauralOscillator
+{
+    /** The settings at one sample. */
+    struct Settings
+    {
+        double ampL = 0.5, ampR = 0.5;
+        double baseFreq = 200.0, beatFreq = 4.0;
+        double ampOscDepthL = 0.0, ampOscDepthR = 0.0;
+        double freqOscRangeL = 0.0, freqOscRangeR = 0.0;
+        double phaseOscRange = 0.0;
+        bool forceMono = false;
+    };
+
+    /** LFO angles, in radians, at one sample, phase offsets included. */
+    struct Lfos
+    {
+        double freqOscL = 0.0, freqOscR = 0.0;
+        double ampOscL = 0.0, ampOscR = 0.0;
+        double phaseOsc = 0.0;
+    };
+
+    static double wrapPhase(double phase) noexcept
+    {
+        constexpr double twoPi = juce::MathConstants<double>::twoPi;
+        return (phase >= twoPi || phase < 0.0) ? phase - twoPi * std::floor(phase / twoPi) : phase;
+    }
+
+    /** Advances the carriers by @p dt seconds and writes the next sample. */
+    void process(const Settings& s, const Lfos& lfo, double dt, float& left, float& right) noexcept
+    {
+        constexpr double twoPi = juce::MathConstants<double>::twoPi;
+        double fL, fR;
+        if (s.forceMono || s.beatFreq == 0.0)
+        {
+            fL = fR = std::max(0.0, s.baseFreq);
+        }
+        else
+        {
+            fL = std::max(0.0, s.baseFreq - s.beatFreq * 0.5 + (s.freqOscRangeL * 0.5) * std::sin(lfo.freqOscL));
+            fR = std::max(0.0, s.baseFreq + s.beatFreq * 0.5 + (s.freqOscRangeR * 0.5) * std::sin(lfo.freqOscR));
+        }
+
+        carrierL = wrapPhase(carrierL + twoPi * fL * dt);
+        carrierR = wrapPhase(carrierR + twoPi * fR * dt);
+
+        double dphi = (s.phaseOscRange * 0.5) * std::sin(lfo.phaseOsc);
+        double envL = 1.0 - s.ampOscDepthL * (0.5 * (1.0 + std::sin(lfo.ampOscL)));
+        double envR = 1.0 - s.ampOscDepthR * (0.5 * (1.0 + std::sin(lfo.ampOscR)));
+
+        left  = static_cast<float>(std::sin(carrierL - dphi) * envL * s.ampL);
+        right = static_cast<float>(std::sin(carrierR + dphi) * envR * s.ampR);
+    }
+
+    double carrierL = 0.0, carrierR = 0.0;
+};
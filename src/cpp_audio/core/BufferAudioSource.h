@@ -1,5 +1,6 @@
 #pragma once
 #include <juce_audio_basics/juce_audio_basics.h>
+#include "RealtimeSafety.h"
 
 class BufferAudioSource : public juce::PositionableAudioSource
 {
@@ -21,6 +22,7 @@ public:
 
     void getNextAudioBlock(const juce::AudioSourceChannelInfo& info) override
     {
+        REALTIME_SECTION();
         if (buffer.getNumSamples() == 0)
         {
             info.clearActiveBufferRegion();
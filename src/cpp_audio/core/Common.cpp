@@ -1,4 +1,5 @@
 #include "Common.h"
+#include "Kernels.h"
 #ifndef _USE_MATH_DEFINES
 #define _USE_MATH_DEFINES
 #endif
@@ -42,6 +43,26 @@ std::vector<double> sineWaveVarying(const std::vector<double>& freqArray,
     return out;
 }
 
+namespace
+{
+/** Samples per rate implied by a time axis, as the envelope helpers take it. */
+double rateOf(const std::vector<double>& t)
+{
+    size_t N = t.size();
+    double duration = t.back() - t.front();
+    if (N > 1)
+        duration += (t[1]-t[0]);
+    return (duration > 0.0) ? static_cast<double>(N) / duration : 44100.0;
+}
+
+std::vector<double> render(LinearEnvelope env, size_t N)
+{
+    std::vector<double> out(N);
+    env.getNextBlock(out.data(), static_cast<int>(N));
+    return out;
+}
+}
+
 std::vector<double> adsrEnvelope(const std::vector<double>& t,
                                  double attack,
                                  double decay,
@@ -51,56 +72,7 @@ std::vector<double> adsrEnvelope(const std::vector<double>& t,
     size_t N = t.size();
     if (N <= 1)
         return std::vector<double>(N, 0.0);
-
-    double duration = t.back() - t.front();
-    if (N > 1)
-        duration += (t[1]-t[0]);
-    double sr = (duration > 0.0) ? static_cast<double>(N) / duration : 44100.0;
-
-    attack = std::max(0.0, attack);
-    decay = std::max(0.0, decay);
-    release = std::max(0.0, release);
-    sustainLevel = std::clamp(sustainLevel, 0.0, 1.0);
-
-    size_t attackSamples = static_cast<size_t>(attack * sr);
-    size_t decaySamples = static_cast<size_t>(decay * sr);
-    size_t releaseSamples = static_cast<size_t>(release * sr);
-
-    attackSamples = std::min(attackSamples, N);
-    decaySamples = std::min(decaySamples, N);
-    releaseSamples = std::min(releaseSamples, N);
-
-    size_t totalADSR = attackSamples + decaySamples + releaseSamples;
-    if (totalADSR > N && totalADSR > 0)
-    {
-        double scale = static_cast<double>(N) / static_cast<double>(totalADSR);
-        attackSamples = static_cast<size_t>(attackSamples * scale);
-        decaySamples = static_cast<size_t>(decaySamples * scale);
-        releaseSamples = N - attackSamples - decaySamples;
-    }
-
-    size_t sustainSamples = N - (attackSamples + decaySamples + releaseSamples);
-
-    std::vector<double> env;
-    env.reserve(N);
-
-    for (size_t i = 0; i < attackSamples; ++i)
-        env.push_back(static_cast<double>(i) / std::max<size_t>(1, attackSamples));
-    for (size_t i = 0; i < decaySamples; ++i)
-    {
-        double alpha = static_cast<double>(i) / std::max<size_t>(1, decaySamples);
-        env.push_back(1.0 + alpha * (sustainLevel - 1.0));
-    }
-    for (size_t i = 0; i < sustainSamples; ++i)
-        env.push_back(sustainLevel);
-    for (size_t i = 0; i < releaseSamples; ++i)
-    {
-        double alpha = static_cast<double>(i) / std::max<size_t>(1, releaseSamples);
-        env.push_back((1.0 - alpha) * sustainLevel);
-    }
-
-    env.resize(N, releaseSamples > 0 ? 0.0 : sustainLevel);
-    return env;
+    return render(LinearEnvelope::adsr(static_cast<int>(N), rateOf(t), attack, decay, sustainLevel, release), N);
 }
 
 std::vector<double> createLinearFadeEnvelope(double totalDuration,
@@ -114,28 +86,8 @@ std::vector<double> createLinearFadeEnvelope(double totalDuration,
     int fadeSamples  = std::min(static_cast<int>(fadeDuration * sampleRate), totalSamples);
     if (totalSamples <= 0)
         return {};
-
-    std::vector<double> env(totalSamples, 1.0);
-    if (fadeSamples <= 0)
-    {
-        std::fill(env.begin(), env.end(), fadeType == "in" ? endAmp : startAmp);
-        return env;
-    }
-
-    if (fadeType == "in")
-    {
-        for (int i = 0; i < fadeSamples; ++i)
-            env[i] = startAmp + (endAmp - startAmp) * (static_cast<double>(i) / static_cast<double>(fadeSamples));
-        std::fill(env.begin() + fadeSamples, env.end(), endAmp);
-    }
-    else
-    {
-        int sustain = totalSamples - fadeSamples;
-        std::fill(env.begin(), env.begin() + sustain, startAmp);
-        for (int i = 0; i < fadeSamples; ++i)
-            env[sustain + i] = startAmp + (endAmp - startAmp) * (static_cast<double>(i) / static_cast<double>(fadeSamples));
-    }
-    return env;
+    return render(LinearEnvelope::fade(totalSamples, fadeSamples, startAmp, endAmp, fadeType == "in"),
+                  static_cast<size_t>(totalSamples));
 }
 
 std::vector<double> linenEnvelope(const std::vector<double>& t,
@@ -145,41 +97,7 @@ std::vector<double> linenEnvelope(const std::vector<double>& t,
     size_t N = t.size();
     if (N <= 1)
         return std::vector<double>(N, 0.0);
-
-    double duration = t.back() - t.front();
-    if (N > 1)
-        duration += (t[1]-t[0]);
-    double sr = (duration > 0.0) ? static_cast<double>(N) / duration : 44100.0;
-
-    attack = std::max(0.0, attack);
-    release = std::max(0.0, release);
-
-    size_t attackSamples = static_cast<size_t>(attack * sr);
-    size_t releaseSamples = static_cast<size_t>(release * sr);
-    attackSamples = std::min(attackSamples, N);
-    releaseSamples = std::min(releaseSamples, N);
-
-    size_t totalAR = attackSamples + releaseSamples;
-    if (totalAR > N && totalAR > 0)
-    {
-        double scale = static_cast<double>(N) / static_cast<double>(totalAR);
-        attackSamples = static_cast<size_t>(attackSamples * scale);
-        releaseSamples = N - attackSamples;
-    }
-
-    size_t sustainSamples = N - (attackSamples + releaseSamples);
-    std::vector<double> env;
-    env.reserve(N);
-
-    for (size_t i = 0; i < attackSamples; ++i)
-        env.push_back(static_cast<double>(i) / std::max<size_t>(1, attackSamples));
-    for (size_t i = 0; i < sustainSamples; ++i)
-        env.push_back(1.0);
-    for (size_t i = 0; i < releaseSamples; ++i)
-        env.push_back(1.0 - static_cast<double>(i) / std::max<size_t>(1, releaseSamples));
-
-    env.resize(N, releaseSamples > 0 ? 0.0 : 1.0);
-    return env;
+    return render(LinearEnvelope::linen(static_cast<int>(N), rateOf(t), attack, release), N);
 }
 
 std::pair<std::vector<double>, std::vector<double>> pan2(const std::vector<double>& signal,
@@ -200,60 +118,24 @@ std::pair<std::vector<double>, std::vector<double>> pan2(const std::vector<doubl
     return {left, right};
 }
 
-static std::vector<double> applyIIR(const std::vector<double>& data,
-                                    double center,
-                                    double Q,
-                                    double fs,
-                                    bool bandpass)
+namespace
 {
-    if (data.empty() || fs <= 0.0)
-        return data;
-
-    std::vector<double> out(data.size(), 0.0);
-
-    double omega = 2.0 * M_PI * center / fs;
-    double alpha = std::sin(omega) / (2.0 * Q);
-    double cosw = std::cos(omega);
-
-    double b0, b1, b2, a0, a1, a2;
-    if (bandpass)
-    {
-        b0 = alpha;
-        b1 = 0.0;
-        b2 = -alpha;
-    }
-    else
-    {
-        b0 = 1.0;
-        b1 = -2.0 * cosw;
-        b2 = 1.0;
-    }
-    a0 = 1.0 + alpha;
-    a1 = -2.0 * cosw;
-    a2 = 1.0 - alpha;
-
-    b0 /= a0; b1 /= a0; b2 /= a0; a1 /= a0; a2 /= a0;
-
-    double x1 = 0.0, x2 = 0.0;
-    double y1 = 0.0, y2 = 0.0;
-    for (size_t i = 0; i < data.size(); ++i)
-    {
-        double x0 = data[i];
-        double y0 = b0*x0 + b1*x1 + b2*x2 - a1*y1 - a2*y2;
-        out[i] = y0;
-        x2 = x1; x1 = x0; y2 = y1; y1 = y0;
-    }
+std::vector<double> filtered(const std::vector<double>& data, const Biquad::Coefficients& c)
+{
+    std::vector<double> out = data;
+    Biquad(c).process(out.data(), static_cast<int>(out.size()));
     return out;
 }
+}
 
 std::vector<double> bandpassFilter(const std::vector<double>& data,
                                    double center,
                                    double Q,
                                    double fs)
 {
-    center = std::max(center, 1e-6);
-    Q = std::max(Q, 0.1);
-    return applyIIR(data, center, Q, fs, true);
+    if (data.empty() || fs <= 0.0)
+        return data;
+    return filtered(data, Biquad::bandPass(std::max(center, 1e-6), std::max(Q, 0.1), fs));
 }
 
 std::vector<double> bandrejectFilter(const std::vector<double>& data,
@@ -261,9 +143,9 @@ std::vector<double> bandrejectFilter(const std::vector<double>& data,
                                      double Q,
                                      double fs)
 {
-    center = std::max(center, 1e-6);
-    Q = std::max(Q, 0.1);
-    return applyIIR(data, center, Q, fs, false);
+    if (data.empty() || fs <= 0.0)
+        return data;
+    return filtered(data, Biquad::bandReject(std::max(center, 1e-6), std::max(Q, 0.1), fs));
 }
 
 std::vector<double> lowpassFilter(const std::vector<double>& data,
@@ -272,32 +154,7 @@ std::vector<double> lowpassFilter(const std::vector<double>& data,
 {
     if (data.empty() || fs <= 0.0)
         return data;
-
-    double omega = 2.0 * M_PI * cutoff / fs;
-    double cosw = std::cos(omega);
-    double sinw = std::sin(omega);
-    double alpha = sinw / std::sqrt(2.0);
-
-    double b0 = (1.0 - cosw)/2.0;
-    double b1 = 1.0 - cosw;
-    double b2 = (1.0 - cosw)/2.0;
-    double a0 = 1.0 + alpha;
-    double a1 = -2.0*cosw;
-    double a2 = 1.0 - alpha;
-
-    b0 /= a0; b1 /= a0; b2 /= a0; a1 /= a0; a2 /= a0;
-
-    std::vector<double> out(data.size(), 0.0);
-    double x1 = 0.0, x2 = 0.0;
-    double y1 = 0.0, y2 = 0.0;
-    for (size_t i = 0; i < data.size(); ++i)
-    {
-        double x0 = data[i];
-        double y0 = b0*x0 + b1*x1 + b2*x2 - a1*y1 - a2*y2;
-        out[i] = y0;
-        x2 = x1; x1 = x0; y2 = y1; y1 = y0;
-    }
-    return out;
+    return filtered(data, Biquad::lowPass(cutoff, fs));
 }
 
 std::vector<double> pinkNoise(int n)
@@ -389,11 +246,280 @@ std::vector<double> applyFilters(const std::vector<double>& signalSegment,
     double hpCutoff = 30.0;
     double lpCutoff = fs * 0.5 * 0.9;
 
-    std::vector<double> result = signalSegment;
+    BiquadCascade filters;
     if (hpCutoff > 0.0 && hpCutoff < fs * 0.5)
-        result = bandpassFilter(result, hpCutoff, hpCutoff / 2.0, fs); // simple high-pass using bandpass implementation
+        filters.add(Biquad::highPass(hpCutoff, fs));
     if (lpCutoff > 0.0 && lpCutoff < fs * 0.5)
-        result = lowpassFilter(result, lpCutoff, fs);
+        filters.add(Biquad::lowPass(lpCutoff, fs));
+
+    std::vector<double> result = signalSegment;
+    filters.process(result.data(), static_cast<int>(result.size()));
     return result;
 }
 
+//==============================================================================
+namespace
+{
+// State below this is flushed to zero: far under anything audible, far
+// above the denormal range.
+constexpr double snapThreshold = 1e-15;
+// Samples between flushes when a long block is processed.
+constexpr int snapInterval = 512;
+
+void snap(double& v) noexcept
+{
+    if (std::abs(v) < snapThreshold)
+        v = 0.0;
+}
+
+double normalisedOmega(double freq, double fs)
+{
+    return 2.0 * M_PI * freq / fs;
+}
+
+Biquad::Coefficients normalise(double b0, double b1, double b2, double a0, double a1, double a2)
+{
+    return { b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0 };
+}
+}
+
+Biquad::Coefficients Biquad::lowPass(double cutoff, double fs, double Q)
+{
+    double omega = normalisedOmega(cutoff, fs);
+    double cosw = std::cos(omega);
+    double alpha = std::sin(omega) / (2.0 * Q);
+    return normalise((1.0 - cosw) / 2.0, 1.0 - cosw, (1.0 - cosw) / 2.0,
+                     1.0 + alpha, -2.0 * cosw, 1.0 - alpha);
+}
+
+Biquad::Coefficients Biquad::highPass(double cutoff, double fs, double Q)
+{
+    double omega = normalisedOmega(cutoff, fs);
+    double cosw = std::cos(omega);
+    double alpha = std::sin(omega) / (2.0 * Q);
+    return normalise((1.0 + cosw) / 2.0, -(1.0 + cosw), (1.0 + cosw) / 2.0,
+                     1.0 + alpha, -2.0 * cosw, 1.0 - alpha);
+}
+
+Biquad::Coefficients Biquad::bandPass(double center, double Q, double fs)
+{
+    double omega = normalisedOmega(center, fs);
+    double cosw = std::cos(omega);
+    double alpha = std::sin(omega) / (2.0 * Q);
+    return normalise(alpha, 0.0, -alpha, 1.0 + alpha, -2.0 * cosw, 1.0 - alpha);
+}
+
+Biquad::Coefficients Biquad::bandReject(double center, double Q, double fs)
+{
+    double omega = normalisedOmega(center, fs);
+    double cosw = std::cos(omega);
+    double alpha = std::sin(omega) / (2.0 * Q);
+    return normalise(1.0, -2.0 * cosw, 1.0, 1.0 + alpha, -2.0 * cosw, 1.0 - alpha);
+}
+
+void Biquad::process(double* data, int numSamples) noexcept
+{
+    for (int start = 0; start < numSamples; start += snapInterval)
+    {
+        int end = std::min(numSamples, start + snapInterval);
+        for (int i = start; i < end; ++i)
+            data[i] = processSample(data[i]);
+        snapToZero();
+    }
+}
+
+// The float path runs on the dispatched kernel.
+void Biquad::process(float* data, int numSamples) noexcept
+{
+    const double c[5] = { coeffs.b0, coeffs.b1, coeffs.b2, coeffs.a1, coeffs.a2 };
+    double state[4] = { x1, x2, y1, y2 };
+    const auto& kernels = getKernels();
+    for (int start = 0; start < numSamples; start += snapInterval)
+    {
+        kernels.biquad(data + start, std::min(snapInterval, numSamples - start), c, state);
+        for (double& s : state)
+            snap(s);
+    }
+    x1 = state[0]; x2 = state[1]; y1 = state[2]; y2 = state[3];
+}
+
+void Biquad::snapToZero() noexcept
+{
+    snap(x1); snap(x2);
+    snap(y1); snap(y2);
+}
+
+void BiquadCascade::reset() noexcept
+{
+    for (auto& stage : stages)
+        stage.reset();
+}
+
+void BiquadCascade::process(double* data, int numSamples) noexcept
+{
+    for (auto& stage : stages)
+        stage.process(data, numSamples);
+}
+
+void BiquadCascade::process(float* data, int numSamples) noexcept
+{
+    for (auto& stage : stages)
+        stage.process(data, numSamples);
+}
+
+void OnePole::setCutoff(double cutoff, double fs) noexcept
+{
+    pole = std::exp(-normalisedOmega(std::max(0.0, cutoff), fs));
+}
+
+void OnePole::process(double* data, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+        data[i] = processSample(data[i]);
+    snap(y1);
+}
+
+void OnePole::process(float* data, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+        data[i] = static_cast<float>(processSample(data[i]));
+    snap(y1);
+}
+
+DcBlocker::DcBlocker(double fs, double cutoff)
+    : pole(std::exp(-normalisedOmega(std::max(0.0, cutoff), fs)))
+{
+}
+
+void DcBlocker::process(double* data, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+        data[i] = processSample(data[i]);
+    snap(x1);
+    snap(y1);
+}
+
+void DcBlocker::process(float* data, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+        data[i] = static_cast<float>(processSample(data[i]));
+    snap(x1);
+    snap(y1);
+}
+
+//==============================================================================
+LinearEnvelope LinearEnvelope::adsr(int N, double sr, double attack, double decay,
+                                    double sustainLevel, double release)
+{
+    LinearEnvelope env;
+    if (N <= 1)
+        return env;
+
+    attack = std::max(0.0, attack);
+    decay = std::max(0.0, decay);
+    release = std::max(0.0, release);
+    sustainLevel = std::clamp(sustainLevel, 0.0, 1.0);
+
+    int attackSamples = std::min(static_cast<int>(attack * sr), N);
+    int decaySamples = std::min(static_cast<int>(decay * sr), N);
+    int releaseSamples = std::min(static_cast<int>(release * sr), N);
+
+    int totalADSR = attackSamples + decaySamples + releaseSamples;
+    if (totalADSR > N && totalADSR > 0)
+    {
+        double scale = static_cast<double>(N) / static_cast<double>(totalADSR);
+        attackSamples = static_cast<int>(attackSamples * scale);
+        decaySamples = static_cast<int>(decaySamples * scale);
+        releaseSamples = N - attackSamples - decaySamples;
+    }
+    int sustainSamples = N - (attackSamples + decaySamples + releaseSamples);
+
+    env.addSegment(attackSamples, 0.0, 1.0);
+    env.addSegment(decaySamples, 1.0, sustainLevel);
+    env.addSegment(sustainSamples, sustainLevel, sustainLevel);
+    env.addSegment(releaseSamples, sustainLevel, 0.0);
+    env.finalValue = releaseSamples > 0 ? 0.0 : sustainLevel;
+    return env;
+}
+
+LinearEnvelope LinearEnvelope::linen(int N, double sr, double attack, double release)
+{
+    LinearEnvelope env;
+    if (N <= 1)
+        return env;
+
+    int attackSamples = std::min(static_cast<int>(std::max(0.0, attack) * sr), N);
+    int releaseSamples = std::min(static_cast<int>(std::max(0.0, release) * sr), N);
+
+    int totalAR = attackSamples + releaseSamples;
+    if (totalAR > N && totalAR > 0)
+    {
+        double scale = static_cast<double>(N) / static_cast<double>(totalAR);
+        attackSamples = static_cast<int>(attackSamples * scale);
+        releaseSamples = N - attackSamples;
+    }
+
+    env.addSegment(attackSamples, 0.0, 1.0);
+    env.addSegment(N - (attackSamples + releaseSamples), 1.0, 1.0);
+    env.addSegment(releaseSamples, 1.0, 0.0);
+    env.finalValue = releaseSamples > 0 ? 0.0 : 1.0;
+    return env;
+}
+
+LinearEnvelope LinearEnvelope::fade(int totalSamples, int fadeSamples, double startAmp, double endAmp, bool fadeIn)
+{
+    LinearEnvelope env;
+    if (fadeIn)
+    {
+        env.addSegment(fadeSamples, startAmp, endAmp);
+        env.finalValue = endAmp;
+    }
+    else
+    {
+        env.addSegment(totalSamples - std::max(0, fadeSamples), startAmp, startAmp);
+        env.addSegment(fadeSamples, startAmp, endAmp);
+        env.finalValue = fadeSamples > 0 ? endAmp : startAmp;
+    }
+    return env;
+}
+
+void LinearEnvelope::addSegment(int length, double from, double to) noexcept
+{
+    if (length > 0 && numSegments < static_cast<int>(segments.size()))
+        segments[static_cast<size_t>(numSegments++)] = { length, from, to };
+}
+
+template <typename Op>
+void LinearEnvelope::generate(int numSamples, Op&& op) noexcept
+{
+    int i = 0;
+    while (i < numSamples && segment < numSegments)
+    {
+        const auto& seg = segments[static_cast<size_t>(segment)];
+        int count = std::min(numSamples - i, seg.length - position);
+        double span = seg.to - seg.from;
+        double length = static_cast<double>(seg.length);
+        for (int k = 0; k < count; ++k)
+            op(i + k, seg.from + span * (static_cast<double>(position + k) / length));
+
+        i += count;
+        position += count;
+        if (position >= seg.length)
+        {
+            ++segment;
+            position = 0;
+        }
+    }
+    for (; i < numSamples; ++i)
+        op(i, finalValue);
+}
+
+void LinearEnvelope::getNextBlock(double* out, int numSamples) noexcept
+{
+    generate(numSamples, [out](int i, double v) { out[i] = v; });
+}
+
+void LinearEnvelope::applyTo(float* data, int numSamples) noexcept
+{
+    generate(numSamples, [data](int i, double v) { data[i] = static_cast<float>(data[i] * v); });
+}
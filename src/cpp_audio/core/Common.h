@@ -2,6 +2,7 @@
 #include <vector>
 #include <string>
 #include <utility>
+#include <array>
 
 std::vector<double> sineWave(double freq, const std::vector<double>& t, double phase = 0.0);
 std::vector<double> sineWaveVarying(const std::vector<double>& freqArray,
@@ -53,3 +54,142 @@ std::vector<double> trapezoidEnvelopeVectorized(const std::vector<double>& tInCy
 std::vector<double> applyFilters(const std::vector<double>& signalSegment,
                                  double fs);
 
+
+/** A second-order IIR section on the RBJ cookbook designs, run in place a
+    block at a time. State carries over between calls, and is flushed to
+    zero once it decays below audibility so silence cannot turn denormal. */
+class Biquad
+{
+public:
+    struct Coefficients
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    };
+
+    static Coefficients lowPass(double cutoff, double fs, double Q = 0.7071067811865476);
+    static Coefficients highPass(double cutoff, double fs, double Q = 0.7071067811865476);
+    /** Constant 0 dB peak gain. */
+    static Coefficients bandPass(double center, double Q, double fs);
+    static Coefficients bandReject(double center, double Q, double fs);
+
+    Biquad() = default;
+    explicit Biquad(const Coefficients& c) : coeffs(c) {}
+
+    /** Changes the response without clearing the state. */
+    void setCoefficients(const Coefficients& c) noexcept { coeffs = c; }
+    void reset() noexcept { x1 = x2 = y1 = y2 = 0.0; }
+
+    double processSample(double x) noexcept
+    {
+        double y = coeffs.b0 * x + coeffs.b1 * x1 + coeffs.b2 * x2 - coeffs.a1 * y1 - coeffs.a2 * y2;
+        x2 = x1; x1 = x;
+        y2 = y1; y1 = y;
+        return y;
+    }
+
+    void process(double* data, int numSamples) noexcept;
+    void process(float* data, int numSamples) noexcept;
+
+private:
+    void snapToZero() noexcept;
+
+    Coefficients coeffs;
+    double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
+};
+
+/** Biquads run one after another, each over the whole block. */
+class BiquadCascade
+{
+public:
+    void add(const Biquad::Coefficients& c) { stages.emplace_back(c); }
+    int getNumStages() const noexcept { return static_cast<int>(stages.size()); }
+    Biquad& getStage(int index) noexcept { return stages[static_cast<size_t>(index)]; }
+    void reset() noexcept;
+
+    void process(double* data, int numSamples) noexcept;
+    void process(float* data, int numSamples) noexcept;
+
+private:
+    std::vector<Biquad> stages;
+};
+
+/** One-pole low-pass, y += (1 - a) (x - y), for smoothing control signals. */
+class OnePole
+{
+public:
+    OnePole() = default;
+    OnePole(double cutoff, double fs) { setCutoff(cutoff, fs); }
+
+    void setCutoff(double cutoff, double fs) noexcept;
+    void reset(double value = 0.0) noexcept { y1 = value; }
+
+    double processSample(double x) noexcept { return y1 += (1.0 - pole) * (x - y1); }
+    void process(double* data, int numSamples) noexcept;
+    void process(float* data, int numSamples) noexcept;
+
+private:
+    double pole = 0.0;
+    double y1 = 0.0;
+};
+
+/** Removes DC with a one-zero, one-pole high-pass at @p cutoff Hz. */
+class DcBlocker
+{
+public:
+    explicit DcBlocker(double fs, double cutoff = 10.0);
+
+    void reset() noexcept { x1 = y1 = 0.0; }
+
+    double processSample(double x) noexcept
+    {
+        double y = x - x1 + pole * y1;
+        x1 = x;
+        y1 = y;
+        return y;
+    }
+
+    void process(double* data, int numSamples) noexcept;
+    void process(float* data, int numSamples) noexcept;
+
+private:
+    double pole;
+    double x1 = 0.0, y1 = 0.0;
+};
+
+/** An envelope of up to four straight segments followed by a held value,
+    generated a block at a time, so a long render never holds the whole
+    envelope. The factories match adsrEnvelope(), linenEnvelope() and
+    createLinearFadeEnvelope() sample for sample. */
+class LinearEnvelope
+{
+public:
+    static LinearEnvelope adsr(int totalSamples, double sampleRate, double attack, double decay,
+                               double sustainLevel, double release);
+    static LinearEnvelope linen(int totalSamples, double sampleRate, double attack, double release);
+    static LinearEnvelope fade(int totalSamples, int fadeSamples, double startAmp, double endAmp, bool fadeIn);
+
+    /** Back to the first sample. */
+    void reset() noexcept { segment = 0; position = 0; }
+
+    /** Writes the next @p numSamples values to @p out. */
+    void getNextBlock(double* out, int numSamples) noexcept;
+    /** Multiplies the next @p numSamples values into @p data. */
+    void applyTo(float* data, int numSamples) noexcept;
+
+private:
+    struct Segment
+    {
+        int length = 0;
+        double from = 0.0, to = 0.0;
+    };
+
+    void addSegment(int length, double from, double to) noexcept;
+    template <typename Op>
+    void generate(int numSamples, Op&& op) noexcept;
+
+    std::array<Segment, 4> segments {};
+    int numSegments = 0;
+    double finalValue = 0.0;
+    int segment = 0;
+    int position = 0;
+};
@@ -0,0 +1,182 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+/** Approximations of the transcendental functions the synths call per
+    sample. Each is straight-line arithmetic (no tables, no libm calls), so
+    loops over them can be auto-vectorised, and each has a stated accuracy
+    that keeps it well below 24-bit resolution for audio-range inputs. GCC
+    needs -fno-trapping-math to vectorise the clamps; the build sets it.
+
+    Building with DIY_AV_REFERENCE_MATH=1 (CMake option
+    DIY_AV_ENABLE_REFERENCE_MATH) turns every function into a call to the
+    libm equivalent, for reference renders and for checking the contracts.
+*/
+namespace fastmath
+{
+namespace detail
+{
+    constexpr double pi = 3.14159265358979323846;
+    constexpr double halfPi = 1.57079632679489661923;
+    constexpr double invTwoPi = 0.15915494309189533577;
+    // 2 pi split so that k * twoPiHi is exact for |k| < 2^20 (Cody-Waite).
+    constexpr double twoPiHi = 6.28318530717958623200;
+    constexpr double twoPiLo = 2.44929359829470635445e-16;
+
+    inline double fromBits(std::uint64_t bits) noexcept
+    {
+        double d;
+        std::memcpy(&d, &bits, sizeof(d));
+        return d;
+    }
+
+    inline std::uint64_t toBits(double d) noexcept
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        return bits;
+    }
+
+    /** @p x rounded to the nearest integer, ties to even, for |x| < 2^51.
+        Adding 1.5 * 2^52 pushes the fraction out of the mantissa, so this
+        stays inline and vectorises where std::nearbyint is a libm call. */
+    inline double roundToInteger(double x) noexcept
+    {
+        constexpr double roundingBias = 6755399441055744.0;
+        return (x + roundingBias) - roundingBias;
+    }
+
+    /** sin(x) for |x| <= pi/2: odd Taylor series to x^15, error < 1e-11. */
+    inline double sinKernel(double x) noexcept
+    {
+        double x2 = x * x;
+        return x * (1.0 + x2 * (-1.66666666666666666667e-1
+                   + x2 * (8.33333333333333333333e-3
+                   + x2 * (-1.98412698412698412698e-4
+                   + x2 * (2.75573192239858906526e-6
+                   + x2 * (-2.50521083854417187751e-8
+                   + x2 * (1.60590438368216145994e-10
+                   + x2 * -7.64716373181981647590e-13)))))));
+    }
+}
+
+#if DIY_AV_REFERENCE_MATH
+
+inline double sin(double x) noexcept               { return std::sin(x); }
+inline double cos(double x) noexcept               { return std::cos(x); }
+inline double tanh(double x) noexcept              { return std::tanh(x); }
+inline double exp2(double x) noexcept              { return std::exp2(x); }
+inline double log2(double x) noexcept              { return std::log2(x); }
+inline double pow(double base, double e) noexcept  { return std::pow(base, e); }
+
+#else
+
+/** Absolute error < 5e-10 for |x| < 1e5 (about 4 hours of phase at 1 kHz),
+    growing with |x| as the range reduction loses bits beyond that. */
+inline double sin(double x) noexcept
+{
+    using namespace detail;
+    double k = roundToInteger(x * invTwoPi);
+    double r = (x - k * twoPiHi) - k * twoPiLo;     // [-pi, pi]
+    // Fold [pi/2, pi] and [-pi, -pi/2] back onto [-pi/2, pi/2].
+    r = r > halfPi ? pi - r : (r < -halfPi ? -pi - r : r);
+    return sinKernel(r);
+}
+
+/** Same contract as sin(). */
+inline double cos(double x) noexcept
+{
+    return sin(x + detail::halfPi);
+}
+
+/** Absolute error < 1e-7 everywhere. A 13/6
+    rational approximation on the clamped input. */
+inline double tanh(double x) noexcept
+{
+    constexpr double clampAt = 9.0;
+    x = x > clampAt ? clampAt : (x < -clampAt ? -clampAt : x);
+    double x2 = x * x;
+    double p = x2 * -2.76076847742355e-16 + 2.00018790482477e-13;
+    p = p * x2 - 8.60467152213735e-11;
+    p = p * x2 + 5.12229709037114e-8;
+    p = p * x2 + 1.48572235717979e-5;
+    p = p * x2 + 6.37261928875436e-4;
+    p = p * x2 + 4.89352455891786e-3;
+    p *= x;
+    double q = x2 * 1.19825839466702e-6 + 1.18534705686654e-4;
+    q = q * x2 + 2.26843463243900e-3;
+    q = q * x2 + 4.89352518554385e-3;
+    double y = p / q;
+    return y > 1.0 ? 1.0 : (y < -1.0 ? -1.0 : y);
+}
+
+/** Relative error < 1e-8 for |x| <= 1022; 0 below -1022 and saturates at
+    2^1023 above. */
+inline double exp2(double x) noexcept
+{
+    x = x < -1022.0 ? -1022.0 : (x > 1023.0 ? 1023.0 : x);
+    double n = detail::roundToInteger(x);
+    double f = (x - n) * 0.69314718055994530942;    // |f| <= ln2 / 2
+    // e^f, Taylor series to f^7.
+    double p = 1.0 + f * (1.0 + f * (0.5 + f * (1.66666666666666666667e-1
+             + f * (4.16666666666666666667e-2 + f * (8.33333333333333333333e-3
+             + f * (1.38888888888888888889e-3 + f * 1.98412698412698412698e-4))))));
+    // 2^n built from its exponent bits; adding 1.5 * 2^52 leaves the biased
+    // exponent in the low mantissa bits without an integer conversion.
+    double biased = n + (1023.0 + 6755399441055744.0);
+    double scale = detail::fromBits(detail::toBits(biased) << 52);
+    return x <= -1022.0 ? 0.0 : p * scale;
+}
+
+/** Absolute error < 2e-9 for normal positive @p x; -1022 for zero and
+    denormals. Undefined for negative input. */
+inline double log2(double x) noexcept
+{
+    using namespace detail;
+    std::uint64_t bits = toBits(x);
+    // Biased exponent as a double, again without an integer conversion.
+    double e = fromBits(((bits >> 52) & 0x7ff) | 0x4330000000000000ULL) - (4503599627370496.0 + 1023.0);
+    // Mantissa in [1, 2), then moved to [sqrt(1/2), sqrt(2)).
+    double m = fromBits((bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL);
+    bool high = m > 1.41421356237309504880;
+    m = high ? m * 0.5 : m;
+    e = high ? e + 1.0 : e;
+    // log(m) = 2 atanh(t), |t| < 0.172; series to t^9.
+    double t = (m - 1.0) / (m + 1.0);
+    double t2 = t * t;
+    double s = t * (2.0 + t2 * (6.66666666666666666667e-1 + t2 * (4.0e-1
+             + t2 * (2.85714285714285714286e-1 + t2 * 2.22222222222222222222e-1))));
+    double result = e + s * 1.44269504088896340736;
+    return e < -1022.0 ? -1022.0 : result;
+}
+
+/** @p base to the power @p e for @p base >= 0, via exp2(e * log2(base)).
+    Relative error < 1e-8 * (1 + |e * log2(base)|); pow(0, e) is 0 for
+    positive @p e. */
+inline double pow(double base, double e) noexcept
+{
+    return base <= 0.0 ? 0.0 : fastmath::exp2(e * fastmath::log2(base));
+}
+
+#endif
+
+/** Block forms, for loops that compute a whole array at once. */
+inline void sin(const double* x, double* out, int n) noexcept
+{
+    for (int i = 0; i < n; ++i)
+        out[i] = fastmath::sin(x[i]);
+}
+
+inline void tanh(const double* x, double* out, int n) noexcept
+{
+    for (int i = 0; i < n; ++i)
+        out[i] = fastmath::tanh(x[i]);
+}
+
+inline void pow(const double* base, double e, double* out, int n) noexcept
+{
+    for (int i = 0; i < n; ++i)
+        out[i] = fastmath::pow(base[i], e);
+}
+} // namespace fastmath
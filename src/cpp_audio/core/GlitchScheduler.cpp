@@ -0,0 +1,126 @@
+#include "GlitchScheduler.h"
+#include <cmath>
+
+using namespace juce;
+
+GlitchScheduler::GlitchScheduler(double intervalSeconds, double burstLengthSeconds, double noiseLevel,
+                                 double focusFreq, double focusWidth, double rate,
+                                 int64 total, int64 seedToUse)
+    : interval(intervalSeconds),
+      burstSeconds(burstLengthSeconds),
+      sampleRate(rate),
+      totalSamples(total),
+      seed(seedToUse)
+{
+    if (interval <= 0.0 || burstSeconds <= 0.0 || noiseLevel <= 0.0)
+        return;
+
+    burstLength = jmax(0, static_cast<int>(burstSeconds * sampleRate));
+    if (burstLength == 0)
+        return;
+
+    focused = focusWidth > 0.0;
+    double bandwidth = sampleRate * 0.5;
+    double variance = 1.0;
+    if (focused)
+    {
+        double q = focusFreq / jmax(1e-6, focusWidth);
+        bandPass.coefficients = dsp::IIR::Coefficients<float>::makeBandPass(sampleRate, focusFreq, q);
+        bandwidth = jmin(bandwidth, focusWidth);
+
+        // The filter starts from rest each burst, so a narrow one is still
+        // ringing up when the burst ends: take the variance it has reached
+        // by then, the energy of its impulse response so far.
+        dsp::IIR::Filter<float> impulse(bandPass.coefficients);
+        variance = 0.0;
+        for (int i = 0; i < burstLength; ++i)
+        {
+            double h = impulse.processSample(i == 0 ? 1.0f : 0.0f);
+            variance += h * h;
+        }
+    }
+
+    // Gaussian noise with n independent samples peaks a little above
+    // sqrt(2 ln n) standard deviations; the + 2 keeps a narrow band, which
+    // swings like a sine, at no less than a sine's sqrt(2).
+    double independent = jmax(1.0, 2.0 * bandwidth * burstSeconds);
+    double peak = std::sqrt(jmax(1e-12, variance)) * std::sqrt(2.0 * std::log(independent) + 2.0);
+    gain = static_cast<float>(noiseLevel / peak);
+    reset();
+}
+
+int64 GlitchScheduler::burstStart(int64 k) const noexcept
+{
+    double start = jmax(0.0, k * interval - burstSeconds);
+    auto first = static_cast<int64>(start * sampleRate);
+    if (totalSamples >= 0 && first + burstLength > totalSamples)
+        return -1;
+    return first;
+}
+
+void GlitchScheduler::reset()
+{
+    rng.seed(static_cast<std::mt19937::result_type>(seed));
+    dist.reset();
+    bandPass.reset();
+    position = 0;
+    nextBurst = 1;
+    nextStart = burstLength > 0 ? burstStart(nextBurst) : -1;
+    burstPosition = -1;
+}
+
+void GlitchScheduler::startBurst() noexcept
+{
+    bandPass.reset();
+    burstPosition = 0;
+
+    // Later bursts can only start later; a late one that does not fit means
+    // none after it will either.
+    int64 start = nextStart;
+    do
+        nextStart = burstStart(++nextBurst);
+    while (nextStart >= 0 && nextStart <= start);
+}
+
+void GlitchScheduler::process(float* left, float* right, int numSamples) noexcept
+{
+    if (burstLength == 0)
+        return;
+
+    const float fade = 1.0f / static_cast<float>(burstLength);
+    int done = 0;
+    while (done < numSamples)
+    {
+        if (nextStart >= 0 && position == nextStart)
+            startBurst();
+
+        // Run up to whichever comes first: the end of the block, the end
+        // of this burst, or the start of the next.
+        int64 span = numSamples - done;
+        if (nextStart >= 0)
+            span = jmin(span, nextStart - position);
+        if (burstPosition < 0)
+        {
+            position += span;
+            done += static_cast<int>(span);
+            continue;
+        }
+
+        int count = static_cast<int>(jmin<int64>(span, burstLength - burstPosition));
+        for (int i = 0; i < count; ++i)
+        {
+            float noise = dist(rng);
+            if (focused)
+                noise = bandPass.processSample(noise);
+            float value = noise * gain * static_cast<float>(burstPosition + i) * fade;
+            left[done + i] += value;
+            right[done + i] += value;
+        }
+
+        burstPosition += count;
+        if (burstPosition >= burstLength)
+            burstPosition = -1;
+        position += count;
+        done += count;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include <random>
+
+/** The noise bursts of binauralBeat(), worked out as they are played.
+
+    Burst k (from 1) ends k * interval seconds in and lasts burstSeconds.
+    Each one is Gaussian noise, optionally band-passed round focusFreq with
+    a bandwidth of focusWidth Hz, faded in linearly across the burst. The
+    next start time is computed from the burst count, so nothing is
+    rendered ahead and the state is the same size however long the voice
+    runs. A burst due while another is playing cuts the earlier one off.
+
+    Bursts are scaled by the expected peak of the filtered noise rather than
+    normalised to their own peak, which would need the whole burst first;
+    the noise peaks at about noiseLevel before the fade.
+*/
+class GlitchScheduler
+{
+public:
+    /** @p totalSamples limits the bursts to ones that finish before it;
+        pass a negative length for a voice with no end. */
+    GlitchScheduler(double interval, double burstSeconds, double noiseLevel,
+                    double focusFreq, double focusWidth, double sampleRate,
+                    juce::int64 totalSamples, juce::int64 seed);
+
+    /** False if the settings produce no bursts at all. */
+    bool isActive() const noexcept { return burstLength > 0 && burstStart(1) >= 0; }
+
+    /** Rewinds to the first sample; the same bursts are produced again. */
+    void reset();
+
+    /** Adds the next @p numSamples to @p left and @p right (the same noise
+        in both). */
+    void process(float* left, float* right, int numSamples) noexcept;
+
+private:
+    /** First sample of burst @p k, or -1 if it would not finish in time. */
+    juce::int64 burstStart(juce::int64 k) const noexcept;
+    void startBurst() noexcept;
+
+    double interval, burstSeconds, sampleRate;
+    juce::int64 totalSamples;
+    juce::int64 seed;
+    int burstLength = 0;
+    bool focused = false;
+    float gain = 0.0f;
+
+    std::mt19937 rng;
+    std::normal_distribution<float> dist { 0.0f, 1.0f };
+    juce::dsp::IIR::Filter<float> bandPass;
+
+    juce::int64 position = 0;
+    juce::int64 nextBurst = 1;          // index of the next burst to start
+    juce::int64 nextStart = -1;         // its first sample, or -1 if none
+    int burstPosition = -1;             // sample within the current burst, -1 when idle
+};
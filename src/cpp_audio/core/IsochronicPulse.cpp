@@ -0,0 +1,68 @@
+#include "IsochronicPulse.h"
+#include "FastMath.h"
+#include <algorithm>
+
+using namespace juce;
+
+IsochronicPulse::IsochronicPulse(double rampPercent, double gapPercent, RampShape shape)
+    : rampShape(shape)
+{
+    audible = 1.0 - gapPercent;
+    double rampLen = std::clamp(audible * rampPercent * 2.0, 0.0, audible) * 0.5;
+    rampScale = rampLen > 0.0 ? 1.0 / rampLen : 0.0;
+    rampBias = rampLen > 0.0 ? 0.0 : 1.0;
+}
+
+IsochronicPulse::RampShape IsochronicPulse::parseRampShape(const String& name)
+{
+    return name.equalsIgnoreCase("cosine") ? RampShape::cosine : RampShape::linear;
+}
+
+double IsochronicPulse::getEnvelope(double p) const noexcept
+{
+    double values[1] = { p };
+    shape(values, 1);
+    return values[0];
+}
+
+void IsochronicPulse::process(double phaseIncrement, double* env, int numSamples) noexcept
+{
+    // Phases from the block start rather than by accumulation, so the
+    // loop has no carried dependency.
+    for (int k = 0; k < numSamples; ++k)
+    {
+        double p = phase + k * phaseIncrement;
+        env[k] = p - std::floor(p);
+    }
+    setPhase(phase + numSamples * phaseIncrement);
+    shape(env, numSamples);
+}
+
+void IsochronicPulse::process(const double* phaseIncrements, double* env, int numSamples) noexcept
+{
+    for (int k = 0; k < numSamples; ++k)
+    {
+        env[k] = phase;
+        phase += phaseIncrements[k];
+        phase -= std::floor(phase);
+    }
+    shape(env, numSamples);
+}
+
+void IsochronicPulse::shape(double* values, int numSamples) const noexcept
+{
+    // The rise and fall ramps as lines through the pulse edges; their
+    // minimum, clamped to [0, 1], is the trapezoid.
+    for (int k = 0; k < numSamples; ++k)
+    {
+        double p = values[k];
+        double rise = p * rampScale + rampBias;
+        double fall = (audible - p) * rampScale + rampBias;
+        double level = std::min(1.0, std::min(rise, fall));
+        values[k] = p < audible && level > 0.0 ? level : 0.0;
+    }
+
+    if (rampShape == RampShape::cosine)
+        for (int k = 0; k < numSamples; ++k)
+            values[k] = 0.5 - 0.5 * fastmath::cos(MathConstants<double>::pi * values[k]);
+}
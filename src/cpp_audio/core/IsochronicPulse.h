@@ -0,0 +1,49 @@
+#pragma once
+#include <juce_core/juce_core.h>
+
+/** The on/off envelope of an isochronic tone, driven by a beat phase that
+    wraps at 1 rather than by absolute time, so long steps keep their
+    timing precision.
+
+    Each beat is a ramp up, a hold at 1 and a ramp down over the first
+    (1 - gapPercent) of the cycle, then silence. rampPercent is the length
+    of each ramp as a fraction of the audible part. With RampShape::cosine
+    the ramps follow a raised cosine, which starts and ends each pulse
+    with zero slope and so clicks less than the linear ramps.
+
+    The segment boundaries are worked out once, and the envelope itself has
+    no branches, so the fill loops vectorise.
+*/
+class IsochronicPulse
+{
+public:
+    enum class RampShape { linear, cosine };
+
+    IsochronicPulse(double rampPercent, double gapPercent, RampShape shape = RampShape::linear);
+
+    /** Maps the "rampShape" voice param ("linear" or "cosine"). */
+    static RampShape parseRampShape(const juce::String& name);
+
+    /** Envelope at @p phase, which must be in [0, 1). */
+    double getEnvelope(double phase) const noexcept;
+
+    /** Fills @p env with @p numSamples of envelope at a fixed beat rate of
+        @p phaseIncrement cycles per sample. Each sample reads the phase
+        before advancing it. */
+    void process(double phaseIncrement, double* env, int numSamples) noexcept;
+
+    /** As above, with a separate increment for each sample. */
+    void process(const double* phaseIncrements, double* env, int numSamples) noexcept;
+
+    double getPhase() const noexcept { return phase; }
+    void setPhase(double newPhase) noexcept { phase = newPhase - std::floor(newPhase); }
+
+private:
+    void shape(double* values, int numSamples) const noexcept;
+
+    double audible;         // end of the pulse, as a fraction of the cycle
+    double rampScale;       // 1 / ramp length, or 0 with no ramps
+    double rampBias;        // 1 with no ramps, so the pulse is a plain gate
+    RampShape rampShape;
+    double phase = 0.0;
+};
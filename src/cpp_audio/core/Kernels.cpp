@@ -0,0 +1,170 @@
+#include "Kernels.h"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+ #define DIY_AV_X86 1
+ #if defined(_MSC_VER)
+  #include <intrin.h>
+ #else
+  #include <cpuid.h>
+ #endif
+#elif defined(__arm__) && defined(__linux__)
+ #include <sys/auxv.h>
+ #include <asm/hwcap.h>
+#endif
+
+// One per Kernels<Level>.cpp; null where the level was not compiled in.
+const DspKernels* getScalarKernels() noexcept;
+const DspKernels* getSse2Kernels() noexcept;
+const DspKernels* getAvx2Kernels() noexcept;
+const DspKernels* getAvx512Kernels() noexcept;
+const DspKernels* getNeonKernels() noexcept;
+
+namespace
+{
+const char* const levelNames[] = { "scalar", "sse2", "avx2", "avx512", "neon" };
+
+static_assert(sizeof(levelNames) / sizeof(levelNames[0]) == static_cast<size_t>(SimdLevel::numLevels),
+              "SIMD level names out of sync");
+
+#if DIY_AV_X86
+struct CpuidRegisters
+{
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+};
+
+CpuidRegisters cpuid(unsigned leaf, unsigned subleaf)
+{
+    CpuidRegisters r;
+   #if defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (leaf > static_cast<unsigned>(regs[0]))
+        return r;
+    __cpuidex(regs, static_cast<int>(leaf), static_cast<int>(subleaf));
+    r.eax = static_cast<unsigned>(regs[0]);
+    r.ebx = static_cast<unsigned>(regs[1]);
+    r.ecx = static_cast<unsigned>(regs[2]);
+    r.edx = static_cast<unsigned>(regs[3]);
+   #else
+    if (leaf <= __get_cpuid_max(0, nullptr))
+        __cpuid_count(leaf, subleaf, r.eax, r.ebx, r.ecx, r.edx);
+   #endif
+    return r;
+}
+
+/** Which register sets the OS saves on a context switch (XCR0). */
+unsigned long long enabledRegisterState()
+{
+   #if defined(_MSC_VER)
+    return _xgetbv(0);
+   #else
+    unsigned lo = 0, hi = 0;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<unsigned long long>(hi) << 32) | lo;
+   #endif
+}
+
+bool hasBit(unsigned reg, int bit) { return (reg >> bit) & 1u; }
+
+bool cpuSupports(SimdLevel level)
+{
+    const CpuidRegisters basic = cpuid(1, 0);
+    if (level == SimdLevel::sse2)
+        return hasBit(basic.edx, 26);
+
+    // AVX needs the OS to save the YMM registers, AVX-512 the ZMM and mask
+    // registers as well; XGETBV may only be used once OSXSAVE says so.
+    if (! hasBit(basic.ecx, 27) || ! hasBit(basic.ecx, 28) || ! hasBit(basic.ecx, 12))
+        return false;
+    const unsigned long long state = enabledRegisterState();
+    const CpuidRegisters extended = cpuid(7, 0);
+
+    if (level == SimdLevel::avx2)
+        return (state & 0x6) == 0x6 && hasBit(extended.ebx, 5);
+
+    if (level == SimdLevel::avx512)
+        return (state & 0xe6) == 0xe6 && hasBit(extended.ebx, 5)
+            && hasBit(extended.ebx, 16) && hasBit(extended.ebx, 17)
+            && hasBit(extended.ebx, 30) && hasBit(extended.ebx, 31);
+
+    return false;
+}
+#else
+bool cpuSupports(SimdLevel level)
+{
+    if (level != SimdLevel::neon)
+        return false;
+   #if defined(__arm__) && defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+   #else
+    return true; // part of AArch64
+   #endif
+}
+#endif
+
+const DspKernels* compiledKernels(SimdLevel level)
+{
+    switch (level)
+    {
+        case SimdLevel::scalar: return getScalarKernels();
+        case SimdLevel::sse2:   return getSse2Kernels();
+        case SimdLevel::avx2:   return getAvx2Kernels();
+        case SimdLevel::avx512: return getAvx512Kernels();
+        case SimdLevel::neon:   return getNeonKernels();
+        case SimdLevel::numLevels: break;
+    }
+    return nullptr;
+}
+
+SimdLevel chooseLevel()
+{
+    if (const char* forced = std::getenv("DIY_AV_SIMD"))
+    {
+        for (int i = 0; i < static_cast<int>(SimdLevel::numLevels); ++i)
+        {
+            auto level = static_cast<SimdLevel>(i);
+            if (std::strcmp(forced, levelNames[i]) == 0 && isSimdLevelSupported(level))
+                return level;
+        }
+    }
+
+    // Levels are listed weakest first within each architecture.
+    SimdLevel best = SimdLevel::scalar;
+    for (int i = 0; i < static_cast<int>(SimdLevel::numLevels); ++i)
+        if (isSimdLevelSupported(static_cast<SimdLevel>(i)))
+            best = static_cast<SimdLevel>(i);
+    return best;
+}
+}
+
+bool isSimdLevelSupported(SimdLevel level) noexcept
+{
+    if (compiledKernels(level) == nullptr)
+        return false;
+    return level == SimdLevel::scalar || cpuSupports(level);
+}
+
+const DspKernels* getKernelsFor(SimdLevel level) noexcept
+{
+    return isSimdLevelSupported(level) ? compiledKernels(level) : nullptr;
+}
+
+SimdLevel getSimdLevel() noexcept
+{
+    static const SimdLevel level = chooseLevel();
+    return level;
+}
+
+const char* getSimdLevelName(SimdLevel level) noexcept
+{
+    auto index = static_cast<int>(level);
+    return index >= 0 && index < static_cast<int>(SimdLevel::numLevels) ? levelNames[index] : "unknown";
+}
+
+const DspKernels& getKernels() noexcept
+{
+    static const DspKernels& kernels = *compiledKernels(getSimdLevel());
+    return kernels;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+/** The engine's innermost loops, compiled once per instruction-set level
+    and chosen at startup for the CPU the binary is running on, so one build
+    can use AVX-512 where it exists and still run on an SSE2-only or ARM
+    machine.
+
+    Every level computes the same thing with the same operations in the
+    same order per sample; they differ only in how many samples the compiler
+    does at once and whether it fuses multiply-adds, so results agree to
+    within a rounding step.
+
+    The level is picked on first use: the best one this CPU supports
+    (CPUID on x86, the auxiliary vector on 32-bit ARM), unless the
+    DIY_AV_SIMD environment variable names another ("scalar", "sse2",
+    "avx2", "avx512" or "neon"). A level the CPU lacks falls back to the
+    best it has.
+*/
+enum class SimdLevel
+{
+    scalar,
+    sse2,
+    avx2,
+    avx512,
+    neon,
+    numLevels
+};
+
+struct DspKernels
+{
+    /** Writes sin(phase + i * increment) for each sample and returns the
+        phase after the block, wrapped to [0, 2 pi). Accurate to about 1e-6. */
+    double (*sine)(float* out, double phase, double increment, int numSamples);
+
+    void (*applyGain)(float* data, float gain, int numSamples);
+    void (*addWithGain)(float* dest, const float* src, float gain, int numSamples);
+
+    /** Adds @p src to @p left and @p right at fixed pan gains. */
+    void (*pan)(const float* src, float* left, float* right, float gainL, float gainR, int numSamples);
+
+    /** dest = dest * fadeOut + src * fadeIn. */
+    void (*crossfade)(float* dest, const float* src, const float* fadeOut, const float* fadeIn, int numSamples);
+
+    /** Direct form I biquad in place. @p coefficients is b0 b1 b2 a1 a2
+        (a0 = 1) and @p state is x1 x2 y1 y2, updated on return. */
+    void (*biquad)(float* data, int numSamples, const double* coefficients, double* state);
+
+    /** Linear interpolation of @p src at position, position + step, ...;
+        returns the position after the block. Reads are clamped to the last
+        source sample. */
+    double (*resampleLinear)(const float* src, int srcLength, float* out, int numSamples,
+                             double position, double step);
+};
+
+/** The kernels for the level in use. */
+const DspKernels& getKernels() noexcept;
+
+SimdLevel getSimdLevel() noexcept;
+const char* getSimdLevelName(SimdLevel level) noexcept;
+
+/** True if @p level was compiled in and this CPU can run it. */
+bool isSimdLevelSupported(SimdLevel level) noexcept;
+
+/** The kernels for @p level, or nullptr if it is not supported; for
+    comparing levels against each other. */
+const DspKernels* getKernelsFor(SimdLevel level) noexcept;
@@ -0,0 +1,20 @@
+// x86 only, built with AVX2 and FMA enabled (see CMakeLists.txt). Nothing
+// here may run until Kernels.cpp has checked the CPU supports both.
+#include "Kernels.h"
+
+#if defined(__AVX2__)
+namespace kernels_avx2
+{
+#include "KernelsImpl.h"
+}
+
+const DspKernels* getAvx2Kernels() noexcept
+{
+    return &kernels_avx2::table;
+}
+#else
+const DspKernels* getAvx2Kernels() noexcept
+{
+    return nullptr;
+}
+#endif
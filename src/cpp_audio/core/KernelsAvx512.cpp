@@ -0,0 +1,21 @@
+// x86 only, built with AVX-512 (F, DQ, BW, VL) enabled (see
+// CMakeLists.txt). Nothing here may run until Kernels.cpp has checked the
+// CPU and OS support it.
+#include "Kernels.h"
+
+#if defined(__AVX512F__)
+namespace kernels_avx512
+{
+#include "KernelsImpl.h"
+}
+
+const DspKernels* getAvx512Kernels() noexcept
+{
+    return &kernels_avx512::table;
+}
+#else
+const DspKernels* getAvx512Kernels() noexcept
+{
+    return nullptr;
+}
+#endif
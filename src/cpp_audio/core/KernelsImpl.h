@@ -0,0 +1,100 @@
+// The DspKernels loop bodies. Not a normal header: each Kernels<Level>.cpp
+// includes it inside its own namespace and builds it with that level's
+// compiler flags, so it must stay free of #includes and of anything with
+// external linkage that another level's copy could be merged with.
+
+constexpr double twoPi = 6.283185307179586476925;
+constexpr double invTwoPi = 0.159154943091895335769;
+constexpr float piF = 3.14159265358979323846f;
+
+double wrapCycles(double cycles) noexcept
+{
+    auto whole = static_cast<long long>(cycles);
+    if (cycles < static_cast<double>(whole))
+        --whole;
+    return cycles - static_cast<double>(whole);
+}
+
+double sine(float* out, double phase, double increment, int numSamples)
+{
+    // Adding and taking away 1.5 * 2^52 rounds to the nearest integer
+    // without a branch or a conversion, for magnitudes below 2^51.
+    constexpr double roundingBias = 6755399441055744.0;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // sin(n pi + x) = (-1)^n sin(x), with n the nearest half cycle and
+        // x in [-pi/2, pi/2], where the odd Taylor series to x^11 is within
+        // 6e-8. Everything is arithmetic so every level can vectorise it.
+        double halfCycles = (phase + increment * i) * (2.0 * invTwoPi);
+        double n = (halfCycles + roundingBias) - roundingBias;
+        double odd = n - 2.0 * ((n * 0.5 + roundingBias) - roundingBias);
+        float sign = static_cast<float>(1.0 - 2.0 * odd * odd);
+        float x = static_cast<float>(halfCycles - n) * piF;
+        float x2 = x * x;
+        out[i] = sign * x * (1.0f + x2 * (-1.66666667e-1f + x2 * (8.33333333e-3f + x2 * (-1.98412698e-4f
+                            + x2 * (2.75573192e-6f + x2 * -2.50521084e-8f)))));
+    }
+    return wrapCycles((phase + increment * numSamples) * invTwoPi) * twoPi;
+}
+
+void applyGain(float* data, float gain, int numSamples)
+{
+    for (int i = 0; i < numSamples; ++i)
+        data[i] *= gain;
+}
+
+void addWithGain(float* dest, const float* src, float gain, int numSamples)
+{
+    for (int i = 0; i < numSamples; ++i)
+        dest[i] += src[i] * gain;
+}
+
+void pan(const float* src, float* left, float* right, float gainL, float gainR, int numSamples)
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        left[i] += src[i] * gainL;
+        right[i] += src[i] * gainR;
+    }
+}
+
+void crossfade(float* dest, const float* src, const float* fadeOut, const float* fadeIn, int numSamples)
+{
+    for (int i = 0; i < numSamples; ++i)
+        dest[i] = dest[i] * fadeOut[i] + src[i] * fadeIn[i];
+}
+
+void biquad(float* data, int numSamples, const double* c, double* state)
+{
+    // Each output depends on the last, so this only gains from fused
+    // multiply-adds, not from wider registers.
+    const double b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+    double x1 = state[0], x2 = state[1], y1 = state[2], y2 = state[3];
+    for (int i = 0; i < numSamples; ++i)
+    {
+        double x = data[i];
+        double y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+        x2 = x1; x1 = x;
+        y2 = y1; y1 = y;
+        data[i] = static_cast<float>(y);
+    }
+    state[0] = x1; state[1] = x2; state[2] = y1; state[3] = y2;
+}
+
+double resampleLinear(const float* src, int srcLength, float* out, int numSamples,
+                      double position, double step)
+{
+    const int last = srcLength - 1;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        double pos = position + step * i;
+        int index = static_cast<int>(pos);
+        float frac = static_cast<float>(pos - index);
+        int i0 = index < 0 ? 0 : (index < last ? index : last);
+        int i1 = i0 < last ? i0 + 1 : last;
+        out[i] = src[i0] + frac * (src[i1] - src[i0]);
+    }
+    return position + step * numSamples;
+}
+
+const DspKernels table { sine, applyGain, addWithGain, pan, crossfade, biquad, resampleLinear };
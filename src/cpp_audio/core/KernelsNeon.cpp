@@ -0,0 +1,20 @@
+// ARM only. NEON is part of AArch64; 32-bit builds add -mfpu=neon (see
+// CMakeLists.txt) and Kernels.cpp checks the CPU has it before use.
+#include "Kernels.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+namespace kernels_neon
+{
+#include "KernelsImpl.h"
+}
+
+const DspKernels* getNeonKernels() noexcept
+{
+    return &kernels_neon::table;
+}
+#else
+const DspKernels* getNeonKernels() noexcept
+{
+    return nullptr;
+}
+#endif
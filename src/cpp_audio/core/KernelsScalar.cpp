@@ -0,0 +1,14 @@
+// Built with auto-vectorisation turned off (see CMakeLists.txt): the
+// baseline the other levels are measured against, and the fallback on any
+// CPU.
+#include "Kernels.h"
+
+namespace kernels_scalar
+{
+#include "KernelsImpl.h"
+}
+
+const DspKernels* getScalarKernels() noexcept
+{
+    return &kernels_scalar::table;
+}
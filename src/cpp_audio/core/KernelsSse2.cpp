@@ -0,0 +1,20 @@
+// x86 only. SSE2 is part of x86-64, so this is the compiler's default
+// vectorisation there; 32-bit builds add -msse2 (see CMakeLists.txt).
+#include "Kernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+namespace kernels_sse2
+{
+#include "KernelsImpl.h"
+}
+
+const DspKernels* getSse2Kernels() noexcept
+{
+    return &kernels_sse2::table;
+}
+#else
+const DspKernels* getSse2Kernels() noexcept
+{
+    return nullptr;
+}
+#endif
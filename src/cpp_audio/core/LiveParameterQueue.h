@@ -0,0 +1,55 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <vector>
+
+/** One parameter update for a running live voice. Parameter names are
+    resolved to indices on the sending side so the audio thread never
+    touches strings. */
+struct LiveParameterChange
+{
+    int voiceIndex = 0;
+    int parameterIndex = 0;
+    double value = 0.0;
+};
+
+/** Single-producer, single-consumer queue of parameter changes. The UI
+    thread pushes, the audio thread drains at the start of each block.
+    Neither side allocates or locks once constructed. */
+class LiveParameterQueue
+{
+public:
+    explicit LiveParameterQueue(int capacity = 256)
+        : fifo(capacity), slots(static_cast<size_t>(capacity)) {}
+
+    /** Returns false if the queue is full and the change was dropped. */
+    bool push(const LiveParameterChange& change)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(1, start1, size1, start2, size2);
+        if (size1 + size2 < 1)
+            return false;
+        slots[static_cast<size_t>(size1 > 0 ? start1 : start2)] = change;
+        fifo.finishedWrite(1);
+        return true;
+    }
+
+    /** Calls @p fn for every pending change, oldest first. */
+    template <typename Fn>
+    void drain(Fn&& fn)
+    {
+        int ready = fifo.getNumReady();
+        if (ready <= 0)
+            return;
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(ready, start1, size1, start2, size2);
+        for (int i = 0; i < size1; ++i)
+            fn(slots[static_cast<size_t>(start1 + i)]);
+        for (int i = 0; i < size2; ++i)
+            fn(slots[static_cast<size_t>(start2 + i)]);
+        fifo.finishedRead(size1 + size2);
+    }
+
+private:
+    juce::AbstractFifo fifo;
+    std::vector<LiveParameterChange> slots;
+};
@@ -0,0 +1,148 @@
+#include "LivePreviewSource.h"
+#include "RealtimeSafety.h"
+
+using namespace juce;
+
+namespace
+{
+    constexpr int scratchBlockSize = 512;
+}
+
+LivePreviewSource::LivePreviewSource(const Step& step, double sampleRate, double lengthSeconds)
+    : current(step),
+      scratch(2, scratchBlockSize),
+      totalLength(static_cast<int64>(lengthSeconds * sampleRate))
+{
+    double peak = 0.0;
+    for (const auto& v : step.voices)
+    {
+        if (auto voice = LiveVoice::create(v, sampleRate))
+        {
+            voices.push_back(std::move(voice));
+            peak += jmax((double) v.params.getWithDefault("ampL", 0.5),
+                         (double) v.params.getWithDefault("ampR", 0.5));
+        }
+    }
+    headroom = static_cast<float>(1.0 / jmax(1.0, peak));
+}
+
+bool LivePreviewSource::canPlay(const Step& step)
+{
+    if (step.voices.empty())
+        return false;
+    for (const auto& v : step.voices)
+        if (! LiveVoice::isSupported(v))
+            return false;
+    return true;
+}
+
+bool LivePreviewSource::hasSameStructure(const Step& step) const
+{
+    if (step.voices.size() != current.voices.size())
+        return false;
+    for (size_t i = 0; i < step.voices.size(); ++i)
+        if (step.voices[i].synthFunction != current.voices[i].synthFunction
+            || step.voices[i].isTransition != current.voices[i].isTransition)
+            return false;
+    return true;
+}
+
+bool LivePreviewSource::setParameter(int voiceIndex, const String& name, double value)
+{
+    if (! isPositiveAndBelow(voiceIndex, (int) voices.size()))
+        return false;
+    int index = voices[static_cast<size_t>(voiceIndex)]->findParameter(name);
+    if (index < 0)
+        return false;
+    if (! queue.push({ voiceIndex, index, value }))
+        return false;
+
+    // Keep current in step with what the voices play, so a later
+    // updateStep() back to the saved value is seen as a change.
+    current.voices[static_cast<size_t>(voiceIndex)].params.set(name, value);
+    return true;
+}
+
+bool LivePreviewSource::updateStep(const Step& step)
+{
+    if (! hasSameStructure(step))
+        return false;
+
+    // Work out every change first so nothing is sent for a step that turns
+    // out to need a rebuild.
+    std::vector<LiveParameterChange> changes;
+    for (size_t v = 0; v < step.voices.size(); ++v)
+    {
+        const auto& oldParams = current.voices[v].params;
+        const auto& newParams = step.voices[v].params;
+        const auto& voice = *voices[v];
+
+        for (const auto& p : oldParams)
+            if (! newParams.contains(p.name))
+                return false;
+
+        for (const auto& p : newParams)
+        {
+            const var* old = oldParams.getVarPointer(p.name);
+            if (old != nullptr && *old == p.value)
+                continue;
+            int index = voice.findParameter(p.name.toString());
+            if (index < 0)
+                return false;
+            changes.push_back({ (int) v, index, (double) p.value });
+        }
+    }
+
+    for (const auto& c : changes)
+        if (! queue.push(c))
+            return false;
+
+    current = step;
+    return true;
+}
+
+void LivePreviewSource::getNextAudioBlock(const AudioSourceChannelInfo& info)
+{
+    REALTIME_SECTION();
+    queue.drain([this](const LiveParameterChange& c)
+    {
+        if (isPositiveAndBelow(c.voiceIndex, (int) voices.size()))
+            voices[static_cast<size_t>(c.voiceIndex)]->setParameter(c.parameterIndex, c.value);
+    });
+
+    int64 pos = position.load();
+    bool loop = looping.load();
+    int toPlay = info.numSamples;
+    if (! loop)
+        toPlay = (int) jlimit<int64>(0, info.numSamples, totalLength - pos);
+
+    auto* out = info.buffer;
+    int numChannels = out->getNumChannels();
+    for (int done = 0; done < toPlay;)
+    {
+        int n = jmin(scratchBlockSize, toPlay - done);
+        scratch.clear(0, n);
+        float* left = scratch.getWritePointer(0);
+        float* right = scratch.getWritePointer(1);
+        for (auto& voice : voices)
+            voice->process(left, right, n);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            float* dest = out->getWritePointer(ch, info.startSample + done);
+            FloatVectorOperations::copyWithMultiply(dest, scratch.getReadPointer(ch % 2), headroom, n);
+            FloatVectorOperations::clip(dest, dest, -1.0f, 1.0f, n);
+        }
+        done += n;
+    }
+
+    if (toPlay < info.numSamples)
+        out->clear(info.startSample + toPlay, info.numSamples - toPlay);
+
+    pos += info.numSamples;
+    if (loop && totalLength > 0)
+        pos %= totalLength;
+    else
+        pos = jmin(pos, totalLength);
+    position.store(pos);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "LiveParameterQueue.h"
+#include "LiveVoice.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/** Plays a step by running its voices live instead of rendering them, so
+    parameter edits are heard on the next audio block. Only steps whose
+    voices are all supported by LiveVoice can be played this way.
+
+    Parameter changes go through a lock-free queue and are applied with a
+    short glide. Seeking moves the transport position only; the voices keep
+    running. The step's peak normalisation is replaced by a fixed headroom
+    gain chosen at load time and a hard limit at full scale.
+*/
+class LivePreviewSource : public juce::PositionableAudioSource
+{
+public:
+    LivePreviewSource(const Step& step, double sampleRate, double lengthSeconds);
+
+    static bool canPlay(const Step& step);
+
+    /** True if @p step has the same voices, in the same order, as the one
+        being played, so it can be reached by parameter changes alone. */
+    bool hasSameStructure(const Step& step) const;
+
+    /** Message thread. Queues a change and records it in the current step;
+        false if the voice or parameter is not live or the queue is full. */
+    bool setParameter(int voiceIndex, const juce::String& name, double value);
+
+    /** Message thread. Queues every live parameter that differs between the
+        step being played and @p step, and remembers @p step as current.
+        False if the structure differs or a changed parameter is not live. */
+    bool updateStep(const Step& step);
+
+    void prepareToPlay(int, double) override {}
+    void releaseResources() override {}
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& info) override;
+
+    void setNextReadPosition(juce::int64 newPosition) override { position.store(newPosition); }
+    juce::int64 getNextReadPosition() const override { return position.load(); }
+    juce::int64 getTotalLength() const override { return totalLength; }
+    bool isLooping() const override { return looping.load(); }
+    void setLooping(bool shouldLoop) override { looping.store(shouldLoop); }
+
+private:
+    Step current;
+    std::vector<std::unique_ptr<LiveVoice>> voices;
+    LiveParameterQueue queue;
+    juce::AudioBuffer<float> scratch;
+    float headroom = 1.0f;
+    juce::int64 totalLength;
+    std::atomic<juce::int64> position { 0 };
+    std::atomic<bool> looping { false };
+};
@@ -0,0 +1,148 @@
+#include "LiveVoice.h"
+
+using namespace juce;
+
+namespace
+{
+    constexpr double twoPi = MathConstants<double>::twoPi;
+
+    const char* const binauralNames[] = {
+        "ampL", "ampR", "baseFreq", "beatFreq",
+        "ampOscDepthL", "ampOscFreqL", "ampOscDepthR", "ampOscFreqR",
+        "ampOscPhaseOffsetL", "ampOscPhaseOffsetR",
+        "freqOscRangeL", "freqOscFreqL", "freqOscRangeR", "freqOscFreqR",
+        "phaseOscFreq", "phaseOscRange",
+        "freqOscPhaseOffsetL", "freqOscPhaseOffsetR", "phaseOscPhaseOffset"
+    };
+
+    // Same defaults as binauralBeat().
+    const double binauralDefaults[] = {
+        0.5, 0.5, 200.0, 4.0,
+        0.0, 0.0, 0.0, 0.0,
+        0.0, 0.0,
+        0.0, 0.0, 0.0, 0.0,
+        0.0, 0.0,
+        0.0, 0.0, 0.0
+    };
+
+    static_assert(sizeof(binauralNames) / sizeof(binauralNames[0]) == LiveBinauralVoice::numParameters,
+                  "binaural parameter names out of sync");
+    static_assert(sizeof(binauralDefaults) / sizeof(binauralDefaults[0]) == LiveBinauralVoice::numParameters,
+                  "binaural parameter defaults out of sync");
+}
+
+//==============================================================================
+bool LiveVoice::isSupported(const Voice& voice)
+{
+    return voice.synthFunction == "binaural_beat";
+}
+
+std::unique_ptr<LiveVoice> LiveVoice::create(const Voice& voice, double sampleRate)
+{
+    if (! isSupported(voice))
+        return nullptr;
+    return std::make_unique<LiveBinauralVoice>(sampleRate, voice.params);
+}
+
+LiveVoice::LiveVoice(double sr, const char* const* names, const double* defaults,
+                     int numParameters, const NamedValueSet& params)
+    : sampleRate(sr), parameterNames(names), values(static_cast<size_t>(numParameters))
+{
+    for (int i = 0; i < numParameters; ++i)
+    {
+        auto& v = values[static_cast<size_t>(i)];
+        v.reset(sampleRate, smoothingSeconds);
+        v.setCurrentAndTargetValue(params.getWithDefault(names[i], defaults[i]));
+    }
+}
+
+int LiveVoice::findParameter(const String& name) const
+{
+    for (int i = 0; i < getNumParameters(); ++i)
+        if (name == parameterNames[i])
+            return i;
+    return -1;
+}
+
+void LiveVoice::setParameter(int index, double value) noexcept
+{
+    if (isPositiveAndBelow(index, getNumParameters()))
+        values[static_cast<size_t>(index)].setTargetValue(value);
+}
+
+void LiveVoice::setParameterImmediately(int index, double value) noexcept
+{
+    if (isPositiveAndBelow(index, getNumParameters()))
+        values[static_cast<size_t>(index)].setCurrentAndTargetValue(value);
+}
+
+double LiveVoice::getParameter(int index) const noexcept
+{
+    return isPositiveAndBelow(index, getNumParameters())
+        ? values[static_cast<size_t>(index)].getTargetValue() : 0.0;
+}
+
+//==============================================================================
+LiveBinauralVoice::LiveBinauralVoice(double sr, const NamedValueSet& params)
+    : LiveVoice(sr, binauralNames, binauralDefaults, numParameters, params),
+      forceMono(params.getWithDefault("forceMono", false)),
+      glitches(params.getWithDefault("glitchInterval", 0.0), params.getWithDefault("glitchDur", 0.0),
+               params.getWithDefault("glitchNoiseLevel", 0.0), params.getWithDefault("baseFreq", 200.0),
+               params.getWithDefault("glitchFocusWidth", 0.0), sr, -1,
+               static_cast<int64>(params.getWithDefault("glitchSeed", 1)))
+{
+    osc.carrierL = params.getWithDefault("startPhaseL", 0.0);
+    osc.carrierR = params.getWithDefault("startPhaseR", 0.0);
+}
+
+void LiveBinauralVoice::process(float* left, float* right, int numSamples) noexcept
+{
+    const double dt = 1.0 / sampleRate;
+    BinauralOscillator::Settings settings;
+    settings.forceMono = forceMono;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        settings.ampL = nextValue(ampL);
+        settings.ampR = nextValue(ampR);
+        settings.baseFreq = nextValue(baseFreq);
+        settings.beatFreq = nextValue(beatFreq);
+        settings.ampOscDepthL = nextValue(ampOscDepthL);
+        double aOFL = nextValue(ampOscFreqL);
+        settings.ampOscDepthR = nextValue(ampOscDepthR);
+        double aOFR = nextValue(ampOscFreqR);
+        double aOPL = nextValue(ampOscPhaseOffsetL);
+        double aOPR = nextValue(ampOscPhaseOffsetR);
+        settings.freqOscRangeL = nextValue(freqOscRangeL);
+        double fOFL = nextValue(freqOscFreqL);
+        settings.freqOscRangeR = nextValue(freqOscRangeR);
+        double fOFR = nextValue(freqOscFreqR);
+        double pOF = nextValue(phaseOscFreq);
+        settings.phaseOscRange = nextValue(phaseOscRange);
+        double fOPL = nextValue(freqOscPhaseOffsetL);
+        double fOPR = nextValue(freqOscPhaseOffsetR);
+        double pOP = nextValue(phaseOscPhaseOffset);
+
+        // binauralBeat() evaluates every oscillator at t[i] before advancing.
+        BinauralOscillator::Lfos lfo;
+        lfo.freqOscL = vibratoL + fOPL;
+        lfo.freqOscR = vibratoR + fOPR;
+        lfo.ampOscL = ampOscL + aOPL;
+        lfo.ampOscR = ampOscR + aOPR;
+        lfo.phaseOsc = phaseOsc + pOP;
+
+        float l, r;
+        osc.process(settings, lfo, dt, l, r);
+        left[i] += l;
+        right[i] += r;
+
+        vibratoL = BinauralOscillator::wrapPhase(vibratoL + twoPi * fOFL * dt);
+        vibratoR = BinauralOscillator::wrapPhase(vibratoR + twoPi * fOFR * dt);
+        ampOscL = BinauralOscillator::wrapPhase(ampOscL + twoPi * aOFL * dt);
+        ampOscR = BinauralOscillator::wrapPhase(ampOscR + twoPi * aOFR * dt);
+        phaseOsc = BinauralOscillator::wrapPhase(phaseOsc + twoPi * pOF * dt);
+    }
+
+    if (glitches.isActive())
+        glitches.process(left, right, numSamples);
+}
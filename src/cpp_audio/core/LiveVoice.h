@@ -0,0 +1,88 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "../models/TrackData.h"
+#include "BinauralOscillator.h"
+#include "GlitchScheduler.h"
+#include <memory>
+#include <vector>
+
+/** A running synth voice that renders block by block and accepts
+    parameter changes while it plays. Each parameter glides to a new value
+    over a short ramp so edits do not click.
+
+    Only parameters that can change smoothly are live. Anything else
+    (synth type, forceMono, glitch settings, envelopes) needs the voice to
+    be rebuilt; findParameter() returns -1 for those.
+*/
+class LiveVoice
+{
+public:
+    virtual ~LiveVoice() = default;
+
+    /** Builds a live voice for @p voice, or returns nullptr if its synth,
+        or the way it is configured, is not supported. */
+    static std::unique_ptr<LiveVoice> create(const Voice& voice, double sampleRate);
+    static bool isSupported(const Voice& voice);
+
+    /** Message thread. Index of a live parameter, or -1. */
+    int findParameter(const juce::String& name) const;
+    int getNumParameters() const noexcept { return static_cast<int>(values.size()); }
+
+    /** Audio thread. Starts a glide to @p value. */
+    void setParameter(int index, double value) noexcept;
+    /** Jumps to @p value without a glide. */
+    void setParameterImmediately(int index, double value) noexcept;
+    double getParameter(int index) const noexcept;
+
+    /** Adds the next @p numSamples to @p left and @p right. */
+    virtual void process(float* left, float* right, int numSamples) noexcept = 0;
+
+    /** Seconds over which a parameter change is ramped. */
+    static constexpr double smoothingSeconds = 0.05;
+
+protected:
+    LiveVoice(double sampleRate, const char* const* names, const double* defaults,
+              int numParameters, const juce::NamedValueSet& params);
+
+    double nextValue(int index) noexcept { return values[static_cast<size_t>(index)].getNextValue(); }
+
+    double sampleRate;
+
+private:
+    const char* const* parameterNames;
+    std::vector<juce::SmoothedValue<double>> values;
+};
+
+/** Live counterpart of binauralBeat(), rendering through the same
+    BinauralOscillator, with every LFO kept as a running phase so
+    frequencies can change without a jump. Glitch bursts carry on
+    for as long as the voice plays. Their band-pass stays centred on the
+    baseFreq the voice was built with: retuning it means new filter
+    coefficients, which cannot be made on the audio thread, so a baseFreq
+    edit moves the tone but not the bursts until the voice is rebuilt. */
+class LiveBinauralVoice : public LiveVoice
+{
+public:
+    enum Parameter
+    {
+        ampL, ampR, baseFreq, beatFreq,
+        ampOscDepthL, ampOscFreqL, ampOscDepthR, ampOscFreqR,
+        ampOscPhaseOffsetL, ampOscPhaseOffsetR,
+        freqOscRangeL, freqOscFreqL, freqOscRangeR, freqOscFreqR,
+        phaseOscFreq, phaseOscRange,
+        freqOscPhaseOffsetL, freqOscPhaseOffsetR, phaseOscPhaseOffset,
+        numParameters
+    };
+
+    LiveBinauralVoice(double sampleRate, const juce::NamedValueSet& params);
+
+    void process(float* left, float* right, int numSamples) noexcept override;
+
+private:
+    bool forceMono;
+    BinauralOscillator osc;
+    double ampOscL = 0.0, ampOscR = 0.0;
+    double vibratoL = 0.0, vibratoR = 0.0;
+    double phaseOsc = 0.0;
+    GlitchScheduler glitches;
+};
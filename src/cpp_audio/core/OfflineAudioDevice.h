@@ -0,0 +1,123 @@
+#pragma once
+#include <juce_audio_devices/juce_audio_devices.h>
+#include "RealtimeSafety.h"
+#include <thread>
+#include <vector>
+
+/** An AudioIODevice with no hardware behind it. Callbacks are issued from
+    processBlocks() on the calling thread, either as fast as possible or
+    paced against the wall clock, and each one runs inside an armed
+    ScopedRealtimeSection. Used by the diagnostic tools to drive audio
+    callbacks without a sound card. */
+class OfflineAudioDevice : public juce::AudioIODevice
+{
+public:
+    OfflineAudioDevice(double sr = 44100.0, int blockSize = 512, int numOutputs = 2)
+        : juce::AudioIODevice("Offline", "Offline"),
+          sampleRate(sr), bufferSize(blockSize), outputs(numOutputs)
+    {
+        output.setSize(outputs, bufferSize);
+        channelPointers.resize(static_cast<size_t>(outputs));
+        for (int ch = 0; ch < outputs; ++ch)
+            channelPointers[static_cast<size_t>(ch)] = output.getWritePointer(ch);
+    }
+
+    ~OfflineAudioDevice() override { close(); }
+
+    juce::StringArray getOutputChannelNames() override
+    {
+        juce::StringArray names;
+        for (int ch = 0; ch < outputs; ++ch)
+            names.add("Output " + juce::String(ch + 1));
+        return names;
+    }
+
+    juce::StringArray getInputChannelNames() override { return {}; }
+    juce::Array<double> getAvailableSampleRates() override { return { sampleRate }; }
+    juce::Array<int> getAvailableBufferSizes() override { return { bufferSize }; }
+    int getDefaultBufferSize() override { return bufferSize; }
+
+    juce::String open(const juce::BigInteger&, const juce::BigInteger&, double, int) override
+    {
+        opened = true;
+        return {};
+    }
+
+    void close() override
+    {
+        stop();
+        opened = false;
+    }
+
+    bool isOpen() override { return opened; }
+
+    void start(juce::AudioIODeviceCallback* cb) override
+    {
+        if (cb == nullptr || cb == callback)
+            return;
+        stop();
+        cb->audioDeviceAboutToStart(this);
+        callback = cb;
+    }
+
+    void stop() override
+    {
+        if (auto* cb = callback)
+        {
+            callback = nullptr;
+            cb->audioDeviceStopped();
+        }
+    }
+
+    bool isPlaying() override { return callback != nullptr; }
+    juce::String getLastError() override { return {}; }
+    int getCurrentBufferSizeSamples() override { return bufferSize; }
+    double getCurrentSampleRate() override { return sampleRate; }
+    int getCurrentBitDepth() override { return 32; }
+
+    juce::BigInteger getActiveOutputChannels() const override
+    {
+        juce::BigInteger channels;
+        channels.setRange(0, outputs, true);
+        return channels;
+    }
+
+    juce::BigInteger getActiveInputChannels() const override { return {}; }
+    int getOutputLatencyInSamples() override { return 0; }
+    int getInputLatencyInSamples() override { return 0; }
+
+    /** Issues @p numBlocks callbacks. With @p speed > 0 each block is
+        delivered no earlier than its due time at speed x realtime; with
+        speed <= 0 the blocks run back to back. */
+    void processBlocks(int numBlocks, double speed = 0.0)
+    {
+        const double blockMs = 1000.0 * bufferSize / sampleRate;
+        const double startMs = juce::Time::getMillisecondCounterHiRes();
+
+        for (int b = 0; b < numBlocks && callback != nullptr; ++b)
+        {
+            if (speed > 0.0)
+            {
+                double dueMs = startMs + b * blockMs / speed;
+                double waitMs = dueMs - juce::Time::getMillisecondCounterHiRes();
+                if (waitMs > 0.0)
+                    std::this_thread::sleep_for(std::chrono::microseconds(static_cast<long long>(waitMs * 1000.0)));
+            }
+
+            ScopedRealtimeSection section;
+            callback->audioDeviceIOCallback(nullptr, 0, channelPointers.data(), outputs, bufferSize);
+        }
+    }
+
+    /** Output of the most recent callback. */
+    const juce::AudioBuffer<float>& getLastOutput() const { return output; }
+
+private:
+    double sampleRate;
+    int bufferSize;
+    int outputs;
+    bool opened = false;
+    juce::AudioIODeviceCallback* callback = nullptr;
+    juce::AudioBuffer<float> output;
+    std::vector<float*> channelPointers;
+};
@@ -0,0 +1,56 @@
+#include "OversampledTanh.h"
+#include "FastMath.h"
+#include "RenderQuality.h"
+
+using namespace juce;
+
+OversampledTanh::OversampledTanh(int factor)
+{
+    int stages = factor >= 8 ? 3 : factor >= 4 ? 2 : factor >= 2 ? 1 : 0;
+    if (stages == 0)
+        return;
+
+    oversampling = std::make_unique<dsp::Oversampling<double>>(
+        1, (size_t) stages, dsp::Oversampling<double>::filterHalfBandPolyphaseIIR, true, true);
+    oversampling->initProcessing((size_t) maxBlockSize);
+    latency = roundToInt(oversampling->getLatencyInSamples());
+    delayL.assign((size_t) latency, 0.0f);
+    delayR.assign((size_t) latency, 0.0f);
+}
+
+int OversampledTanh::getFactor(const NamedValueSet& params)
+{
+    auto quality = getRenderQuality(params);
+    if (quality == RenderQuality::draft)
+        return 1;
+    int fallback = quality == RenderQuality::master ? 4 : 1;
+    return jlimit(1, 8, (int) params.getWithDefault("oversampleFactor", fallback));
+}
+
+void OversampledTanh::process(double* data, float* gainL, float* gainR, int numSamples)
+{
+    jassert(numSamples <= maxBlockSize);
+
+    if (oversampling == nullptr)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            data[i] = fastmath::tanh(data[i]);
+        return;
+    }
+
+    dsp::AudioBlock<double> block(&data, 1, (size_t) numSamples);
+    auto up = oversampling->processSamplesUp(block);
+    double* high = up.getChannelPointer(0);
+    for (size_t i = 0; i < up.getNumSamples(); ++i)
+        high[i] = fastmath::tanh(high[i]);
+    oversampling->processSamplesDown(block);
+
+    if (latency == 0)
+        return;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        std::swap(gainL[i], delayL[(size_t) delayPos]);
+        std::swap(gainR[i], delayR[(size_t) delayPos]);
+        delayPos = (delayPos + 1) % latency;
+    }
+}
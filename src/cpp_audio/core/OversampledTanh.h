@@ -0,0 +1,44 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <juce_dsp/juce_dsp.h>
+#include <memory>
+#include <vector>
+
+/** tanh waveshaping run at 2, 4 or 8 times the sample rate, so the
+    harmonics a strong drive adds above Nyquist are filtered out instead of
+    folding back. Only the nonlinearity is oversampled; the signal feeding
+    it is generated at the base rate and must itself be band-limited.
+
+    The up/down filters are JUCE's polyphase IIR half-bands, which delay the
+    output by getLatency() samples. Per-sample gains that belong to the
+    shaped signal are passed through process() and delayed to match, so a
+    caller only has to run getLatency() samples past the end and discard
+    the first getLatency() outputs.
+*/
+class OversampledTanh
+{
+public:
+    /** Largest block process() accepts. */
+    static constexpr int maxBlockSize = 512;
+
+    /** @p factor is 1, 2, 4 or 8; 1 shapes at the base rate with no delay. */
+    explicit OversampledTanh(int factor);
+
+    /** The factor a waveshaping voice asked for: "oversampleFactor" if set,
+        otherwise 4 at master quality and 1 below it. Draft renders always
+        use 1. */
+    static int getFactor(const juce::NamedValueSet& params);
+
+    int getLatency() const noexcept { return latency; }
+
+    /** Replaces each of @p numSamples values in @p data with tanh of it, and
+        delays @p gainL and @p gainR by the same latency so they still line
+        up with the shaped values. */
+    void process(double* data, float* gainL, float* gainR, int numSamples);
+
+private:
+    std::unique_ptr<juce::dsp::Oversampling<double>> oversampling;
+    int latency = 0;
+    std::vector<float> delayL, delayR;
+    int delayPos = 0;
+};
@@ -0,0 +1,75 @@
+#include "PartitionedConvolver.h"
+#include <algorithm>
+
+using namespace juce;
+
+namespace
+{
+constexpr int log2Of(int n) { return n <= 1 ? 0 : 1 + log2Of(n / 2); }
+}
+
+PartitionedConvolver::PartitionedConvolver(const float* impulseResponse, int length)
+    : fft(log2Of(fftSize)),
+      numPartitions(jmax(1, (length + blockSize - 1) / blockSize)),
+      partitions(static_cast<size_t>(numPartitions * numBins)),
+      inputSpectra(partitions.size()),
+      inputHistory(static_cast<size_t>(fftSize), 0.0f),
+      scratch(static_cast<size_t>(fftSize * 2), 0.0f),
+      accumulator(static_cast<size_t>(numBins))
+{
+    // Each partition is zero padded to fftSize, so the last blockSize
+    // outputs of each circular convolution are the linear result.
+    for (int p = 0; p < numPartitions; ++p)
+    {
+        std::fill(scratch.begin(), scratch.end(), 0.0f);
+        int count = jlimit(0, blockSize, length - p * blockSize);
+        std::copy(impulseResponse + p * blockSize, impulseResponse + p * blockSize + count, scratch.begin());
+        fft.performRealOnlyForwardTransform(scratch.data(), true);
+        auto* bins = reinterpret_cast<const std::complex<float>*>(scratch.data());
+        std::copy(bins, bins + numBins, partitions.begin() + p * numBins);
+    }
+}
+
+void PartitionedConvolver::process(float* data, int numSamples)
+{
+    int done = 0;
+    for (; done + blockSize <= numSamples; done += blockSize)
+        processBlock(data + done);
+
+    if (done < numSamples)
+    {
+        float block[blockSize] {};
+        std::copy(data + done, data + numSamples, block);
+        processBlock(block);
+        std::copy(block, block + (numSamples - done), data + done);
+    }
+}
+
+void PartitionedConvolver::processBlock(float* block)
+{
+    std::copy(inputHistory.begin() + blockSize, inputHistory.end(), inputHistory.begin());
+    std::copy(block, block + blockSize, inputHistory.begin() + blockSize);
+
+    std::fill(scratch.begin(), scratch.end(), 0.0f);
+    std::copy(inputHistory.begin(), inputHistory.end(), scratch.begin());
+    fft.performRealOnlyForwardTransform(scratch.data(), true);
+
+    newestSpectrum = (newestSpectrum + numPartitions - 1) % numPartitions;
+    auto* bins = reinterpret_cast<const std::complex<float>*>(scratch.data());
+    std::copy(bins, bins + numBins, inputSpectra.begin() + newestSpectrum * numBins);
+
+    // Partition p meets the input spectrum from p blocks ago.
+    std::fill(accumulator.begin(), accumulator.end(), std::complex<float>());
+    for (int p = 0; p < numPartitions; ++p)
+    {
+        const auto* x = inputSpectra.data() + ((newestSpectrum + p) % numPartitions) * numBins;
+        const auto* h = partitions.data() + p * numBins;
+        for (int k = 0; k < numBins; ++k)
+            accumulator[static_cast<size_t>(k)] += x[k] * h[k];
+    }
+
+    std::fill(scratch.begin(), scratch.end(), 0.0f);
+    std::copy(accumulator.begin(), accumulator.end(), reinterpret_cast<std::complex<float>*>(scratch.data()));
+    fft.performRealOnlyInverseTransform(scratch.data());
+    std::copy(scratch.begin() + blockSize, scratch.begin() + fftSize, block);
+}
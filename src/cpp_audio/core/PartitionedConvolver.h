@@ -0,0 +1,38 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+#include <complex>
+#include <vector>
+
+/** Convolves one channel with a short impulse response by uniformly
+    partitioned overlap-save FFT convolution: the response is cut into
+    blockSize partitions whose spectra are multiplied with a frequency-domain
+    delay line of past input blocks. Each block costs one forward and one
+    inverse FFT of twice blockSize, whatever the response length, and the
+    output is not delayed.
+*/
+class PartitionedConvolver
+{
+public:
+    static constexpr int blockSize = 128;
+
+    PartitionedConvolver(const float* impulseResponse, int length);
+
+    /** Convolves @p data in place. Calls may be any length; a partial final
+        block is zero padded, so only the last call may be partial. */
+    void process(float* data, int numSamples);
+
+private:
+    void processBlock(float* block);
+
+    static constexpr int fftSize = blockSize * 2;
+    static constexpr int numBins = fftSize / 2 + 1;
+
+    juce::dsp::FFT fft;
+    int numPartitions;
+    std::vector<std::complex<float>> partitions;     // numPartitions * numBins
+    std::vector<std::complex<float>> inputSpectra;   // the same, as a ring
+    int newestSpectrum = 0;
+    std::vector<float> inputHistory;                 // the last fftSize input samples
+    std::vector<float> scratch;                      // fftSize * 2, for the FFT
+    std::vector<std::complex<float>> accumulator;
+};
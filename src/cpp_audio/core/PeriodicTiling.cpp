@@ -0,0 +1,269 @@
+#include "PeriodicTiling.h"
+#include "Trace.h"
+#include "Track.h"
+#include <cmath>
+#include <numeric>
+#include <set>
+
+namespace
+{
+    constexpr juce::int64 maxDenominator = 1000;
+    constexpr double rationalTolerance = 1.0e-9;
+    constexpr float repeatTolerance = 1.0e-4f;
+
+    /** Synths with a random or file-driven component. */
+    bool isDeterministicSynth(const std::string& name)
+    {
+        return name != "generate_swept_notch_pink_sound" && name != "subliminal_encode";
+    }
+
+    bool isFrequencyParam(const juce::String& name)
+    {
+        return name.containsIgnoreCase("freq") || name.containsIgnoreCase("hz")
+               || name == "sidebandOffset";
+    }
+
+    /** Parameters that make the output depend on position within the step. */
+    bool breaksPeriodicity(const juce::String& name, const juce::var& value)
+    {
+        if (name.containsIgnoreCase("audio_path"))
+            return true;
+        if (name.containsIgnoreCase("attack") || name.containsIgnoreCase("release")
+            || name.containsIgnoreCase("glitch") || name.containsIgnoreCase("fade"))
+            return static_cast<double>(value) != 0.0;
+        return false;
+    }
+
+    /** Approximates @p x by p/q with q <= maxDenominator (continued fractions).
+        @return false if no such fraction is within tolerance. */
+    bool toRational(double x, juce::int64& p, juce::int64& q)
+    {
+        juce::int64 p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+        double r = x;
+        for (int iter = 0; iter < 32; ++iter)
+        {
+            double a = std::floor(r);
+            juce::int64 ai = static_cast<juce::int64>(a);
+            juce::int64 p2 = ai * p1 + p0;
+            juce::int64 q2 = ai * q1 + q0;
+            if (q2 > maxDenominator)
+                return false;
+            p0 = p1; q0 = q1; p1 = p2; q1 = q2;
+            if (std::abs(x - static_cast<double>(p1) / static_cast<double>(q1))
+                <= rationalTolerance * std::max(1.0, x))
+            {
+                p = p1;
+                q = q1;
+                return true;
+            }
+            double frac = r - a;
+            if (frac < 1.0e-12)
+                return false;
+            r = 1.0 / frac;
+        }
+        return false;
+    }
+
+    /** Smallest sample count after which a sinusoid of @p freq returns to
+        the same phase, or 0 if there is none within @p limit. */
+    juce::int64 periodOfFrequency(double freq, juce::int64 sampleRate, juce::int64 limit)
+    {
+        juce::int64 p, q;
+        if (! toRational(freq, p, q))
+            return 0;
+        // freq / sampleRate = p / (q * sampleRate); whole cycles every
+        // q * sampleRate / gcd(p, q * sampleRate) samples.
+        juce::int64 denom = q * sampleRate;
+        juce::int64 period = denom / std::gcd(p, denom);
+        return period <= limit ? period : 0;
+    }
+
+    /** Loop length shared by every frequency of @p voice, or 0. */
+    juce::int64 voicePeriodSamples(const Voice& voice, juce::int64 sampleRate, juce::int64 limit)
+    {
+        if (voice.isTransition || juce::String(voice.synthFunction).endsWith("_transition")
+            || ! isDeterministicSynth(voice.synthFunction)
+            || findSynthFunction(voice.synthFunction) == nullptr)
+            return 0;
+
+        std::vector<double> freqs;
+        for (const auto& p : voice.params)
+        {
+            juce::String name = p.name.toString();
+            if (breaksPeriodicity(name, p.value))
+                return 0;
+            if (isFrequencyParam(name) && (p.value.isDouble() || p.value.isInt() || p.value.isInt64()))
+                freqs.push_back(std::abs(static_cast<double>(p.value)));
+        }
+
+        // Carriers are usually derived as base +/- beat / 2, and harmonics
+        // as base * ratio, so include those combinations too.
+        std::vector<double> derived;
+        for (double f : freqs)
+            derived.push_back(f * 0.5);
+        for (const auto& p : voice.params)
+            if (p.name.toString().containsIgnoreCase("ratio"))
+                for (double f : freqs)
+                    derived.push_back(f * static_cast<double>(p.value));
+        freqs.insert(freqs.end(), derived.begin(), derived.end());
+
+        juce::int64 period = 1;
+        for (double f : freqs)
+        {
+            if (f == 0.0)
+                continue;
+            juce::int64 fp = periodOfFrequency(f, sampleRate, limit);
+            if (fp == 0)
+                return 0;
+            period = period / std::gcd(period, fp) * fp;
+            if (period > limit)
+                return 0;
+        }
+        return period;
+    }
+
+    bool repeats(const juce::AudioBuffer<float>& buffer, int period)
+    {
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            const float* d = buffer.getReadPointer(ch);
+            for (int i = 0; i < period; ++i)
+                if (std::abs(d[i] - d[i + period]) > repeatTolerance)
+                    return false;
+        }
+        return true;
+    }
+}
+
+int findStepPeriodSamples(const Step& step, double sampleRate, double maxPeriodSeconds)
+{
+    auto rate = static_cast<juce::int64>(sampleRate);
+    if (step.voices.empty() || static_cast<double>(rate) != sampleRate)
+        return 0;
+
+    // Tiling only pays off when the step holds at least two loops.
+    auto stepSamples = static_cast<juce::int64>(step.durationSeconds * sampleRate);
+    juce::int64 limit = std::min(static_cast<juce::int64>(maxPeriodSeconds * sampleRate), stepSamples / 2);
+
+    juce::int64 period = 1;
+    for (const auto& voice : step.voices)
+    {
+        juce::int64 vp = voicePeriodSamples(voice, rate, limit);
+        if (vp == 0)
+            return 0;
+        period = period / std::gcd(period, vp) * vp;
+        if (period > limit)
+            return 0;
+    }
+    return static_cast<int>(period);
+}
+
+bool renderStepLoop(const Step& step, double sampleRate, juce::AudioBuffer<float>& loop,
+                    RenderQuality quality, double maxPeriodSeconds)
+{
+    loop.setSize(0, 0);
+    int period = findStepPeriodSamples(step, sampleRate, maxPeriodSeconds);
+    if (period == 0)
+        return false;
+
+    TRACE_SCOPE("renderStepLoop");
+    juce::AudioBuffer<float> mix(2, period);
+    mix.clear();
+    // Synths step time by duration / N, so the duration has to land on
+    // exactly 2 * period samples for the loop to keep the sample rate.
+    double twoPeriods = 2.0 * period / sampleRate;
+    if (static_cast<int>(twoPeriods * sampleRate) < 2 * period)
+        twoPeriods = std::nextafter(twoPeriods, 2.0 * twoPeriods);
+
+    for (const auto& voice : step.voices)
+    {
+        SynthFunc fn = findSynthFunction(voice.synthFunction);
+        juce::NamedValueSet params = voice.params;
+        if (quality != RenderQuality::normal)
+            params.set(renderQualityParam, getRenderQualityName(quality));
+        juce::AudioBuffer<float> voiceBuf = fn(twoPeriods, sampleRate, params);
+        if (voiceBuf.getNumSamples() < 2 * period || ! repeats(voiceBuf, period))
+            return false;
+        for (int ch = 0; ch < 2; ++ch)
+            mix.addFrom(ch, 0, voiceBuf, ch % voiceBuf.getNumChannels(), 0, period);
+    }
+
+    float peak = 0.0f;
+    for (int ch = 0; ch < mix.getNumChannels(); ++ch)
+        peak = std::max(peak, mix.getMagnitude(ch, 0, period));
+    if (peak > 1.0f)
+        mix.applyGain(1.0f / peak);
+
+    loop = std::move(mix);
+    return true;
+}
+
+bool isStepDurationIndependent(const Step& step)
+{
+    // Synths whose sample at time t depends only on t and the params: no
+    // random numbers and nothing scaled by the step length. The spatial
+    // synths sweep their arc over the whole step, the noise synths are
+    // unseeded, and subliminal_encode places its segments by duration.
+    static const std::set<std::string> prefixSafe {
+        "binaural_beat", "hybrid_qam_monaural_beat", "isochronic_tone",
+        "monaural_beat_stereo_amps", "qam_beat", "rhythmic_waveshaping",
+        "stereo_am_independent", "wave_shape_stereo_am"
+    };
+
+    for (const auto& voice : step.voices)
+    {
+        if (voice.isTransition || prefixSafe.count(voice.synthFunction) == 0)
+            return false;
+
+        for (const auto& p : voice.params)
+        {
+            juce::String name = p.name.toString();
+            if ((name.containsIgnoreCase("release") || name.containsIgnoreCase("fade"))
+                && static_cast<double>(p.value) != 0.0)
+                return false;
+        }
+    }
+    return true;
+}
+
+double getPrefixDuration(const Step& step, double sampleRate, juce::int64 samples)
+{
+    const auto stepSamples = static_cast<juce::int64>(step.durationSeconds * sampleRate);
+    if (samples >= stepSamples || stepSamples <= 0)
+        return step.durationSeconds;
+
+    double seconds = static_cast<double>(samples) * step.durationSeconds / static_cast<double>(stepSamples);
+    // Rounding can leave the product a hair under a whole sample.
+    while (static_cast<juce::int64>(seconds * sampleRate) < samples)
+        seconds = std::nextafter(seconds, step.durationSeconds);
+    return seconds;
+}
+
+Step getStepPrefix(const Step& step, double sampleRate, juce::int64 samples)
+{
+    Step prefix = step;
+    prefix.durationSeconds = getPrefixDuration(step, sampleRate, samples);
+    for (auto& voice : prefix.voices)
+        if (voice.synthFunction == "binaural_beat" && ! voice.params.contains("glitchEndSeconds"))
+            voice.params.set("glitchEndSeconds", step.durationSeconds);
+    return prefix;
+}
+
+void tileLoop(const juce::AudioBuffer<float>& loop, juce::int64 loopOffset,
+              juce::AudioBuffer<float>& dest, int destStart, int numSamples)
+{
+    const int loopLength = loop.getNumSamples();
+    if (loopLength == 0)
+        return;
+
+    int pos = static_cast<int>(loopOffset % loopLength);
+    int written = 0;
+    while (written < numSamples)
+    {
+        int chunk = std::min(loopLength - pos, numSamples - written);
+        for (int ch = 0; ch < dest.getNumChannels(); ++ch)
+            dest.copyFrom(ch, destStart + written, loop, ch % loop.getNumChannels(), pos, chunk);
+        written += chunk;
+        pos = 0;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "../models/TrackData.h"
+#include "RenderQuality.h"
+
+/** Steady "hold" steps whose voices are exactly periodic are rendered once
+    per period and tiled instead of being synthesised for their full length.
+
+    A voice is a candidate when it is not a transition, uses a deterministic
+    synth, has no duration-dependent envelope (attack/release, glitches)
+    and every frequency parameter is a small rational number. The common
+    period of those frequencies, in whole samples, is the loop length. The
+    candidate is then confirmed by rendering two periods and checking that
+    the second repeats the first, so parameters the analysis does not know
+    about can only disable tiling, never produce a wrong loop. */
+
+/** Longest loop that is considered worth tiling. */
+constexpr double defaultMaxTilePeriodSeconds = 10.0;
+
+/** Returns the loop length in samples shared by every voice of @p step, or
+    0 if the step is not (provably) periodic within @p maxPeriodSeconds or
+    is too short to benefit. Analysis only; nothing is rendered. */
+int findStepPeriodSamples(const Step& step, double sampleRate,
+                          double maxPeriodSeconds = defaultMaxTilePeriodSeconds);
+
+/** Renders exactly one period of @p step, mixed and peak-normalised the same
+    way assembleTrack treats a whole step. Every voice is tagged with
+    @p quality, as renderStep() tags them, but the loop is always rendered
+    at @p sampleRate: resampling it would break the seam.
+    @return false (and leaves @p loop empty) if the step is not periodic or
+            the rendered voices do not repeat. */
+bool renderStepLoop(const Step& step, double sampleRate, juce::AudioBuffer<float>& loop,
+                    RenderQuality quality = RenderQuality::normal,
+                    double maxPeriodSeconds = defaultMaxTilePeriodSeconds);
+
+/** True if rendering @p step with a shorter duration yields a prefix of the
+    full render, before peak normalisation. Only synths known to be
+    deterministic and independent of the step length qualify, without
+    transitions or envelopes timed from the end of the step (release,
+    fade-out). binaural_beat glitch bursts qualify once glitchEndSeconds is
+    set to the full step's length, as getStepPrefix() does. */
+bool isStepDurationIndependent(const Step& step);
+
+/** The duration to render @p step with to get its first @p samples. The
+    synths step time by duration / samples, so this keeps that ratio equal
+    to the full step's and the prefix sample-exact. */
+double getPrefixDuration(const Step& step, double sampleRate, juce::int64 samples);
+
+/** @p step shortened to its first @p samples, by getPrefixDuration(), with
+    binaural_beat glitch bursts still placed as in the full step. */
+Step getStepPrefix(const Step& step, double sampleRate, juce::int64 samples);
+
+/** Fills @p dest from @p loop, starting @p loopOffset samples into the loop
+    and wrapping as often as needed. */
+void tileLoop(const juce::AudioBuffer<float>& loop, juce::int64 loopOffset,
+              juce::AudioBuffer<float>& dest, int destStart, int numSamples);
@@ -0,0 +1,239 @@
+#include "RealtimePlayer.h"
+#include "RealtimeSafety.h"
+#include "Trace.h"
+#include <algorithm>
+
+RealtimePlayer::RealtimePlayer(Track t)
+    : track(std::move(t)),
+      quality(parseRenderQuality(track.settings.renderQuality))
+{
+}
+
+RealtimePlayer::~RealtimePlayer()
+{
+    stopWorker();
+}
+
+void RealtimePlayer::audioDeviceAboutToStart(juce::AudioIODevice* device)
+{
+    stopWorker();
+
+    sampleRate = device->getCurrentSampleRate();
+    bufferSize = device->getCurrentBufferSizeSamples();
+    outputLatencySamples = device->getOutputLatencyInSamples();
+
+    // One second of lookahead, and always several device buffers.
+    int capacity = std::max(bufferSize * 8, static_cast<int>(sampleRate)) + 1;
+    fifo.setTotalSize(capacity);
+    fifo.reset();
+    ring.setSize(2, capacity);
+    ring.clear();
+    scratch.setSize(2, bufferSize);
+    renderer.prepare(sampleRate);
+
+    seekHandledId = seekRequestId.load();
+    flushAckId = flushRequestId.load();
+    awaitingSeekAudio = false;
+    gainAppliedId = gainCommandId.load();
+    currentGain = targetGain.load();
+    repositionTo(seekTargetSample.load());
+
+    // Render the first step up front so playback starts with audio.
+    fillRing();
+    startWorker();
+}
+
+void RealtimePlayer::audioDeviceStopped()
+{
+    stopWorker();
+}
+
+void RealtimePlayer::audioDeviceIOCallback(const float** /*inputChannelData*/, int /*numInputChannels*/,
+                                           float** outputChannelData, int numOutputChannels,
+                                           int numSamples)
+{
+    REALTIME_SECTION();
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    const double blockMs = 1000.0 * (numSamples + outputLatencySamples) / sampleRate;
+
+    int flushId = flushRequestId.load(std::memory_order_acquire);
+    if (flushId != flushAckId.load(std::memory_order_relaxed))
+    {
+        fifo.finishedRead(fifo.getNumReady());
+        flushAckId.store(flushId, std::memory_order_release);
+        awaitingSeekAudio = true;
+    }
+
+    const int ready = fifo.getNumReady();
+    stats.fillLevelMs.record(1000.0 * ready / sampleRate);
+
+    int toRead = std::min(ready, numSamples);
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(toRead, start1, size1, start2, size2);
+
+    for (int ch = 0; ch < numOutputChannels; ++ch)
+    {
+        float* dest = outputChannelData[ch];
+        if (dest == nullptr)
+            continue;
+
+        const float* src = ring.getReadPointer(ch % ring.getNumChannels());
+        if (size1 > 0)
+            std::copy(src + start1, src + start1 + size1, dest);
+        if (size2 > 0)
+            std::copy(src + start2, src + start2 + size2, dest + size1);
+        std::fill(dest + toRead, dest + numSamples, 0.0f);
+    }
+
+    fifo.finishedRead(size1 + size2);
+
+    // Gain: ramp to a new target across this block.
+    float startGain = currentGain;
+    int gainId = gainCommandId.load(std::memory_order_acquire);
+    if (gainId != gainAppliedId)
+    {
+        gainAppliedId = gainId;
+        currentGain = targetGain.load();
+        stats.gainLatencyMs.record(ticksToMs(startTicks - gainCommandTicks.load()) + blockMs);
+    }
+
+    if (startGain != 1.0f || currentGain != 1.0f)
+    {
+        const float step = (currentGain - startGain) / static_cast<float>(std::max(1, numSamples));
+        for (int ch = 0; ch < numOutputChannels; ++ch)
+        {
+            if (float* dest = outputChannelData[ch])
+            {
+                float g = startGain;
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    g += step;
+                    dest[i] *= g;
+                }
+            }
+        }
+    }
+
+    if (awaitingSeekAudio && toRead > 0)
+    {
+        awaitingSeekAudio = false;
+        stats.seekLatencyMs.record(ticksToMs(startTicks - seekCommandTicks.load()) + blockMs);
+    }
+    else if (toRead < numSamples && ! awaitingSeekAudio && ! renderFinished.load())
+    {
+        stats.underruns.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const double elapsedMs = ticksToMs(juce::Time::getHighResolutionTicks() - startTicks);
+    stats.callbacks.fetch_add(1, std::memory_order_relaxed);
+    stats.callbackMs.record(elapsedMs);
+    stats.callbackLoad.record(100.0 * elapsedMs * sampleRate / (1000.0 * std::max(1, numSamples)));
+}
+
+bool RealtimePlayer::isFinished() const
+{
+    return renderFinished.load() && fifo.getNumReady() == 0;
+}
+
+void RealtimePlayer::seek(double seconds)
+{
+    seekTargetSample.store(static_cast<juce::int64>(std::max(0.0, seconds) * sampleRate));
+    seekCommandTicks.store(juce::Time::getHighResolutionTicks());
+    seekRequestId.fetch_add(1, std::memory_order_release);
+}
+
+void RealtimePlayer::setGain(float newGain)
+{
+    targetGain.store(newGain);
+    gainCommandTicks.store(juce::Time::getHighResolutionTicks());
+    gainCommandId.fetch_add(1, std::memory_order_release);
+}
+
+void RealtimePlayer::startWorker()
+{
+    running = true;
+    worker = std::thread([this] { workerLoop(); });
+}
+
+void RealtimePlayer::stopWorker()
+{
+    running = false;
+    if (worker.joinable())
+        worker.join();
+}
+
+void RealtimePlayer::workerLoop()
+{
+    registerTraceThread("RealtimePlayer worker");
+    while (running.load())
+    {
+        handleSeekRequest();
+        fillRing();
+        // The callback never signals the worker (that would take a lock on
+        // the audio thread), so poll at a rate well above the buffer period.
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+bool RealtimePlayer::seekPending() const
+{
+    return seekRequestId.load(std::memory_order_acquire) != seekHandledId;
+}
+
+void RealtimePlayer::handleSeekRequest()
+{
+    if (! seekPending())
+        return;
+
+    seekHandledId = seekRequestId.load(std::memory_order_acquire);
+    repositionTo(seekTargetSample.load());
+
+    // Nothing is written past this point until the callback has dropped
+    // the stale audio, so everything it drops predates the seek.
+    int flushId = flushRequestId.load() + 1;
+    flushRequestId.store(flushId, std::memory_order_release);
+    while (running.load() && flushAckId.load(std::memory_order_acquire) != flushId)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+void RealtimePlayer::repositionTo(juce::int64 sample)
+{
+    renderer.seek(sample);
+    renderFinished = false;
+}
+
+void RealtimePlayer::fillRing()
+{
+    const double periodMs = 1000.0 * bufferSize / sampleRate;
+
+    while (! renderFinished.load() && ! seekPending() && fifo.getFreeSpace() >= bufferSize)
+    {
+        TRACE_SCOPE("fillBuffer");
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        int produced = renderer.render(scratch, bufferSize);
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(produced, start1, size1, start2, size2);
+        for (int ch = 0; ch < ring.getNumChannels(); ++ch)
+        {
+            if (size1 > 0)
+                ring.copyFrom(ch, start1, scratch, ch, 0, size1);
+            if (size2 > 0)
+                ring.copyFrom(ch, start2, scratch, ch, size1, size2);
+        }
+        fifo.finishedWrite(size1 + size2);
+
+        double load = 100.0 * ticksToMs(juce::Time::getHighResolutionTicks() - startTicks) / periodMs;
+        stats.renderLoad.record(load);
+        if (load > 100.0)
+            stats.renderDeadlineMisses.fetch_add(1, std::memory_order_relaxed);
+
+        if (produced < bufferSize)
+            renderFinished = true;
+    }
+}
+
+double RealtimePlayer::ticksToMs(juce::int64 ticks) const
+{
+    return juce::Time::highResolutionTicksToSeconds(ticks) * 1000.0;
+}
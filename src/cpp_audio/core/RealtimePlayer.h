@@ -0,0 +1,90 @@
+#pragma once
+#include <juce_audio_devices/juce_audio_devices.h>
+#include <juce_core/juce_core.h>
+#include "RealtimeStats.h"
+#include "Track.h"
+#include "TrackRenderer.h"
+#include <atomic>
+#include <thread>
+
+/** Streams a Track to an audio device.
+
+    Steps are rendered by a TrackRenderer on a persistent worker thread
+    into a lock-free ring buffer (juce::AbstractFifo). The audio callback
+    only copies out of the ring, so it never allocates, locks or waits for
+    a render. If the worker falls behind the callback outputs silence for
+    the missing samples and counts an underrun.
+*/
+class RealtimePlayer : public juce::AudioIODeviceCallback
+{
+public:
+    explicit RealtimePlayer(Track t);
+    ~RealtimePlayer() override;
+
+    void audioDeviceAboutToStart(juce::AudioIODevice* device) override;
+    void audioDeviceStopped() override;
+    void audioDeviceIOCallback(const float** inputChannelData, int numInputChannels,
+                               float** outputChannelData, int numOutputChannels,
+                               int numSamples) override;
+
+    /** True once every step has been rendered and played out. */
+    bool isFinished() const;
+
+    /** Moves playback to @p seconds from the start of the track. Queued
+        audio is dropped and rendering restarts at the new position. */
+    void seek(double seconds);
+    /** Sets the output gain; ramped over the next callback. */
+    void setGain(float newGain);
+
+    const RealtimeStats& getStats() const { return stats; }
+    void resetStats() { stats.reset(); }
+
+private:
+    void startWorker();
+    void stopWorker();
+    void workerLoop();
+    void handleSeekRequest();
+    void repositionTo(juce::int64 sample);
+    bool seekPending() const;
+    /** Renders into the ring until it is full, the track has ended or a seek
+        is pending. */
+    void fillRing();
+    double ticksToMs(juce::int64 ticks) const;
+
+    Track track;
+    RenderQuality quality;
+    double sampleRate = 44100.0;
+    int bufferSize = 512;
+    int outputLatencySamples = 0;
+
+    juce::AbstractFifo fifo { 1 };
+    juce::AudioBuffer<float> ring;
+    juce::AudioBuffer<float> scratch;
+    std::thread worker;
+    std::atomic<bool> running { false };
+    std::atomic<bool> renderFinished { false };
+
+    // commands (any thread -> worker/callback)
+    std::atomic<juce::int64> seekTargetSample { 0 };
+    std::atomic<juce::int64> seekCommandTicks { 0 };
+    std::atomic<int> seekRequestId { 0 };
+    std::atomic<float> targetGain { 1.0f };
+    std::atomic<juce::int64> gainCommandTicks { 0 };
+    std::atomic<int> gainCommandId { 0 };
+
+    // seek handshake: the worker stops writing and raises flushRequestId; the
+    // callback drops the queued audio and acknowledges with flushAckId.
+    std::atomic<int> flushRequestId { 0 };
+    std::atomic<int> flushAckId { 0 };
+
+    // callback-only state
+    float currentGain = 1.0f;
+    int gainAppliedId = 0;
+    bool awaitingSeekAudio = false;
+
+    // step generation state, owned by the worker thread
+    int seekHandledId = 0;
+    TrackRenderer renderer { track, quality };
+
+    RealtimeStats stats;
+};
@@ -0,0 +1,86 @@
+#include "RealtimeSafety.h"
+#include <atomic>
+#include <mutex>
+
+namespace
+{
+    // Plain (constant-initialised) thread_locals so the hooks can read them
+    // at any point, including during static initialisation.
+    thread_local int sectionDepth = 0;
+    thread_local bool reporting = false;
+
+    constexpr size_t maxRecordedViolations = 16;
+    std::atomic<int> violationCounts[3] {};
+
+    std::mutex& getListLock()
+    {
+        static std::mutex m;
+        return m;
+    }
+
+    std::vector<RealtimeViolation>& getList()
+    {
+        static std::vector<RealtimeViolation> list;
+        return list;
+    }
+}
+
+ScopedRealtimeSection::ScopedRealtimeSection() noexcept { ++sectionDepth; }
+ScopedRealtimeSection::~ScopedRealtimeSection() noexcept { --sectionDepth; }
+
+bool isInRealtimeSection() noexcept
+{
+    return sectionDepth > 0 && ! reporting;
+}
+
+void reportRealtimeViolation(RealtimeViolation::Kind kind) noexcept
+{
+    if (! isInRealtimeSection())
+        return;
+
+    // Capturing the stack allocates and takes locks; the flag stops the
+    // hooks from reporting those as further violations.
+    reporting = true;
+    violationCounts[static_cast<int>(kind)].fetch_add(1, std::memory_order_relaxed);
+    try
+    {
+        std::lock_guard<std::mutex> guard(getListLock());
+        auto& list = getList();
+        if (list.size() < maxRecordedViolations)
+            list.push_back({ kind, juce::SystemStats::getStackBacktrace() });
+    }
+    catch (...)
+    {
+    }
+    reporting = false;
+}
+
+int getRealtimeViolationCount(RealtimeViolation::Kind kind)
+{
+    return violationCounts[static_cast<int>(kind)].load(std::memory_order_relaxed);
+}
+
+std::vector<RealtimeViolation> getRecordedRealtimeViolations()
+{
+    std::lock_guard<std::mutex> guard(getListLock());
+    return getList();
+}
+
+void clearRealtimeViolations()
+{
+    std::lock_guard<std::mutex> guard(getListLock());
+    getList().clear();
+    for (auto& c : violationCounts)
+        c.store(0, std::memory_order_relaxed);
+}
+
+juce::String realtimeViolationKindToString(RealtimeViolation::Kind kind)
+{
+    switch (kind)
+    {
+        case RealtimeViolation::Kind::allocation:   return "allocation";
+        case RealtimeViolation::Kind::deallocation: return "deallocation";
+        case RealtimeViolation::Kind::lock:         return "lock";
+    }
+    return "unknown";
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <vector>
+
+/** Debug detector for work that must not happen on the audio thread.
+
+    While a thread is inside a REALTIME_SECTION, heap allocations, frees and
+    mutex locks are counted and the first few are recorded with their call
+    stack. The hooks that observe them live in RealtimeSafetyHooks.cpp, which
+    is only linked into builds configured with DIY_AV_ENABLE_REALTIME_CHECKS
+    and into the RealtimeSafetyCheck tool. Without DIY_AV_REALTIME_CHECKS the
+    macro expands to nothing.
+*/
+
+struct RealtimeViolation
+{
+    enum class Kind { allocation = 0, deallocation, lock };
+
+    Kind kind;
+    juce::String stack;
+};
+
+/** Arms the detector for the current thread for the lifetime of the object.
+    Sections may nest. */
+class ScopedRealtimeSection
+{
+public:
+    ScopedRealtimeSection() noexcept;
+    ~ScopedRealtimeSection() noexcept;
+
+    ScopedRealtimeSection(const ScopedRealtimeSection&) = delete;
+    ScopedRealtimeSection& operator=(const ScopedRealtimeSection&) = delete;
+};
+
+/** True if the calling thread is inside an armed section (and not already
+    busy recording a violation). Called from the allocation/lock hooks. */
+bool isInRealtimeSection() noexcept;
+
+/** Records a violation if the calling thread is inside an armed section. */
+void reportRealtimeViolation(RealtimeViolation::Kind kind) noexcept;
+
+int getRealtimeViolationCount(RealtimeViolation::Kind kind);
+/** Returns the first recorded violations together with their stacks. */
+std::vector<RealtimeViolation> getRecordedRealtimeViolations();
+void clearRealtimeViolations();
+juce::String realtimeViolationKindToString(RealtimeViolation::Kind kind);
+
+#if DIY_AV_REALTIME_CHECKS
+ #define REALTIME_SECTION() ScopedRealtimeSection JUCE_JOIN_MACRO(realtimeSection_, __LINE__)
+#else
+ #define REALTIME_SECTION()
+#endif
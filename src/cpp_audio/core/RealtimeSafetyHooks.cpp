@@ -0,0 +1,120 @@
+// Allocation and lock hooks for the realtime-safety detector. Link this file
+// only into debug/check builds: it replaces the process-wide allocator entry
+// points and, on Linux, interposes pthread_mutex_lock.
+#include "RealtimeSafety.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+ #include <dlfcn.h>
+ #include <pthread.h>
+
+namespace
+{
+    using LockFn = int (*)(pthread_mutex_t*);
+
+    // Not a function-local static: its guard may itself take a mutex. Set
+    // before main() by the initialiser below; a lock taken during static
+    // initialisation before that resolves it itself, and every thread
+    // stores the same pointer.
+    std::atomic<LockFn> realLock { nullptr };
+
+    LockFn resolveRealLock() noexcept
+    {
+        LockFn fn = realLock.load(std::memory_order_acquire);
+        if (fn == nullptr)
+        {
+            fn = reinterpret_cast<LockFn>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+            realLock.store(fn, std::memory_order_release);
+        }
+        return fn;
+    }
+
+    __attribute__((constructor(101))) void resolveHooksEarly()
+    {
+        resolveRealLock();
+    }
+}
+
+// glibc: interpose the malloc family directly. operator new/delete end up
+// here too, so they do not need replacing separately.
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void __libc_free(void*);
+
+    void* malloc(size_t size)
+    {
+        if (isInRealtimeSection())
+            reportRealtimeViolation(RealtimeViolation::Kind::allocation);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        if (isInRealtimeSection())
+            reportRealtimeViolation(RealtimeViolation::Kind::allocation);
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* ptr, size_t size)
+    {
+        if (isInRealtimeSection())
+            reportRealtimeViolation(RealtimeViolation::Kind::allocation);
+        return __libc_realloc(ptr, size);
+    }
+
+    void free(void* ptr)
+    {
+        if (ptr != nullptr && isInRealtimeSection())
+            reportRealtimeViolation(RealtimeViolation::Kind::deallocation);
+        __libc_free(ptr);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        if (isInRealtimeSection())
+            reportRealtimeViolation(RealtimeViolation::Kind::lock);
+        return resolveRealLock()(mutex);
+    }
+}
+
+#else
+
+// Other platforms: replace the global operator new/delete. Lock detection
+// is not available here.
+void* operator new (std::size_t size)
+{
+    if (isInRealtimeSection())
+        reportRealtimeViolation(RealtimeViolation::Kind::allocation);
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size) { return operator new (size); }
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept
+{
+    if (isInRealtimeSection())
+        reportRealtimeViolation(RealtimeViolation::Kind::allocation);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[] (std::size_t size, const std::nothrow_t& tag) noexcept { return operator new (size, tag); }
+
+void operator delete (void* p) noexcept
+{
+    if (p != nullptr && isInRealtimeSection())
+        reportRealtimeViolation(RealtimeViolation::Kind::deallocation);
+    std::free(p);
+}
+
+void operator delete[] (void* p) noexcept { operator delete (p); }
+void operator delete (void* p, std::size_t) noexcept { operator delete (p); }
+void operator delete[] (void* p, std::size_t) noexcept { operator delete (p); }
+
+#endif
@@ -0,0 +1,102 @@
+#include "RealtimeStats.h"
+#include <cmath>
+
+StatsHistogram::StatsHistogram(double minV, double maxV)
+    : minValue(minV), logRange(std::log(maxV / minV))
+{
+}
+
+void StatsHistogram::record(double value) noexcept
+{
+    int index = 0;
+    if (value > minValue)
+        index = juce::jlimit(0, numBuckets - 1,
+                             static_cast<int>(std::log(value / minValue) / logRange * numBuckets));
+
+    buckets[static_cast<size_t>(index)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+
+    double s = sum.load(std::memory_order_relaxed);
+    while (! sum.compare_exchange_weak(s, s + value, std::memory_order_relaxed)) {}
+
+    double m = maxSeen.load(std::memory_order_relaxed);
+    while (value > m && ! maxSeen.compare_exchange_weak(m, value, std::memory_order_relaxed)) {}
+}
+
+void StatsHistogram::reset() noexcept
+{
+    for (auto& b : buckets)
+        b.store(0, std::memory_order_relaxed);
+    count.store(0, std::memory_order_relaxed);
+    sum.store(0.0, std::memory_order_relaxed);
+    maxSeen.store(0.0, std::memory_order_relaxed);
+}
+
+double StatsHistogram::bucketUpperEdge(int index) const
+{
+    return minValue * std::exp(logRange * (index + 1) / numBuckets);
+}
+
+double StatsHistogram::percentile(double fraction, juce::int64 total) const
+{
+    const auto target = static_cast<juce::int64>(std::ceil(fraction * static_cast<double>(total)));
+    juce::int64 seen = 0;
+    for (int i = 0; i < numBuckets; ++i)
+    {
+        seen += buckets[static_cast<size_t>(i)].load(std::memory_order_relaxed);
+        if (seen >= target)
+            return juce::jmin(bucketUpperEdge(i), maxSeen.load(std::memory_order_relaxed));
+    }
+    return maxSeen.load(std::memory_order_relaxed);
+}
+
+StatsHistogram::Summary StatsHistogram::getSummary() const
+{
+    Summary s;
+    s.count = count.load(std::memory_order_relaxed);
+    if (s.count == 0)
+        return s;
+
+    s.mean = sum.load(std::memory_order_relaxed) / static_cast<double>(s.count);
+    s.p50 = percentile(0.50, s.count);
+    s.p95 = percentile(0.95, s.count);
+    s.p99 = percentile(0.99, s.count);
+    s.max = maxSeen.load(std::memory_order_relaxed);
+    return s;
+}
+
+void RealtimeStats::reset() noexcept
+{
+    for (auto* h : { &callbackMs, &callbackLoad, &renderLoad, &fillLevelMs, &seekLatencyMs, &gainLatencyMs })
+        h->reset();
+    callbacks.store(0);
+    underruns.store(0);
+    renderDeadlineMisses.store(0);
+}
+
+juce::String RealtimeStats::toString() const
+{
+    auto line = [] (const char* name, const StatsHistogram& h, const char* unit)
+    {
+        auto s = h.getSummary();
+        return juce::String(name).paddedRight(' ', 16)
+               + " n=" + juce::String(s.count)
+               + "  mean " + juce::String(s.mean, 3)
+               + "  p50 " + juce::String(s.p50, 3)
+               + "  p95 " + juce::String(s.p95, 3)
+               + "  p99 " + juce::String(s.p99, 3)
+               + "  max " + juce::String(s.max, 3) + " " + unit + "\n";
+    };
+
+    juce::String out;
+    out << "callbacks " << juce::String(callbacks.load())
+        << "  underruns " << juce::String(underruns.load())
+        << "  render deadline misses " << juce::String(renderDeadlineMisses.load()) << "\n";
+    out << line("callback", callbackMs, "ms");
+    out << line("callback load", callbackLoad, "%");
+    out << line("render load", renderLoad, "%");
+    out << line("ring fill", fillLevelMs, "ms");
+    out << line("seek latency", seekLatencyMs, "ms");
+    out << line("gain latency", gainLatencyMs, "ms");
+    return out;
+}
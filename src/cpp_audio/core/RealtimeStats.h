@@ -0,0 +1,62 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+/** Lock-free histogram with log-spaced buckets. record() may be called from
+    the audio thread; getSummary() from anywhere. Values below the range go
+    into the first bucket and values above it into the last. */
+class StatsHistogram
+{
+public:
+    StatsHistogram(double minValue, double maxValue);
+
+    void record(double value) noexcept;
+    void reset() noexcept;
+
+    struct Summary
+    {
+        juce::int64 count { 0 };
+        double mean { 0.0 };
+        double p50 { 0.0 };
+        double p95 { 0.0 };
+        double p99 { 0.0 };
+        double max { 0.0 };
+    };
+
+    Summary getSummary() const;
+
+private:
+    static constexpr int numBuckets = 64;
+
+    double percentile(double fraction, juce::int64 total) const;
+    double bucketUpperEdge(int index) const;
+
+    const double minValue;
+    const double logRange;
+    std::array<std::atomic<juce::uint32>, numBuckets> buckets {};
+    std::atomic<juce::int64> count { 0 };
+    std::atomic<double> sum { 0.0 };
+    std::atomic<double> maxSeen { 0.0 };
+};
+
+/** Counters and histograms collected by RealtimePlayer. Loads are the time
+    spent relative to one buffer period in percent, so headroom is
+    100 - load and anything above 100 missed the deadline. */
+struct RealtimeStats
+{
+    StatsHistogram callbackMs { 0.001, 100.0 };          // time spent inside the device callback
+    StatsHistogram callbackLoad { 0.01, 1000.0 };        // callback time / buffer period, %
+    StatsHistogram renderLoad { 0.01, 1.0e6 };           // worker time per block / buffer period, %
+    StatsHistogram fillLevelMs { 0.1, 1.0e4 };           // audio queued in the ring at callback start
+    StatsHistogram seekLatencyMs { 0.1, 1.0e5 };         // seek() to first audible sample
+    StatsHistogram gainLatencyMs { 0.01, 1.0e4 };        // setGain() to audible change
+
+    std::atomic<juce::int64> callbacks { 0 };
+    std::atomic<juce::int64> underruns { 0 };            // callbacks that ran out of rendered audio
+    std::atomic<juce::int64> renderDeadlineMisses { 0 }; // blocks that took longer than a period to render
+
+    void reset() noexcept;
+    /** Multi-line human-readable dump. */
+    juce::String toString() const;
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <juce_core/juce_core.h>
+
+/** How much accuracy a step render trades for speed.
+
+      * draft:  voices are synthesised at no more than draftSampleRate and
+                resampled up, and synths that read the quality from their
+                params take cheaper paths (e.g. NoiseFlanger sweeps its
+                notches at control rate with fewer cascades). For iterating
+                on long tracks; not for export.
+      * normal: full rate and full accuracy.
+      * master: full rate; synths with an optional costlier path for final
+                exports take it.
+
+    The quality reaches synths as the "render_quality" param, which
+    renderStep() adds to a copy of each voice's params; it is never saved.
+*/
+enum class RenderQuality { draft, normal, master };
+
+/** Highest rate draft renders synthesise at. */
+constexpr double draftSampleRate = 22050.0;
+
+/** Name of the voice param that carries the quality to synths. */
+constexpr const char* renderQualityParam = "render_quality";
+
+/** Maps "draft", "normal" or "master" to a quality; anything else is normal. */
+inline RenderQuality parseRenderQuality(const juce::String& name)
+{
+    if (name.equalsIgnoreCase("draft"))
+        return RenderQuality::draft;
+    if (name.equalsIgnoreCase("master"))
+        return RenderQuality::master;
+    return RenderQuality::normal;
+}
+
+inline juce::String getRenderQualityName(RenderQuality quality)
+{
+    switch (quality)
+    {
+        case RenderQuality::draft:  return "draft";
+        case RenderQuality::master: return "master";
+        case RenderQuality::normal: break;
+    }
+    return "normal";
+}
+
+/** The quality a synth has been asked to render at. */
+inline RenderQuality getRenderQuality(const juce::NamedValueSet& params)
+{
+    return parseRenderQuality(params.getWithDefault(renderQualityParam, "normal").toString());
+}
+
+/** The rate voices are synthesised at for an output at @p sampleRate. */
+inline double getInternalSampleRate(RenderQuality quality, double sampleRate)
+{
+    return quality == RenderQuality::draft ? juce::jmin(sampleRate, draftSampleRate) : sampleRate;
+}
@@ -0,0 +1,666 @@
+#include "RenderServer.h"
+#include "Track.h"
+#include "TrackRenderer.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <chrono>
+#include <condition_variable>
+#include <string>
+#include <vector>
+
+struct RenderServer::Session
+{
+    explicit Session(Track t)
+        : track(std::move(t)),
+          sampleRate(track.settings.sampleRate > 0.0 ? track.settings.sampleRate : 44100.0),
+          renderer(track, parseRenderQuality(track.settings.renderQuality))
+    {
+        renderer.prepare(sampleRate);
+        touch();
+    }
+
+    void touch() { lastActiveMs.store(juce::Time::currentTimeMillis()); }
+
+    /** Changes state under the lock and wakes the stream. */
+    template <typename Fn>
+    void update(Fn&& fn)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            fn();
+        }
+        changed.notify_all();
+    }
+
+    juce::String id;
+    Track track;
+    double sampleRate;
+    TrackRenderer renderer; // used by whichever thread holds the stream
+
+    std::mutex lock;
+    std::condition_variable changed;
+    juce::int64 pendingSeek = -1;       // frame to move to before the next chunk
+    std::atomic<bool> paused { false };
+    std::atomic<bool> closed { false };
+    std::atomic<bool> streaming { false };
+
+    std::atomic<juce::int64> position { 0 };
+    std::atomic<juce::int64> bytesSent { 0 };
+    std::atomic<juce::int64> framesRendered { 0 };
+    std::atomic<double> renderSeconds { 0.0 };
+    std::atomic<juce::int64> lastActiveMs { 0 };
+};
+
+struct RenderServer::Request
+{
+    juce::String method;
+    juce::StringArray path;
+    juce::StringPairArray query;
+    juce::String body;
+};
+
+namespace
+{
+const int requestTimeoutMs = 5000;
+const int maxHeaderBytes = 16 * 1024;
+const int bytesPerFrame = 4; // two 16-bit channels
+
+const char* statusText(int status)
+{
+    switch (status)
+    {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 422: return "Unprocessable Entity";
+        case 503: return "Service Unavailable";
+        default:  return "Error";
+    }
+}
+
+/** Reads whatever has arrived, waiting up to the request timeout.
+    @return bytes read, or -1 on timeout, error or shutdown. */
+int readSome(juce::StreamingSocket& socket, char* dest, int maxBytes, const std::atomic<bool>& running)
+{
+    for (int waited = 0; waited < requestTimeoutMs && running.load(); waited += 100)
+    {
+        int ready = socket.waitUntilReady(true, 100);
+        if (ready < 0)
+            return -1;
+        if (ready > 0)
+        {
+            int n = socket.read(dest, maxBytes, false);
+            return n > 0 ? n : -1;
+        }
+    }
+    return -1;
+}
+
+/** Reads one request. @return 0, the status to refuse it with, or -1 if
+    the client went away. */
+int readRequest(juce::StreamingSocket& socket, juce::String& method, juce::String& target,
+                juce::String& body, int maxBodyBytes, const std::atomic<bool>& running)
+{
+    std::string data;
+    char buffer[4096];
+    size_t headerEnd;
+    while ((headerEnd = data.find("\r\n\r\n")) == std::string::npos)
+    {
+        if (data.size() > static_cast<size_t>(maxHeaderBytes))
+            return 400;
+        int n = readSome(socket, buffer, sizeof(buffer), running);
+        if (n < 0)
+            return -1;
+        data.append(buffer, static_cast<size_t>(n));
+    }
+
+    auto lines = juce::StringArray::fromLines(juce::String(data.substr(0, headerEnd)));
+    auto requestLine = juce::StringArray::fromTokens(lines[0], " ", "");
+    if (requestLine.size() < 3)
+        return 400;
+    method = requestLine[0].toUpperCase();
+    target = requestLine[1];
+
+    juce::int64 contentLength = 0;
+    for (int i = 1; i < lines.size(); ++i)
+    {
+        auto name = lines[i].upToFirstOccurrenceOf(":", false, false).trim();
+        auto value = lines[i].fromFirstOccurrenceOf(":", false, false).trim();
+        if (name.equalsIgnoreCase("content-length"))
+            contentLength = value.getLargeIntValue();
+        else if (name.equalsIgnoreCase("transfer-encoding") && ! value.equalsIgnoreCase("identity"))
+            return 400; // request bodies must come with a length
+    }
+    if (contentLength < 0)
+        return 400;
+    if (contentLength > maxBodyBytes)
+        return 413;
+
+    std::string content = data.substr(headerEnd + 4);
+    while (static_cast<juce::int64>(content.size()) < contentLength)
+    {
+        int n = readSome(socket, buffer, sizeof(buffer), running);
+        if (n < 0)
+            return -1;
+        content.append(buffer, static_cast<size_t>(n));
+    }
+    content.resize(static_cast<size_t>(contentLength));
+    body = juce::String::fromUTF8(content.data(), static_cast<int>(content.size()));
+    return 0;
+}
+
+/** Interleaved big-endian 16-bit PCM, as audio/L16 has it. */
+void encodeL16(const juce::AudioBuffer<float>& block, int numFrames, char* dest)
+{
+    const float* left = block.getReadPointer(0);
+    const float* right = block.getReadPointer(1);
+    for (int i = 0; i < numFrames; ++i)
+    {
+        for (float sample : { left[i], right[i] })
+        {
+            auto value = static_cast<juce::int16>(juce::roundToInt(juce::jlimit(-1.0f, 1.0f, sample) * 32767.0f));
+            *dest++ = static_cast<char>((value >> 8) & 0xff);
+            *dest++ = static_cast<char>(value & 0xff);
+        }
+    }
+}
+}
+
+RenderServer::RenderServer(Options o)
+    : options(o)
+{
+    options.chunkFrames = juce::jmax(64, options.chunkFrames);
+}
+
+RenderServer::~RenderServer()
+{
+    stop();
+}
+
+bool RenderServer::start()
+{
+    if (running.load())
+        return true;
+    if (! listener.createListener(options.port, "127.0.0.1"))
+        return false;
+
+    boundPort = listener.getBoundPort();
+    running = true;
+    acceptThread = std::thread([this] { acceptLoop(); });
+    return true;
+}
+
+void RenderServer::stop()
+{
+    if (! running.exchange(false))
+        return;
+    if (acceptThread.joinable())
+        acceptThread.join();
+
+    {
+        std::lock_guard<std::mutex> guard(sessionLock);
+        for (auto& entry : sessions)
+        {
+            auto& session = *entry.second;
+            session.update([&] { session.closed = true; });
+        }
+        sessions.clear();
+    }
+
+    // Every connection thread notices the flag within one poll interval.
+    reapConnections(true);
+    listener.close();
+}
+
+void RenderServer::acceptLoop()
+{
+    while (running.load())
+    {
+        reapConnections(false);
+        expireIdleSessions();
+
+        if (listener.waitUntilReady(true, 100) != 1)
+            continue;
+        std::unique_ptr<juce::StreamingSocket> socket(listener.waitForNextConnection());
+        if (socket == nullptr)
+            continue;
+
+        std::unique_lock<std::mutex> guard(connectionLock);
+        if (static_cast<int>(connections.size()) >= options.maxConnections)
+        {
+            guard.unlock();
+            sendError(*socket, 503, "Too many connections");
+            continue;
+        }
+
+        auto connection = std::make_unique<Connection>();
+        connection->socket = std::move(socket);
+        Connection* c = connection.get();
+        connections.push_back(std::move(connection));
+        c->thread = std::thread([this, c] {
+            handleConnection(*c->socket);
+            c->finished = true;
+        });
+    }
+}
+
+void RenderServer::reapConnections(bool all)
+{
+    std::list<std::unique_ptr<Connection>> done;
+    {
+        std::lock_guard<std::mutex> guard(connectionLock);
+        for (auto it = connections.begin(); it != connections.end();)
+        {
+            auto next = std::next(it);
+            if (all || (*it)->finished.load())
+                done.splice(done.end(), connections, it);
+            it = next;
+        }
+    }
+    for (auto& c : done)
+        c->thread.join();
+}
+
+void RenderServer::expireIdleSessions()
+{
+    const juce::int64 now = juce::Time::currentTimeMillis();
+    const auto limit = static_cast<juce::int64>(options.idleTimeoutSeconds * 1000.0);
+
+    std::lock_guard<std::mutex> guard(sessionLock);
+    for (auto it = sessions.begin(); it != sessions.end();)
+    {
+        auto& session = *it->second;
+        if (! session.streaming.load() && now - session.lastActiveMs.load() > limit)
+        {
+            session.update([&] { session.closed = true; });
+            it = sessions.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+std::shared_ptr<RenderServer::Session> RenderServer::findSession(const juce::String& id)
+{
+    std::lock_guard<std::mutex> guard(sessionLock);
+    auto it = sessions.find(id);
+    return it != sessions.end() ? it->second : nullptr;
+}
+
+void RenderServer::handleConnection(juce::StreamingSocket& socket)
+{
+    juce::String method, target, body;
+    int status = readRequest(socket, method, target, body, options.maxBodyBytes, running);
+    if (status > 0)
+    {
+        sendError(socket, status, status == 413 ? "Request body too large" : "Malformed request");
+    }
+    else if (status == 0)
+    {
+        Request request;
+        request.method = method;
+        request.path = juce::StringArray::fromTokens(target.upToFirstOccurrenceOf("?", false, false), "/", "");
+        request.path.removeEmptyStrings();
+        for (const auto& pair : juce::StringArray::fromTokens(target.fromFirstOccurrenceOf("?", false, false), "&", ""))
+            if (pair.isNotEmpty())
+                request.query.set(juce::URL::removeEscapeChars(pair.upToFirstOccurrenceOf("=", false, false)),
+                                  juce::URL::removeEscapeChars(pair.fromFirstOccurrenceOf("=", false, false)));
+        request.body = body;
+        route(socket, request);
+    }
+    socket.close();
+}
+
+void RenderServer::route(juce::StreamingSocket& socket, const Request& request)
+{
+    const auto& path = request.path;
+    const auto& method = request.method;
+
+    if (path.size() == 1 && path[0] == "status")
+    {
+        if (method != "GET")
+        {
+            sendError(socket, 405, "Use GET");
+            return;
+        }
+        int numSessions = 0, listeners = 0;
+        {
+            std::lock_guard<std::mutex> guard(sessionLock);
+            numSessions = static_cast<int>(sessions.size());
+            for (const auto& entry : sessions)
+                listeners += entry.second->streaming.load() ? 1 : 0;
+        }
+        auto* obj = new juce::DynamicObject();
+        obj->setProperty("sessions", numSessions);
+        obj->setProperty("listeners", listeners);
+        obj->setProperty("max_sessions", options.maxSessions);
+        obj->setProperty("chunk_frames", options.chunkFrames);
+        obj->setProperty("lead_seconds", options.leadSeconds);
+        sendJson(socket, 200, juce::var(obj));
+        return;
+    }
+
+    if (path.isEmpty() || path[0] != "sessions" || path.size() > 3)
+    {
+        sendError(socket, 404, "No such endpoint");
+        return;
+    }
+
+    if (path.size() == 1)
+    {
+        if (method == "POST")
+            createSession(socket, request);
+        else
+            sendError(socket, 405, "Use POST to create a session");
+        return;
+    }
+
+    auto session = findSession(path[1]);
+    if (session == nullptr)
+    {
+        sendError(socket, 404, "No such session");
+        return;
+    }
+    session->touch();
+
+    const juce::String action = path.size() > 2 ? path[2] : juce::String();
+    if (action.isEmpty())
+    {
+        if (method == "GET")
+        {
+            sendJson(socket, 200, describe(*session));
+        }
+        else if (method == "DELETE")
+        {
+            {
+                std::lock_guard<std::mutex> guard(sessionLock);
+                sessions.erase(session->id);
+            }
+            session->update([&] { session->closed = true; });
+            sendJson(socket, 200, describe(*session));
+        }
+        else
+        {
+            sendError(socket, 405, "Use GET or DELETE");
+        }
+        return;
+    }
+
+    if (action == "stream")
+    {
+        if (method != "GET")
+            sendError(socket, 405, "Use GET");
+        else if (session->streaming.exchange(true))
+            sendError(socket, 409, "Session already has a listener");
+        else
+        {
+            // Runs until the track ends, the listener leaves or the
+            // session is deleted.
+            streamSession(socket, *session);
+            session->streaming = false;
+            session->touch();
+        }
+        return;
+    }
+
+    if (method != "POST")
+    {
+        sendError(socket, 405, "Use POST");
+        return;
+    }
+
+    if (action == "start" || action == "stop")
+    {
+        const bool pause = action == "stop";
+        session->update([&] { session->paused = pause; });
+        sendJson(socket, 200, describe(*session));
+    }
+    else if (action == "seek")
+    {
+        if (! request.query.containsKey("t") || request.query["t"].getDoubleValue() < 0.0)
+        {
+            sendError(socket, 400, "seek needs t=<seconds>");
+            return;
+        }
+        auto frame = juce::jmin(static_cast<juce::int64>(request.query["t"].getDoubleValue() * session->sampleRate),
+                                session->renderer.getTotalLength());
+        session->update([&] {
+            session->pendingSeek = frame;
+            session->position = frame;
+        });
+        sendJson(socket, 200, describe(*session));
+    }
+    else
+    {
+        sendError(socket, 404, "No such endpoint");
+    }
+}
+
+void RenderServer::createSession(juce::StreamingSocket& socket, const Request& request)
+{
+    // Refuse before parsing the track or building its renderer.
+    if (! hasRoomForSession())
+    {
+        sendError(socket, 503, "Too many sessions");
+        return;
+    }
+
+    Track track = parseTrackJson(request.body);
+    if (track.steps.empty())
+    {
+        sendError(socket, 400, "Body is not a track JSON with steps");
+        return;
+    }
+
+    // Steps the renderer cannot split are held whole; keep each session's
+    // buffers bounded by refusing tracks whose steps are too long for that.
+    {
+        TrackRenderer probe(track, parseRenderQuality(track.settings.renderQuality));
+        probe.prepare(track.settings.sampleRate > 0.0 ? track.settings.sampleRate : 44100.0);
+        double needed = probe.getLongestRenderSeconds();
+        if (needed > options.maxRenderSeconds)
+        {
+            sendError(socket, 422, "A step needs " + juce::String(needed, 1) + " s rendered at once; "
+                                   "the limit is " + juce::String(options.maxRenderSeconds, 1) + " s");
+            return;
+        }
+    }
+
+    auto session = std::make_shared<Session>(std::move(track));
+    {
+        // Another request may have taken the last place in the meantime.
+        std::lock_guard<std::mutex> guard(sessionLock);
+        if (static_cast<int>(sessions.size()) >= options.maxSessions)
+            session = nullptr;
+        else
+        {
+            session->id = juce::String(nextSessionId++);
+            sessions[session->id] = session;
+        }
+    }
+
+    if (session == nullptr)
+        sendError(socket, 503, "Too many sessions");
+    else
+        sendJson(socket, 201, describe(*session));
+}
+
+bool RenderServer::hasRoomForSession()
+{
+    std::lock_guard<std::mutex> guard(sessionLock);
+    return static_cast<int>(sessions.size()) < options.maxSessions;
+}
+
+void RenderServer::streamSession(juce::StreamingSocket& socket, Session& session)
+{
+    const double sampleRate = session.sampleRate;
+    juce::String header;
+    header << "HTTP/1.1 200 OK\r\n"
+           << "Content-Type: audio/L16;rate=" << juce::roundToInt(sampleRate) << ";channels=2\r\n"
+           << "Transfer-Encoding: chunked\r\n"
+           << "Cache-Control: no-store\r\n"
+           << "Connection: close\r\n\r\n";
+    if (! writeAll(socket, header.toRawUTF8(), static_cast<int>(header.getNumBytesAsUTF8()), &session))
+        return;
+
+    using Clock = std::chrono::steady_clock;
+    const int chunkFrames = options.chunkFrames;
+    juce::AudioBuffer<float> block(2, chunkFrames);
+    std::vector<char> chunk(static_cast<size_t>(chunkFrames * bytesPerFrame + 16));
+
+    // The lead is measured from when the stream last (re)started: the
+    // beginning, the end of a pause or a seek.
+    auto clockStart = Clock::now();
+    juce::int64 framesSinceClock = 0;
+
+    for (;;)
+    {
+        juce::int64 seekTo = -1;
+        bool waited = false;
+        {
+            std::unique_lock<std::mutex> guard(session.lock);
+            while (session.paused.load() && ! session.closed.load() && running.load())
+            {
+                waited = true;
+                session.changed.wait_for(guard, std::chrono::milliseconds(100));
+            }
+            if (session.closed.load() || ! running.load())
+                break;
+            std::swap(seekTo, session.pendingSeek);
+        }
+
+        if (seekTo >= 0)
+            session.renderer.seek(seekTo);
+        if (waited || seekTo >= 0)
+        {
+            clockStart = Clock::now();
+            framesSinceClock = 0;
+        }
+
+        if (options.leadSeconds > 0.0)
+        {
+            auto due = clockStart + std::chrono::duration_cast<Clock::duration>(
+                           std::chrono::duration<double>(framesSinceClock / sampleRate - options.leadSeconds));
+            std::unique_lock<std::mutex> guard(session.lock);
+            bool interrupted = session.changed.wait_until(guard, due, [&] {
+                return session.closed.load() || session.paused.load() || session.pendingSeek >= 0
+                       || ! running.load();
+            });
+            if (interrupted)
+                continue;
+        }
+
+        const auto renderStart = juce::Time::getHighResolutionTicks();
+        const int frames = session.renderer.render(block, chunkFrames);
+        session.renderSeconds = session.renderSeconds.load()
+                              + juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - renderStart);
+        session.framesRendered += frames;
+        if (frames == 0)
+            break; // end of the track
+
+        const int payloadBytes = frames * bytesPerFrame;
+        const juce::String sizeLine = juce::String::toHexString(payloadBytes) + "\r\n";
+        const int sizeBytes = static_cast<int>(sizeLine.getNumBytesAsUTF8());
+        std::copy(sizeLine.toRawUTF8(), sizeLine.toRawUTF8() + sizeBytes, chunk.data());
+        encodeL16(block, frames, chunk.data() + sizeBytes);
+        chunk[static_cast<size_t>(sizeBytes + payloadBytes)] = '\r';
+        chunk[static_cast<size_t>(sizeBytes + payloadBytes + 1)] = '\n';
+
+        if (! writeAll(socket, chunk.data(), sizeBytes + payloadBytes + 2, &session))
+            return;
+
+        session.bytesSent += payloadBytes;
+        framesSinceClock += frames;
+        {
+            std::lock_guard<std::mutex> guard(session.lock);
+            if (session.pendingSeek < 0)
+                session.position = session.renderer.getPosition();
+        }
+        session.touch();
+    }
+
+    // Also sent when the session is deleted, so the listener sees a clean end.
+    static const char lastChunk[] = "0\r\n\r\n";
+    writeAll(socket, lastChunk, static_cast<int>(sizeof(lastChunk) - 1), nullptr);
+}
+
+juce::var RenderServer::describe(const Session& session) const
+{
+    const double sampleRate = session.sampleRate;
+    const juce::int64 position = session.position.load();
+    const juce::int64 total = session.renderer.getTotalLength();
+
+    const char* state = "ready";
+    if (session.closed.load())
+        state = "closed";
+    else if (session.paused.load())
+        state = "paused";
+    else if (session.streaming.load())
+        state = "streaming";
+    else if (position >= total)
+        state = "finished";
+
+    auto* obj = new juce::DynamicObject();
+    obj->setProperty("id", session.id);
+    obj->setProperty("state", juce::String(state));
+    obj->setProperty("sample_rate", sampleRate);
+    obj->setProperty("channels", 2);
+    obj->setProperty("format", "s16be");
+    obj->setProperty("position_seconds", position / sampleRate);
+    obj->setProperty("duration_seconds", total / sampleRate);
+    obj->setProperty("bytes_sent", session.bytesSent.load());
+
+    // How many times faster than real time this session has rendered.
+    const double renderSeconds = session.renderSeconds.load();
+    if (renderSeconds > 0.0)
+        obj->setProperty("render_speed", session.framesRendered.load() / sampleRate / renderSeconds);
+    return juce::var(obj);
+}
+
+bool RenderServer::writeAll(juce::StreamingSocket& socket, const void* data, int numBytes,
+                            const Session* session) const
+{
+    auto* bytes = static_cast<const char*>(data);
+    while (numBytes > 0)
+    {
+        // Poll so a listener that stops reading cannot pin the thread
+        // after its session or the server is closed.
+        if (! running.load() || (session != nullptr && session->closed.load()))
+            return false;
+        int ready = socket.waitUntilReady(false, 100);
+        if (ready < 0)
+            return false;
+        if (ready == 0)
+            continue;
+        int written = socket.write(bytes, numBytes);
+        if (written <= 0)
+            return false;
+        bytes += written;
+        numBytes -= written;
+    }
+    return true;
+}
+
+void RenderServer::sendJson(juce::StreamingSocket& socket, int status, const juce::var& body) const
+{
+    const juce::String text = juce::JSON::toString(body, true) + "\n";
+    juce::String response;
+    response << "HTTP/1.1 " << status << " " << statusText(status) << "\r\n"
+             << "Content-Type: application/json\r\n"
+             << "Content-Length: " << static_cast<int>(text.getNumBytesAsUTF8()) << "\r\n"
+             << "Connection: close\r\n\r\n"
+             << text;
+    writeAll(socket, response.toRawUTF8(), static_cast<int>(response.getNumBytesAsUTF8()), nullptr);
+}
+
+void RenderServer::sendError(juce::StreamingSocket& socket, int status, const juce::String& message) const
+{
+    auto* obj = new juce::DynamicObject();
+    obj->setProperty("error", message);
+    sendJson(socket, status, juce::var(obj));
+}
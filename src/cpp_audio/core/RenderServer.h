@@ -0,0 +1,106 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/** Renders tracks for HTTP clients on this machine.
+
+    A client posts a track JSON to create a session, then opens the
+    session's stream: the track as interleaved 16-bit stereo PCM
+    ("audio/L16", big-endian) sent with chunked transfer encoding. While it
+    streams, other requests control the session:
+
+        POST   /sessions                body: track JSON; replies {"id": ...}
+        GET    /sessions/<id>/stream    the audio, one listener at a time
+        POST   /sessions/<id>/stop      pause; the stream stays open
+        POST   /sessions/<id>/start     resume
+        POST   /sessions/<id>/seek?t=S  carry on from S seconds
+        GET    /sessions/<id>           status JSON
+        DELETE /sessions/<id>           end the stream and drop the session
+        GET    /status                  server status JSON
+
+    Each connection gets its own thread, up to maxConnections at once;
+    connections beyond that are answered 503 and closed. A stream renders
+    on its thread one chunk at a time and only once the previous chunk has
+    gone to the socket, so it stays no further ahead of its listener than
+    the socket buffers. A session holds one chunk plus what its
+    TrackRenderer has rendered of the current step: a loop, a piece, or for
+    steps it cannot split (noise, transitions, most non-oscillator synths)
+    the whole step. Tracks that would need more than maxRenderSeconds of a
+    step at once are refused with 422, which bounds every session's
+    buffers. With a lead set, a stream is also held to that many seconds
+    ahead of real time so a client with deep buffers cannot pull the whole
+    track at once. Sessions nobody has touched for the idle timeout are
+    dropped.
+
+    Only the loopback interface is bound; there is no authentication.
+*/
+class RenderServer
+{
+public:
+    struct Options
+    {
+        int port = 8765;                  // 0 picks a free port
+        int maxSessions = 64;
+        int maxConnections = 128;         // open at once; more are refused with 503
+        double maxRenderSeconds = 60.0;   // longest stretch of a step rendered at once
+        int chunkFrames = 4096;
+        double leadSeconds = 0.0;         // 0 sends as fast as the client reads
+        double idleTimeoutSeconds = 300.0;
+        int maxBodyBytes = 8 * 1024 * 1024;
+    };
+
+    explicit RenderServer(Options options);
+    ~RenderServer();
+
+    /** Binds to 127.0.0.1 and starts accepting connections.
+        @return false if the port could not be bound. */
+    bool start();
+    /** Closes every connection and waits for their threads. */
+    void stop();
+
+    int getPort() const noexcept { return boundPort; }
+
+private:
+    struct Session;
+    struct Request;
+    struct Connection
+    {
+        std::unique_ptr<juce::StreamingSocket> socket;
+        std::thread thread;
+        std::atomic<bool> finished { false };
+    };
+
+    void acceptLoop();
+    void reapConnections(bool all);
+    void expireIdleSessions();
+    void handleConnection(juce::StreamingSocket& socket);
+    void route(juce::StreamingSocket& socket, const Request& request);
+    void createSession(juce::StreamingSocket& socket, const Request& request);
+    bool hasRoomForSession();
+    void streamSession(juce::StreamingSocket& socket, Session& session);
+    juce::var describe(const Session& session) const;
+    std::shared_ptr<Session> findSession(const juce::String& id);
+
+    /** Writes all of @p data, giving up once the session or server closes. */
+    bool writeAll(juce::StreamingSocket& socket, const void* data, int numBytes, const Session* session) const;
+    void sendJson(juce::StreamingSocket& socket, int status, const juce::var& body) const;
+    void sendError(juce::StreamingSocket& socket, int status, const juce::String& message) const;
+
+    Options options;
+    juce::StreamingSocket listener;
+    int boundPort = 0;
+    std::thread acceptThread;
+    std::atomic<bool> running { false };
+
+    std::mutex connectionLock;
+    std::list<std::unique_ptr<Connection>> connections;
+
+    std::mutex sessionLock;
+    std::map<juce::String, std::shared_ptr<Session>> sessions;
+    int nextSessionId = 1;
+};
@@ -0,0 +1,82 @@
+#include "SpatialPath.h"
+#include "AudioUtils.h"
+#include <cmath>
+
+using namespace juce;
+
+SpatialPath::SpatialPath(Shape shape, double arcStartDeg, double arcEndDeg)
+    : table(static_cast<size_t>(tableSize) + 1)
+{
+    for (int i = 0; i <= tableSize; ++i)
+    {
+        double phase = MathConstants<double>::twoPi * i / tableSize;
+        double x = 0.0;
+        switch (shape)
+        {
+            case Shape::circle:
+                x = std::sin(phase);
+                break;
+            case Shape::arc:
+            {
+                double progress = (1.0 - std::cos(phase)) * 0.5;
+                x = std::sin(degreesToRadians(arcStartDeg + progress * (arcEndDeg - arcStartDeg)));
+                break;
+            }
+            case Shape::oscillatingArc:
+            {
+                double progress = 1.0 - 2.0 * std::abs(static_cast<double>(i) / tableSize - 0.5);
+                x = std::sin(degreesToRadians(arcStartDeg + progress * (arcEndDeg - arcStartDeg)));
+                break;
+            }
+            case Shape::figureEight:
+            {
+                // Lemniscate of Bernoulli, starting from the centre.
+                double s = std::sin(phase);
+                x = s / (1.0 + std::cos(phase) * std::cos(phase));
+                break;
+            }
+        }
+        table[static_cast<size_t>(i)] = x;
+    }
+}
+
+SpatialPath::Shape SpatialPath::parseShape(const String& name)
+{
+    if (name.equalsIgnoreCase("arc"))
+        return Shape::arc;
+    if (name.equalsIgnoreCase("oscillating_arc"))
+        return Shape::oscillatingArc;
+    if (name.equalsIgnoreCase("figure_eight"))
+        return Shape::figureEight;
+    return Shape::circle;
+}
+
+double SpatialPath::getPosition(double cycles) const noexcept
+{
+    double pos = (cycles - std::floor(cycles)) * tableSize;
+    int index = jmin(static_cast<int>(pos), tableSize - 1);
+    double frac = pos - index;
+    return table[static_cast<size_t>(index)]
+         + (table[static_cast<size_t>(index) + 1] - table[static_cast<size_t>(index)]) * frac;
+}
+
+void PanRamp::reset(double pan) noexcept
+{
+    auto gains = getPanGains(pan);
+    left = gains.first;
+    right = gains.second;
+}
+
+void PanRamp::rampTo(double pan, float* gainL, float* gainR, int numSamples) noexcept
+{
+    auto target = getPanGains(pan);
+    float stepL = (target.first - left) / static_cast<float>(numSamples);
+    float stepR = (target.second - right) / static_cast<float>(numSamples);
+    for (int k = 0; k < numSamples; ++k)
+    {
+        gainL[k] = left + stepL * static_cast<float>(k);
+        gainR[k] = right + stepR * static_cast<float>(k);
+    }
+    left = target.first;
+    right = target.second;
+}
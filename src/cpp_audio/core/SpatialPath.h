@@ -0,0 +1,57 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <vector>
+
+/** The lateral position of a source moving around the listener, tabulated
+    over one cycle of its path so that moving it costs a table read rather
+    than trigonometry.
+
+    Shapes follow the Python pathShape names:
+      * circle:          sin of the path phase, a full turn per cycle.
+      * arc:             swings from arcStartDeg to arcEndDeg and back with
+                         a cosine ease.
+      * oscillating_arc: the same swing at constant angular speed.
+      * figure_eight:    a lemniscate with its lobes to the left and right.
+
+    Positions are at unit radius; scale by the path radius to get a pan.
+*/
+class SpatialPath
+{
+public:
+    enum class Shape { circle, arc, oscillatingArc, figureEight };
+
+    /** Entries per cycle; linear interpolation between them is within
+        5e-6 of the exact circle. */
+    static constexpr int tableSize = 2048;
+
+    explicit SpatialPath(Shape shape = Shape::circle, double arcStartDeg = 0.0, double arcEndDeg = 360.0);
+
+    /** Maps a pathShape name; anything unrecognised is a circle. */
+    static Shape parseShape(const juce::String& name);
+
+    /** Position at @p cycles through the path (any value; it wraps). */
+    double getPosition(double cycles) const noexcept;
+
+private:
+    std::vector<double> table;  // tableSize + 1 entries, the last repeating the first
+};
+
+/** Equal-power pan gains evaluated at control points and ramped linearly
+    in between, for sources that move slowly compared to the sample rate.
+*/
+class PanRamp
+{
+public:
+    /** Samples between control points. */
+    static constexpr int controlInterval = 16;
+
+    /** Jumps to @p pan with no ramp. */
+    void reset(double pan) noexcept;
+
+    /** Writes @p numSamples gains that ramp from the current pan to
+        @p pan, reaching it on the sample after the last one written. */
+    void rampTo(double pan, float* gainL, float* gainR, int numSamples) noexcept;
+
+private:
+    float left = 0.0f, right = 0.0f;
+};
@@ -0,0 +1,168 @@
+#include "SphericalHead.h"
+#include <cmath>
+
+using namespace juce;
+
+namespace
+{
+constexpr double speedOfSound = 343.0;
+// Brown and Duda's shadow shelf: the far-ear cut bottoms out at alphaMin
+// theta_min radians round from the ear.
+constexpr double alphaMin = 0.1;
+constexpr double thetaMin = MathConstants<double>::pi * 150.0 / 180.0;
+}
+
+SphericalHeadSpatializer::SphericalHeadSpatializer(double rate, double headRadiusMetres)
+    : sampleRate(rate),
+      headRadius(headRadiusMetres),
+      shadowCorner(2.0 * speedOfSound / headRadiusMetres)
+{
+    // Room for the interpolator taps past the longest delay.
+    int longest = static_cast<int>(std::ceil(delayFor(MathConstants<double>::pi))) + 4;
+    int size = nextPowerOfTwo(longest);
+    mask = size - 1;
+    history.assign(static_cast<size_t>(size), 0.0f);
+    ears[0].side = -1.0;
+    ears[1].side = 1.0;
+    reset(0.0);
+}
+
+double SphericalHeadSpatializer::incidenceAngle(double azimuth, double side) noexcept
+{
+    // Angle between the source and the ear's axis.
+    return std::acos(jlimit(-1.0, 1.0, side * std::sin(azimuth)));
+}
+
+double SphericalHeadSpatializer::delayFor(double incidence) const noexcept
+{
+    // Straight line to the ear while it is in view, then round the head.
+    double seconds = incidence < MathConstants<double>::halfPi
+                         ? headRadius / speedOfSound * (1.0 - std::cos(incidence))
+                         : headRadius / speedOfSound * (incidence - MathConstants<double>::halfPi + 1.0);
+    return 1.0 + seconds * sampleRate;
+}
+
+void SphericalHeadSpatializer::setShadow(Ear& ear, double incidence) noexcept
+{
+    double alpha = (1.0 + alphaMin * 0.5)
+                 + (1.0 - alphaMin * 0.5) * std::cos(incidence / thetaMin * MathConstants<double>::pi);
+    // (beta + alpha s) / (beta + s) through the bilinear transform.
+    double k = 2.0 * sampleRate;
+    double beta = shadowCorner;
+    double norm = 1.0 / (beta + k);
+    ear.b0 = static_cast<float>((beta + alpha * k) * norm);
+    ear.b1 = static_cast<float>((beta - alpha * k) * norm);
+    ear.a1 = static_cast<float>((beta - k) * norm);
+}
+
+void SphericalHeadSpatializer::reset(double azimuth)
+{
+    writePos = 0;
+    std::fill(history.begin(), history.end(), 0.0f);
+    for (auto& ear : ears)
+    {
+        double incidence = incidenceAngle(azimuth, ear.side);
+        ear.delaySamples = delayFor(incidence);
+        setShadow(ear, incidence);
+        ear.x1 = ear.y1 = 0.0f;
+    }
+}
+
+void SphericalHeadSpatializer::process(const float* input, float* left, float* right,
+                                       int numSamples, double azimuth) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    double targetDelay[2], step[2];
+    for (int e = 0; e < 2; ++e)
+    {
+        double incidence = incidenceAngle(azimuth, ears[e].side);
+        targetDelay[e] = delayFor(incidence);
+        step[e] = (targetDelay[e] - ears[e].delaySamples) / numSamples;
+        setShadow(ears[e], incidence);
+    }
+
+    float* outputs[2] = { left, right };
+    for (int k = 0; k < numSamples; ++k)
+    {
+        history[static_cast<size_t>(writePos)] = input[k];
+
+        for (int e = 0; e < 2; ++e)
+        {
+            Ear& ear = ears[e];
+            double d = ear.delaySamples + step[e] * k;
+            int n = static_cast<int>(d);
+            float f = static_cast<float>(d - n);
+
+            // Third-order Lagrange through the samples n - 1 to n + 2 back.
+            const float* buf = history.data();
+            float xm1 = buf[(writePos - n + 1) & mask];
+            float x0  = buf[(writePos - n) & mask];
+            float x1  = buf[(writePos - n - 1) & mask];
+            float x2  = buf[(writePos - n - 2) & mask];
+            float fm1 = f - 1.0f, fm2 = f - 2.0f, fp1 = f + 1.0f;
+            float delayed = -f * fm1 * fm2 * (1.0f / 6.0f) * xm1
+                          + fp1 * fm1 * fm2 * 0.5f * x0
+                          - fp1 * f * fm2 * 0.5f * x1
+                          + fp1 * f * fm1 * (1.0f / 6.0f) * x2;
+
+            float y = ear.b0 * delayed + ear.b1 * ear.x1 - ear.a1 * ear.y1;
+            ear.x1 = delayed;
+            ear.y1 = y;
+            outputs[e][k] = y;
+        }
+        writePos = (writePos + 1) & mask;
+    }
+
+    for (int e = 0; e < 2; ++e)
+        ears[e].delaySamples = targetDelay[e];
+}
+
+bool SphericalHeadSpatializer::loadHrir(const File& file)
+{
+    AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    std::unique_ptr<AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr || reader->sampleRate <= 0.0)
+        return false;
+
+    double ratio = reader->sampleRate / sampleRate;
+    int sourceLength = static_cast<int>(jmin<int64>(reader->lengthInSamples,
+                                                    static_cast<int64>(std::ceil(maxHrirLength * ratio))));
+    if (sourceLength <= 0)
+        return false;
+
+    AudioBuffer<float> source(2, sourceLength);
+    reader->read(&source, 0, sourceLength, 0, true, true);
+    if (reader->numChannels == 1)
+        source.copyFrom(1, 0, source, 0, 0, sourceLength);
+
+    int length = jmin(maxHrirLength, static_cast<int>(sourceLength / ratio));
+    AudioBuffer<float> hrir(2, jmax(1, length));
+    hrir.clear();
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        if (ratio == 1.0)
+        {
+            hrir.copyFrom(ch, 0, source, ch, 0, length);
+            continue;
+        }
+        // Scaled so the response keeps its gain at the new rate.
+        LagrangeInterpolator interpolator;
+        interpolator.process(ratio, source.getReadPointer(ch), hrir.getWritePointer(ch), length);
+        hrir.applyGain(ch, 0, length, static_cast<float>(ratio));
+    }
+
+    hrirLeft = std::make_unique<PartitionedConvolver>(hrir.getReadPointer(0), hrir.getNumSamples());
+    hrirRight = std::make_unique<PartitionedConvolver>(hrir.getReadPointer(1), hrir.getNumSamples());
+    return true;
+}
+
+void SphericalHeadSpatializer::applyHrir(float* left, float* right, int numSamples)
+{
+    if (hrirLeft == nullptr)
+        return;
+    hrirLeft->process(left, numSamples);
+    hrirRight->process(right, numSamples);
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "PartitionedConvolver.h"
+#include <memory>
+#include <vector>
+
+/** Places a mono source around a spherical head (Brown and Duda's
+    structural model), for headphone movement that sounds outside the head
+    rather than panned between the ears.
+
+    Each ear gets:
+      * a delay for the path round the head to it, read from a delay line
+        with cubic Lagrange interpolation so it can change smoothly
+        (interaural time difference, up to about 0.66 ms);
+      * a one-pole, one-zero head-shadow shelf that lifts high frequencies
+        at the near ear and cuts them at the far one (interaural level
+        difference).
+
+    The azimuth is set at control rate: the delays ramp linearly across each
+    process() call and the shelves are recomputed once per call. Azimuth is
+    in radians, 0 straight ahead and positive to the right.
+
+    Optionally a short stereo HRIR is convolved after the head model, for
+    pinna and room cues the sphere cannot give.
+*/
+class SphericalHeadSpatializer
+{
+public:
+    /** Longest HRIR, in samples at the render rate, that is kept. */
+    static constexpr int maxHrirLength = 512;
+
+    explicit SphericalHeadSpatializer(double sampleRate, double headRadiusMetres = 0.0875);
+
+    /** Sets the azimuth with no ramp and clears the delay lines. */
+    void reset(double azimuth);
+
+    /** Spatialises @p numSamples of @p input into @p left and @p right,
+        moving from the previous azimuth to @p azimuth. */
+    void process(const float* input, float* left, float* right, int numSamples, double azimuth) noexcept;
+
+    /** Loads a mono or stereo impulse response from @p file, resampled to
+        the render rate and cut to maxHrirLength. False if it cannot be read. */
+    bool loadHrir(const juce::File& file);
+
+    /** Convolves the output with the loaded HRIR, if any. Run it over the
+        finished output in order; it keeps its own history. */
+    void applyHrir(float* left, float* right, int numSamples);
+
+private:
+    struct Ear
+    {
+        double side = 0.0;           // -1 left, +1 right
+        double delaySamples = 0.0;
+        // Head-shadow shelf
+        float b0 = 1.0f, b1 = 0.0f, a1 = 0.0f;
+        float x1 = 0.0f, y1 = 0.0f;
+    };
+
+    void setShadow(Ear& ear, double incidence) noexcept;
+    double delayFor(double incidence) const noexcept;
+    static double incidenceAngle(double azimuth, double side) noexcept;
+
+    double sampleRate;
+    double headRadius;
+    double shadowCorner;              // 2 c / a, in rad/s
+    std::vector<float> history;       // input ring, a power of two long
+    int writePos = 0;
+    int mask = 0;
+    Ear ears[2];
+    std::unique_ptr<PartitionedConvolver> hrirLeft, hrirRight;
+};
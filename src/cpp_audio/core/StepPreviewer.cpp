@@ -1,45 +1,70 @@
 #include "StepPreviewer.h"
+#include "RealtimeSafety.h"
 
-class StepPreviewJob : public juce::ThreadPoolJob {
+namespace {
+// Arms the realtime-safety detector around the whole transport chain.
+class CheckedAudioSourcePlayer : public juce::AudioSourcePlayer {
 public:
-  StepPreviewJob(StepPreviewer &o, Step s, GlobalSettings g, double dur)
-      : juce::ThreadPoolJob("StepPreviewJob"), owner(o), step(std::move(s)),
-        settings(std::move(g)), previewDur(dur) {}
-
-  JobStatus runJob() override;
-
-private:
-  StepPreviewer &owner;
-  Step step;
-  GlobalSettings settings;
-  double previewDur = 0.0;
+  void audioDeviceIOCallback(const float **inputChannelData,
+                             int numInputChannels, float **outputChannelData,
+                             int numOutputChannels, int numSamples) override {
+    REALTIME_SECTION();
+    juce::AudioSourcePlayer::audioDeviceIOCallback(
+        inputChannelData, numInputChannels, outputChannelData,
+        numOutputChannels, numSamples);
+  }
 };
+} // namespace
 
 StepPreviewer::StepPreviewer(juce::AudioDeviceManager &dm) : deviceManager(dm) {
-  player = std::make_unique<juce::AudioSourcePlayer>();
+  player = std::make_unique<CheckedAudioSourcePlayer>();
   player->setSource(&transport);
 }
 
 StepPreviewer::~StepPreviewer() {
-
-  cancelJob();
-
   if (playing)
     deviceManager.removeAudioCallback(player.get());
   player->setSource(nullptr);
-  transport.setSource(nullptr);
+  releaseSource();
 }
 
 bool StepPreviewer::loadStep(const Step &step, const GlobalSettings &settings,
                              double previewDuration) {
-  cancelJob();
+  releaseSource();
   sampleRate = settings.sampleRate;
-  ready.store(false);
-  job.reset(new StepPreviewJob(*this, step, settings, previewDuration));
-  pool.addJob(job.get(), true);
+
+  juce::PositionableAudioSource *newSource = nullptr;
+  if (liveEditing && LivePreviewSource::canPlay(step)) {
+    liveSource = std::make_unique<LivePreviewSource>(step, sampleRate,
+                                                     previewDuration);
+    newSource = liveSource.get();
+  } else {
+    // Rendering starts on the source's own thread; it can be played at once.
+    source = std::make_unique<StreamingStepSource>(step, sampleRate,
+                                                   previewDuration, quality);
+    newSource = source.get();
+  }
+  transport.setSource(newSource, 0, nullptr, sampleRate);
+  lengthSeconds = transport.getLengthInSeconds();
+  transport.setPosition(0.0);
   return true;
 }
 
+bool StepPreviewer::updateStep(const Step &step, double previewDuration) {
+  if (liveSource == nullptr ||
+      static_cast<juce::int64>(previewDuration * sampleRate) !=
+          liveSource->getTotalLength())
+    return false;
+  return liveSource->updateStep(step);
+}
+
+bool StepPreviewer::updateVoiceParameter(int voiceIndex,
+                                         const juce::String &name,
+                                         double value) {
+  return liveSource != nullptr &&
+         liveSource->setParameter(voiceIndex, name, value);
+}
+
 void StepPreviewer::play() {
   if (playing)
     return;
@@ -77,55 +102,13 @@ double StepPreviewer::getLength() const { return lengthSeconds; }
 
 bool StepPreviewer::isPlaying() const { return playing; }
 
-void StepPreviewer::cancelJob() {
-  if (job) {
-    pool.removeJob(job.get(), true, 4000);
-    job.reset();
-  }
-  ready.store(false);
-}
-
-bool StepPreviewer::isReady() const { return ready.load(); }
-
-juce::AudioBuffer<float>
-StepPreviewer::generateAudio(const Step &step, const GlobalSettings &settings,
-                             double previewDuration) {
-  Track t;
-  t.settings = settings;
-  t.settings.crossfadeDuration = 0.0; // no crossfade
-  t.steps.push_back(step);
-
-  auto stepBuffer = assembleTrack(t);
-
-  int previewSamples = static_cast<int>(previewDuration * settings.sampleRate);
-  juce::AudioBuffer<float> result(2, std::max(0, previewSamples));
-  result.clear();
-
-  if (stepBuffer.getNumSamples() == 0 || previewSamples <= 0)
-    return result;
-
-  int pos = 0;
-  while (pos < previewSamples) {
-    int remain = previewSamples - pos;
-    int copy = std::min(remain, stepBuffer.getNumSamples());
-    for (int ch = 0; ch < 2; ++ch)
-      result.copyFrom(ch, pos, stepBuffer, ch, 0, copy);
-    pos += copy;
-  }
-  return result;
+void StepPreviewer::releaseSource() {
+  transport.setSource(nullptr);
+  source.reset();
+  liveSource.reset();
+  lengthSeconds = 0.0;
 }
 
-StepPreviewJob::JobStatus StepPreviewJob::runJob() {
-  auto audio = owner.generateAudio(step, settings, previewDur);
-  {
-    const juce::ScopedLock sl(owner.lock);
-    owner.bufferSource = std::make_unique<BufferAudioSource>();
-    owner.bufferSource->setBuffer(std::move(audio));
-    owner.transport.setSource(owner.bufferSource.get(), 0, nullptr,
-                              owner.sampleRate);
-    owner.lengthSeconds = owner.transport.getLengthInSeconds();
-    owner.transport.setPosition(0.0);
-  }
-  owner.ready.store(true);
-  return jobHasFinished;
+bool StepPreviewer::isReady() const {
+  return liveSource != nullptr || (source != nullptr && source->isReady());
 }
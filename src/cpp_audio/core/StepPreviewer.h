@@ -1,11 +1,9 @@
 #pragma once
 #include "Track.h"
-#include "BufferAudioSource.h"
+#include "LivePreviewSource.h"
+#include "StreamingStepSource.h"
 #include <juce_audio_utils/juce_audio_utils.h>
 #include <juce_core/juce_core.h>
-#include <atomic>
-
-class StepPreviewJob;
 
 class StepPreviewer
 {
@@ -15,6 +13,27 @@ public:
 
     bool loadStep(const Step& step, const GlobalSettings& settings, double previewDuration);
 
+    /** In live-edit mode, steps whose voices LivePreviewSource supports are
+        played by running voices rather than a render, so edits are heard
+        without reloading. Takes effect on the next loadStep(). */
+    void setLiveEditing(bool shouldBeLive) { liveEditing = shouldBeLive; }
+    bool isLiveEditing() const { return liveEditing; }
+    /** True if the loaded step is playing through live voices. */
+    bool isLive() const { return liveSource != nullptr; }
+
+    /** Quality rendered previews use; draft trades accuracy for a much
+        faster render. Takes effect on the next loadStep(). */
+    void setRenderQuality(RenderQuality newQuality) { quality = newQuality; }
+    RenderQuality getRenderQuality() const { return quality; }
+
+    /** Moves a live preview to @p step's parameters without interrupting
+        playback. Returns false if the step has to be reloaded instead
+        (not live, different voices or length, or a non-live parameter
+        changed). */
+    bool updateStep(const Step& step, double previewDuration);
+    /** Sends one parameter edit to a live voice; false if it is not live. */
+    bool updateVoiceParameter(int voiceIndex, const juce::String& name, double value);
+
     void play();
     void pause();
     void stop();
@@ -26,20 +45,17 @@ public:
     bool isReady() const;
 
 private:
-    void cancelJob();
-    friend class StepPreviewJob;
-    juce::AudioBuffer<float> generateAudio(const Step& step, const GlobalSettings& settings, double previewDuration);
+    void releaseSource();
 
     juce::AudioDeviceManager& deviceManager;
     std::unique_ptr<juce::AudioSourcePlayer> player;
     juce::AudioTransportSource transport;
-    std::unique_ptr<BufferAudioSource> bufferSource;
+    std::unique_ptr<StreamingStepSource> source;
+    std::unique_ptr<LivePreviewSource> liveSource;
     double sampleRate = 44100.0;
     double lengthSeconds = 0.0;
     bool playing = false;
-    std::atomic<bool> ready { false };
-    juce::ThreadPool pool { 1 };
-    std::unique_ptr<juce::ThreadPoolJob> job;
-    juce::CriticalSection lock;
+    bool liveEditing = false;
+    RenderQuality quality = RenderQuality::normal;
 };
 
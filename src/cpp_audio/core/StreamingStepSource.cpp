@@ -0,0 +1,136 @@
+#include "StreamingStepSource.h"
+#include "PeriodicTiling.h"
+#include "RealtimeSafety.h"
+#include "Trace.h"
+#include "Track.h"
+#include "TrackRenderer.h"
+
+namespace
+{
+    // Samples rendered between checks for a stop, and the longest the
+    // destructor waits for a synth call to return.
+    constexpr int renderBlockSamples = 16384;
+    constexpr int stopTimeoutMs = 10000;
+}
+
+StreamingStepSource::StreamingStepSource(Step stepToPlay, double sr, double lengthSeconds,
+                                         RenderQuality q)
+    : juce::Thread("StreamingStepSource"),
+      step(std::move(stepToPlay)),
+      sampleRate(sr),
+      quality(q),
+      stepLength(static_cast<juce::int64>(step.durationSeconds * sr)),
+      totalLength(std::max<juce::int64>(0, static_cast<juce::int64>(lengthSeconds * sr)))
+{
+    startThread();
+}
+
+StreamingStepSource::~StreamingStepSource()
+{
+    // run() stops between blocks; a synth call cannot be interrupted.
+    stopThread(stopTimeoutMs);
+}
+
+void StreamingStepSource::prepareToPlay(int /*samplesPerBlockExpected*/, double /*newSampleRate*/)
+{
+}
+
+void StreamingStepSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& info)
+{
+    REALTIME_SECTION();
+
+    // Only the first `available` samples are complete; the render thread
+    // writes nothing below them.
+    const juce::int64 available = validSamples.load();
+    juce::AudioBuffer<float>& out = *info.buffer;
+    juce::int64 pos = position.load();
+    int written = 0;
+
+    while (written < info.numSamples)
+    {
+        if (pos >= totalLength)
+        {
+            if (! looping.load() || totalLength == 0)
+                break;
+            pos = 0;
+        }
+
+        int chunk = static_cast<int>(std::min<juce::int64>(info.numSamples - written, totalLength - pos));
+        const int destStart = info.startSample + written;
+
+        if (available <= 0 || stepLength <= 0)
+        {
+            for (int ch = 0; ch < out.getNumChannels(); ++ch)
+                out.clear(ch, destStart, chunk);
+        }
+        else
+        {
+            const juce::int64 period = bufferIsLoop ? available : stepLength;
+            const juce::int64 stepPos = pos % period;
+            chunk = static_cast<int>(std::min<juce::int64>(chunk, period - stepPos));
+
+            if (stepPos < available)
+            {
+                chunk = static_cast<int>(std::min<juce::int64>(chunk, available - stepPos));
+                for (int ch = 0; ch < out.getNumChannels(); ++ch)
+                    out.copyFrom(ch, destStart, buffer, ch % buffer.getNumChannels(),
+                                 static_cast<int>(stepPos), chunk);
+            }
+            else
+            {
+                // Not rendered yet.
+                for (int ch = 0; ch < out.getNumChannels(); ++ch)
+                    out.clear(ch, destStart, chunk);
+            }
+        }
+
+        pos += chunk;
+        written += chunk;
+    }
+
+    if (written < info.numSamples)
+        for (int ch = 0; ch < out.getNumChannels(); ++ch)
+            out.clear(ch, info.startSample + written, info.numSamples - written);
+
+    position.store(pos);
+}
+
+void StreamingStepSource::run()
+{
+    registerTraceThread();
+    TRACE_SCOPE("previewRender");
+    if (stepLength <= 0)
+        return;
+
+    if (renderStepLoop(step, sampleRate, buffer, quality))
+    {
+        bufferIsLoop = true;
+        validSamples.store(buffer.getNumSamples());
+        fullyRendered = true;
+        return;
+    }
+
+    // The renderer picks pieces, prefixes or a whole render for the step;
+    // each block it returns is published as soon as it is copied in.
+    Track track;
+    track.steps.push_back(step);
+    TrackRenderer renderer(track, quality);
+    renderer.prepare(sampleRate);
+
+    const juce::int64 length = std::min(stepLength, renderer.getTotalLength());
+    buffer.setSize(2, static_cast<int>(length));
+    juce::AudioBuffer<float> block(2, renderBlockSamples);
+    juce::int64 done = 0;
+    while (done < length && ! threadShouldExit())
+    {
+        int n = renderer.render(block, static_cast<int>(std::min<juce::int64>(renderBlockSamples,
+                                                                              length - done)));
+        if (n <= 0)
+            break;
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            buffer.copyFrom(ch, static_cast<int>(done), block, ch, 0, n);
+        done += n;
+        validSamples.store(done);
+    }
+    fullyRendered = done >= length;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include "../models/TrackData.h"
+#include "RenderQuality.h"
+#include <atomic>
+
+/** Plays a single step, looped, for a preview of a given length, rendering
+    it on a background thread so playback can start almost immediately.
+
+    Periodic holds (see PeriodicTiling.h) are rendered as one loop, which
+    is ready within milliseconds and played as a seamless loop, always at
+    the output rate since it is short. Any other step is rendered through a
+    TrackRenderer at the given RenderQuality, a block at a time, into a
+    buffer holding the whole step: steps that do not depend on their length
+    arrive in pieces or growing prefixes long before the whole step has
+    been synthesised, anything else arrives whole.
+
+    Audio that has not been rendered yet plays as silence. The audio thread
+    only reads the part of the buffer already published; the render thread
+    only writes past it. Destroying the source stops the render between
+    blocks; a synth call already running is waited for, up to a bound.
+*/
+class StreamingStepSource : public juce::PositionableAudioSource,
+                            private juce::Thread
+{
+public:
+    StreamingStepSource(Step stepToPlay, double sampleRate, double lengthSeconds,
+                        RenderQuality quality = RenderQuality::normal);
+    ~StreamingStepSource() override;
+
+    /** True once the first audio has been rendered. */
+    bool isReady() const noexcept { return validSamples.load() > 0; }
+    /** True once the whole step is available. */
+    bool isFullyRendered() const noexcept { return fullyRendered.load(); }
+
+    void prepareToPlay(int samplesPerBlockExpected, double newSampleRate) override;
+    void releaseResources() override {}
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& info) override;
+
+    void setNextReadPosition(juce::int64 newPosition) override { position.store(newPosition); }
+    juce::int64 getNextReadPosition() const override { return position.load(); }
+    juce::int64 getTotalLength() const override { return totalLength; }
+    bool isLooping() const override { return looping.load(); }
+    void setLooping(bool shouldLoop) override { looping.store(shouldLoop); }
+
+private:
+    void run() override;
+
+    Step step;
+    double sampleRate;
+    RenderQuality quality;
+    juce::int64 stepLength;
+    juce::int64 totalLength;
+
+    juce::AudioBuffer<float> buffer; // one loop, or the step from its start
+    bool bufferIsLoop = false;       // written before validSamples is first set
+    std::atomic<juce::int64> validSamples { 0 };
+    std::atomic<juce::int64> position { 0 };
+    std::atomic<bool> looping { false };
+    std::atomic<bool> fullyRendered { false };
+};
@@ -0,0 +1,172 @@
+#include "Trace.h"
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    struct Span
+    {
+        const char* name;
+        char detail[48];
+        juce::int64 start;
+        juce::int64 end;
+    };
+
+    /** Single-writer buffer owned by one thread. The writer publishes each
+        span by bumping `count` with release ordering; the exporter reads up
+        to an acquired count, so no lock is taken on the recording path. */
+    struct ThreadBuffer
+    {
+        static constexpr int capacity = 32768;
+
+        explicit ThreadBuffer(int tid, juce::String name)
+            : threadId(tid), threadName(std::move(name)), spans(capacity) {}
+
+        const int threadId;
+        const juce::String threadName;
+        std::vector<Span> spans;
+        std::atomic<int> count { 0 };
+        std::atomic<int> dropped { 0 };
+    };
+
+    struct Registry
+    {
+        std::mutex lock;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        const juce::int64 epoch = juce::Time::getHighResolutionTicks();
+    };
+
+    Registry& getRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    // Buffers live for the whole process so spans from threads that have
+    // already exited can still be exported. Registration happens once per
+    // thread (registerTraceThread() or the first span it records) and is
+    // the only locked step.
+    ThreadBuffer& getThreadBuffer(const juce::String& threadName = {})
+    {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (buffer == nullptr)
+        {
+            auto& reg = getRegistry();
+            std::lock_guard<std::mutex> guard(reg.lock);
+            auto* current = juce::Thread::getCurrentThread();
+            int tid = static_cast<int>(reg.buffers.size()) + 1;
+            juce::String name = threadName.isNotEmpty() ? threadName
+                              : current != nullptr      ? current->getThreadName()
+                                                        : juce::String("thread ") + juce::String(tid);
+            reg.buffers.push_back(std::make_unique<ThreadBuffer>(tid, name));
+            buffer = reg.buffers.back().get();
+        }
+        return *buffer;
+    }
+
+    double ticksToMicroseconds(juce::int64 ticks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks - getRegistry().epoch) * 1.0e6;
+    }
+}
+
+void registerTraceThread(const juce::String& name)
+{
+#if DIY_AV_TRACING
+    getThreadBuffer(name);
+#else
+    juce::ignoreUnused(name);
+#endif
+}
+
+ScopedTraceSpan::ScopedTraceSpan(const char* name, const char* detail) noexcept
+    : spanName(name), spanDetail(detail), startTicks(juce::Time::getHighResolutionTicks())
+{
+}
+
+ScopedTraceSpan::~ScopedTraceSpan() noexcept
+{
+    auto endTicks = juce::Time::getHighResolutionTicks();
+    auto& buffer = getThreadBuffer();
+    int index = buffer.count.load(std::memory_order_relaxed);
+    if (index >= ThreadBuffer::capacity)
+    {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto& span = buffer.spans[static_cast<size_t>(index)];
+    span.name = spanName;
+    span.detail[0] = '\0';
+    if (spanDetail != nullptr)
+    {
+        std::strncpy(span.detail, spanDetail, sizeof(span.detail) - 1);
+        span.detail[sizeof(span.detail) - 1] = '\0';
+    }
+    span.start = startTicks;
+    span.end = endTicks;
+    buffer.count.store(index + 1, std::memory_order_release);
+}
+
+bool exportChromeTrace(const juce::File& file)
+{
+    juce::Array<juce::var> events;
+    auto& reg = getRegistry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+
+    for (const auto& buffer : reg.buffers)
+    {
+        auto* meta = new juce::DynamicObject();
+        meta->setProperty("name", "thread_name");
+        meta->setProperty("ph", "M");
+        meta->setProperty("pid", 1);
+        meta->setProperty("tid", buffer->threadId);
+        auto* metaArgs = new juce::DynamicObject();
+        metaArgs->setProperty("name", buffer->threadName);
+        meta->setProperty("args", juce::var(metaArgs));
+        events.add(juce::var(meta));
+
+        int n = buffer->count.load(std::memory_order_acquire);
+        for (int i = 0; i < n; ++i)
+        {
+            const auto& span = buffer->spans[static_cast<size_t>(i)];
+            auto* ev = new juce::DynamicObject();
+            ev->setProperty("name", juce::String(span.name));
+            ev->setProperty("cat", "render");
+            ev->setProperty("ph", "X");
+            ev->setProperty("pid", 1);
+            ev->setProperty("tid", buffer->threadId);
+            ev->setProperty("ts", ticksToMicroseconds(span.start));
+            ev->setProperty("dur", ticksToMicroseconds(span.end) - ticksToMicroseconds(span.start));
+            if (span.detail[0] != '\0')
+            {
+                auto* args = new juce::DynamicObject();
+                args->setProperty("detail", juce::String(span.detail));
+                ev->setProperty("args", juce::var(args));
+            }
+            events.add(juce::var(ev));
+        }
+
+        if (int dropped = buffer->dropped.load(std::memory_order_relaxed))
+            DBG("Trace buffer for " << buffer->threadName << " dropped " << dropped << " spans");
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("traceEvents", events);
+    root->setProperty("displayTimeUnit", "ms");
+    return file.replaceWithText(juce::JSON::toString(juce::var(root), true));
+}
+
+void clearTrace()
+{
+    auto& reg = getRegistry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+    for (auto& buffer : reg.buffers)
+    {
+        buffer->count.store(0, std::memory_order_release);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <juce_core/juce_core.h>
+
+/** Lightweight span tracing for the render pipeline.
+
+    Spans are recorded into per-thread buffers without locking and can be
+    exported as Chrome/Perfetto trace JSON (load it in chrome://tracing or
+    ui.perfetto.dev). Recording is compiled in only when DIY_AV_TRACING is
+    defined to 1 (CMake option DIY_AV_ENABLE_TRACING); otherwise TRACE_SCOPE
+    expands to nothing and the export functions write an empty trace.
+*/
+
+/** RAII span. @p name must be a string literal (the pointer is stored);
+    @p detail is copied and may be a temporary. */
+class ScopedTraceSpan
+{
+public:
+    explicit ScopedTraceSpan(const char* name, const char* detail = nullptr) noexcept;
+    ~ScopedTraceSpan() noexcept;
+
+    ScopedTraceSpan(const ScopedTraceSpan&) = delete;
+    ScopedTraceSpan& operator=(const ScopedTraceSpan&) = delete;
+
+private:
+    const char* spanName;
+    const char* spanDetail;
+    juce::int64 startTicks;
+};
+
+/** Sets up the calling thread's span buffer, which is otherwise allocated
+    (about 2 MB, under a lock) when the thread records its first span. Call
+    it at the start of render threads that feed the audio callback. @p name
+    labels the thread in the trace; by default the juce::Thread name is
+    used. Does nothing when tracing is compiled out. */
+void registerTraceThread(const juce::String& name = {});
+
+/** Writes every span recorded so far as Chrome trace JSON.
+    @return true on success. */
+bool exportChromeTrace(const juce::File& file);
+
+/** Discards recorded spans. Only call while no render is in progress. */
+void clearTrace();
+
+/** True when tracing was compiled in. */
+constexpr bool isTracingEnabled()
+{
+#if DIY_AV_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+#if DIY_AV_TRACING
+ #define TRACE_SCOPE(name) ScopedTraceSpan JUCE_JOIN_MACRO(traceSpan_, __LINE__) (name)
+ #define TRACE_SCOPE_DETAIL(name, detail) ScopedTraceSpan JUCE_JOIN_MACRO(traceSpan_, __LINE__) (name, detail)
+#else
+ #define TRACE_SCOPE(name)
+ #define TRACE_SCOPE_DETAIL(name, detail)
+#endif
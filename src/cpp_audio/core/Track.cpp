@@ -1,15 +1,15 @@
 #include "Track.h"
 #include "../synths/SynthFunctions.h"
 #include "AudioUtils.h"
+#include "Kernels.h"
+#include "PeriodicTiling.h"
+#include "Trace.h"
 #include "VarUtils.h"
 #include <juce_audio_formats/juce_audio_formats.h>
 #include <juce_data_structures/juce_data_structures.h>
 #include <juce_dsp/juce_dsp.h>
 #include <map>
 
-using SynthFunc = juce::AudioBuffer<float> (*)(double, double,
-                                               const juce::NamedValueSet &);
-
 static std::map<juce::String, SynthFunc> synthMap{
     {"binaural_beat", binauralBeat},
     {"binaural_beat_transition", binauralBeatTransition},
@@ -45,25 +45,58 @@ std::vector<juce::String> getAvailableSynthNames() {
   return names;
 }
 
+SynthFunc findSynthFunction(const juce::String &name) {
+  auto it = synthMap.find(name);
+  return it != synthMap.end() ? it->second : nullptr;
+}
+
+// Resamples @p in to @p destSamples samples, or to its own length at the new
+// rate if @p destSamples is negative.
 static juce::AudioBuffer<float>
 resampleBuffer(const juce::AudioBuffer<float> &in, double srcRate,
-               double dstRate) {
-  if (std::abs(srcRate - dstRate) < 1e-6)
+               double dstRate, int destSamples = -1) {
+  if (std::abs(srcRate - dstRate) < 1e-6 &&
+      (destSamples < 0 || destSamples == in.getNumSamples()))
     return in;
 
-  int destSamples = static_cast<int>(in.getNumSamples() * dstRate / srcRate);
+  TRACE_SCOPE("resample");
+  if (destSamples < 0)
+    destSamples = static_cast<int>(in.getNumSamples() * dstRate / srcRate);
+
+  // The interpolator reads a few samples ahead; feed it silence past the end.
+  int needed =
+      static_cast<int>(std::ceil(destSamples * srcRate / dstRate)) + 4;
+  const juce::AudioBuffer<float> *src = &in;
+  juce::AudioBuffer<float> padded;
+  if (needed > in.getNumSamples()) {
+    padded.setSize(in.getNumChannels(), needed);
+    padded.clear();
+    for (int ch = 0; ch < in.getNumChannels(); ++ch)
+      padded.copyFrom(ch, 0, in, ch, 0, in.getNumSamples());
+    src = &padded;
+  }
+
   juce::AudioBuffer<float> out(in.getNumChannels(), destSamples);
   for (int ch = 0; ch < in.getNumChannels(); ++ch) {
     juce::LagrangeInterpolator interp;
     interp.reset();
-    interp.process(srcRate / dstRate, in.getReadPointer(ch),
+    interp.process(srcRate / dstRate, src->getReadPointer(ch),
                    out.getWritePointer(ch), destSamples);
   }
   return out;
 }
 
+static void normalisePeak(juce::AudioBuffer<float> &buffer) {
+  float peak = 0.0f;
+  for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    peak = std::max(peak, buffer.getMagnitude(ch, 0, buffer.getNumSamples()));
+  if (peak > 1.0f)
+    buffer.applyGain(1.0f / peak);
+}
+
 static juce::AudioBuffer<float> loadAudioFile(const juce::File &file,
                                               double sampleRate) {
+  TRACE_SCOPE_DETAIL("decodeAudio", file.getFileName().toRawUTF8());
   juce::AudioFormatManager fm;
   fm.registerBasicFormats();
   std::unique_ptr<juce::AudioFormatReader> reader(fm.createReaderFor(file));
@@ -85,12 +118,16 @@ static juce::AudioBuffer<float> loadAudioFile(const juce::File &file,
 }
 
 Track loadTrackFromJson(const juce::File &file) {
-  Track track;
+  TRACE_SCOPE("loadTrackFromJson");
   auto stream = file.createInputStream();
   if (!stream)
-    return track;
+    return {};
+  return parseTrackJson(stream->readEntireStreamAsString());
+}
 
-  juce::var parsed = juce::JSON::parse(stream->readEntireStreamAsString());
+Track parseTrackJson(const juce::String &json) {
+  Track track;
+  juce::var parsed = juce::JSON::parse(json);
   if (auto *obj = parsed.getDynamicObject()) {
     if (auto *gs = obj->getProperty("global_settings").getDynamicObject()) {
       track.settings.sampleRate =
@@ -99,6 +136,11 @@ Track loadTrackFromJson(const juce::File &file) {
           getPropertyWithDefault(gs, "crossfade_duration", 1.0);
       track.settings.crossfadeCurve =
           gs->getProperty("crossfade_curve").toString();
+      track.settings.crossfadeAlignWindow =
+          getPropertyWithDefault(gs, "crossfade_align_window", 0.0);
+      track.settings.renderQuality =
+          getPropertyWithDefault(gs, "render_quality", juce::String("normal"))
+              .toString();
       track.settings.outputFilename =
           getPropertyWithDefault(gs, "output_filename",
                                  juce::String("my_track.wav"))
@@ -164,6 +206,7 @@ Track loadTrackFromJson(const juce::File &file) {
                         vobj->getProperty("params").getDynamicObject())
                   voice.params = paramsObj->getProperties();
                 voice.description = vobj->getProperty("description").toString();
+                voice.voiceId = vobj->getProperty("voice_id").toString();
               }
               step.voices.push_back(std::move(voice));
             }
@@ -189,6 +232,12 @@ bool saveTrackToJson(const Track &track, const juce::File &file) {
     gs->setProperty("sample_rate", track.settings.sampleRate);
     gs->setProperty("crossfade_duration", track.settings.crossfadeDuration);
     gs->setProperty("crossfade_curve", track.settings.crossfadeCurve);
+    if (track.settings.crossfadeAlignWindow > 0.0)
+      gs->setProperty("crossfade_align_window",
+                      track.settings.crossfadeAlignWindow);
+    if (parseRenderQuality(track.settings.renderQuality) !=
+        RenderQuality::normal)
+      gs->setProperty("render_quality", track.settings.renderQuality);
     gs->setProperty("output_filename", track.settings.outputFilename);
     obj->setProperty("global_settings", juce::var(gs));
   }
@@ -246,6 +295,8 @@ bool saveTrackToJson(const Track &track, const juce::File &file) {
         vobj->setProperty("is_transition", voice.isTransition);
         vobj->setProperty("params", namedValueSetToVar(voice.params));
         vobj->setProperty("description", voice.description);
+        if (voice.voiceId.isNotEmpty())
+          vobj->setProperty("voice_id", voice.voiceId);
         voicesVar.add(juce::var(vobj));
       }
       sobj->setProperty("voices", voicesVar);
@@ -291,6 +342,7 @@ int loadExternalStepsFromJson(const juce::File &file,
                         vobj->getProperty("params").getDynamicObject())
                   voice.params = paramsObj->getProperties();
                 voice.description = vobj->getProperty("description").toString();
+                voice.voiceId = vobj->getProperty("voice_id").toString();
               }
               step.voices.push_back(std::move(voice));
             }
@@ -308,6 +360,7 @@ int loadExternalStepsFromJson(const juce::File &file,
 
 bool writeWavFile(const juce::File &file,
                   const juce::AudioBuffer<float> &buffer, double sampleRate) {
+  TRACE_SCOPE("writeWavFile");
   juce::WavAudioFormat format;
   std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
   if (!stream)
@@ -320,10 +373,87 @@ bool writeWavFile(const juce::File &file,
   return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
 }
 
+juce::AudioBuffer<float> renderStep(const Step &step, double sampleRate,
+                                    VoiceStateMap *carried,
+                                    bool continuesIntoNext,
+                                    RenderQuality quality, bool normalise) {
+  TRACE_SCOPE("renderStep");
+  int stepSamples = static_cast<int>(step.durationSeconds * sampleRate);
+  juce::AudioBuffer<float> stepBuf(2, std::max(0, stepSamples));
+  stepBuf.clear();
+  if (stepSamples <= 0)
+    return stepBuf;
+
+  if (quality != RenderQuality::normal) {
+    // Tell the synths, then render as normal at the internal rate. Voice
+    // state is kept as phases, so it carries across the rate change.
+    Step tagged = step;
+    for (auto &voice : tagged.voices)
+      voice.params.set(renderQualityParam, getRenderQualityName(quality));
+    double internalRate = getInternalSampleRate(quality, sampleRate);
+    auto rendered = renderStep(tagged, internalRate, carried, continuesIntoNext,
+                               RenderQuality::normal, normalise);
+    if (internalRate == sampleRate)
+      return rendered;
+    stepBuf = resampleBuffer(rendered, internalRate, sampleRate, stepSamples);
+    if (normalise)
+      normalisePeak(stepBuf);
+    return stepBuf;
+  }
+
+  Step seeded = step;
+  if (carried != nullptr)
+    for (auto &voice : seeded.voices)
+      voice.params = applyCarriedState(voice, *carried);
+
+  VoiceStateMap endState;
+
+  // Steady holds: render one period and repeat it. The state at the end of
+  // a tiled step is not tracked, so only do this when nothing continues.
+  juce::AudioBuffer<float> loop;
+  if (!continuesIntoNext && renderStepLoop(seeded, sampleRate, loop)) {
+    tileLoop(loop, 0, stepBuf, 0, stepSamples);
+  } else {
+    for (const auto &voice : seeded.voices) {
+      auto it = synthMap.find(voice.synthFunction);
+      if (it != synthMap.end()) {
+        TRACE_SCOPE_DETAIL("synth", voice.synthFunction.c_str());
+        ScopedVoiceStateCapture capture;
+        juce::AudioBuffer<float> voiceBuf =
+            it->second(step.durationSeconds, sampleRate, voice.params);
+        for (int ch = 0; ch < 2; ++ch)
+          getKernels().addWithGain(stepBuf.getWritePointer(ch),
+                                   voiceBuf.getReadPointer(ch), 1.0f,
+                                   voiceBuf.getNumSamples());
+        if (voice.voiceId.isNotEmpty())
+          endState[voice.voiceId] = {getSynthFamily(voice.synthFunction),
+                                     capture.getState()};
+      }
+    }
+  }
+
+  if (carried != nullptr) {
+    if (continuesIntoNext)
+      *carried = std::move(endState);
+    else
+      carried->clear();
+  }
+
+  if (normalise)
+    normalisePeak(stepBuf);
+  return stepBuf;
+}
+
 juce::AudioBuffer<float> assembleTrack(const Track &track) {
+  TRACE_SCOPE("assembleTrack");
   double sampleRate = track.settings.sampleRate;
   double crossfadeDuration = track.settings.crossfadeDuration;
   int crossfadeSamples = static_cast<int>(crossfadeDuration * sampleRate);
+  int alignSamples =
+      static_cast<int>(track.settings.crossfadeAlignWindow * sampleRate);
+  CrossfadeTable crossfadeTable(
+      parseCrossfadeCurve(track.settings.crossfadeCurve));
+  RenderQuality quality = parseRenderQuality(track.settings.renderQuality);
 
   double totalDuration = 0.0;
   for (const auto &step : track.steps)
@@ -336,6 +466,7 @@ juce::AudioBuffer<float> assembleTrack(const Track &track) {
 
   double currentTime = 0.0;
   int lastStepEnd = 0;
+  VoiceStateMap carried;
 
   for (size_t i = 0; i < track.steps.size(); ++i) {
     const auto &step = track.steps[i];
@@ -343,27 +474,18 @@ juce::AudioBuffer<float> assembleTrack(const Track &track) {
     if (stepSamples <= 0)
       continue;
 
-    juce::AudioBuffer<float> stepBuf(2, stepSamples);
-    stepBuf.clear();
-
-    for (const auto &voice : step.voices) {
-      auto it = synthMap.find(voice.synthFunction);
-      if (it != synthMap.end()) {
-        juce::AudioBuffer<float> voiceBuf =
-            it->second(step.durationSeconds, sampleRate, voice.params);
-        for (int ch = 0; ch < 2; ++ch)
-          stepBuf.addFrom(ch, 0, voiceBuf, ch, 0, voiceBuf.getNumSamples());
-      }
-    }
-
-    float peak = 0.0f;
-    for (int ch = 0; ch < stepBuf.getNumChannels(); ++ch)
-      peak =
-          std::max(peak, stepBuf.getMagnitude(ch, 0, stepBuf.getNumSamples()));
-    if (peak > 1.0f)
-      stepBuf.applyGain(1.0f / peak);
-
-    int stepStart = static_cast<int>(currentTime * sampleRate);
+    bool continuesFromPrev =
+        i > 0 && stepContinuesFrom(track.steps[i - 1], step);
+    bool continuesIntoNext =
+        i + 1 < track.steps.size() &&
+        stepContinuesFrom(step, track.steps[i + 1]);
+    juce::AudioBuffer<float> stepBuf =
+        renderStep(step, sampleRate, &carried, continuesIntoNext, quality);
+
+    // A continued voice picks up where it left off, so the step is butted
+    // against the previous one instead of overlapping it.
+    int stepStart = continuesFromPrev ? lastStepEnd
+                                      : static_cast<int>(currentTime * sampleRate);
     int stepEnd = stepStart + stepSamples;
     int safeStart = std::max(0, stepStart);
     int safeEnd = std::min(stepEnd, estimatedSamples);
@@ -374,42 +496,47 @@ juce::AudioBuffer<float> assembleTrack(const Track &track) {
     int overlapStart = safeStart;
     int overlapEnd = std::min(safeEnd, lastStepEnd);
     int overlap = overlapEnd - overlapStart;
-    bool doCrossfade = (i > 0 && crossfadeSamples > 0 && overlap > 0);
+    bool doCrossfade =
+        (i > 0 && !continuesFromPrev && crossfadeSamples > 0 && overlap > 0);
 
+    int spliceOffset = 0;
     if (doCrossfade) {
+      TRACE_SCOPE("crossfade");
       int actual = std::min(overlap, crossfadeSamples);
-      juce::AudioBuffer<float> prevSeg(2, actual);
-      prevSeg.copyFrom(0, 0, buffer, 0, overlapStart, actual);
-      prevSeg.copyFrom(1, 0, buffer, 1, overlapStart, actual);
-
-      juce::AudioBuffer<float> newSeg(2, actual);
-      newSeg.copyFrom(0, 0, stepBuf, 0, 0, actual);
-      newSeg.copyFrom(1, 0, stepBuf, 1, 0, actual);
 
-      juce::AudioBuffer<float> blended =
-          crossfade(prevSeg, newSeg, static_cast<double>(actual) / sampleRate,
-                    sampleRate, track.settings.crossfadeCurve);
+      // Start the incoming step where it lines up best with the outgoing
+      // audio; the step loses that many samples from its head.
+      if (alignSamples > 0)
+        spliceOffset = findSpliceOffset(buffer, overlapStart, stepBuf, actual,
+                                        std::min(alignSamples,
+                                                 lenToPlace - actual));
+      actual = std::min(actual, lenToPlace - spliceOffset);
 
-      buffer.copyFrom(0, overlapStart, blended, 0, 0, actual);
-      buffer.copyFrom(1, overlapStart, blended, 1, 0, actual);
+      crossfadeInPlace(buffer, overlapStart, stepBuf, spliceOffset, actual,
+                       crossfadeTable);
 
-      int remainingStartStep = actual;
+      int remainingStartStep = spliceOffset + actual;
       int remainingStartTrack = overlapStart + actual;
-      int remainingLen = lenToPlace - actual;
+      int remainingLen = lenToPlace - spliceOffset - actual;
       if (remainingLen > 0) {
         buffer.addFrom(0, remainingStartTrack, stepBuf, 0, remainingStartStep,
                        remainingLen);
         buffer.addFrom(1, remainingStartTrack, stepBuf, 1, remainingStartStep,
                        remainingLen);
       }
+      safeEnd -= spliceOffset;
     } else {
       buffer.addFrom(0, safeStart, stepBuf, 0, 0, lenToPlace);
       buffer.addFrom(1, safeStart, stepBuf, 1, 0, lenToPlace);
     }
 
     lastStepEnd = std::max(lastStepEnd, safeEnd);
-    currentTime +=
-        step.durationSeconds - (crossfadeSamples > 0 ? crossfadeDuration : 0.0);
+    if (continuesIntoNext)
+      currentTime = static_cast<double>(safeEnd) / sampleRate;
+    else
+      currentTime += step.durationSeconds -
+                     (crossfadeSamples > 0 ? crossfadeDuration : 0.0) -
+                     spliceOffset / sampleRate;
   }
 
   juce::AudioBuffer<float> finalBuf(2, lastStepEnd);
@@ -428,9 +555,8 @@ juce::AudioBuffer<float> assembleTrack(const Track &track) {
       float leftGain, rightGain;
       std::tie(leftGain, rightGain) = getPanGains(track.backgroundNoise.pan);
       float amp = static_cast<float>(track.backgroundNoise.amp);
-      noise.applyGain(0, 0, len, amp * leftGain);
-      noise.applyGain(1, 0, len, amp * rightGain);
 
+      // The level and pan are applied as the noise is mixed in, below.
       if (track.backgroundNoise.fadeIn > 0.0) {
         int n = std::min(len, (int)(track.backgroundNoise.fadeIn * sampleRate));
         noise.applyGainRamp(0, 0, n, 0.0f, amp * leftGain);
@@ -449,8 +575,11 @@ juce::AudioBuffer<float> assembleTrack(const Track &track) {
       if (end > finalBuf.getNumSamples())
         finalBuf.setSize(2, end, true, true, true);
 
-      finalBuf.addFrom(0, start, noise, 0, 0, len);
-      finalBuf.addFrom(1, start, noise, 1, 0, len);
+      const auto &kernels = getKernels();
+      kernels.addWithGain(finalBuf.getWritePointer(0, start),
+                          noise.getReadPointer(0), amp * leftGain, len);
+      kernels.addWithGain(finalBuf.getWritePointer(1, start),
+                          noise.getReadPointer(1), amp * rightGain, len);
       lastStepEnd = std::max(lastStepEnd, end);
     }
   }
@@ -469,9 +598,8 @@ juce::AudioBuffer<float> assembleTrack(const Track &track) {
     float leftGain, rightGain;
     std::tie(leftGain, rightGain) = getPanGains(clip.pan);
     float amp = static_cast<float>(clip.amp);
-    clipBuf.applyGain(0, 0, len, amp * leftGain);
-    clipBuf.applyGain(1, 0, len, amp * rightGain);
 
+    // The level and pan are applied as the clip is mixed in, below.
     if (clip.fadeIn > 0.0) {
       int n = std::min(len, (int)(clip.fadeIn * sampleRate));
       clipBuf.applyGainRamp(0, 0, n, 0.0f, amp * leftGain);
@@ -488,8 +616,11 @@ juce::AudioBuffer<float> assembleTrack(const Track &track) {
     if (end > finalBuf.getNumSamples())
       finalBuf.setSize(2, end, true, true, true);
 
-    finalBuf.addFrom(0, start, clipBuf, 0, 0, len);
-    finalBuf.addFrom(1, start, clipBuf, 1, 0, len);
+    const auto &kernels = getKernels();
+    kernels.addWithGain(finalBuf.getWritePointer(0, start),
+                        clipBuf.getReadPointer(0), amp * leftGain, len);
+    kernels.addWithGain(finalBuf.getWritePointer(1, start),
+                        clipBuf.getReadPointer(1), amp * rightGain, len);
     lastStepEnd = std::max(lastStepEnd, end);
   }
 
@@ -5,15 +5,37 @@
 #include <vector>
 #include <string>
 #include "../models/TrackData.h"
+#include "RenderQuality.h"
+#include "VoiceState.h"
 
+/** Signature shared by every synth in the registry. */
+using SynthFunc = juce::AudioBuffer<float> (*)(double, double,
+                                               const juce::NamedValueSet&);
 
 Track loadTrackFromJson(const juce::File& file);
+/** Reads a track from JSON text in the same format as loadTrackFromJson;
+    text that is not a JSON object gives a track with no steps. */
+Track parseTrackJson(const juce::String& json);
 /** Saves the given track structure to a JSON file. The file extension will
     be forced to ".json" if not already present.
     @return true on success. */
 bool saveTrackToJson(const Track& track, const juce::File& file);
 bool writeWavFile(const juce::File& file, const juce::AudioBuffer<float>& buffer, double sampleRate);
 juce::AudioBuffer<float> assembleTrack(const Track& track);
+/** Renders and mixes the voices of a single step, peak-normalised the same
+    way assembleTrack does. When @p carried is given, voices with a voice id
+    start from the state it holds for them; if @p continuesIntoNext is true
+    it is then updated with their state at the end of the step, otherwise it
+    is cleared. Periodic steps are tiled unless state has to be carried out.
+    Below normal @p quality the voices are synthesised at a lower rate and
+    the mix is resampled to @p sampleRate (see RenderQuality.h). With
+    @p normalise false the mix is returned as summed, peaks above full
+    scale included. */
+juce::AudioBuffer<float> renderStep(const Step& step, double sampleRate,
+                                    VoiceStateMap* carried = nullptr,
+                                    bool continuesIntoNext = false,
+                                    RenderQuality quality = RenderQuality::normal,
+                                    bool normalise = true);
 /** Loads steps from a JSON file containing a top-level "steps" array and
     appends them to the provided vector.
     @return number of steps successfully loaded. */
@@ -22,3 +44,7 @@ int loadExternalStepsFromJson(const juce::File& file, std::vector<Step>& steps);
 /** Returns a list of all available synth function names. */
 std::vector<juce::String> getAvailableSynthNames();
 
+/** Looks up a synth by its registry name.
+    @return nullptr if no synth with that name exists. */
+SynthFunc findSynthFunction(const juce::String& name);
+
@@ -0,0 +1,248 @@
+#include "TrackRenderer.h"
+#include "PeriodicTiling.h"
+#include <algorithm>
+
+namespace
+{
+    constexpr int prefixGrowth = 4;
+
+    /** @p step with an id on every voice that lacks one, so renderStep()
+        hands each voice's state from one piece of the step to the next. */
+    Step withPieceVoiceIds(Step step)
+    {
+        for (size_t i = 0; i < step.voices.size(); ++i)
+            if (step.voices[i].voiceId.isEmpty())
+                step.voices[i].voiceId = "#piece" + juce::String(static_cast<int>(i));
+        return step;
+    }
+
+    /** True if @p pieceStep can be rendered as consecutive pieces, each
+        started from the state the one before published. Attacks and glitch
+        bursts are timed from the start of each render, so they rule it out. */
+    bool canRenderInPieces(const Step& pieceStep)
+    {
+        if (! stepContinuesFrom(pieceStep, pieceStep))
+            return false;
+        for (const auto& voice : pieceStep.voices)
+        {
+            for (const auto& p : voice.params)
+            {
+                juce::String name = p.name.toString();
+                if ((name.startsWithIgnoreCase("attack") || name.startsWithIgnoreCase("glitch"))
+                    && static_cast<double>(p.value) != 0.0)
+                    return false;
+            }
+        }
+        return true;
+    }
+}
+
+TrackRenderer::TrackRenderer(const Track& t, RenderQuality q)
+    : track(t),
+      quality(q)
+{
+}
+
+void TrackRenderer::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    totalLength = 0;
+    for (const auto& step : track.steps)
+        totalLength += static_cast<juce::int64>(step.durationSeconds * sampleRate);
+    seek(0);
+}
+
+void TrackRenderer::seek(juce::int64 sample)
+{
+    endStep();
+    carriedState.clear();
+    position = std::max<juce::int64>(0, sample);
+
+    juce::int64 stepStart = 0;
+    for (stepIndex = 0; stepIndex < static_cast<int>(track.steps.size()); ++stepIndex)
+    {
+        auto length = static_cast<juce::int64>(track.steps[stepIndex].durationSeconds * sampleRate);
+        if (position < stepStart + length)
+        {
+            pendingStepOffset = position - stepStart;
+            break;
+        }
+        stepStart += length;
+    }
+}
+
+bool TrackRenderer::isFinished() const noexcept
+{
+    return stepIndex >= static_cast<int>(track.steps.size());
+}
+
+TrackRenderer::StepMode TrackRenderer::chooseMode(int index, bool hasCarriedState, bool tryLoop) const
+{
+    const auto& steps = track.steps;
+    const Step& step = steps[static_cast<size_t>(index)];
+    bool continuesFromPrev = index > 0 && hasCarriedState
+                             && stepContinuesFrom(steps[static_cast<size_t>(index - 1)], step);
+    bool continuesIntoNext = index + 1 < static_cast<int>(steps.size())
+                             && stepContinuesFrom(step, steps[static_cast<size_t>(index + 1)]);
+    if (continuesFromPrev || continuesIntoNext)
+        return StepMode::whole;
+
+    if (tryLoop && findStepPeriodSamples(step, sampleRate) > 0)
+        return StepMode::loop;
+
+    if (getInternalSampleRate(quality, sampleRate) == sampleRate && isStepDurationIndependent(step))
+        return canRenderInPieces(withPieceVoiceIds(step)) ? StepMode::pieces : StepMode::prefixes;
+
+    return StepMode::whole;
+}
+
+double TrackRenderer::getLongestRenderSeconds() const
+{
+    double longest = 0.0;
+    for (int i = 0; i < static_cast<int>(track.steps.size()); ++i)
+    {
+        const Step& step = track.steps[static_cast<size_t>(i)];
+        double seconds = step.durationSeconds;
+        switch (chooseMode(i, true, true))
+        {
+            case StepMode::loop:   seconds = findStepPeriodSamples(step, sampleRate) / sampleRate; break;
+            case StepMode::pieces: seconds = std::min(seconds, pieceSeconds); break;
+            default:               break;
+        }
+        longest = std::max(longest, seconds);
+    }
+    return longest;
+}
+
+void TrackRenderer::beginStep()
+{
+    const auto& steps = track.steps;
+    const Step& step = steps[stepIndex];
+    stepLength = static_cast<juce::int64>(step.durationSeconds * sampleRate);
+    stepPos = std::min(pendingStepOffset, stepLength);
+    pendingStepOffset = 0;
+    bufferStart = 0;
+    pieceGain = 0.0f;
+
+    stepMode = chooseMode(stepIndex, ! carriedState.empty(), true);
+    if (stepMode == StepMode::loop && ! renderStepLoop(step, sampleRate, stepBuffer, quality))
+        stepMode = chooseMode(stepIndex, ! carriedState.empty(), false);
+
+    if (stepMode == StepMode::pieces || stepMode == StepMode::prefixes)
+    {
+        pieceStep = withPieceVoiceIds(step);
+        stepBuffer.setSize(0, 0);
+    }
+    else if (stepMode == StepMode::whole)
+    {
+        bool continuesIntoNext = stepIndex + 1 < static_cast<int>(steps.size())
+                                 && stepContinuesFrom(step, steps[stepIndex + 1]);
+        stepBuffer = renderStep(step, sampleRate, &carriedState, continuesIntoNext, quality);
+        stepLength = stepBuffer.getNumSamples();
+    }
+}
+
+void TrackRenderer::renderNextPiece()
+{
+    do
+    {
+        juce::int64 end;
+        if (stepMode == StepMode::pieces)
+        {
+            // Each piece starts where the last one stopped, from its state.
+            bufferStart += stepBuffer.getNumSamples();
+            end = std::min(stepLength, bufferStart + static_cast<juce::int64>(pieceSeconds * sampleRate));
+            Step piece = pieceStep;
+            piece.durationSeconds = getPrefixDuration(pieceStep, sampleRate, end - bufferStart);
+            stepBuffer = renderStep(piece, sampleRate, &pieceState, end < stepLength, quality, false);
+        }
+        else
+        {
+            // A longer prefix, reaching at least a little past stepPos.
+            juce::int64 previous = bufferStart + stepBuffer.getNumSamples();
+            juce::int64 first = static_cast<juce::int64>(firstPrefixSeconds * sampleRate);
+            end = std::min(stepLength, std::max(previous * prefixGrowth, stepPos + first));
+            stepBuffer = renderStep(getStepPrefix(pieceStep, sampleRate, end), sampleRate,
+                                    nullptr, false, quality, false);
+            bufferStart = 0;
+        }
+
+        if (stepBuffer.getNumSamples() == 0)
+            break;
+
+        if (pieceGain == 0.0f)
+        {
+            float peak = 0.0f;
+            for (int ch = 0; ch < stepBuffer.getNumChannels(); ++ch)
+                peak = std::max(peak, stepBuffer.getMagnitude(ch, 0, stepBuffer.getNumSamples()));
+            pieceGain = 1.0f / std::max(1.0f, peak);
+        }
+    }
+    while (bufferStart + stepBuffer.getNumSamples() <= stepPos);
+
+    for (int ch = 0; ch < stepBuffer.getNumChannels(); ++ch)
+    {
+        float* data = stepBuffer.getWritePointer(ch);
+        juce::FloatVectorOperations::multiply(data, pieceGain, stepBuffer.getNumSamples());
+        juce::FloatVectorOperations::clip(data, data, -1.0f, 1.0f, stepBuffer.getNumSamples());
+    }
+}
+
+void TrackRenderer::endStep()
+{
+    stepMode = StepMode::idle;
+    stepBuffer.setSize(0, 0);
+    pieceStep = {};
+    pieceState.clear();
+    bufferStart = 0;
+    stepPos = 0;
+    pendingStepOffset = 0;
+}
+
+int TrackRenderer::render(juce::AudioBuffer<float>& dest, int numSamples)
+{
+    dest.clear();
+    int filled = 0;
+    while (filled < numSamples)
+    {
+        if (isFinished())
+            break; // no more audio
+
+        if (stepMode == StepMode::idle)
+            beginStep();
+
+        juce::int64 available = stepLength - stepPos;
+        if (stepMode == StepMode::pieces || stepMode == StepMode::prefixes)
+        {
+            if (stepPos < stepLength && stepPos >= bufferStart + stepBuffer.getNumSamples())
+                renderNextPiece();
+            available = std::min(available, bufferStart + stepBuffer.getNumSamples() - stepPos);
+        }
+        else if (stepBuffer.getNumSamples() == 0)
+        {
+            available = 0;
+        }
+
+        if (available <= 0)
+        {
+            stepIndex++;
+            endStep();
+            continue;
+        }
+
+        // A loop wraps; anything else holds the step from bufferStart.
+        int toCopy = static_cast<int>(std::min<juce::int64>(available, numSamples - filled));
+        tileLoop(stepBuffer, stepPos - bufferStart, dest, filled, toCopy);
+
+        stepPos += toCopy;
+        filled += toCopy;
+
+        if (stepPos >= stepLength)
+        {
+            stepIndex++;
+            endStep();
+        }
+    }
+    position += filled;
+    return filled;
+}
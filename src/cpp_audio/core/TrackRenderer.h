@@ -0,0 +1,87 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "RenderQuality.h"
+#include "Track.h"
+
+/** Renders a Track from any position in blocks of any size.
+
+    Steps are rendered when the position reaches them and copied out block
+    by block. How much of a step is held at once depends on the step:
+      * periodic holds are kept as a single loop and tiled;
+      * steps of state-carrying synths (binaural_beat, qam_beat) that do
+        not depend on the step length, with no attack, glitch bursts or
+        cross-modulation delay, are rendered pieceSeconds at a time, each
+        piece continuing every oscillator and LFO phase of the one before;
+      * other steps that do not depend on their length are rendered as a
+        growing prefix (firstPrefixSeconds, then four times as much), so
+        the first audio does not wait for the whole step. The last prefix
+        is the whole step;
+      * anything else, and steps joined to a neighbour by a continuous
+        voice, is rendered whole. A seek into the middle of such a chain
+        starts it from fresh state.
+    Only the first two are bounded in memory; getLongestRenderSeconds()
+    says how much of a step a track needs rendered at once.
+    Pieces and prefixes are taken before peak normalisation and share one
+    gain, set from the first, with a hard limit, as the step preview does;
+    they are not used at draft quality, where each render is resampled.
+
+    Not thread-safe: one thread renders and seeks. The track must outlive
+    the renderer.
+*/
+class TrackRenderer
+{
+public:
+    TrackRenderer(const Track& track, RenderQuality quality);
+
+    /** Sets the output rate and moves back to the start. */
+    void prepare(double sampleRate);
+
+    /** Moves to @p sample from the start of the track; the next block is
+        rendered from there. */
+    void seek(juce::int64 sample);
+
+    /** Clears @p dest and renders up to @p numSamples of the track into it.
+        @return number of samples written (less than requested at the end). */
+    int render(juce::AudioBuffer<float>& dest, int numSamples);
+
+    bool isFinished() const noexcept;
+    juce::int64 getPosition() const noexcept { return position; }
+    /** Sum of the step durations at the current rate. */
+    juce::int64 getTotalLength() const noexcept { return totalLength; }
+
+    /** The most audio, in seconds, the track has rendered in one go: the
+        longest loop, piece or step held whole (prefixes count as whole).
+        Analysis only; valid after prepare(). */
+    double getLongestRenderSeconds() const;
+
+    /** Seconds of a step held at once in piece and prefix rendering. */
+    static constexpr double pieceSeconds = 5.0;
+    static constexpr double firstPrefixSeconds = 2.0;
+
+private:
+    enum class StepMode { idle, whole, loop, pieces, prefixes };
+
+    StepMode chooseMode(int index, bool hasCarriedState, bool tryLoop) const;
+    void beginStep();
+    /** Renders the piece or prefix holding stepPos into stepBuffer. */
+    void renderNextPiece();
+    void endStep();
+
+    const Track& track;
+    RenderQuality quality;
+    double sampleRate = 44100.0;
+    juce::int64 totalLength = 0;
+    juce::int64 position = 0;
+
+    int stepIndex = 0;
+    StepMode stepMode = StepMode::idle;
+    Step pieceStep;                      // the step with a voice id on every voice
+    juce::AudioBuffer<float> stepBuffer; // one loop, or the step from bufferStart
+    juce::int64 bufferStart = 0;
+    juce::int64 stepLength = 0;
+    juce::int64 stepPos = 0;
+    juce::int64 pendingStepOffset = 0;
+    float pieceGain = 0.0f;
+    VoiceStateMap carriedState;
+    VoiceStateMap pieceState;
+};
@@ -0,0 +1,107 @@
+#include "VoiceState.h"
+#include <cmath>
+
+namespace
+{
+    thread_local ScopedVoiceStateCapture* currentCapture = nullptr;
+
+    const Voice* findVoice(const Step& step, const juce::String& voiceId)
+    {
+        for (const auto& v : step.voices)
+            if (v.voiceId == voiceId)
+                return &v;
+        return nullptr;
+    }
+
+    /** Synth families that publish their state with publishVoiceState(). */
+    bool carriesState(const juce::String& family)
+    {
+        return family == "binaural_beat" || family == "qam_beat";
+    }
+
+    /** True if @p voice keeps state that is not published, so a continuing
+        voice would restart it: qam_beat's cross-modulation delay line. */
+    bool hasUnpublishedState(const Voice& voice)
+    {
+        const auto& p = voice.params;
+        if ((double) p.getWithDefault("crossModDelay", 0.0) <= 0.0)
+            return false;
+        for (auto name : { "crossModDepth", "startCrossModDepth", "endCrossModDepth" })
+            if ((double) p.getWithDefault(name, 0.0) != 0.0)
+                return true;
+        return false;
+    }
+
+    bool allVoicesMatched(const Step& from, const Step& to)
+    {
+        for (const auto& v : from.voices)
+        {
+            if (v.voiceId.isEmpty() || ! carriesState(getSynthFamily(v.synthFunction))
+                || hasUnpublishedState(v))
+                return false;
+            const Voice* other = findVoice(to, v.voiceId);
+            if (other == nullptr || getSynthFamily(other->synthFunction) != getSynthFamily(v.synthFunction))
+                return false;
+        }
+        return true;
+    }
+}
+
+ScopedVoiceStateCapture::ScopedVoiceStateCapture() noexcept : previous(currentCapture)
+{
+    currentCapture = this;
+}
+
+ScopedVoiceStateCapture::~ScopedVoiceStateCapture() noexcept
+{
+    currentCapture = previous;
+}
+
+void publishVoiceState(const char* name, double phase)
+{
+    if (currentCapture == nullptr)
+        return;
+
+    double wrapped = std::fmod(phase, juce::MathConstants<double>::twoPi);
+    if (wrapped < 0.0)
+        wrapped += juce::MathConstants<double>::twoPi;
+    currentCapture->state.set(name, wrapped);
+}
+
+juce::String getSynthFamily(const std::string& synthFunction)
+{
+    juce::String name (synthFunction);
+    return name.endsWith("_transition") ? name.dropLastCharacters(11) : name;
+}
+
+juce::NamedValueSet applyCarriedState(const Voice& voice, const VoiceStateMap& carried)
+{
+    if (voice.voiceId.isEmpty())
+        return voice.params;
+
+    auto it = carried.find(voice.voiceId);
+    if (it == carried.end() || it->second.synthFamily != getSynthFamily(voice.synthFunction))
+        return voice.params;
+
+    const bool transition = juce::String(voice.synthFunction).endsWith("_transition");
+    juce::NamedValueSet params = voice.params;
+    for (const auto& v : it->second.values)
+    {
+        juce::String name = v.name.toString();
+        if (transition)
+            name = "start" + name.substring(0, 1).toUpperCase() + name.substring(1);
+        params.set(juce::Identifier(name), v.value);
+    }
+
+    // The voice is already sounding; it must not fade in again.
+    if (params.contains("attackTime"))
+        params.set("attackTime", 0.0);
+    return params;
+}
+
+bool stepContinuesFrom(const Step& previous, const Step& next)
+{
+    if (previous.voices.empty() || previous.voices.size() != next.voices.size())
+        return false;
+    return allVoicesMatched(previous, next) && allVoicesMatched(next, previous);
+}
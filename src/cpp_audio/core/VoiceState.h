@@ -0,0 +1,62 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include "../models/TrackData.h"
+#include <map>
+
+/** Phase continuity for voices that carry on from one step into the next.
+
+    Voices sharing a "voice_id" in consecutive steps are treated as one
+    voice. Synths that support it publish their oscillator state at the end
+    of a render (carrier and every LFO phase, keyed by the parameter that
+    seeds them, e.g. "startPhaseL" or "phaseOscPhaseOffset"); the next
+    step's render of the same voice is started from those values instead of
+    the ones in its params, and skips its attack. A step whose voices all
+    continue from the previous step can then be joined without a
+    crossfade.
+*/
+
+struct CarriedVoiceState
+{
+    juce::String synthFamily;   // synth name without "_transition"
+    juce::NamedValueSet values;
+};
+
+/** Voice id -> state at the end of the last rendered step. */
+using VoiceStateMap = std::map<juce::String, CarriedVoiceState>;
+
+/** Collects the values published by synths rendered on this thread during
+    the object's lifetime. Captures may nest; the innermost one receives. */
+class ScopedVoiceStateCapture
+{
+public:
+    ScopedVoiceStateCapture() noexcept;
+    ~ScopedVoiceStateCapture() noexcept;
+
+    ScopedVoiceStateCapture(const ScopedVoiceStateCapture&) = delete;
+    ScopedVoiceStateCapture& operator=(const ScopedVoiceStateCapture&) = delete;
+
+    const juce::NamedValueSet& getState() const noexcept { return state; }
+
+private:
+    friend void publishVoiceState(const char*, double);
+    juce::NamedValueSet state;
+    ScopedVoiceStateCapture* previous;
+};
+
+/** Called by synths at the end of a render. Phases are wrapped to
+    [0, 2pi). Does nothing unless a capture is active on this thread. */
+void publishVoiceState(const char* name, double phase);
+
+/** "binaural_beat_transition" -> "binaural_beat". */
+juce::String getSynthFamily(const std::string& synthFunction);
+
+/** Returns @p voice's params with any state carried for its voice id
+    applied and its attackTime zeroed. Transition voices receive it on
+    their "start" parameters ("startPhaseL" -> "startStartPhaseL"). */
+juce::NamedValueSet applyCarriedState(const Voice& voice, const VoiceStateMap& carried);
+
+/** True if every voice of @p next continues a voice of @p previous and
+    vice versa, and all of them use a synth that publishes its state and
+    keep none it cannot publish (a qam_beat cross-modulation delay), so the
+    two steps can be joined without a crossfade. */
+bool stepContinuesFrom(const Step& previous, const Step& next);
@@ -56,6 +56,10 @@ public:
     {
       auto ptr = std::make_unique<StepConfigPanel>();
       stepConfig = std::move(ptr);
+      stepConfig->onVoiceParameterEdited =
+          [this](int voice, const juce::String &name, double value) {
+            preview->updateVoiceParameter(voice, name, value);
+          };
       addAndMakeVisible(stepConfig.get());
     }
 
@@ -66,28 +70,9 @@ public:
         stepConfig->setVoices(steps[index].voices);
         stepConfig->onVoicesChanged = [this, index]() {
           stepList.updateStepVoices(index, stepConfig->getVoices());
+          previewStep(index);
         };
-        Step step;
-        step.durationSeconds = steps[index].duration;
-        step.description = steps[index].description;
-        for (const auto &vd : steps[index].voices) {
-          Voice v;
-          v.synthFunction = vd.synthFunction.toStdString();
-          if (auto *obj = vd.params.getDynamicObject())
-            v.params = obj->getProperties();
-          v.isTransition = vd.isTransition;
-          v.description = vd.description;
-          step.voices.push_back(std::move(v));
-        }
-        auto gsRaw = settings->getSettings();
-        GlobalSettings gs;
-        gs.sampleRate = gsRaw.sampleRate;
-        gs.crossfadeDuration = gsRaw.crossfadeSeconds;
-        gs.outputFilename = gsRaw.outputFile;
-        gs.crossfadeCurve = "linear";
-        double previewDur =
-            step.durationSeconds < 180.0 ? step.durationSeconds : 60.0;
-        preview->loadStep(step, gs, previewDur);
+        previewStep(index);
       } else {
         preview->reset();
       }
@@ -123,7 +108,7 @@ public:
     auto area = getLocalBounds().reduced(8);
 
     toolsBox.setBounds(area.removeFromTop(40));
-    settingsBox.setBounds(area.removeFromTop(220));
+    settingsBox.setBounds(area.removeFromTop(250));
     previewBox.setBounds(area.removeFromTop(100));
 
     area.removeFromTop(4);
@@ -186,6 +171,7 @@ public:
     s.outputFile = "my_track.wav";
     s.noiseFile = juce::String();
     s.noiseAmp = 0.0;
+    s.renderQuality = "normal";
     settings->setSettings(s);
     stepList.clearSteps();
     stepConfig->setVoices({});
@@ -222,6 +208,7 @@ void openTrack() {
     track.settings.sampleRate = gs.sampleRate;
     track.settings.crossfadeDuration = gs.crossfadeSeconds;
     track.settings.crossfadeCurve = prefs.crossfadeCurve;
+    track.settings.renderQuality = gs.renderQuality;
     track.settings.outputFilename = gs.outputFile;
     track.backgroundNoise.filePath = gs.noiseFile;
     track.backgroundNoise.amp = gs.noiseAmp;
@@ -257,6 +244,35 @@ private:
 
   juce::File currentFile;
 
+  // Loads step @p index into the preview. In live-edit mode the preview
+  // follows parameter changes to the same step without restarting.
+  void previewStep(int index) {
+    const auto &steps = stepList.getSteps();
+    if (!juce::isPositiveAndBelow(index, steps.size()))
+      return;
+    Step step;
+    step.durationSeconds = steps[index].duration;
+    step.description = steps[index].description;
+    for (const auto &vd : steps[index].voices) {
+      Voice v;
+      v.synthFunction = vd.synthFunction.toStdString();
+      if (auto *obj = vd.params.getDynamicObject())
+        v.params = obj->getProperties();
+      v.isTransition = vd.isTransition;
+      v.description = vd.description;
+      step.voices.push_back(std::move(v));
+    }
+    auto gsRaw = settings->getSettings();
+    GlobalSettings gs;
+    gs.sampleRate = gsRaw.sampleRate;
+    gs.crossfadeDuration = gsRaw.crossfadeSeconds;
+    gs.outputFilename = gsRaw.outputFile;
+    gs.crossfadeCurve = "linear";
+    double previewDur =
+        step.durationSeconds < 180.0 ? step.durationSeconds : 60.0;
+    preview->loadStep(step, gs, previewDur);
+  }
+
   void applyThemeFromPrefs()
   {
       if (auto* laf = dynamic_cast<juce::LookAndFeel_V4*>(&getLookAndFeel()))
@@ -286,6 +302,7 @@ private:
     t.settings.crossfadeDuration = gsRaw.crossfadeSeconds;
     t.settings.outputFilename = gsRaw.outputFile;
     t.settings.crossfadeCurve = "linear";
+    t.settings.renderQuality = gsRaw.renderQuality;
     t.backgroundNoise.filePath = gsRaw.noiseFile;
     t.backgroundNoise.amp = gsRaw.noiseAmp;
 
@@ -327,6 +344,7 @@ private:
     gs.outputFile = t.settings.outputFilename;
     gs.noiseFile = t.backgroundNoise.filePath;
     gs.noiseAmp = t.backgroundNoise.amp;
+    gs.renderQuality = t.settings.renderQuality;
     settings->setSettings(gs);
 
     clips.clear();
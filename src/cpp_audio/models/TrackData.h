@@ -15,6 +15,7 @@ struct Voice
     juce::NamedValueSet params;           // Parameter dictionary
     bool isTransition { false };          // "is_transition"
     juce::String description;             // Optional voice description
+    juce::String voiceId;                 // "voice_id"; same id in consecutive steps = one continuous voice
 };
 
 struct Step
@@ -29,6 +30,8 @@ struct GlobalSettings
     double sampleRate { 44100.0 };        // "sample_rate"
     double crossfadeDuration { 1.0 };     // "crossfade_duration"
     juce::String crossfadeCurve { "linear" }; // "crossfade_curve"
+    double crossfadeAlignWindow { 0.0 };  // "crossfade_align_window" (s); 0 = no splice search
+    juce::String renderQuality { "normal" }; // "render_quality": draft, normal or master
     juce::String outputFilename { "my_track.wav" }; // "output_filename"
 };
 
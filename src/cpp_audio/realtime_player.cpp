@@ -1,117 +1,72 @@
 #include <juce_audio_devices/juce_audio_devices.h>
 #include <juce_core/juce_core.h>
+#include "core/OfflineAudioDevice.h"
+#include "core/RealtimePlayer.h"
+#include "core/Trace.h"
 #include "core/Track.h"
-#include <thread>
 #include <atomic>
+#include <iostream>
+#include <thread>
 
-// Simple real-time player that loads a Track and streams it to the audio device
-class RealtimePlayer : public juce::AudioIODeviceCallback
+namespace
 {
-public:
-    explicit RealtimePlayer(Track t) : track(std::move(t)) {}
-
-    void audioDeviceAboutToStart(juce::AudioIODevice* device) override
+    /** Plays @p track through an OfflineAudioDevice whose callbacks arrive
+        @p speed times faster than realtime. Returns true if no callback ran
+        out of rendered audio. */
+    bool runStress(const Track& track, double speed, double seconds, bool verbose)
     {
-        sampleRate = device->getCurrentSampleRate();
-        bufferSize = device->getCurrentBufferSizeSamples();
-        buffers[0].setSize(2, bufferSize);
-        buffers[1].setSize(2, bufferSize);
-        currentBuffer = 0;
-        stepIndex = 0;
-        stepPos = 0;
-        fillBuffer(0);
-        fillBuffer(1);
-        running = true;
+        const double sampleRate = track.settings.sampleRate;
+        const int bufferSize = 512;
+        OfflineAudioDevice device(sampleRate, bufferSize);
+        RealtimePlayer player(track);
+
+        device.start(&player);
+        device.processBlocks(static_cast<int>(seconds * sampleRate / bufferSize), speed);
+        device.stop();
+
+        const auto& stats = player.getStats();
+        bool ok = stats.underruns.load() == 0;
+        std::cout << (ok ? "ok   " : "FAIL ") << speed << "x realtime, "
+                  << stats.underruns.load() << " underruns" << std::endl;
+        if (verbose || ! ok)
+            std::cout << stats.toString() << std::endl;
+        return ok;
     }
-
-    void audioDeviceStopped() override
-    {
-        running = false;
-        if (worker.joinable())
-            worker.join();
-    }
-
-    void audioDeviceIOCallback(const float** /*inputChannelData*/, int /*numInputChannels*/,
-                               float** outputChannelData, int numOutputChannels,
-                               int numSamples) override
-    {
-        juce::ignoreUnused(numSamples); // assume matches bufferSize
-        auto& buf = buffers[currentBuffer];
-        for (int ch = 0; ch < numOutputChannels; ++ch)
-        {
-            const float* src = buf.getReadPointer(ch % buf.getNumChannels());
-            float* dest = outputChannelData[ch];
-            std::memcpy(dest, src, sizeof(float) * bufferSize);
-        }
-
-        if (worker.joinable())
-            worker.join();
-        int next = (currentBuffer + 1) % 2;
-        worker = std::thread([this, next]() { fillBuffer(next); });
-        currentBuffer = next;
-    }
-
-private:
-    void fillBuffer(int index)
-    {
-        auto& buf = buffers[index];
-        buf.clear();
-        int filled = 0;
-        while (filled < bufferSize)
-        {
-            if (stepIndex >= static_cast<int>(track.steps.size()))
-            {
-                break; // no more audio
-            }
-
-            if (stepBuffer.getNumSamples() == 0)
-            {
-                Track t;
-                t.settings = track.settings;
-                t.settings.crossfadeDuration = 0.0;
-                t.steps.push_back(track.steps[stepIndex]);
-                stepBuffer = assembleTrack(t);
-                stepPos = 0;
-            }
-
-            int remain = stepBuffer.getNumSamples() - stepPos;
-            int toCopy = std::min(remain, bufferSize - filled);
-            for (int ch = 0; ch < buf.getNumChannels(); ++ch)
-                buf.copyFrom(ch, filled, stepBuffer, ch, stepPos, toCopy);
-
-            stepPos += toCopy;
-            filled += toCopy;
-
-            if (stepPos >= stepBuffer.getNumSamples())
-            {
-                stepIndex++;
-                stepBuffer.setSize(0, 0);
-            }
-        }
-    }
-
-    Track track;
-    double sampleRate = 44100.0;
-    int bufferSize = 512;
-    juce::AudioBuffer<float> buffers[2];
-    int currentBuffer = 0;
-    std::thread worker;
-    std::atomic<bool> running { false };
-
-    // step generation state
-    int stepIndex = 0;
-    juce::AudioBuffer<float> stepBuffer;
-    int stepPos = 0;
-};
+}
 
 int main(int argc, char* argv[])
 {
     if (argc < 2)
     {
-        std::cout << "Usage: realtime_player <track.json>" << std::endl;
+        std::cout << "Usage: realtime_player <track.json> [--trace trace.json] [--stats SECONDS]\n"
+                     "                       [--stress N|max] [--stress-seconds S]\n"
+                     "                       [--quality draft|normal|master]" << std::endl;
         return 1;
     }
 
+    juce::File traceFile;
+    double statsInterval = 0.0;
+    juce::String stress;
+    double stressSeconds = 60.0;
+    juce::String quality;
+    for (int i = 2; i + 1 < argc; ++i)
+    {
+        juce::String arg (argv[i]);
+        if (arg == "--trace")
+            traceFile = juce::File::getCurrentWorkingDirectory().getChildFile(argv[i + 1]);
+        else if (arg == "--stats")
+            statsInterval = juce::String(argv[i + 1]).getDoubleValue();
+        else if (arg == "--stress")
+            stress = argv[i + 1];
+        else if (arg == "--stress-seconds")
+            stressSeconds = juce::String(argv[i + 1]).getDoubleValue();
+        else if (arg == "--quality")
+            quality = argv[i + 1];
+    }
+
+    if (traceFile != juce::File() && ! isTracingEnabled())
+        std::cerr << "Tracing not compiled in; rebuild with -DDIY_AV_ENABLE_TRACING=ON" << std::endl;
+
     juce::File trackFile (argv[1]);
     if (! trackFile.existsAsFile())
     {
@@ -120,6 +75,25 @@ int main(int argc, char* argv[])
     }
 
     Track track = loadTrackFromJson(trackFile);
+    if (quality.isNotEmpty())
+        track.settings.renderQuality = quality;
+
+    if (stress.isNotEmpty())
+    {
+        // Offline: no sound card, callbacks on a simulated clock at N x realtime.
+        if (stress != "max")
+            return runStress(track, stress.getDoubleValue(), stressSeconds, true) ? 0 : 1;
+
+        double lastOk = 0.0;
+        for (double speed = 1.0; speed <= 1024.0; speed *= 2.0)
+        {
+            if (! runStress(track, speed, stressSeconds, false))
+                break;
+            lastOk = speed;
+        }
+        std::cout << "Highest sustained speed: " << lastOk << "x realtime" << std::endl;
+        return lastOk >= 1.0 ? 0 : 1;
+    }
 
     juce::AudioDeviceManager deviceManager;
     deviceManager.initialise(0, 2, nullptr, true);
@@ -127,10 +101,36 @@ int main(int argc, char* argv[])
     RealtimePlayer player(std::move(track));
     deviceManager.addAudioCallback(&player);
 
+    std::atomic<bool> quit { false };
+    std::thread statsThread;
+    if (statsInterval > 0.0)
+    {
+        statsThread = std::thread([&] {
+            auto next = std::chrono::steady_clock::now();
+            while (! quit.load())
+            {
+                next += std::chrono::milliseconds(static_cast<int>(statsInterval * 1000.0));
+                while (! quit.load() && std::chrono::steady_clock::now() < next)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                if (! quit.load())
+                    std::cout << player.getStats().toString() << std::endl;
+            }
+        });
+    }
+
     std::cout << "Playing... press ENTER to quit" << std::endl;
     std::cin.get();
 
+    quit = true;
+    if (statsThread.joinable())
+        statsThread.join();
+
     deviceManager.removeAudioCallback(&player);
+
+    if (statsInterval > 0.0)
+        std::cout << player.getStats().toString() << std::endl;
+
+    if (traceFile != juce::File() && exportChromeTrace(traceFile))
+        std::cout << "Trace written to " << traceFile.getFullPathName() << std::endl;
     return 0;
 }
-
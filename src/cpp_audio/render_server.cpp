@@ -0,0 +1,76 @@
+#include <juce_core/juce_core.h>
+#include "core/RenderServer.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+    std::atomic<bool> quitRequested { false };
+
+    void requestQuit(int)
+    {
+        quitRequested = true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    RenderServer::Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        juce::String arg (argv[i]);
+        if (arg == "--help" || arg == "-h" || i + 1 >= argc)
+        {
+            std::cout << "Usage: render_server [--port N] [--max-sessions N] [--max-connections N]\n"
+                         "                     [--chunk-frames N] [--lead SECONDS] [--idle-timeout SECONDS]\n"
+                         "                     [--max-render SECONDS]\n"
+                         "Serves tracks as streamed PCM on 127.0.0.1; see core/RenderServer.h." << std::endl;
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+
+        juce::String value (argv[++i]);
+        if (arg == "--port")
+            options.port = value.getIntValue();
+        else if (arg == "--max-sessions")
+            options.maxSessions = value.getIntValue();
+        else if (arg == "--max-connections")
+            options.maxConnections = value.getIntValue();
+        else if (arg == "--chunk-frames")
+            options.chunkFrames = value.getIntValue();
+        else if (arg == "--lead")
+            options.leadSeconds = value.getDoubleValue();
+        else if (arg == "--idle-timeout")
+            options.idleTimeoutSeconds = value.getDoubleValue();
+        else if (arg == "--max-render")
+            options.maxRenderSeconds = value.getDoubleValue();
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::signal(SIGINT, requestQuit);
+    std::signal(SIGTERM, requestQuit);
+   #ifdef SIGPIPE
+    // A listener hanging up mid-write should end its stream, not the server.
+    std::signal(SIGPIPE, SIG_IGN);
+   #endif
+
+    RenderServer server(options);
+    if (! server.start())
+    {
+        std::cerr << "Could not listen on port " << options.port << std::endl;
+        return 1;
+    }
+
+    std::cout << "Listening on http://127.0.0.1:" << server.getPort() << " (Ctrl+C to quit)" << std::endl;
+    while (! quitRequested.load())
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    server.stop();
+    return 0;
+}
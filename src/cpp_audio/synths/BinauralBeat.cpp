@@ -1,10 +1,11 @@
 #include "BinauralBeat.h"
 #include "AudioUtils.h"
+#include "VoiceState.h"
+#include "BinauralOscillator.h"
+#include "GlitchScheduler.h"
 #include <vector>
 #include <cmath>
 #include <algorithm>
-#include <random>
-#include <juce_dsp/juce_dsp.h>
 
 using namespace juce;
 
@@ -32,147 +33,67 @@ AudioBuffer<float> binauralBeat(double duration, double sampleRate, const NamedV
     double fOFR  = params.getWithDefault("freqOscFreqR", 0.0);
     double ampOscPhaseOffsetL = params.getWithDefault("ampOscPhaseOffsetL", 0.0);
     double ampOscPhaseOffsetR = params.getWithDefault("ampOscPhaseOffsetR", 0.0);
+    double fOPL = params.getWithDefault("freqOscPhaseOffsetL", 0.0);
+    double fOPR = params.getWithDefault("freqOscPhaseOffsetR", 0.0);
     double pOF  = params.getWithDefault("phaseOscFreq", 0.0);
     double pOR  = params.getWithDefault("phaseOscRange", 0.0);
+    double pOP  = params.getWithDefault("phaseOscPhaseOffset", 0.0);
 
     double glitchInterval   = params.getWithDefault("glitchInterval", 0.0);
     double glitchDur        = params.getWithDefault("glitchDur", 0.0);
     double glitchNoiseLevel = params.getWithDefault("glitchNoiseLevel", 0.0);
     double glitchFocusWidth = params.getWithDefault("glitchFocusWidth", 0.0);
     double glitchFocusExp   = params.getWithDefault("glitchFocusExp", 0.0);
-
-    std::vector<double> t(N);
-    std::vector<double> instL(N), instR(N);
-    std::vector<double> phaseL(N), phaseR(N);
-    std::vector<double> envL(N), envR(N);
-
+    // A fixed seed keeps renders repeatable. Bursts must finish by
+    // glitchEndSeconds, which a render of the start of a longer step sets
+    // to that step's length so the same bursts are placed.
+    int64  glitchSeed       = static_cast<int64>(params.getWithDefault("glitchSeed", 1));
+    double glitchEnd        = params.getWithDefault("glitchEndSeconds", duration);
+
+    BinauralOscillator::Settings settings;
+    settings.ampL = ampL;
+    settings.ampR = ampR;
+    settings.baseFreq = baseF;
+    settings.beatFreq = beatF;
+    settings.ampOscDepthL = aODL;
+    settings.ampOscDepthR = aODR;
+    settings.freqOscRangeL = fORL;
+    settings.freqOscRangeR = fORR;
+    settings.phaseOscRange = pOR;
+    settings.forceMono = forceMono;
+
+    BinauralOscillator osc;
+    osc.carrierL = startL;
+    osc.carrierR = startR;
+    const double twoPi = 2.0 * MathConstants<double>::pi;
     double dt = duration / static_cast<double>(N);
-    for (int i = 0; i < N; ++i)
-        t[i] = i * dt;
-
-    double halfB = beatF * 0.5;
-    double fLbase = baseF - halfB;
-    double fRbase = baseF + halfB;
+    float* outL = buffer.getWritePointer(0);
+    float* outR = buffer.getWritePointer(1);
     for (int i = 0; i < N; ++i)
     {
-        double vibL = (fORL * 0.5) * std::sin(2.0 * MathConstants<double>::pi * fOFL * t[i]);
-        double vibR = (fORR * 0.5) * std::sin(2.0 * MathConstants<double>::pi * fOFR * t[i]);
-        instL[i] = std::max(0.0, fLbase + vibL);
-        instR[i] = std::max(0.0, fRbase + vibR);
+        double t = i * dt;
+        BinauralOscillator::Lfos lfo;
+        lfo.freqOscL = twoPi * fOFL * t + fOPL;
+        lfo.freqOscR = twoPi * fOFR * t + fOPR;
+        lfo.ampOscL = twoPi * aOFL * t + ampOscPhaseOffsetL;
+        lfo.ampOscR = twoPi * aOFR * t + ampOscPhaseOffsetR;
+        lfo.phaseOsc = twoPi * pOF * t + pOP;
+        osc.process(settings, lfo, dt, outL[i], outR[i]);
     }
 
-    if (forceMono || beatF == 0.0)
-        for (int i = 0; i < N; ++i)
-            instL[i] = instR[i] = std::max(0.0, baseF);
+    // Hand the oscillator state on to a continuing voice in the next step.
+    publishVoiceState("startPhaseL", osc.carrierL);
+    publishVoiceState("startPhaseR", osc.carrierR);
+    publishVoiceState("ampOscPhaseOffsetL", twoPi * aOFL * duration + ampOscPhaseOffsetL);
+    publishVoiceState("ampOscPhaseOffsetR", twoPi * aOFR * duration + ampOscPhaseOffsetR);
+    publishVoiceState("freqOscPhaseOffsetL", twoPi * fOFL * duration + fOPL);
+    publishVoiceState("freqOscPhaseOffsetR", twoPi * fOFR * duration + fOPR);
+    publishVoiceState("phaseOscPhaseOffset", twoPi * pOF * duration + pOP);
 
-    double curL = startL;
-    double curR = startR;
-    for (int i = 0; i < N; ++i)
-    {
-        curL += 2.0 * MathConstants<double>::pi * instL[i] * dt;
-        curR += 2.0 * MathConstants<double>::pi * instR[i] * dt;
-        phaseL[i] = curL;
-        phaseR[i] = curR;
-    }
-
-    if (pOF != 0.0 || pOR != 0.0)
-    {
-        for (int i = 0; i < N; ++i)
-        {
-            double dphi = (pOR * 0.5) * std::sin(2.0 * MathConstants<double>::pi * pOF * t[i]);
-            phaseL[i] -= dphi;
-            phaseR[i] += dphi;
-        }
-    }
-
-    for (int i = 0; i < N; ++i)
-    {
-        envL[i] = 1.0 - aODL * (0.5 * (1.0 + std::sin(2.0 * MathConstants<double>::pi * aOFL * t[i] + ampOscPhaseOffsetL)));
-        envR[i] = 1.0 - aODR * (0.5 * (1.0 + std::sin(2.0 * MathConstants<double>::pi * aOFR * t[i] + ampOscPhaseOffsetR)));
-    }
-
-    std::vector<int> glitchPos;
-    std::vector<float> glitchBuf;
-    if (glitchInterval > 0.0 && glitchDur > 0.0 && glitchNoiseLevel > 0.0 && N > 0)
-    {
-        int fullN = static_cast<int>(glitchDur * sampleRate);
-        if (fullN > 0)
-        {
-            int repeats = glitchInterval > 0.0 ? static_cast<int>(duration / glitchInterval) : 0;
-            std::mt19937 rng(std::random_device{}());
-            std::normal_distribution<float> dist(0.0f, 1.0f);
-
-            juce::dsp::IIR::Filter<float> bpFilter;
-            if (glitchFocusWidth > 0.0)
-            {
-                double q = baseF / std::max(1e-6, glitchFocusWidth);
-                bpFilter.coefficients = juce::dsp::IIR::Coefficients<float>::makeBandPass(sampleRate, baseF, q);
-            }
-
-            for (int k = 1; k <= repeats; ++k)
-            {
-                double tEnd = k * glitchInterval;
-                double tStart = std::max(0.0, tEnd - glitchDur);
-                int i0 = static_cast<int>(tStart * sampleRate);
-                int i1 = i0 + fullN;
-                if (i1 > N)
-                    continue;
-
-                std::vector<float> noise(fullN);
-                for (int i = 0; i < fullN; ++i)
-                    noise[i] = dist(rng);
-
-                if (glitchFocusWidth > 0.0)
-                {
-                    bpFilter.reset();
-                    for (int i = 0; i < fullN; ++i)
-                        noise[i] = bpFilter.processSample(noise[i]);
-                }
-
-                float maxAbs = 0.0f;
-                for (float s : noise)
-                    maxAbs = std::max(maxAbs, std::abs(s));
-                if (maxAbs < 1e-6f)
-                    maxAbs = 1.0f;
-
-                for (int i = 0; i < fullN; ++i)
-                {
-                    float ramp = static_cast<float>(i) / static_cast<float>(fullN);
-                    glitchBuf.push_back((noise[i] / maxAbs) * ramp * static_cast<float>(glitchNoiseLevel));
-                }
-                glitchPos.push_back(i0);
-            }
-        }
-    }
-
-    for (int i = 0; i < N; ++i)
-    {
-        float outL = static_cast<float>(std::sin(phaseL[i]) * envL[i] * ampL);
-        float outR = static_cast<float>(std::sin(phaseR[i]) * envR[i] * ampR);
-        buffer.setSample(0, i, outL);
-        buffer.setSample(1, i, outR);
-    }
-
-    if (!glitchBuf.empty() && glitchBuf.size() % glitchPos.size() == 0)
-    {
-        int segLen = static_cast<int>(glitchBuf.size() / glitchPos.size());
-        size_t idx = 0;
-        for (size_t b = 0; b < glitchPos.size(); ++b)
-        {
-            int start = glitchPos[b];
-            for (int j = 0; j < segLen; ++j)
-            {
-                int p = start + j;
-                if (p < N)
-                {
-                    float val = glitchBuf[idx + j];
-                    buffer.addSample(0, p, val);
-                    buffer.addSample(1, p, val);
-                }
-            }
-            idx += segLen;
-        }
-    }
+    GlitchScheduler glitches(glitchInterval, glitchDur, glitchNoiseLevel, baseF, glitchFocusWidth,
+                             sampleRate, static_cast<int64>(glitchEnd * sampleRate), glitchSeed);
+    if (glitches.isActive())
+        glitches.process(buffer.getWritePointer(0), buffer.getWritePointer(1), N);
 
     return buffer;
 }
@@ -222,6 +143,12 @@ AudioBuffer<float> binauralBeatTransition(double duration, double sampleRate, co
     double endFORR   = params.getWithDefault("endFreqOscRangeR", startFORR);
     double startFOFR = params.getWithDefault("startFreqOscFreqR", params.getWithDefault("freqOscFreqR", 0.0));
     double endFOFR   = params.getWithDefault("endFreqOscFreqR", startFOFR);
+    double startFOPL = params.getWithDefault("startFreqOscPhaseOffsetL", params.getWithDefault("freqOscPhaseOffsetL", 0.0));
+    double endFOPL   = params.getWithDefault("endFreqOscPhaseOffsetL", startFOPL);
+    double startFOPR = params.getWithDefault("startFreqOscPhaseOffsetR", params.getWithDefault("freqOscPhaseOffsetR", 0.0));
+    double endFOPR   = params.getWithDefault("endFreqOscPhaseOffsetR", startFOPR);
+    double startPOP = params.getWithDefault("startPhaseOscPhaseOffset", params.getWithDefault("phaseOscPhaseOffset", 0.0));
+    double endPOP   = params.getWithDefault("endPhaseOscPhaseOffset", startPOP);
 
     double sGlitchInterval = params.getWithDefault("startGlitchInterval", params.getWithDefault("glitchInterval", 0.0));
     double eGlitchInterval = params.getWithDefault("endGlitchInterval", sGlitchInterval);
@@ -247,146 +174,55 @@ AudioBuffer<float> binauralBeatTransition(double duration, double sampleRate, co
     String curve = params.getWithDefault("transition_curve", "linear");
 
     auto alpha = calculateTransitionAlpha(duration, sampleRate, initialOffset, postOffset, curve);
-    std::vector<double> t(N);
-    for (int i = 0; i < N; ++i)
-        t[i] = i * (duration / static_cast<double>(N));
-
-    std::vector<double> instL(N), instR(N), phaseL(N), phaseR(N), envL(N), envR(N);
-    std::vector<double> outAmpL(N), outAmpR(N);
-
-    std::vector<int> glitchPos;
-    std::vector<float> glitchBuf;
-    if (avgGlitchInterval > 0.0 && avgGlitchDur > 0.0 && avgGlitchNoiseLevel > 0.0 && N > 0)
-    {
-        int gSamples = static_cast<int>(avgGlitchDur * sampleRate);
-        if (gSamples > 0)
-        {
-            int repeats = avgGlitchInterval > 0.0 ? static_cast<int>(duration / avgGlitchInterval) : 0;
-            std::mt19937 rng(std::random_device{}());
-            std::normal_distribution<float> dist(0.0f, 1.0f);
-            double shapingFreq = (startBaseF + endBaseF) * 0.5;
-            juce::dsp::IIR::Filter<float> bpFilter;
-            if (avgGlitchFocusWidth > 0.0)
-            {
-                double q = shapingFreq / std::max(1e-6, avgGlitchFocusWidth);
-                bpFilter.coefficients = juce::dsp::IIR::Coefficients<float>::makeBandPass(sampleRate, shapingFreq, q);
-            }
-
-            for (int k = 1; k <= repeats; ++k)
-            {
-                double tEnd = k * avgGlitchInterval;
-                double tStart = std::max(0.0, tEnd - avgGlitchDur);
-                int i0 = static_cast<int>(tStart * sampleRate);
-                int i1 = i0 + gSamples;
-                if (i1 > N)
-                    continue;
-
-                std::vector<float> noise(gSamples);
-                for (int i = 0; i < gSamples; ++i)
-                    noise[i] = dist(rng);
-
-                if (avgGlitchFocusWidth > 0.0)
-                {
-                    bpFilter.reset();
-                    for (int i = 0; i < gSamples; ++i)
-                        noise[i] = bpFilter.processSample(noise[i]);
-                }
-
-                float maxAbs = 0.0f;
-                for (float s : noise)
-                    maxAbs = std::max(maxAbs, std::abs(s));
-                if (maxAbs < 1e-6f)
-                    maxAbs = 1.0f;
-
-                for (int i = 0; i < gSamples; ++i)
-                {
-                    float ramp = static_cast<float>(i) / static_cast<float>(gSamples);
-                    float val = (noise[i] / maxAbs) * ramp * static_cast<float>(avgGlitchNoiseLevel);
-                    glitchBuf.push_back(val);
-                }
-                glitchPos.push_back(i0);
-            }
-        }
-    }
-
-    for (int i = 0; i < N; ++i)
-    {
-        double a = alpha.empty() ? static_cast<double>(i) / (N > 1 ? N - 1 : 1) : alpha[i];
-        outAmpL[i] = startAmpL + (endAmpL - startAmpL) * a;
-        outAmpR[i] = startAmpR + (endAmpR - startAmpR) * a;
-        double baseF = startBaseF + (endBaseF - startBaseF) * a;
-        double beatF = startBeatF + (endBeatF - startBeatF) * a;
-        double forceM = startForceMono + (endForceMono - startForceMono) * a;
-        double forL = startFORL + (endFORL - startFORL) * a;
-        double fofL = startFOFL + (endFOFL - startFOFL) * a;
-        double forR = startFORR + (endFORR - startFORR) * a;
-        double fofR = startFOFR + (endFOFR - startFOFR) * a;
-
-        double halfB = beatF * 0.5;
-        double fLbase = baseF - halfB;
-        double fRbase = baseF + halfB;
-        double vibL = (forL * 0.5) * std::sin(2.0 * MathConstants<double>::pi * fofL * t[i]);
-        double vibR = (forR * 0.5) * std::sin(2.0 * MathConstants<double>::pi * fofR * t[i]);
-        instL[i] = (forceM > 0.5 || beatF == 0.0) ? std::max(0.0, baseF) : std::max(0.0, fLbase + vibL);
-        instR[i] = (forceM > 0.5 || beatF == 0.0) ? std::max(0.0, baseF) : std::max(0.0, fRbase + vibR);
-
-        envL[i] = 1.0 - (startAODL + (endAODL - startAODL) * a) *
-                        (0.5 * (1.0 + std::sin(2.0 * MathConstants<double>::pi * (startAOFL + (endAOFL - startAOFL) * a) * t[i] +
-                                            (startAmpOscPhaseOffsetL + (endAmpOscPhaseOffsetL - startAmpOscPhaseOffsetL) * a))));
-        envR[i] = 1.0 - (startAODR + (endAODR - startAODR) * a) *
-                        (0.5 * (1.0 + std::sin(2.0 * MathConstants<double>::pi * (startAOFR + (endAOFR - startAOFR) * a) * t[i] +
-                                            (startAmpOscPhaseOffsetR + (endAmpOscPhaseOffsetR - startAmpOscPhaseOffsetR) * a))));
-    }
 
-    double curL = startStartPhaseL;
-    double curR = startStartPhaseR;
+    BinauralOscillator osc;
+    osc.carrierL = startStartPhaseL;
+    osc.carrierR = startStartPhaseR;
+    const double twoPi = 2.0 * MathConstants<double>::pi;
     double dt = duration / static_cast<double>(N);
-    for (int i = 0; i < N; ++i)
-    {
-        curL += 2.0 * MathConstants<double>::pi * instL[i] * dt;
-        curR += 2.0 * MathConstants<double>::pi * instR[i] * dt;
-        phaseL[i] = curL;
-        phaseR[i] = curR;
-    }
-
+    float* outL = buffer.getWritePointer(0);
+    float* outR = buffer.getWritePointer(1);
     for (int i = 0; i < N; ++i)
     {
         double a = alpha.empty() ? static_cast<double>(i) / (N > 1 ? N - 1 : 1) : alpha[i];
-        double pOFv = startPOF + (endPOF - startPOF) * a;
-        double pORv = startPOR + (endPOR - startPOR) * a;
-        double dphi = (pORv * 0.5) * std::sin(2.0 * MathConstants<double>::pi * pOFv * t[i]);
-        phaseL[i] -= dphi;
-        phaseR[i] += dphi;
+        double t = i * dt;
+
+        BinauralOscillator::Settings settings;
+        settings.ampL = startAmpL + (endAmpL - startAmpL) * a;
+        settings.ampR = startAmpR + (endAmpR - startAmpR) * a;
+        settings.baseFreq = startBaseF + (endBaseF - startBaseF) * a;
+        settings.beatFreq = startBeatF + (endBeatF - startBeatF) * a;
+        settings.ampOscDepthL = startAODL + (endAODL - startAODL) * a;
+        settings.ampOscDepthR = startAODR + (endAODR - startAODR) * a;
+        settings.freqOscRangeL = startFORL + (endFORL - startFORL) * a;
+        settings.freqOscRangeR = startFORR + (endFORR - startFORR) * a;
+        settings.phaseOscRange = startPOR + (endPOR - startPOR) * a;
+        settings.forceMono = startForceMono + (endForceMono - startForceMono) * a > 0.5;
+
+        BinauralOscillator::Lfos lfo;
+        lfo.freqOscL = twoPi * (startFOFL + (endFOFL - startFOFL) * a) * t + (startFOPL + (endFOPL - startFOPL) * a);
+        lfo.freqOscR = twoPi * (startFOFR + (endFOFR - startFOFR) * a) * t + (startFOPR + (endFOPR - startFOPR) * a);
+        lfo.ampOscL = twoPi * (startAOFL + (endAOFL - startAOFL) * a) * t
+                      + (startAmpOscPhaseOffsetL + (endAmpOscPhaseOffsetL - startAmpOscPhaseOffsetL) * a);
+        lfo.ampOscR = twoPi * (startAOFR + (endAOFR - startAOFR) * a) * t
+                      + (startAmpOscPhaseOffsetR + (endAmpOscPhaseOffsetR - startAmpOscPhaseOffsetR) * a);
+        lfo.phaseOsc = twoPi * (startPOF + (endPOF - startPOF) * a) * t + (startPOP + (endPOP - startPOP) * a);
+        osc.process(settings, lfo, dt, outL[i], outR[i]);
     }
 
-    for (int i = 0; i < N; ++i)
-    {
-        float outL = static_cast<float>(std::sin(phaseL[i]) * envL[i] * outAmpL[i]);
-        float outR = static_cast<float>(std::sin(phaseR[i]) * envR[i] * outAmpR[i]);
-        buffer.setSample(0, i, outL);
-        buffer.setSample(1, i, outR);
-    }
-
-    if (!glitchBuf.empty() && glitchBuf.size() % glitchPos.size() == 0)
-    {
-        int segLen = static_cast<int>(glitchBuf.size() / glitchPos.size());
-        size_t idx = 0;
-        for (size_t b = 0; b < glitchPos.size(); ++b)
-        {
-            int start = glitchPos[b];
-            for (int j = 0; j < segLen; ++j)
-            {
-                int p = start + j;
-                if (p < N)
-                {
-                    float val = glitchBuf[idx + j];
-                    buffer.addSample(0, p, val);
-                    buffer.addSample(1, p, val);
-                }
-            }
-            idx += segLen;
-        }
-    }
+    publishVoiceState("startPhaseL", osc.carrierL);
+    publishVoiceState("startPhaseR", osc.carrierR);
+    publishVoiceState("ampOscPhaseOffsetL", twoPi * endAOFL * duration + endAmpOscPhaseOffsetL);
+    publishVoiceState("ampOscPhaseOffsetR", twoPi * endAOFR * duration + endAmpOscPhaseOffsetR);
+    publishVoiceState("freqOscPhaseOffsetL", twoPi * endFOFL * duration + endFOPL);
+    publishVoiceState("freqOscPhaseOffsetR", twoPi * endFOFR * duration + endFOPR);
+    publishVoiceState("phaseOscPhaseOffset", twoPi * endPOF * duration + endPOP);
+
+    double shapingFreq = (startBaseF + endBaseF) * 0.5;
+    GlitchScheduler glitches(avgGlitchInterval, avgGlitchDur, avgGlitchNoiseLevel, shapingFreq, avgGlitchFocusWidth,
+                             sampleRate, N, static_cast<int64>(params.getWithDefault("glitchSeed", 1)));
+    if (glitches.isActive())
+        glitches.process(buffer.getWritePointer(0), buffer.getWritePointer(1), N);
 
     return buffer;
 }
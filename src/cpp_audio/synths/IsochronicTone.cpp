@@ -1,29 +1,13 @@
 #include "IsochronicTone.h"
 #include "AudioUtils.h"
+#include "IsochronicPulse.h"
 #include <cmath>
 #include <algorithm>
 
 using namespace juce;
 
-static double trapezoidEnv(double t, double cycleLen, double rampPercent, double gapPercent)
-{
-    if (cycleLen <= 0.0)
-        return 0.0;
-
-    double audibleLen = (1.0 - gapPercent) * cycleLen;
-    double rampTotal = std::clamp(audibleLen * rampPercent * 2.0, 0.0, audibleLen);
-    double rampUpLen = rampTotal * 0.5;
-    double stableLen = audibleLen - rampTotal;
-    double stableEnd = rampUpLen + stableLen;
-
-    if (t >= audibleLen)
-        return 0.0;
-    if (t < rampUpLen)
-        return rampUpLen > 0.0 ? t / rampUpLen : 0.0;
-    if (t >= stableEnd)
-        return rampUpLen > 0.0 ? (audibleLen - t) / rampUpLen : 0.0;
-    return 1.0;
-}
+// Samples per envelope block; small enough to live on the stack.
+static constexpr int pulseBlockSize = 256;
 
 AudioBuffer<float> isochronicTone(double duration, double sampleRate, const NamedValueSet& params)
 {
@@ -38,25 +22,31 @@ AudioBuffer<float> isochronicTone(double duration, double sampleRate, const Name
     double rampPct    = params.getWithDefault("rampPercent", 0.2);
     double gapPct     = params.getWithDefault("gapPercent", 0.15);
     double pan        = params.getWithDefault("pan", 0.0);
+    String rampShape  = params.getWithDefault("rampShape", "linear");
 
     auto gains = getPanGains(pan);
 
     double dt = 1.0 / sampleRate;
     double phase = 0.0;
-    double cycle = beatFreq > 0.0 ? 1.0 / beatFreq : 0.0;
-    double onTime = cycle * (1.0 - gapPct);
-    double rampTime = onTime * rampPct;
+    IsochronicPulse pulse(rampPct, gapPct, IsochronicPulse::parseRampShape(rampShape));
+    double env[pulseBlockSize];
 
-    for (int i = 0; i < totalSamples; ++i)
+    for (int start = 0; start < totalSamples; start += pulseBlockSize)
     {
-        double tInCycle = beatFreq > 0.0 ? std::fmod(i * dt, cycle) : 0.0;
-        double env = trapezoidEnv(tInCycle, cycle, rampPct, gapPct);
-
-        float s = static_cast<float>(std::sin(phase) * amp * env);
-        buffer.setSample(0, i, s * gains.first);
-        buffer.setSample(1, i, s * gains.second);
-
-        phase += MathConstants<double>::twoPi * baseFreq * dt;
+        int n = std::min(pulseBlockSize, totalSamples - start);
+        if (beatFreq > 0.0)
+            pulse.process(beatFreq * dt, env, n);
+        else
+            std::fill(env, env + n, 0.0);
+
+        for (int k = 0; k < n; ++k)
+        {
+            float s = static_cast<float>(std::sin(phase) * amp * env[k]);
+            buffer.setSample(0, start + k, s * gains.first);
+            buffer.setSample(1, start + k, s * gains.second);
+
+            phase += MathConstants<double>::twoPi * baseFreq * dt;
+        }
     }
     return buffer;
 }
@@ -76,6 +66,7 @@ AudioBuffer<float> isochronicToneTransition(double duration, double sampleRate,
     double rampPct       = params.getWithDefault("rampPercent", 0.2);
     double gapPct        = params.getWithDefault("gapPercent", 0.15);
     double pan           = params.getWithDefault("pan", 0.0);
+    String rampShape     = params.getWithDefault("rampShape", "linear");
     double initialOffset = params.getWithDefault("initial_offset", 0.0);
     double postOffset    = params.getWithDefault("post_offset", 0.0);
     String curve         = params.getWithDefault("transition_curve", "linear");
@@ -85,26 +76,46 @@ AudioBuffer<float> isochronicToneTransition(double duration, double sampleRate,
 
     double dt = 1.0 / sampleRate;
     double phase = 0.0;
-    double beatPhase = 0.0;
+    IsochronicPulse pulse(rampPct, gapPct, IsochronicPulse::parseRampShape(rampShape));
 
-    for (int i = 0; i < totalSamples; ++i)
+    auto fractionAt = [&](int i)
     {
-        double a = alpha.empty() ? static_cast<double>(i) / (totalSamples > 1 ? totalSamples - 1 : 1)
-                                 : alpha[i];
-
-        double baseF = std::max(0.0, startBaseF + (endBaseF - startBaseF) * a);
-        double beatF = std::max(0.0, startBeatF + (endBeatF - startBeatF) * a);
-        double cycle = beatF > 0.0 ? 1.0 / beatF : 0.0;
+        return alpha.empty() ? static_cast<double>(i) / (totalSamples > 1 ? totalSamples - 1 : 1)
+                             : alpha[static_cast<size_t>(i)];
+    };
+    auto beatFreqAt = [&](int i)
+    {
+        return std::max(0.0, startBeatF + (endBeatF - startBeatF) * fractionAt(i));
+    };
 
-        beatPhase += beatF * dt;
-        double tInCycle = beatF > 0.0 ? std::fmod(beatPhase, 1.0) * cycle : 0.0;
-        double env = trapezoidEnv(tInCycle, cycle, rampPct, gapPct);
+    // Each sample has always been shaped after adding its own beat
+    // increment, so start one increment in and advance by the next
+    // sample's rate.
+    pulse.setPhase(beatFreqAt(0) * dt);
 
-        float s = static_cast<float>(std::sin(phase) * amp * env);
-        buffer.setSample(0, i, s * gains.first);
-        buffer.setSample(1, i, s * gains.second);
+    double env[pulseBlockSize];
+    double increments[pulseBlockSize];
 
-        phase += MathConstants<double>::twoPi * baseF * dt;
+    for (int start = 0; start < totalSamples; start += pulseBlockSize)
+    {
+        int n = std::min(pulseBlockSize, totalSamples - start);
+        for (int k = 0; k < n; ++k)
+            increments[k] = beatFreqAt(std::min(start + k + 1, totalSamples - 1)) * dt;
+        pulse.process(increments, env, n);
+
+        for (int k = 0; k < n; ++k)
+        {
+            int i = start + k;
+            double a = fractionAt(i);
+            double baseF = std::max(0.0, startBaseF + (endBaseF - startBaseF) * a);
+            double beatF = std::max(0.0, startBeatF + (endBeatF - startBeatF) * a);
+
+            float s = static_cast<float>(std::sin(phase) * amp * (beatF > 0.0 ? env[k] : 0.0));
+            buffer.setSample(0, i, s * gains.first);
+            buffer.setSample(1, i, s * gains.second);
+
+            phase += MathConstants<double>::twoPi * baseF * dt;
+        }
     }
 
     return buffer;
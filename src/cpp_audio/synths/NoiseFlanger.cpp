@@ -1,10 +1,11 @@
 #include "NoiseFlanger.h"
 #include "AudioUtils.h"
+#include "../core/RenderQuality.h"
 #include "../core/VarUtils.h"
-#include <juce_dsp/juce_dsp.h>
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <thread>
 
 // The implementation here is a simplified C++ version of the Python
 // ``noise_flanger`` module.  It generates pink or brown noise and applies one
@@ -19,431 +20,492 @@ namespace
 //------------------------------------------------------------------------------
 // Helper utilities
 
-static std::vector<float> generatePinkNoise(int n)
-{
-    Random rng;
-    std::vector<float> out(n);
+constexpr int renderBlockSize = 65536;
 
-    float b0 = 0.0f, b1 = 0.0f, b2 = 0.0f, b3 = 0.0f, b4 = 0.0f, b5 = 0.0f;
-    for (int i = 0; i < n; ++i)
-    {
-        float w = rng.nextFloat() * 2.0f - 1.0f;
-        b0 = 0.99886f * b0 + w * 0.0555179f;
-        b1 = 0.99332f * b1 + w * 0.0750759f;
-        b2 = 0.96900f * b2 + w * 0.1538520f;
-        b3 = 0.86650f * b3 + w * 0.3104856f;
-        b4 = 0.55000f * b4 + w * 0.5329522f;
-        b5 = -0.7616f * b5 - w * 0.0168980f;
-
-        out[i] = (b0 + b1 + b2 + b3 + b4 + b5 + w * 0.5362f) * 0.11f;
-    }
-    return out;
-}
+// Draft renders: fewer notches, retuned every few milliseconds.
+constexpr int draftMaxCascades = 3;
+constexpr int draftControlInterval = 32;
 
-static std::vector<float> generateBrownNoise(int n)
+// Reads the first entry of a filter_sweeps list.  Expect [[min, max], ...] or
+// a dictionary with keys <prefix>_min/<prefix>_max (or min/max).
+static void readFirstSweep(const NamedValueSet& params, const char* key,
+                           const String& prefix, double& minFreq, double& maxFreq)
 {
-    Random rng;
-    std::vector<float> out(n);
-    float accum = 0.0f;
-    for (int i = 0; i < n; ++i)
+    if (! params.contains(key))
+        return;
+    auto* arr = params[key].getArray();
+    if (arr == nullptr || arr->isEmpty())
+        return;
+
+    auto e = (*arr)[0];
+    if (auto* pair = e.getArray())
     {
-        accum += rng.nextFloat() * 2.0f - 1.0f;
-        out[i] = accum;
+        if (pair->size() >= 2)
+        {
+            minFreq = pair->getUnchecked(0);
+            maxFreq = pair->getUnchecked(1);
+        }
+    }
+    else if (auto* obj = e.getDynamicObject())
+    {
+        minFreq = getPropertyWithDefault(obj, prefix + "_min", getPropertyWithDefault(obj, "min", minFreq));
+        maxFreq = getPropertyWithDefault(obj, prefix + "_max", getPropertyWithDefault(obj, "max", maxFreq));
     }
-
-    float maxAbs = 1e-9f;
-    for (float v : out)
-        maxAbs = std::max(maxAbs, std::abs(v));
-    for (float& v : out)
-        v /= maxAbs;
-    return out;
 }
 
-static float computeRms(const std::vector<float>& data)
+static double triangle(double phase)
 {
-    double sum = 0.0;
-    for (float v : data)
-        sum += static_cast<double>(v) * static_cast<double>(v);
-    return static_cast<float>(std::sqrt(sum / std::max<size_t>(1, data.size())));
+    double frac = phase / MathConstants<double>::twoPi;
+    frac = frac - std::floor(frac);
+    return 2.0 * std::abs(2.0 * frac - 1.0) - 1.0;
 }
 
-static std::vector<float> applyNotchSweep(const std::vector<float>& in,
-                                          double sampleRate,
-                                          double lfoFreq,
-                                          double phaseOffset,
-                                          double intraPhaseOffset,
-                                          double minFreq,
-                                          double maxFreq,
-                                          double q,
-                                          int    cascades,
-                                          String lfoWaveform)
+struct ChannelLevels
 {
-    int n = static_cast<int>(in.size());
-    std::vector<float> out(n);
-
-    std::vector<dsp::IIR::Filter<float>> filters(cascades);
-    for (auto& f : filters)
-        f.reset();
+    double energy = 0.0;
+    float peak = 0.0f;
+};
+
+// Gains that bring each output channel to the RMS of its dry input, then
+// pull both down together if the louder one would peak above 0.95.
+static std::pair<float, float> computeGains(const ChannelLevels& dryL, const ChannelLevels& dryR,
+                                            const ChannelLevels& l, const ChannelLevels& r)
+{
+    double gL = l.energy > 1e-16 ? std::sqrt(jmax(1e-16, dryL.energy) / l.energy) : 1.0;
+    double gR = r.energy > 1e-16 ? std::sqrt(jmax(1e-16, dryR.energy) / r.energy) : 1.0;
 
-    auto triangle = [](double phase)
+    double maxAbs = jmax(l.peak * gL, r.peak * gR);
+    if (maxAbs > 0.95)
     {
-        double frac = phase / MathConstants<double>::twoPi;
-        frac = frac - std::floor(frac);
-        return 2.0 * std::abs(2.0 * frac - 1.0) - 1.0;
-    };
-
-    double phase = phaseOffset;
-    double phase2 = phaseOffset + intraPhaseOffset;
-    double dt = 1.0 / sampleRate;
+        gL *= 0.95 / maxAbs;
+        gR *= 0.95 / maxAbs;
+    }
+    return { (float) gL, (float) gR };
+}
 
-    for (int i = 0; i < n; ++i)
+static void measure(const AudioBuffer<float>& buf, int start, int numSamples,
+                    ChannelLevels& l, ChannelLevels& r)
+{
+    ChannelLevels* levels[] = { &l, &r };
+    for (int ch = 0; ch < 2; ++ch)
     {
-        double lfo = (lfoWaveform == "triangle") ? triangle(phase)
-                                                   : std::cos(phase);
-        double lfo2 = (lfoWaveform == "triangle") ? triangle(phase2)
-                                                   : std::cos(phase2);
-
-        double freq1 = minFreq + (maxFreq - minFreq) * (lfo + 1.0) * 0.5;
-        double freq2 = minFreq + (maxFreq - minFreq) * (lfo2 + 1.0) * 0.5;
+        const float* d = buf.getReadPointer(ch, start);
+        double e = 0.0;
+        for (int i = 0; i < numSamples; ++i)
+            e += (double) d[i] * (double) d[i];
+        levels[ch]->energy += e;
+        levels[ch]->peak = jmax(levels[ch]->peak, buf.getMagnitude(ch, start, numSamples));
+    }
+}
 
-        auto coeff1 = dsp::IIR::Coefficients<float>::makeNotch(sampleRate, freq1, q);
-        auto coeff2 = dsp::IIR::Coefficients<float>::makeNotch(sampleRate, freq2, q);
+// The dry signal for the notches: the processor's own noise or a recording
+// read a block at a time (and resampled if its rate differs).
+class DrySignal
+{
+public:
+    DrySignal(SweptNotchProcessor& p, const File& input, double sampleRate)
+        : processor(p)
+    {
+        if (input == File())
+            return;
 
-        float sample = in[i];
-        for (auto& f : filters)
+        formatManager.registerBasicFormats();
+        auto* reader = formatManager.createReaderFor(input);
+        if (reader == nullptr || reader->sampleRate <= 0.0)
         {
-            f.coefficients = coeff1;
-            sample = f.processSample(sample);
+            delete reader;
+            failed = true;
+            return;
         }
-        for (auto& f : filters)
+
+        monoInput = reader->numChannels == 1;
+        inputLength = (int64) (reader->lengthInSamples * sampleRate / reader->sampleRate);
+        double inputRate = reader->sampleRate;
+        readerSource = std::make_unique<AudioFormatReaderSource>(reader, true);
+        source = readerSource.get();
+        if (std::abs(inputRate - sampleRate) > 1e-6)
         {
-            f.coefficients = coeff2;
-            sample = f.processSample(sample);
+            resampler = std::make_unique<ResamplingAudioSource>(readerSource.get(), false, 2);
+            resampler->setResamplingRatio(inputRate / sampleRate);
+            source = resampler.get();
         }
+        source->prepareToPlay(renderBlockSize, sampleRate);
+    }
 
-        out[i] = sample;
+    ~DrySignal()
+    {
+        if (source != nullptr)
+            source->releaseResources();
+    }
 
-        phase += MathConstants<double>::twoPi * lfoFreq * dt;
-        phase2 += MathConstants<double>::twoPi * lfoFreq * dt;
+    bool isValid() const { return ! failed; }
+    bool isFile() const { return source != nullptr; }
+    /** Length of the input at the output rate; 0 for noise. */
+    int64 getInputLength() const { return inputLength; }
+
+    void read(AudioBuffer<float>& dry, int numSamples)
+    {
+        if (source == nullptr)
+        {
+            processor.generateNoise(dry, numSamples);
+            return;
+        }
+        source->getNextAudioBlock(AudioSourceChannelInfo(&dry, 0, numSamples));
+        if (monoInput)
+            dry.copyFrom(1, 0, dry, 0, 0, numSamples);
     }
 
-    return out;
-}
+    void rewind()
+    {
+        processor.reset();
+        if (readerSource != nullptr)
+            readerSource->setNextReadPosition(0);
+        if (resampler != nullptr)
+            resampler->flushBuffers();
+    }
+
+private:
+    SweptNotchProcessor& processor;
+    AudioFormatManager formatManager;
+    std::unique_ptr<AudioFormatReaderSource> readerSource;
+    std::unique_ptr<ResamplingAudioSource> resampler;
+    AudioSource* source = nullptr;
+    bool monoInput = false;
+    bool failed = false;
+    int64 inputLength = 0;
+};
 } // namespace
 
 //------------------------------------------------------------------------------
 
-AudioBuffer<float> generateSweptNotchPinkSound(double duration,
-                                               double sampleRate,
-                                               const NamedValueSet& params)
+SweptNotchProcessor::Settings SweptNotchProcessor::Settings::fromParams(const NamedValueSet& params,
+                                                                        bool transition)
 {
-    int totalSamples = static_cast<int>(duration * sampleRate);
-    AudioBuffer<float> buffer(2, totalSamples);
-    if (totalSamples <= 0)
-        return buffer;
+    Settings s;
+    s.brownNoise  = params.getWithDefault("noise_type", "pink").toString() == "brown";
+    String inputPath = params.getWithDefault("input_audio_path", "").toString();
+    if (inputPath.isNotEmpty())
+        s.inputFile = File::getCurrentWorkingDirectory().getChildFile(inputPath);
+    s.triangleLfo = params.getWithDefault("lfo_waveform", "sine").toString() == "triangle";
+
+    double phaseDeg, intraDeg;
+    if (transition)
+    {
+        s.startLfoFreq  = params.getWithDefault("start_lfo_freq", 1.0 / 12.0);
+        s.endLfoFreq    = params.getWithDefault("end_lfo_freq", 1.0 / 12.0);
+        s.startQ        = params.getWithDefault("start_notch_q", 25.0);
+        s.endQ          = params.getWithDefault("end_notch_q", 25.0);
+        s.startCascades = static_cast<int>(params.getWithDefault("start_cascade_count", 10));
+        s.endCascades   = static_cast<int>(params.getWithDefault("end_cascade_count", 10));
+        phaseDeg        = params.getWithDefault("start_lfo_phase_offset_deg", 90.0);
+        intraDeg        = params.getWithDefault("start_intra_phase_offset_deg", 0.0);
+        s.initialOffset = params.getWithDefault("initial_offset", 0.0);
+        s.postOffset    = params.getWithDefault("post_offset", 0.0);
+        s.curve         = params.getWithDefault("transition_curve", "linear").toString();
+        readFirstSweep(params, "start_filter_sweeps", "start", s.startMin, s.startMax);
+        readFirstSweep(params, "end_filter_sweeps", "end", s.endMin, s.endMax);
+    }
+    else
+    {
+        s.startLfoFreq  = s.endLfoFreq = params.getWithDefault("lfo_freq", 1.0 / 12.0);
+        s.startQ        = s.endQ = params.getWithDefault("notch_q", 25.0);
+        s.startCascades = s.endCascades = static_cast<int>(params.getWithDefault("cascade_count", 10));
+        phaseDeg        = params.getWithDefault("lfo_phase_offset_deg", 90.0);
+        intraDeg        = params.getWithDefault("intra_phase_offset_deg", 0.0);
+        // Only the first sweep is used in this simplified implementation.
+        readFirstSweep(params, "filter_sweeps", "start", s.startMin, s.startMax);
+        s.endMin = s.startMin;
+        s.endMax = s.startMax;
+    }
 
-    double lfoFreq = params.getWithDefault("lfo_freq", 1.0 / 12.0);
-    double notchQ  = params.getWithDefault("notch_q", 25.0);
-    int    casc    = static_cast<int>(params.getWithDefault("cascade_count", 10));
-    double phaseOffsetDeg = params.getWithDefault("lfo_phase_offset_deg", 90.0);
-    double intraPhaseDeg  = params.getWithDefault("intra_phase_offset_deg", 0.0);
-    String noiseType      = params.getWithDefault("noise_type", "pink").toString();
-    String lfoWave        = params.getWithDefault("lfo_waveform", "sine").toString();
-
-    // Parse filter_sweeps parameter (only first entry is used in this simplified
-    // implementation).  Expect [[min, max], ...] or a dictionary with keys
-    // start_min/start_max.
-    double minFreq = 1000.0;
-    double maxFreq = 10000.0;
-    if (params.contains("filter_sweeps"))
+    s.phaseOffsetRad = MathConstants<double>::pi * phaseDeg / 180.0;
+    s.intraPhaseRad  = MathConstants<double>::pi * intraDeg / 180.0;
+
+    if (getRenderQuality(params) == RenderQuality::draft)
     {
-        if (auto* arr = params["filter_sweeps"].getArray())
-        {
-            if (! arr->isEmpty())
-            {
-                auto e = (*arr)[0];
-                if (auto* pair = e.getArray())
-                {
-                    if (pair->size() >= 2)
-                    {
-                        minFreq = pair->getUnchecked(0);
-                        maxFreq = pair->getUnchecked(1);
-                    }
-                }
-                else if (auto* obj = e.getDynamicObject())
-                {
-                    minFreq = getPropertyWithDefault(obj, "start_min", getPropertyWithDefault(obj, "min", minFreq));
-                    maxFreq = getPropertyWithDefault(obj, "start_max", getPropertyWithDefault(obj, "max", maxFreq));
-                }
-            }
-        }
+        s.startCascades   = jmin(s.startCascades, draftMaxCascades);
+        s.endCascades     = jmin(s.endCascades, draftMaxCascades);
+        s.controlInterval = draftControlInterval;
     }
+    return s;
+}
 
-    std::vector<float> noise = (noiseType == "brown") ? generateBrownNoise(totalSamples)
-                                                       : generatePinkNoise(totalSamples);
+SweptNotchProcessor::SweptNotchProcessor(const Settings& s, double sr, int64 total, int64 seedToUse)
+    : settings(s), sampleRate(sr), totalSamples(jmax<int64>(0, total)), seed(seedToUse)
+{
+    double duration = totalSamples / sampleRate;
+    transitionStart = std::min(settings.initialOffset, duration);
+    transitionTime = std::max(transitionStart, duration - settings.postOffset) - transitionStart;
+    if (settings.curve == "logarithmic")
+        curve = Curve::logarithmic;
+    else if (settings.curve == "exponential")
+        curve = Curve::exponential;
+
+    // A random walk of N uniform steps peaks at about 1.25 * sqrt(N / 3);
+    // scaling by that stands in for normalising the whole walk to its peak.
+    brownScale = 1.0 / (1.25 * std::sqrt(jmax<int64>(1, totalSamples) / 3.0));
 
-    // Pre-filter for warmth / HPF to roughly match python processing
-    dsp::IIR::Filter<float> lowPass;
-    dsp::IIR::Filter<float> highPass;
     lowPass.coefficients  = dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, 10000.0);
     highPass.coefficients = dsp::IIR::Coefficients<float>::makeHighPass(sampleRate, 50.0);
 
-    for (float& s : noise)
-        s = highPass.processSample(lowPass.processSample(s));
-
-    float rmsIn = computeRms(noise);
-    if (rmsIn < 1e-8f)
-        rmsIn = 1e-8f;
-
-    double phaseOffsetRad  = MathConstants<double>::pi * phaseOffsetDeg / 180.0;
-    double intraPhaseRad   = MathConstants<double>::pi * intraPhaseDeg / 180.0;
-
-    auto left  = applyNotchSweep(noise, sampleRate, lfoFreq, 0.0, intraPhaseRad, minFreq, maxFreq, notchQ, casc, lfoWave);
-    auto right = applyNotchSweep(noise, sampleRate, lfoFreq, phaseOffsetRad, intraPhaseRad, minFreq, maxFreq, notchQ, casc, lfoWave);
+    size_t cascades = (size_t) std::max(1, std::max(settings.startCascades, settings.endCascades));
+    for (auto& c : channels)
+        c.filters.resize(cascades);
+    reset();
+}
 
-    float rmsL = computeRms(left);
-    float rmsR = computeRms(right);
-    if (rmsL > 1e-8f)
-    {
-        float g = rmsIn / rmsL;
-        for (auto& s : left)
-            s *= g;
-    }
-    if (rmsR > 1e-8f)
+void SweptNotchProcessor::reset()
+{
+    rng.setSeed(seed);
+    std::fill(std::begin(pink), std::end(pink), 0.0f);
+    brown = 0.0;
+    lowPass.reset();
+    highPass.reset();
+    for (auto& c : channels)
     {
-        float g = rmsIn / rmsR;
-        for (auto& s : right)
-            s *= g;
+        for (auto& f : c.filters)
+            f.reset();
+        c.position = 0;
     }
 
-    float maxAbs = 0.0f;
-    for (int i = 0; i < totalSamples; ++i)
-        maxAbs = std::max({ maxAbs, std::abs(left[i]), std::abs(right[i]) });
-    if (maxAbs > 0.95f)
-    {
-        float g = 0.95f / maxAbs;
-        for (auto& s : left)
-            s *= g;
-        for (auto& s : right)
-            s *= g;
-    }
+    channels[0].phase = 0.0;
+    channels[0].phase2 = settings.intraPhaseRad;
+    channels[1].phase = settings.phaseOffsetRad;
+    channels[1].phase2 = settings.phaseOffsetRad + settings.intraPhaseRad;
+}
 
-    buffer.clear();
-    for (int i = 0; i < totalSamples; ++i)
+float SweptNotchProcessor::nextNoiseSample() noexcept
+{
+    float w = rng.nextFloat() * 2.0f - 1.0f;
+    if (settings.brownNoise)
     {
-        buffer.setSample(0, i, left[i]);
-        buffer.setSample(1, i, right[i]);
+        brown += w;
+        return static_cast<float>(brown * brownScale);
     }
 
-    return buffer;
+    float* b = pink;
+    b[0] = 0.99886f * b[0] + w * 0.0555179f;
+    b[1] = 0.99332f * b[1] + w * 0.0750759f;
+    b[2] = 0.96900f * b[2] + w * 0.1538520f;
+    b[3] = 0.86650f * b[3] + w * 0.3104856f;
+    b[4] = 0.55000f * b[4] + w * 0.5329522f;
+    b[5] = -0.7616f * b[5] - w * 0.0168980f;
+    return (b[0] + b[1] + b[2] + b[3] + b[4] + b[5] + w * 0.5362f) * 0.11f;
 }
 
-//------------------------------------------------------------------------------
+double SweptNotchProcessor::alphaAt(int64 sampleIndex) const noexcept
+{
+    // Same shape as calculateTransitionAlpha().
+    double a = 0.0;
+    if (transitionTime > 0.0)
+        a = std::clamp((sampleIndex / sampleRate - transitionStart) / transitionTime, 0.0, 1.0);
+
+    if (curve == Curve::logarithmic)
+        a = 1.0 - (1.0 - a) * (1.0 - a);
+    else if (curve == Curve::exponential)
+        a = a * a;
+    return a;
+}
 
-AudioBuffer<float> generateSweptNotchPinkSoundTransition(double duration,
-                                                         double sampleRate,
-                                                         const NamedValueSet& params)
+void SweptNotchProcessor::generateNoise(AudioBuffer<float>& dry, int numSamples) noexcept
 {
-    int totalSamples = static_cast<int>(duration * sampleRate);
-    AudioBuffer<float> buffer(2, totalSamples);
-    if (totalSamples <= 0)
-        return buffer;
+    float* out = dry.getWritePointer(0);
+    // Pre-filter for warmth / HPF to roughly match python processing
+    for (int i = 0; i < numSamples; ++i)
+        out[i] = highPass.processSample(lowPass.processSample(nextNoiseSample()));
+    dry.copyFrom(1, 0, dry, 0, 0, numSamples);
+}
 
-    double startFreq = params.getWithDefault("start_lfo_freq", 1.0 / 12.0);
-    double endFreq   = params.getWithDefault("end_lfo_freq", 1.0 / 12.0);
-    double startQ    = params.getWithDefault("start_notch_q", 25.0);
-    double endQ      = params.getWithDefault("end_notch_q", 25.0);
-    int    startCasc = static_cast<int>(params.getWithDefault("start_cascade_count", 10));
-    int    endCasc   = static_cast<int>(params.getWithDefault("end_cascade_count", 10));
-    double startPhaseDeg = params.getWithDefault("start_lfo_phase_offset_deg", 90.0);
-    double endPhaseDeg   = params.getWithDefault("end_lfo_phase_offset_deg", 90.0);
-    double startIntraDeg = params.getWithDefault("start_intra_phase_offset_deg", 0.0);
-    double endIntraDeg   = params.getWithDefault("end_intra_phase_offset_deg", 0.0);
-    String noiseType     = params.getWithDefault("noise_type", "pink").toString();
-    String lfoWave       = params.getWithDefault("lfo_waveform", "sine").toString();
-    double initialOffset = params.getWithDefault("initial_offset", 0.0);
-    double postOffset    = params.getWithDefault("post_offset", 0.0);
-    String curve         = params.getWithDefault("transition_curve", "linear").toString();
-
-    double minFreqStart = 1000.0, maxFreqStart = 10000.0;
-    double minFreqEnd   = 1000.0, maxFreqEnd   = 10000.0;
-
-    if (params.contains("start_filter_sweeps"))
+void SweptNotchProcessor::processChannel(int channel, const float* in, float* out, int numSamples) noexcept
+{
+    auto& c = channels[channel];
+    const int maxCascades = (int) c.filters.size();
+    const int interval = jmax(1, settings.controlInterval);
+    const double nyquistLimit = sampleRate * 0.49;
+
+    for (int i = 0; i < numSamples; ++i, ++c.position)
     {
-        if (auto* arr = params["start_filter_sweeps"].getArray())
+        if (c.position % interval == 0)
         {
-            if (! arr->isEmpty())
-            {
-                auto e = (*arr)[0];
-                if (auto* pair = e.getArray())
-                {
-                    if (pair->size() >= 2)
-                    {
-                        minFreqStart = pair->getUnchecked(0);
-                        maxFreqStart = pair->getUnchecked(1);
-                    }
-                }
-                else if (auto* obj = e.getDynamicObject())
-                {
-                    minFreqStart = getPropertyWithDefault(obj, "start_min", getPropertyWithDefault(obj, "min", minFreqStart));
-                    maxFreqStart = getPropertyWithDefault(obj, "start_max", getPropertyWithDefault(obj, "max", maxFreqStart));
-                }
-            }
+            double a = alphaAt(c.position);
+            double lfoFreq = settings.startLfoFreq + (settings.endLfoFreq - settings.startLfoFreq) * a;
+            double minFreq = settings.startMin + (settings.endMin - settings.startMin) * a;
+            double maxFreq = settings.startMax + (settings.endMax - settings.startMax) * a;
+            double q       = settings.startQ + (settings.endQ - settings.startQ) * a;
+            int cascades   = static_cast<int>(std::round(settings.startCascades
+                                                         + (settings.endCascades - settings.startCascades) * a));
+            c.cascades = jlimit(1, maxCascades, cascades);
+
+            double lfo  = settings.triangleLfo ? triangle(c.phase)  : std::cos(c.phase);
+            double lfo2 = settings.triangleLfo ? triangle(c.phase2) : std::cos(c.phase2);
+
+            double freq1 = jmin(nyquistLimit, minFreq + (maxFreq - minFreq) * (lfo + 1.0) * 0.5);
+            double freq2 = jmin(nyquistLimit, minFreq + (maxFreq - minFreq) * (lfo2 + 1.0) * 0.5);
+
+            c.notch1 = dsp::IIR::Coefficients<float>::makeNotch(sampleRate, freq1, q);
+            c.notch2 = dsp::IIR::Coefficients<float>::makeNotch(sampleRate, freq2, q);
+            c.phaseIncrement = MathConstants<double>::twoPi * lfoFreq / sampleRate;
         }
-    }
 
-    if (params.contains("end_filter_sweeps"))
-    {
-        if (auto* arr = params["end_filter_sweeps"].getArray())
+        float sample = in[i];
+        for (int k = 0; k < c.cascades; ++k)
         {
-            if (! arr->isEmpty())
-            {
-                auto e = (*arr)[0];
-                if (auto* pair = e.getArray())
-                {
-                    if (pair->size() >= 2)
-                    {
-                        minFreqEnd = pair->getUnchecked(0);
-                        maxFreqEnd = pair->getUnchecked(1);
-                    }
-                }
-                else if (auto* obj = e.getDynamicObject())
-                {
-                    minFreqEnd = getPropertyWithDefault(obj, "end_min", getPropertyWithDefault(obj, "min", minFreqEnd));
-                    maxFreqEnd = getPropertyWithDefault(obj, "end_max", getPropertyWithDefault(obj, "max", maxFreqEnd));
-                }
-            }
+            c.filters[(size_t) k].coefficients = c.notch1;
+            sample = c.filters[(size_t) k].processSample(sample);
         }
-    }
-
-    std::vector<float> noise = (noiseType == "brown") ? generateBrownNoise(totalSamples)
-                                                       : generatePinkNoise(totalSamples);
-
-    dsp::IIR::Filter<float> lowPass;
-    dsp::IIR::Filter<float> highPass;
-    lowPass.coefficients  = dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, 10000.0);
-    highPass.coefficients = dsp::IIR::Coefficients<float>::makeHighPass(sampleRate, 50.0);
+        for (int k = 0; k < c.cascades; ++k)
+        {
+            c.filters[(size_t) k].coefficients = c.notch2;
+            sample = c.filters[(size_t) k].processSample(sample);
+        }
+        out[i] = sample;
 
-    for (float& s : noise)
-        s = highPass.processSample(lowPass.processSample(s));
+        c.phase += c.phaseIncrement;
+        c.phase2 += c.phaseIncrement;
+    }
+}
 
-    float rmsIn = computeRms(noise);
-    if (rmsIn < 1e-8f)
-        rmsIn = 1e-8f;
+void SweptNotchProcessor::process(const AudioBuffer<float>& dry, AudioBuffer<float>& dest,
+                                  int destStart, int numSamples, bool parallel)
+{
+    auto run = [&](int ch)
+    {
+        processChannel(ch, dry.getReadPointer(ch), dest.getWritePointer(ch, destStart), numSamples);
+    };
 
-    auto alpha = calculateTransitionAlpha(duration, sampleRate, initialOffset, postOffset, curve);
-    if (alpha.size() != static_cast<size_t>(totalSamples))
+    if (! parallel)
     {
-        alpha.resize(totalSamples, alpha.empty() ? 0.0 : alpha.back());
+        run(0);
+        run(1);
+        return;
     }
+    std::thread right(run, 1);
+    run(0);
+    right.join();
+}
 
-    std::vector<float> left(totalSamples);
-    std::vector<float> right(totalSamples);
-
-    std::vector<dsp::IIR::Filter<float>> leftFilters(std::max(startCasc, endCasc));
-    std::vector<dsp::IIR::Filter<float>> rightFilters(std::max(startCasc, endCasc));
-    for (auto& f : leftFilters)
-        f.reset();
-    for (auto& f : rightFilters)
-        f.reset();
+//------------------------------------------------------------------------------
 
-    double phaseL = 0.0;
-    double phaseR = MathConstants<double>::pi * startPhaseDeg / 180.0;
-    double phaseL2 = MathConstants<double>::pi * startIntraDeg / 180.0;
-    double phaseR2 = MathConstants<double>::pi * (startPhaseDeg + startIntraDeg) / 180.0;
+AudioBuffer<float> renderSweptNotchBuffer(const SweptNotchProcessor::Settings& settings,
+                                          double duration, double sampleRate,
+                                          const RenderProgressCallback& progress)
+{
+    int totalSamples = std::max(0, static_cast<int>(duration * sampleRate));
+    AudioBuffer<float> buffer(2, totalSamples);
+    if (totalSamples <= 0)
+        return buffer;
 
-    for (int i = 0; i < totalSamples; ++i)
+    SweptNotchProcessor processor(settings, sampleRate, totalSamples,
+                                  Random::getSystemRandom().nextInt64());
+    DrySignal signal(processor, settings.inputFile, sampleRate);
+    if (! signal.isValid())
     {
-        double a = alpha.empty() ? static_cast<double>(i) / (totalSamples > 1 ? totalSamples - 1 : 1)
-                                 : alpha[(size_t) i];
-
-        double curFreq  = startFreq + (endFreq - startFreq) * a;
-        double curMin   = minFreqStart + (minFreqEnd - minFreqStart) * a;
-        double curMax   = maxFreqStart + (maxFreqEnd - maxFreqStart) * a;
-        double curQ     = startQ + (endQ - startQ) * a;
-        int    curCasc  = static_cast<int>(std::round(startCasc + (endCasc - startCasc) * a));
-        curCasc        = std::max(1, curCasc);
-
-        double lfoL  = (lfoWave == "triangle") ? (2.0 * std::abs(2.0 * std::fmod(phaseL / MathConstants<double>::twoPi, 1.0) - 1.0) - 1.0)
-                                               : std::cos(phaseL);
-        double lfoR  = (lfoWave == "triangle") ? (2.0 * std::abs(2.0 * std::fmod(phaseR / MathConstants<double>::twoPi, 1.0) - 1.0) - 1.0)
-                                               : std::cos(phaseR);
-        double lfoL2 = (lfoWave == "triangle") ? (2.0 * std::abs(2.0 * std::fmod(phaseL2 / MathConstants<double>::twoPi, 1.0) - 1.0) - 1.0)
-                                               : std::cos(phaseL2);
-        double lfoR2 = (lfoWave == "triangle") ? (2.0 * std::abs(2.0 * std::fmod(phaseR2 / MathConstants<double>::twoPi, 1.0) - 1.0) - 1.0)
-                                               : std::cos(phaseR2);
-
-        double freqL  = curMin + (curMax - curMin) * (lfoL + 1.0) * 0.5;
-        double freqR  = curMin + (curMax - curMin) * (lfoR + 1.0) * 0.5;
-        double freqL2 = curMin + (curMax - curMin) * (lfoL2 + 1.0) * 0.5;
-        double freqR2 = curMin + (curMax - curMin) * (lfoR2 + 1.0) * 0.5;
-
-        auto coeffL  = dsp::IIR::Coefficients<float>::makeNotch(sampleRate, freqL, curQ);
-        auto coeffR  = dsp::IIR::Coefficients<float>::makeNotch(sampleRate, freqR, curQ);
-        auto coeffL2 = dsp::IIR::Coefficients<float>::makeNotch(sampleRate, freqL2, curQ);
-        auto coeffR2 = dsp::IIR::Coefficients<float>::makeNotch(sampleRate, freqR2, curQ);
-
-        float sampleL = noise[i];
-        float sampleR = noise[i];
-
-        for (int c = 0; c < curCasc; ++c)
-        {
-            leftFilters[c].coefficients = coeffL;
-            sampleL = leftFilters[c].processSample(sampleL);
-            rightFilters[c].coefficients = coeffR;
-            sampleR = rightFilters[c].processSample(sampleR);
-        }
-        for (int c = 0; c < curCasc; ++c)
-        {
-            leftFilters[c].coefficients = coeffL2;
-            sampleL = leftFilters[c].processSample(sampleL);
-            rightFilters[c].coefficients = coeffR2;
-            sampleR = rightFilters[c].processSample(sampleR);
-        }
-
-        left[i]  = sampleL;
-        right[i] = sampleR;
-
-        double inc = MathConstants<double>::twoPi * curFreq / sampleRate;
-        phaseL += inc;
-        phaseR += inc;
-        phaseL2 += inc;
-        phaseR2 += inc;
+        buffer.clear();
+        return buffer;
     }
 
-    float rmsL = computeRms(left);
-    float rmsR = computeRms(right);
-    if (rmsL > 1e-8f)
+    AudioBuffer<float> dry(2, std::min(renderBlockSize, totalSamples));
+    ChannelLevels dryL, dryR;
+    for (int done = 0; done < totalSamples;)
     {
-        float g = rmsIn / rmsL;
-        for (auto& s : left)
-            s *= g;
+        int n = std::min(renderBlockSize, totalSamples - done);
+        signal.read(dry, n);
+        measure(dry, 0, n, dryL, dryR);
+        processor.process(dry, buffer, done, n);
+        done += n;
+        if (progress && ! progress((double) done / totalSamples))
+            return {};
     }
-    if (rmsR > 1e-8f)
+
+    ChannelLevels l, r;
+    measure(buffer, 0, totalSamples, l, r);
+    auto gains = computeGains(dryL, dryR, l, r);
+    buffer.applyGain(0, 0, totalSamples, gains.first);
+    buffer.applyGain(1, 0, totalSamples, gains.second);
+    return buffer;
+}
+
+bool renderSweptNotchToWriter(const SweptNotchProcessor::Settings& settings,
+                              double duration, double sampleRate,
+                              AudioFormatWriter& writer,
+                              const RenderProgressCallback& progress)
+{
+    // The processor's transition is laid out over the requested length, so
+    // find the input's length before creating it.
+    int64 totalSamples = std::max<int64>(0, static_cast<int64>(duration * sampleRate));
+    if (settings.inputFile != File() && totalSamples == 0)
     {
-        float g = rmsIn / rmsR;
-        for (auto& s : right)
-            s *= g;
+        SweptNotchProcessor probe(settings, sampleRate, 0, 0);
+        DrySignal input(probe, settings.inputFile, sampleRate);
+        if (! input.isValid())
+            return false;
+        totalSamples = input.getInputLength();
     }
+    if (totalSamples <= 0)
+        return false;
+
+    SweptNotchProcessor processor(settings, sampleRate, totalSamples,
+                                  Random::getSystemRandom().nextInt64());
+    DrySignal signal(processor, settings.inputFile, sampleRate);
+    if (! signal.isValid())
+        return false;
+
+    double work = (double) jmax<int64>(1, 2 * totalSamples);
+    AudioBuffer<float> dry(2, renderBlockSize);
+    AudioBuffer<float> block(2, renderBlockSize);
 
-    float maxAbs = 0.0f;
-    for (int i = 0; i < totalSamples; ++i)
-        maxAbs = std::max({ maxAbs, std::abs(left[i]), std::abs(right[i]) });
-    if (maxAbs > 0.95f)
+    // Pass 1: measure levels over the whole sound, writing nothing.
+    ChannelLevels dryL, dryR, l, r;
+    for (int64 done = 0; done < totalSamples;)
     {
-        float g = 0.95f / maxAbs;
-        for (auto& s : left)
-            s *= g;
-        for (auto& s : right)
-            s *= g;
+        int n = (int) std::min<int64>(renderBlockSize, totalSamples - done);
+        signal.read(dry, n);
+        measure(dry, 0, n, dryL, dryR);
+        processor.process(dry, block, 0, n, true);
+        measure(block, 0, n, l, r);
+        done += n;
+        if (progress && ! progress(done / work))
+            return false;
     }
+    auto gains = computeGains(dryL, dryR, l, r);
 
-    buffer.clear();
-    for (int i = 0; i < totalSamples; ++i)
+    // Pass 2: replay the same signal from the start and write it out.
+    signal.rewind();
+    for (int64 done = 0; done < totalSamples;)
     {
-        buffer.setSample(0, i, left[i]);
-        buffer.setSample(1, i, right[i]);
+        int n = (int) std::min<int64>(renderBlockSize, totalSamples - done);
+        signal.read(dry, n);
+        processor.process(dry, block, 0, n, true);
+        block.applyGain(0, 0, n, gains.first);
+        block.applyGain(1, 0, n, gains.second);
+        for (int ch = 0; ch < 2; ++ch)
+            FloatVectorOperations::clip(block.getWritePointer(ch), block.getReadPointer(ch), -1.0f, 1.0f, n);
+
+        if (! writer.writeFromAudioSampleBuffer(block, 0, n))
+            return false;
+        done += n;
+        if (progress && ! progress((totalSamples + done) / work))
+            return false;
     }
+    return true;
+}
 
-    return buffer;
+//------------------------------------------------------------------------------
+
+AudioBuffer<float> generateSweptNotchPinkSound(double duration,
+                                               double sampleRate,
+                                               const NamedValueSet& params)
+{
+    return renderSweptNotchBuffer(SweptNotchProcessor::Settings::fromParams(params, false),
+                                  duration, sampleRate);
+}
+
+//------------------------------------------------------------------------------
+
+AudioBuffer<float> generateSweptNotchPinkSoundTransition(double duration,
+                                                         double sampleRate,
+                                                         const NamedValueSet& params)
+{
+    return renderSweptNotchBuffer(SweptNotchProcessor::Settings::fromParams(params, true),
+                                  duration, sampleRate);
 }
@@ -1,8 +1,123 @@
 #pragma once
 #include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_dsp/juce_dsp.h>
+#include <functional>
+#include <vector>
 
 juce::AudioBuffer<float> generateSweptNotchPinkSound(double duration, double sampleRate,
                                                     const juce::NamedValueSet& params);
 
 juce::AudioBuffer<float> generateSweptNotchPinkSoundTransition(double duration, double sampleRate,
                                                              const juce::NamedValueSet& params);
+
+/** Receives the fraction done (0..1); returning false cancels the render. */
+using RenderProgressCallback = std::function<bool(double progress)>;
+
+/** The swept-notch noise generator as a stateful processor, so it can be run
+    a block at a time. Noise source, pre-filters, cascaded notches and LFO
+    phases all carry over between calls. The notches can be run over the
+    processor's own noise or over any other signal, such as an input
+    recording. The output is not levelled; see renderSweptNotchBuffer() and
+    renderSweptNotchToWriter().
+*/
+class SweptNotchProcessor
+{
+public:
+    struct Settings
+    {
+        bool brownNoise = false;
+        bool triangleLfo = false;
+        double startLfoFreq = 1.0 / 12.0, endLfoFreq = 1.0 / 12.0;
+        double startMin = 1000.0, endMin = 1000.0;
+        double startMax = 10000.0, endMax = 10000.0;
+        double startQ = 25.0, endQ = 25.0;
+        int startCascades = 10, endCascades = 10;
+        double phaseOffsetRad = 0.0;     // right channel LFO offset
+        double intraPhaseRad = 0.0;      // second notch bank offset
+        // Transition shape; unused when start and end values match.
+        double initialOffset = 0.0, postOffset = 0.0;
+        juce::String curve = "linear";
+        // When set, the notches run over this recording instead of noise.
+        // A relative input_audio_path is taken from the working directory.
+        juce::File inputFile;
+        // Samples between notch frequency updates; 1 sweeps every sample.
+        int controlInterval = 1;
+
+        /** Reads the generate_swept_notch_pink_sound(_transition) params.
+            A draft render_quality caps the cascades and sweeps the notches
+            at control rate. */
+        static Settings fromParams(const juce::NamedValueSet& params, bool transition);
+    };
+
+    SweptNotchProcessor(const Settings& settings, double sampleRate,
+                        juce::int64 totalSamples, juce::int64 seed);
+
+    /** Rewinds to the first sample; the same noise is produced again. */
+    void reset();
+
+    /** Writes the next @p numSamples of pre-filtered noise to channels 0
+        and 1 of @p dry (the same signal in both). */
+    void generateNoise(juce::AudioBuffer<float>& dry, int numSamples) noexcept;
+
+    /** Runs the next @p numSamples of one channel (0 left, 1 right) through
+        its notches; @p in and @p out may be the same. The channels keep
+        separate state, so both may be processed at once on two threads. */
+    void processChannel(int channel, const float* in, float* out, int numSamples) noexcept;
+
+    /** Filters channels 0 and 1 of @p dry into @p dest from @p destStart,
+        with the right channel on a second thread if @p parallel is set. */
+    void process(const juce::AudioBuffer<float>& dry, juce::AudioBuffer<float>& dest,
+                 int destStart, int numSamples, bool parallel = false);
+
+    juce::int64 getTotalLength() const noexcept { return totalSamples; }
+
+private:
+    struct Channel
+    {
+        std::vector<juce::dsp::IIR::Filter<float>> filters;
+        double phase = 0.0;
+        double phase2 = 0.0;
+        juce::int64 position = 0;
+        // Held between control-rate updates.
+        juce::dsp::IIR::Coefficients<float>::Ptr notch1, notch2;
+        int cascades = 1;
+        double phaseIncrement = 0.0;
+    };
+
+    float nextNoiseSample() noexcept;
+    double alphaAt(juce::int64 sampleIndex) const noexcept;
+
+    Settings settings;
+    double sampleRate;
+    juce::int64 totalSamples;
+    juce::int64 seed;
+    double transitionStart = 0.0, transitionTime = 0.0;
+    enum class Curve { linear, logarithmic, exponential } curve = Curve::linear;
+
+    juce::Random rng;
+    float pink[6] {};
+    double brown = 0.0;
+    double brownScale = 1.0;
+    juce::dsp::IIR::Filter<float> lowPass, highPass;
+    Channel channels[2];
+};
+
+/** Renders the whole sound in memory, levelled like the synth functions.
+    Returns an empty buffer if @p progress cancels. */
+juce::AudioBuffer<float> renderSweptNotchBuffer(const SweptNotchProcessor::Settings& settings,
+                                                double duration, double sampleRate,
+                                                const RenderProgressCallback& progress = nullptr);
+
+/** Streams the sound to @p writer a block at a time, so the length is not
+    limited by memory; with an input file, the file is read a block at a
+    time as well and a @p duration of 0 processes all of it. The two
+    channels are filtered on separate threads. A first pass measures the
+    levels over the whole sound and a second replays it, so it is levelled
+    exactly as renderSweptNotchBuffer() would level it. Returns
+    false if the input cannot be read, there is nothing to render,
+    @p progress cancels or a write fails. */
+bool renderSweptNotchToWriter(const SweptNotchProcessor::Settings& settings,
+                              double duration, double sampleRate,
+                              juce::AudioFormatWriter& writer,
+                              const RenderProgressCallback& progress = nullptr);
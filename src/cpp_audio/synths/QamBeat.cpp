@@ -1,5 +1,7 @@
 #include "QamBeat.h"
 #include "AudioUtils.h"
+#include "VoiceState.h"
+#include "FastMath.h"
 
 using namespace juce;
 
@@ -13,13 +15,47 @@ using namespace juce;
 
 static inline double shapedCos(double phase, double shape)
 {
-    double c = std::cos(phase);
+    double c = fastmath::cos(phase);
     if (shape == 1.0)
         return c;
     double sign = (c >= 0.0) ? 1.0 : -1.0;
-    return sign * std::pow(std::abs(c), 1.0 / std::max(1e-6, shape));
+    return sign * fastmath::pow(std::abs(c), 1.0 / std::max(1e-6, shape));
 }
 
+namespace
+{
+// Couples each channel's envelope to the other's, crossModDelay seconds
+// earlier. Only the last delay's worth of envelope is kept, in two ring
+// buffers that start at 1 (no modulation) so the first delay is untouched.
+class CrossModDelay
+{
+public:
+    explicit CrossModDelay(int delaySamples)
+        : left(static_cast<size_t>(std::max(0, delaySamples)), 1.0),
+          right(left.size(), 1.0)
+    {
+    }
+
+    /** Pushes the current envelopes and modulates them by the delayed ones. */
+    void process(double& envL, double& envR, double depth) noexcept
+    {
+        double delayedL = envL, delayedR = envR;
+        if (!left.empty())
+        {
+            std::swap(delayedL, left[pos]);
+            std::swap(delayedR, right[pos]);
+            pos = (pos + 1) % left.size();
+        }
+        envL *= 1.0 + depth * (delayedR - 1.0);
+        envR *= 1.0 + depth * (delayedL - 1.0);
+    }
+
+private:
+    std::vector<double> left, right;
+    size_t pos = 0;
+};
+} // namespace
+
 AudioBuffer<float> qamBeat(double duration, double sampleRate, const NamedValueSet& params)
 {
     int N = static_cast<int>(duration * sampleRate);
@@ -60,6 +96,7 @@ AudioBuffer<float> qamBeat(double duration, double sampleRate, const NamedValueS
     double harmonicRatio = params.getWithDefault("harmonicRatio", 2.0);
     double subHarmonicFreq = params.getWithDefault("subHarmonicFreq", 0.0);
     double subHarmonicDepth = params.getWithDefault("subHarmonicDepth", 0.0);
+    double subHarmonicPhaseOffset = params.getWithDefault("subHarmonicPhaseOffset", 0.0);
 
     // Phase and additional modulation
     double startPhaseL = params.getWithDefault("startPhaseL", 0.0);
@@ -71,126 +108,118 @@ AudioBuffer<float> qamBeat(double duration, double sampleRate, const NamedValueS
     bool beatingSidebands = params.getWithDefault("beatingSidebands", false);
     double sidebandOffset = params.getWithDefault("sidebandOffset", 1.0);
     double sidebandDepth = params.getWithDefault("sidebandDepth", 0.1);
+    double sidebandPhaseOffset = params.getWithDefault("sidebandPhaseOffset", 0.0);
     double attackTime = params.getWithDefault("attackTime", 0.0);
     double releaseTime = params.getWithDefault("releaseTime", 0.0);
 
-    std::vector<double> t(N);
-    std::vector<double> envL(N, 1.0), envR(N, 1.0);
-    std::vector<double> phaseL(N), phaseR(N);
-
     double dt = duration / static_cast<double>(N);
-    for (int i = 0; i < N; ++i)
-        t[i] = i * dt;
 
-    // Primary modulation
+    // A delay of N or more never reaches the output.
+    int delaySamp = static_cast<int>(crossModDelay * sampleRate);
+    bool crossMod = crossModDepth != 0.0 && crossModDelay > 0.0 && delaySamp < N;
+    CrossModDelay crossModDelayLine(crossMod ? delaySamp : 0);
+
+    double curL = startPhaseL;
+    double curR = startPhaseR;
+
     for (int i = 0; i < N; ++i)
     {
+        double time = i * dt;
+        double envL = 1.0, envR = 1.0;
+
+        // Primary modulation
         if (qamAmFreqL != 0.0 && qamAmDepthL != 0.0)
         {
-            double ph = 2.0 * MathConstants<double>::pi * qamAmFreqL * t[i] + qamAmPhaseOffsetL;
-            envL[i] *= 1.0 + qamAmDepthL * shapedCos(ph, modShapeL);
+            double ph = 2.0 * MathConstants<double>::pi * qamAmFreqL * time + qamAmPhaseOffsetL;
+            envL *= 1.0 + qamAmDepthL * shapedCos(ph, modShapeL);
         }
         if (qamAmFreqR != 0.0 && qamAmDepthR != 0.0)
         {
-            double ph = 2.0 * MathConstants<double>::pi * qamAmFreqR * t[i] + qamAmPhaseOffsetR;
-            envR[i] *= 1.0 + qamAmDepthR * shapedCos(ph, modShapeR);
+            double ph = 2.0 * MathConstants<double>::pi * qamAmFreqR * time + qamAmPhaseOffsetR;
+            envR *= 1.0 + qamAmDepthR * shapedCos(ph, modShapeR);
         }
-    }
 
-    // Secondary modulation
-    if (qamAm2FreqL != 0.0 && qamAm2DepthL != 0.0)
-        for (int i = 0; i < N; ++i)
+        // Secondary modulation
+        if (qamAm2FreqL != 0.0 && qamAm2DepthL != 0.0)
         {
-            double ph = 2.0 * MathConstants<double>::pi * qamAm2FreqL * t[i] + qamAm2PhaseOffsetL;
-            envL[i] *= 1.0 + qamAm2DepthL * std::cos(ph);
+            double ph = 2.0 * MathConstants<double>::pi * qamAm2FreqL * time + qamAm2PhaseOffsetL;
+            envL *= 1.0 + qamAm2DepthL * std::cos(ph);
         }
-
-    if (qamAm2FreqR != 0.0 && qamAm2DepthR != 0.0)
-        for (int i = 0; i < N; ++i)
+        if (qamAm2FreqR != 0.0 && qamAm2DepthR != 0.0)
         {
-            double ph = 2.0 * MathConstants<double>::pi * qamAm2FreqR * t[i] + qamAm2PhaseOffsetR;
-            envR[i] *= 1.0 + qamAm2DepthR * std::cos(ph);
+            double ph = 2.0 * MathConstants<double>::pi * qamAm2FreqR * time + qamAm2PhaseOffsetR;
+            envR *= 1.0 + qamAm2DepthR * std::cos(ph);
         }
 
-    // Cross-channel coupling
-    if (crossModDepth != 0.0 && crossModDelay > 0.0)
-    {
-        std::vector<double> envLCopy = envL;
-        std::vector<double> envRCopy = envR;
-        int delaySamp = static_cast<int>(crossModDelay * sampleRate);
-        for (int i = delaySamp; i < N; ++i)
-        {
-            envL[i] *= 1.0 + crossModDepth * (envRCopy[i - delaySamp] - 1.0);
-            envR[i] *= 1.0 + crossModDepth * (envLCopy[i - delaySamp] - 1.0);
-        }
-    }
+        // Cross-channel coupling
+        if (crossMod)
+            crossModDelayLine.process(envL, envR, crossModDepth);
 
-    // Sub-harmonic modulation
-    if (subHarmonicFreq != 0.0 && subHarmonicDepth != 0.0)
-        for (int i = 0; i < N; ++i)
+        // Sub-harmonic modulation
+        if (subHarmonicFreq != 0.0 && subHarmonicDepth != 0.0)
         {
-            double subMod = std::cos(2.0 * MathConstants<double>::pi * subHarmonicFreq * t[i]);
+            double subMod = std::cos(2.0 * MathConstants<double>::pi * subHarmonicFreq * time + subHarmonicPhaseOffset);
             double m = 1.0 + subHarmonicDepth * subMod;
-            envL[i] *= m;
-            envR[i] *= m;
+            envL *= m;
+            envR *= m;
         }
 
-    // Carrier phases
-    double curL = startPhaseL;
-    double curR = startPhaseR;
-    for (int i = 0; i < N; ++i)
-    {
-        phaseL[i] = curL;
-        phaseR[i] = curR;
+        // Carrier phases
+        double phaseL = curL;
+        double phaseR = curR;
         curL += MathConstants<double>::twoPi * baseFreqL * dt;
         curR += MathConstants<double>::twoPi * baseFreqR * dt;
-    }
 
-    // Phase oscillation
-    if (phaseOscFreq != 0.0 || phaseOscRange != 0.0)
-    {
-        for (int i = 0; i < N; ++i)
+        // Phase oscillation
+        if (phaseOscFreq != 0.0 || phaseOscRange != 0.0)
         {
             double dphi = (phaseOscRange * 0.5) *
-                           std::sin(2.0 * MathConstants<double>::pi * phaseOscFreq * t[i] +
+                           std::sin(2.0 * MathConstants<double>::pi * phaseOscFreq * time +
                                     phaseOscPhaseOffset);
-            phaseL[i] -= dphi;
-            phaseR[i] += dphi;
+            phaseL -= dphi;
+            phaseR += dphi;
         }
-    }
 
-    // Generate output
-    for (int i = 0; i < N; ++i)
-    {
-        double time = t[i];
+        // Generate output
         double envMul = 1.0;
         if (attackTime > 0.0 && time < attackTime)
             envMul *= time / attackTime;
         if (releaseTime > 0.0 && time > (duration - releaseTime))
             envMul *= (duration - time) / releaseTime;
 
-        double sigL = envL[i] * std::cos(phaseL[i]);
-        double sigR = envR[i] * std::cos(phaseR[i]);
+        double sigL = envL * std::cos(phaseL);
+        double sigR = envR * std::cos(phaseR);
 
         if (harmonicDepth != 0.0)
         {
-            sigL += harmonicDepth * envL[i] * std::cos(harmonicRatio * phaseL[i]);
-            sigR += harmonicDepth * envR[i] * std::cos(harmonicRatio * phaseR[i]);
+            sigL += harmonicDepth * envL * std::cos(harmonicRatio * phaseL);
+            sigR += harmonicDepth * envR * std::cos(harmonicRatio * phaseR);
         }
 
         if (beatingSidebands && sidebandDepth != 0.0)
         {
-            double side = 2.0 * MathConstants<double>::pi * sidebandOffset * time;
-            sigL += sidebandDepth * envL[i] * std::cos(phaseL[i] - side);
-            sigR += sidebandDepth * envR[i] * std::cos(phaseR[i] - side);
-            sigL += sidebandDepth * envL[i] * std::cos(phaseL[i] + side);
-            sigR += sidebandDepth * envR[i] * std::cos(phaseR[i] + side);
+            double side = 2.0 * MathConstants<double>::pi * sidebandOffset * time + sidebandPhaseOffset;
+            sigL += sidebandDepth * envL * std::cos(phaseL - side);
+            sigR += sidebandDepth * envR * std::cos(phaseR - side);
+            sigL += sidebandDepth * envL * std::cos(phaseL + side);
+            sigR += sidebandDepth * envR * std::cos(phaseR + side);
         }
 
         buffer.setSample(0, i, static_cast<float>(sigL * ampL * envMul));
         buffer.setSample(1, i, static_cast<float>(sigR * ampR * envMul));
     }
 
+    // Hand the oscillator state on to a continuing voice in the next step.
+    publishVoiceState("startPhaseL", curL);
+    publishVoiceState("startPhaseR", curR);
+    publishVoiceState("qamAmPhaseOffsetL", MathConstants<double>::twoPi * qamAmFreqL * duration + qamAmPhaseOffsetL);
+    publishVoiceState("qamAmPhaseOffsetR", MathConstants<double>::twoPi * qamAmFreqR * duration + qamAmPhaseOffsetR);
+    publishVoiceState("qamAm2PhaseOffsetL", MathConstants<double>::twoPi * qamAm2FreqL * duration + qamAm2PhaseOffsetL);
+    publishVoiceState("qamAm2PhaseOffsetR", MathConstants<double>::twoPi * qamAm2FreqR * duration + qamAm2PhaseOffsetR);
+    publishVoiceState("subHarmonicPhaseOffset", MathConstants<double>::twoPi * subHarmonicFreq * duration + subHarmonicPhaseOffset);
+    publishVoiceState("phaseOscPhaseOffset", MathConstants<double>::twoPi * phaseOscFreq * duration + phaseOscPhaseOffset);
+    publishVoiceState("sidebandPhaseOffset", MathConstants<double>::twoPi * sidebandOffset * duration + sidebandPhaseOffset);
+
     return buffer;
 }
 
@@ -261,11 +290,17 @@ AudioBuffer<float> qamBeatTransition(double duration, double sampleRate, const N
     double endSubHarmonicFreq   = params.getWithDefault("endSubHarmonicFreq", startSubHarmonicFreq);
     double startSubHarmonicDepth = params.getWithDefault("startSubHarmonicDepth", params.getWithDefault("subHarmonicDepth", 0.0));
     double endSubHarmonicDepth   = params.getWithDefault("endSubHarmonicDepth", startSubHarmonicDepth);
+    double startSubHarmonicPhaseOffset = params.getWithDefault("startSubHarmonicPhaseOffset", params.getWithDefault("subHarmonicPhaseOffset", 0.0));
+    double endSubHarmonicPhaseOffset   = params.getWithDefault("endSubHarmonicPhaseOffset", startSubHarmonicPhaseOffset);
 
     double startPhaseOscFreq = params.getWithDefault("startPhaseOscFreq", params.getWithDefault("phaseOscFreq", 0.0));
     double endPhaseOscFreq   = params.getWithDefault("endPhaseOscFreq", startPhaseOscFreq);
     double startPhaseOscRange = params.getWithDefault("startPhaseOscRange", params.getWithDefault("phaseOscRange", 0.0));
     double endPhaseOscRange   = params.getWithDefault("endPhaseOscRange", startPhaseOscRange);
+    double startPhaseOscPhaseOffset = params.getWithDefault("startPhaseOscPhaseOffset", params.getWithDefault("phaseOscPhaseOffset", 0.0));
+    double endPhaseOscPhaseOffset   = params.getWithDefault("endPhaseOscPhaseOffset", startPhaseOscPhaseOffset);
+    double startSidebandPhaseOffset = params.getWithDefault("startSidebandPhaseOffset", params.getWithDefault("sidebandPhaseOffset", 0.0));
+    double endSidebandPhaseOffset   = params.getWithDefault("endSidebandPhaseOffset", startSidebandPhaseOffset);
 
     double startStartPhaseL = params.getWithDefault("startStartPhaseL", params.getWithDefault("startPhaseL", 0.0));
     double endStartPhaseL   = params.getWithDefault("endStartPhaseL", startStartPhaseL);
@@ -275,7 +310,6 @@ AudioBuffer<float> qamBeatTransition(double duration, double sampleRate, const N
     // Static parameters
     double crossModDelay = params.getWithDefault("crossModDelay", 0.0);
     double harmonicRatio = params.getWithDefault("harmonicRatio", 2.0);
-    double phaseOscPhaseOffset = params.getWithDefault("phaseOscPhaseOffset", 0.0);
     bool beatingSidebands = params.getWithDefault("beatingSidebands", false);
     double sidebandOffset = params.getWithDefault("sidebandOffset", 1.0);
     double sidebandDepth = params.getWithDefault("sidebandDepth", 0.1);
@@ -288,161 +322,140 @@ AudioBuffer<float> qamBeatTransition(double duration, double sampleRate, const N
 
     auto alpha = calculateTransitionAlpha(duration, sampleRate, initialOffset, postOffset, curve);
 
-    std::vector<double> t(N);
-    for (int i = 0; i < N; ++i)
-        t[i] = i * (duration / static_cast<double>(N));
-
-    // Parameter arrays
-    std::vector<double> ampLArr(N), ampRArr(N);
-    std::vector<double> baseLArr(N), baseRArr(N);
-    std::vector<double> amFreqLArr(N), amDepthLArr(N), amPhaseOffsetLArr(N);
-    std::vector<double> amFreqRArr(N), amDepthRArr(N), amPhaseOffsetRArr(N);
-    std::vector<double> am2FreqLArr(N), am2DepthLArr(N), am2PhaseOffsetLArr(N);
-    std::vector<double> am2FreqRArr(N), am2DepthRArr(N), am2PhaseOffsetRArr(N);
-    std::vector<double> modShapeLArr(N), modShapeRArr(N);
-    std::vector<double> crossDepthArr(N);
-    std::vector<double> harmonicDepthArr(N);
-    std::vector<double> subFreqArr(N), subDepthArr(N);
-    std::vector<double> phaseOscFreqArr(N), phaseOscRangeArr(N);
-
-    for (int i = 0; i < N; ++i)
-    {
-        double a = alpha.empty() ? static_cast<double>(i) / (N > 1 ? N - 1 : 1) : alpha[i];
+    double dt = duration / static_cast<double>(N);
 
-        ampLArr[i] = startAmpL + (endAmpL - startAmpL) * a;
-        ampRArr[i] = startAmpR + (endAmpR - startAmpR) * a;
-        baseLArr[i] = startBaseFreqL + (endBaseFreqL - startBaseFreqL) * a;
-        baseRArr[i] = startBaseFreqR + (endBaseFreqR - startBaseFreqR) * a;
-
-        amFreqLArr[i] = startQamAmFreqL + (endQamAmFreqL - startQamAmFreqL) * a;
-        amDepthLArr[i] = startQamAmDepthL + (endQamAmDepthL - startQamAmDepthL) * a;
-        amPhaseOffsetLArr[i] = startQamAmPhaseOffsetL + (endQamAmPhaseOffsetL - startQamAmPhaseOffsetL) * a;
-        amFreqRArr[i] = startQamAmFreqR + (endQamAmFreqR - startQamAmFreqR) * a;
-        amDepthRArr[i] = startQamAmDepthR + (endQamAmDepthR - startQamAmDepthR) * a;
-        amPhaseOffsetRArr[i] = startQamAmPhaseOffsetR + (endQamAmPhaseOffsetR - startQamAmPhaseOffsetR) * a;
-
-        am2FreqLArr[i] = startQamAm2FreqL + (endQamAm2FreqL - startQamAm2FreqL) * a;
-        am2DepthLArr[i] = startQamAm2DepthL + (endQamAm2DepthL - startQamAm2DepthL) * a;
-        am2PhaseOffsetLArr[i] = startQamAm2PhaseOffsetL + (endQamAm2PhaseOffsetL - startQamAm2PhaseOffsetL) * a;
-        am2FreqRArr[i] = startQamAm2FreqR + (endQamAm2FreqR - startQamAm2FreqR) * a;
-        am2DepthRArr[i] = startQamAm2DepthR + (endQamAm2DepthR - startQamAm2DepthR) * a;
-        am2PhaseOffsetRArr[i] = startQamAm2PhaseOffsetR + (endQamAm2PhaseOffsetR - startQamAm2PhaseOffsetR) * a;
-
-        modShapeLArr[i] = startModShapeL + (endModShapeL - startModShapeL) * a;
-        modShapeRArr[i] = startModShapeR + (endModShapeR - startModShapeR) * a;
-        crossDepthArr[i] = startCrossModDepth + (endCrossModDepth - startCrossModDepth) * a;
-        harmonicDepthArr[i] = startHarmonicDepth + (endHarmonicDepth - startHarmonicDepth) * a;
-        subFreqArr[i] = startSubHarmonicFreq + (endSubHarmonicFreq - startSubHarmonicFreq) * a;
-        subDepthArr[i] = startSubHarmonicDepth + (endSubHarmonicDepth - startSubHarmonicDepth) * a;
-        phaseOscFreqArr[i] = startPhaseOscFreq + (endPhaseOscFreq - startPhaseOscFreq) * a;
-        phaseOscRangeArr[i] = startPhaseOscRange + (endPhaseOscRange - startPhaseOscRange) * a;
-    }
+    // The coupling reads the envelopes before it is applied, so it runs
+    // whenever a delay is set; a zero depth then leaves them unchanged.
+    int delaySamp = static_cast<int>(crossModDelay * sampleRate);
+    bool crossMod = crossModDelay > 0.0 && delaySamp < N;
+    CrossModDelay crossModDelayLine(crossMod ? delaySamp : 0);
 
-    std::vector<double> envL(N, 1.0), envR(N, 1.0);
+    double curL = startStartPhaseL;
+    double curR = startStartPhaseR;
 
     for (int i = 0; i < N; ++i)
     {
-        if (amFreqLArr[i] != 0.0 && amDepthLArr[i] != 0.0)
+        double a = alpha.empty() ? static_cast<double>(i) / (N > 1 ? N - 1 : 1) : alpha[i];
+        double time = i * dt;
+
+        double ampL = startAmpL + (endAmpL - startAmpL) * a;
+        double ampR = startAmpR + (endAmpR - startAmpR) * a;
+        double baseFreqL = startBaseFreqL + (endBaseFreqL - startBaseFreqL) * a;
+        double baseFreqR = startBaseFreqR + (endBaseFreqR - startBaseFreqR) * a;
+
+        double amFreqL = startQamAmFreqL + (endQamAmFreqL - startQamAmFreqL) * a;
+        double amDepthL = startQamAmDepthL + (endQamAmDepthL - startQamAmDepthL) * a;
+        double amPhaseOffsetL = startQamAmPhaseOffsetL + (endQamAmPhaseOffsetL - startQamAmPhaseOffsetL) * a;
+        double amFreqR = startQamAmFreqR + (endQamAmFreqR - startQamAmFreqR) * a;
+        double amDepthR = startQamAmDepthR + (endQamAmDepthR - startQamAmDepthR) * a;
+        double amPhaseOffsetR = startQamAmPhaseOffsetR + (endQamAmPhaseOffsetR - startQamAmPhaseOffsetR) * a;
+
+        double am2FreqL = startQamAm2FreqL + (endQamAm2FreqL - startQamAm2FreqL) * a;
+        double am2DepthL = startQamAm2DepthL + (endQamAm2DepthL - startQamAm2DepthL) * a;
+        double am2PhaseOffsetL = startQamAm2PhaseOffsetL + (endQamAm2PhaseOffsetL - startQamAm2PhaseOffsetL) * a;
+        double am2FreqR = startQamAm2FreqR + (endQamAm2FreqR - startQamAm2FreqR) * a;
+        double am2DepthR = startQamAm2DepthR + (endQamAm2DepthR - startQamAm2DepthR) * a;
+        double am2PhaseOffsetR = startQamAm2PhaseOffsetR + (endQamAm2PhaseOffsetR - startQamAm2PhaseOffsetR) * a;
+
+        double modShapeL = startModShapeL + (endModShapeL - startModShapeL) * a;
+        double modShapeR = startModShapeR + (endModShapeR - startModShapeR) * a;
+        double crossDepth = startCrossModDepth + (endCrossModDepth - startCrossModDepth) * a;
+        double harmonicDepth = startHarmonicDepth + (endHarmonicDepth - startHarmonicDepth) * a;
+        double subFreq = startSubHarmonicFreq + (endSubHarmonicFreq - startSubHarmonicFreq) * a;
+        double subDepth = startSubHarmonicDepth + (endSubHarmonicDepth - startSubHarmonicDepth) * a;
+        double subPhaseOffset = startSubHarmonicPhaseOffset + (endSubHarmonicPhaseOffset - startSubHarmonicPhaseOffset) * a;
+        double phaseOscFreq = startPhaseOscFreq + (endPhaseOscFreq - startPhaseOscFreq) * a;
+        double phaseOscRange = startPhaseOscRange + (endPhaseOscRange - startPhaseOscRange) * a;
+        double phaseOscPhaseOffset = startPhaseOscPhaseOffset + (endPhaseOscPhaseOffset - startPhaseOscPhaseOffset) * a;
+        double sidebandPhaseOffset = startSidebandPhaseOffset + (endSidebandPhaseOffset - startSidebandPhaseOffset) * a;
+
+        double envL = 1.0, envR = 1.0;
+
+        if (amFreqL != 0.0 && amDepthL != 0.0)
         {
-            double ph = 2.0 * MathConstants<double>::pi * amFreqLArr[i] * t[i] + amPhaseOffsetLArr[i];
-            envL[i] *= 1.0 + amDepthLArr[i] * shapedCos(ph, modShapeLArr[i]);
+            double ph = 2.0 * MathConstants<double>::pi * amFreqL * time + amPhaseOffsetL;
+            envL *= 1.0 + amDepthL * shapedCos(ph, modShapeL);
         }
-        if (amFreqRArr[i] != 0.0 && amDepthRArr[i] != 0.0)
+        if (amFreqR != 0.0 && amDepthR != 0.0)
         {
-            double ph = 2.0 * MathConstants<double>::pi * amFreqRArr[i] * t[i] + amPhaseOffsetRArr[i];
-            envR[i] *= 1.0 + amDepthRArr[i] * shapedCos(ph, modShapeRArr[i]);
+            double ph = 2.0 * MathConstants<double>::pi * amFreqR * time + amPhaseOffsetR;
+            envR *= 1.0 + amDepthR * shapedCos(ph, modShapeR);
         }
 
-        if (am2FreqLArr[i] != 0.0 && am2DepthLArr[i] != 0.0)
+        if (am2FreqL != 0.0 && am2DepthL != 0.0)
         {
-            double ph = 2.0 * MathConstants<double>::pi * am2FreqLArr[i] * t[i] + am2PhaseOffsetLArr[i];
-            envL[i] *= 1.0 + am2DepthLArr[i] * std::cos(ph);
+            double ph = 2.0 * MathConstants<double>::pi * am2FreqL * time + am2PhaseOffsetL;
+            envL *= 1.0 + am2DepthL * std::cos(ph);
         }
-        if (am2FreqRArr[i] != 0.0 && am2DepthRArr[i] != 0.0)
+        if (am2FreqR != 0.0 && am2DepthR != 0.0)
         {
-            double ph = 2.0 * MathConstants<double>::pi * am2FreqRArr[i] * t[i] + am2PhaseOffsetRArr[i];
-            envR[i] *= 1.0 + am2DepthRArr[i] * std::cos(ph);
+            double ph = 2.0 * MathConstants<double>::pi * am2FreqR * time + am2PhaseOffsetR;
+            envR *= 1.0 + am2DepthR * std::cos(ph);
         }
 
-        if (subFreqArr[i] != 0.0 && subDepthArr[i] != 0.0)
+        if (subFreq != 0.0 && subDepth != 0.0)
         {
-            double ph = 2.0 * MathConstants<double>::pi * subFreqArr[i] * t[i];
-            double m = 1.0 + subDepthArr[i] * std::cos(ph);
-            envL[i] *= m;
-            envR[i] *= m;
+            double ph = 2.0 * MathConstants<double>::pi * subFreq * time + subPhaseOffset;
+            double m = 1.0 + subDepth * std::cos(ph);
+            envL *= m;
+            envR *= m;
         }
-    }
 
-    if (crossModDelay > 0.0)
-    {
-        std::vector<double> preL = envL;
-        std::vector<double> preR = envR;
-        int delaySamp = static_cast<int>(crossModDelay * sampleRate);
-        for (int i = delaySamp; i < N; ++i)
-        {
-            if (crossDepthArr[i] != 0.0)
-            {
-                envL[i] *= 1.0 + crossDepthArr[i] * (preR[i - delaySamp] - 1.0);
-                envR[i] *= 1.0 + crossDepthArr[i] * (preL[i - delaySamp] - 1.0);
-            }
-        }
-    }
+        if (crossMod)
+            crossModDelayLine.process(envL, envR, crossDepth);
 
-    std::vector<double> phaseL(N), phaseR(N);
-    double curL = startStartPhaseL;
-    double curR = startStartPhaseR;
-    double dt = duration / static_cast<double>(N);
-    for (int i = 0; i < N; ++i)
-    {
-        phaseL[i] = curL;
-        phaseR[i] = curR;
-        curL += MathConstants<double>::twoPi * baseLArr[i] * dt;
-        curR += MathConstants<double>::twoPi * baseRArr[i] * dt;
-    }
+        double phaseL = curL;
+        double phaseR = curR;
+        curL += MathConstants<double>::twoPi * baseFreqL * dt;
+        curR += MathConstants<double>::twoPi * baseFreqR * dt;
 
-    for (int i = 0; i < N; ++i)
-    {
-        if (phaseOscFreqArr[i] != 0.0 || phaseOscRangeArr[i] != 0.0)
+        if (phaseOscFreq != 0.0 || phaseOscRange != 0.0)
         {
-            double dphi = (phaseOscRangeArr[i] * 0.5) *
-                           std::sin(2.0 * MathConstants<double>::pi * phaseOscFreqArr[i] * t[i] +
+            double dphi = (phaseOscRange * 0.5) *
+                           std::sin(2.0 * MathConstants<double>::pi * phaseOscFreq * time +
                                     phaseOscPhaseOffset);
-            phaseL[i] -= dphi;
-            phaseR[i] += dphi;
+            phaseL -= dphi;
+            phaseR += dphi;
         }
-    }
 
-    for (int i = 0; i < N; ++i)
-    {
-        double time = t[i];
         double envMul = 1.0;
         if (attackTime > 0.0 && time < attackTime)
             envMul *= time / attackTime;
         if (releaseTime > 0.0 && time > (duration - releaseTime))
             envMul *= (duration - time) / releaseTime;
 
-        double sigL = envL[i] * std::cos(phaseL[i]);
-        double sigR = envR[i] * std::cos(phaseR[i]);
+        double sigL = envL * std::cos(phaseL);
+        double sigR = envR * std::cos(phaseR);
 
-        if (harmonicDepthArr[i] != 0.0)
+        if (harmonicDepth != 0.0)
         {
-            sigL += harmonicDepthArr[i] * envL[i] * std::cos(harmonicRatio * phaseL[i]);
-            sigR += harmonicDepthArr[i] * envR[i] * std::cos(harmonicRatio * phaseR[i]);
+            sigL += harmonicDepth * envL * std::cos(harmonicRatio * phaseL);
+            sigR += harmonicDepth * envR * std::cos(harmonicRatio * phaseR);
         }
 
         if (beatingSidebands && sidebandDepth != 0.0)
         {
-            double side = 2.0 * MathConstants<double>::pi * sidebandOffset * time;
-            sigL += sidebandDepth * envL[i] * std::cos(phaseL[i] - side);
-            sigR += sidebandDepth * envR[i] * std::cos(phaseR[i] - side);
-            sigL += sidebandDepth * envL[i] * std::cos(phaseL[i] + side);
-            sigR += sidebandDepth * envR[i] * std::cos(phaseR[i] + side);
+            double side = 2.0 * MathConstants<double>::pi * sidebandOffset * time + sidebandPhaseOffset;
+            sigL += sidebandDepth * envL * std::cos(phaseL - side);
+            sigR += sidebandDepth * envR * std::cos(phaseR - side);
+            sigL += sidebandDepth * envL * std::cos(phaseL + side);
+            sigR += sidebandDepth * envR * std::cos(phaseR + side);
         }
 
-        buffer.setSample(0, i, static_cast<float>(sigL * ampLArr[i] * envMul));
-        buffer.setSample(1, i, static_cast<float>(sigR * ampRArr[i] * envMul));
+        buffer.setSample(0, i, static_cast<float>(sigL * ampL * envMul));
+        buffer.setSample(1, i, static_cast<float>(sigR * ampR * envMul));
     }
 
+    publishVoiceState("startPhaseL", curL);
+    publishVoiceState("startPhaseR", curR);
+    publishVoiceState("qamAmPhaseOffsetL", MathConstants<double>::twoPi * endQamAmFreqL * duration + endQamAmPhaseOffsetL);
+    publishVoiceState("qamAmPhaseOffsetR", MathConstants<double>::twoPi * endQamAmFreqR * duration + endQamAmPhaseOffsetR);
+    publishVoiceState("qamAm2PhaseOffsetL", MathConstants<double>::twoPi * endQamAm2FreqL * duration + endQamAm2PhaseOffsetL);
+    publishVoiceState("qamAm2PhaseOffsetR", MathConstants<double>::twoPi * endQamAm2FreqR * duration + endQamAm2PhaseOffsetR);
+    publishVoiceState("subHarmonicPhaseOffset", MathConstants<double>::twoPi * endSubHarmonicFreq * duration + endSubHarmonicPhaseOffset);
+    publishVoiceState("phaseOscPhaseOffset", MathConstants<double>::twoPi * endPhaseOscFreq * duration + endPhaseOscPhaseOffset);
+    publishVoiceState("sidebandPhaseOffset", MathConstants<double>::twoPi * sidebandOffset * duration + endSidebandPhaseOffset);
+
     return buffer;
 }
 
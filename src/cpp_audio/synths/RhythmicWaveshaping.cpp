@@ -1,5 +1,7 @@
 #include "RhythmicWaveshaping.h"
 #include "AudioUtils.h"
+#include "FastMath.h"
+#include "OversampledTanh.h"
 #include <cmath>
 
 using namespace juce;
@@ -20,21 +22,45 @@ AudioBuffer<float> rhythmicWaveshaping(double duration, double sampleRate, const
     double dt = 1.0 / sampleRate;
     double carrierPhase = 0.0;
     double modPhase = 0.0;
-    double tanhShape = std::tanh(std::max(1e-6, shapeAmount));
+    double invTanhShape = 1.0 / fastmath::tanh(std::max(1e-6, shapeAmount));
 
-    for (int i = 0; i < totalSamples; ++i)
+    // The shaper delays its output, so run on past the end by its latency.
+    OversampledTanh shaper(OversampledTanh::getFactor(params));
+    const int latency = shaper.getLatency();
+    double drive[OversampledTanh::maxBlockSize];
+    float gainL[OversampledTanh::maxBlockSize], gainR[OversampledTanh::maxBlockSize];
+
+    for (int start = 0; start < totalSamples + latency; start += OversampledTanh::maxBlockSize)
     {
-        double carrier = std::sin(carrierPhase);
-        double lfo = std::sin(modPhase);
-        double shapeLFO = 1.0 - modDepth * (1.0 - lfo) * 0.5;
-        double modulated = carrier * shapeLFO;
-        double shaped = std::tanh(modulated * shapeAmount) / tanhShape;
-        float s = static_cast<float>(shaped * amp);
-        buffer.setSample(0, i, s * gains.first);
-        buffer.setSample(1, i, s * gains.second);
-
-        carrierPhase += MathConstants<double>::twoPi * carrierFreq * dt;
-        modPhase += MathConstants<double>::twoPi * modFreq * dt;
+        int n = std::min(OversampledTanh::maxBlockSize, totalSamples + latency - start);
+        for (int k = 0; k < n; ++k)
+        {
+            if (start + k >= totalSamples)
+            {
+                drive[k] = 0.0;
+                gainL[k] = gainR[k] = 0.0f;
+                continue;
+            }
+
+            double carrier = fastmath::sin(carrierPhase);
+            double lfo = fastmath::sin(modPhase);
+            double shapeLFO = 1.0 - modDepth * (1.0 - lfo) * 0.5;
+            drive[k] = carrier * shapeLFO * shapeAmount;
+            float s = static_cast<float>(invTanhShape * amp);
+            gainL[k] = s * gains.first;
+            gainR[k] = s * gains.second;
+
+            carrierPhase += MathConstants<double>::twoPi * carrierFreq * dt;
+            modPhase += MathConstants<double>::twoPi * modFreq * dt;
+        }
+
+        shaper.process(drive, gainL, gainR, n);
+        for (int k = std::max(0, latency - start); k < n; ++k)
+        {
+            int i = start + k - latency;
+            buffer.setSample(0, i, static_cast<float>(drive[k]) * gainL[k]);
+            buffer.setSample(1, i, static_cast<float>(drive[k]) * gainR[k]);
+        }
     }
 
     return buffer;
@@ -65,29 +91,72 @@ AudioBuffer<float> rhythmicWaveshapingTransition(double duration, double sampleR
     double dt = 1.0 / sampleRate;
     double carrierPhase = 0.0;
     double modPhase = 0.0;
-
-    for (int i = 0; i < totalSamples; ++i)
+    // 1/tanh(shapeAmount) is worked out every shapeControlInterval samples
+    // and interpolated in between, so a shape ramp costs no tanh per sample.
+    constexpr int shapeControlInterval = 32;
+    auto invTanhShapeAt = [&](int i)
     {
         double a = alpha.empty() ? static_cast<double>(i) / (totalSamples > 1 ? totalSamples - 1 : 1)
                                  : alpha[i];
-
-        double carrierFreq = startCarrierFreq + (endCarrierFreq - startCarrierFreq) * a;
-        double modFreq = startModFreq + (endModFreq - startModFreq) * a;
-        double modDepth = startModDepth + (endModDepth - startModDepth) * a;
         double shapeAmount = startShapeAmount + (endShapeAmount - startShapeAmount) * a;
-        double tanhShape = std::tanh(std::max(1e-6, shapeAmount));
-
-        double carrier = std::sin(carrierPhase);
-        double lfo = std::sin(modPhase);
-        double shapeLFO = 1.0 - modDepth * (1.0 - lfo) * 0.5;
-        double modulated = carrier * shapeLFO;
-        double shaped = std::tanh(modulated * shapeAmount) / tanhShape;
-        float s = static_cast<float>(shaped * amp);
-        buffer.setSample(0, i, s * gains.first);
-        buffer.setSample(1, i, s * gains.second);
-
-        carrierPhase += MathConstants<double>::twoPi * carrierFreq * dt;
-        modPhase += MathConstants<double>::twoPi * modFreq * dt;
+        return 1.0 / fastmath::tanh(std::max(1e-6, shapeAmount));
+    };
+    double invTanhFrom = invTanhShapeAt(0);
+    double invTanhTo = invTanhFrom;
+
+    OversampledTanh shaper(OversampledTanh::getFactor(params));
+    const int latency = shaper.getLatency();
+    double drive[OversampledTanh::maxBlockSize];
+    float gainL[OversampledTanh::maxBlockSize], gainR[OversampledTanh::maxBlockSize];
+
+    for (int start = 0; start < totalSamples + latency; start += OversampledTanh::maxBlockSize)
+    {
+        int n = std::min(OversampledTanh::maxBlockSize, totalSamples + latency - start);
+        for (int k = 0; k < n; ++k)
+        {
+            int i = start + k;
+            if (i >= totalSamples)
+            {
+                drive[k] = 0.0;
+                gainL[k] = gainR[k] = 0.0f;
+                continue;
+            }
+
+            double a = alpha.empty() ? static_cast<double>(i) / (totalSamples > 1 ? totalSamples - 1 : 1)
+                                     : alpha[i];
+
+            double carrierFreq = startCarrierFreq + (endCarrierFreq - startCarrierFreq) * a;
+            double modFreq = startModFreq + (endModFreq - startModFreq) * a;
+            double modDepth = startModDepth + (endModDepth - startModDepth) * a;
+            double shapeAmount = startShapeAmount + (endShapeAmount - startShapeAmount) * a;
+            int controlPhase = i % shapeControlInterval;
+            if (controlPhase == 0)
+            {
+                invTanhFrom = invTanhTo;
+                invTanhTo = invTanhShapeAt(std::min(i + shapeControlInterval, totalSamples - 1));
+            }
+            double invTanhShape = invTanhFrom
+                + (invTanhTo - invTanhFrom) * (controlPhase * (1.0 / shapeControlInterval));
+
+            double carrier = fastmath::sin(carrierPhase);
+            double lfo = fastmath::sin(modPhase);
+            double shapeLFO = 1.0 - modDepth * (1.0 - lfo) * 0.5;
+            drive[k] = carrier * shapeLFO * shapeAmount;
+            float s = static_cast<float>(invTanhShape * amp);
+            gainL[k] = s * gains.first;
+            gainR[k] = s * gains.second;
+
+            carrierPhase += MathConstants<double>::twoPi * carrierFreq * dt;
+            modPhase += MathConstants<double>::twoPi * modFreq * dt;
+        }
+
+        shaper.process(drive, gainL, gainR, n);
+        for (int k = std::max(0, latency - start); k < n; ++k)
+        {
+            int i = start + k - latency;
+            buffer.setSample(0, i, static_cast<float>(drive[k]) * gainL[k]);
+            buffer.setSample(1, i, static_cast<float>(drive[k]) * gainR[k]);
+        }
     }
 
     return buffer;
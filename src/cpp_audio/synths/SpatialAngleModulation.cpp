@@ -1,8 +1,80 @@
 #include "SpatialAngleModulation.h"
 #include "AudioUtils.h"
+#include "SpatialPath.h"
+#include "SphericalHead.h"
 
 using namespace juce;
 
+namespace
+{
+/** The last stage of the spatial synths: the voice is either panned
+    (the default) or, with spatializer set to "head", placed round a
+    spherical head for headphones, optionally through the HRIR at hrirPath.
+    Either way the position is updated once per PanRamp::controlInterval. */
+class SpatialStage
+{
+public:
+    SpatialStage(const NamedValueSet& params, double sampleRate, double pan, bool behind)
+    {
+        panRamp.reset(pan);
+        if (!params.getWithDefault("spatializer", "pan").toString().equalsIgnoreCase("head"))
+            return;
+
+        head = std::make_unique<SphericalHeadSpatializer>(sampleRate);
+        head->reset(azimuthFor(pan, behind));
+        String hrirPath = params.getWithDefault("hrirPath", "");
+        if (hrirPath.isNotEmpty() && File::isAbsolutePath(hrirPath))
+            head->loadHrir(File(hrirPath));
+    }
+
+    /** Writes @p numSamples of @p voice to @p buffer from @p start, moving
+        to @p pan (and to the rear half if @p behind) by the end. */
+    void process(const float* voice, AudioBuffer<float>& buffer, int start, int numSamples,
+                 double pan, bool behind)
+    {
+        float* left = buffer.getWritePointer(0, start);
+        float* right = buffer.getWritePointer(1, start);
+        if (head != nullptr)
+        {
+            head->process(voice, left, right, numSamples, azimuthFor(pan, behind));
+            return;
+        }
+
+        float gainL[PanRamp::controlInterval], gainR[PanRamp::controlInterval];
+        panRamp.rampTo(pan, gainL, gainR, numSamples);
+        for (int k = 0; k < numSamples; ++k)
+        {
+            left[k] = voice[k] * gainL[k];
+            right[k] = voice[k] * gainR[k];
+        }
+    }
+
+    /** Applies the HRIR, if one was loaded, to the whole of @p buffer. */
+    void finish(AudioBuffer<float>& buffer)
+    {
+        if (head != nullptr)
+            head->applyHrir(buffer.getWritePointer(0), buffer.getWritePointer(1), buffer.getNumSamples());
+    }
+
+private:
+    // The pan is the source's lateral position, so it fixes the azimuth up
+    // to a front/back mirror.
+    static double azimuthFor(double pan, bool behind)
+    {
+        double lateral = std::asin(jlimit(-1.0, 1.0, pan));
+        return behind ? MathConstants<double>::pi - lateral : lateral;
+    }
+
+    PanRamp panRamp;
+    std::unique_ptr<SphericalHeadSpatializer> head;
+};
+
+bool isBehind(double deg)
+{
+    return std::cos(degreesToRadians(deg)) < 0.0;
+}
+} // namespace
+
 AudioBuffer<float> spatialAngleModulation(double duration, double sampleRate, const NamedValueSet& params)
 {
     const int N = static_cast<int>(duration * sampleRate);
@@ -17,27 +89,39 @@ AudioBuffer<float> spatialAngleModulation(double duration, double sampleRate, co
     const double startDeg    = params.getWithDefault("arcStartDeg", 0.0);
     const double endDeg      = params.getWithDefault("arcEndDeg", 360.0);
 
+    // The sweep is a circle path traversed from startDeg to endDeg, with
+    // the pan updated at control rate.
+    const SpatialPath path;
+    auto degAt = [&](int i)
+    {
+        double t = static_cast<double>(i) / sampleRate;
+        return startDeg + (endDeg - startDeg) * (t / duration);
+    };
+    SpatialStage stage(params, sampleRate, path.getPosition(startDeg / 360.0) * radius, isBehind(startDeg));
+    float voice[PanRamp::controlInterval];
+
     const double dt = 1.0 / sampleRate;
     double phCarrier = 0.0;
     double phBeat = 0.0;
-    for (int i = 0; i < N; ++i)
+    for (int start = 0; start < N; start += PanRamp::controlInterval)
     {
-        double t = static_cast<double>(i) / sampleRate;
-        double angle = juce::degreesToRadians(startDeg + (endDeg - startDeg) * (t / duration));
-        double pan = std::sin(angle) * radius;
-        auto gains = getPanGains(pan);
-
-        double leftBeat  = std::sin(phCarrier - phBeat * 0.5);
-        double rightBeat = std::sin(phCarrier + phBeat * 0.5);
-        double mono = (leftBeat + rightBeat) * 0.5;
+        const int n = jmin(PanRamp::controlInterval, N - start);
+        for (int k = 0; k < n; ++k)
+        {
+            double leftBeat  = std::sin(phCarrier - phBeat * 0.5);
+            double rightBeat = std::sin(phCarrier + phBeat * 0.5);
+            double mono = (leftBeat + rightBeat) * 0.5;
+            voice[k] = static_cast<float>(mono * amp);
 
-        buffer.setSample(0, i, static_cast<float>(mono * amp * gains.first));
-        buffer.setSample(1, i, static_cast<float>(mono * amp * gains.second));
+            phCarrier += MathConstants<double>::twoPi * carrierFreq * dt;
+            phBeat += MathConstants<double>::twoPi * beatFreq * dt;
+        }
 
-        phCarrier += MathConstants<double>::twoPi * carrierFreq * dt;
-        phBeat += MathConstants<double>::twoPi * beatFreq * dt;
+        double deg = degAt(start + n);
+        stage.process(voice, buffer, start, n, path.getPosition(deg / 360.0) * radius, isBehind(deg));
     }
 
+    stage.finish(buffer);
     return buffer;
 }
 
@@ -64,31 +148,50 @@ AudioBuffer<float> spatialAngleModulationTransition(double duration, double samp
     const double sDeg         = params.getWithDefault("startArcStartDeg", params.getWithDefault("arcStartDeg", 0.0));
     const double eDeg         = params.getWithDefault("endArcEndDeg", params.getWithDefault("arcEndDeg", 360.0));
 
+    auto fractionAt = [&](int i)
+    {
+        i = jmin(i, N - 1);
+        return alpha.empty() ? static_cast<double>(i) / (N > 1 ? N - 1 : 1) : alpha[static_cast<size_t>(i)];
+    };
+    const SpatialPath path;
+    auto panAt = [&](int i)
+    {
+        double a = fractionAt(i);
+        double radius = sRadius + (eRadius - sRadius) * a;
+        double deg    = sDeg + (eDeg - sDeg) * a;
+        return path.getPosition(deg / 360.0) * radius;
+    };
+    auto behindAt = [&](int i) { return isBehind(sDeg + (eDeg - sDeg) * fractionAt(i)); };
+    SpatialStage stage(params, sampleRate, panAt(0), behindAt(0));
+    float voice[PanRamp::controlInterval];
+
     const double dt = 1.0 / sampleRate;
     double phCarrier = 0.0;
     double phBeat = 0.0;
-    for (int i = 0; i < N; ++i)
+    for (int start = 0; start < N; start += PanRamp::controlInterval)
     {
-        double a = alpha.empty() ? static_cast<double>(i) / (N > 1 ? N - 1 : 1) : alpha[i];
-        double amp    = sAmp + (eAmp - sAmp) * a;
-        double cfreq  = sCarrierFreq + (eCarrierFreq - sCarrierFreq) * a;
-        double bfreq  = sBeatFreq + (eBeatFreq - sBeatFreq) * a;
-        double radius = sRadius + (eRadius - sRadius) * a;
-        double deg    = sDeg + (eDeg - sDeg) * a;
-        double pan    = std::sin(juce::degreesToRadians(deg)) * radius;
-        auto gains = getPanGains(pan);
+        const int n = jmin(PanRamp::controlInterval, N - start);
+        for (int k = 0; k < n; ++k)
+        {
+            double a = fractionAt(start + k);
+            double amp    = sAmp + (eAmp - sAmp) * a;
+            double cfreq  = sCarrierFreq + (eCarrierFreq - sCarrierFreq) * a;
+            double bfreq  = sBeatFreq + (eBeatFreq - sBeatFreq) * a;
 
-        double leftBeat  = std::sin(phCarrier - phBeat * 0.5);
-        double rightBeat = std::sin(phCarrier + phBeat * 0.5);
-        double mono = (leftBeat + rightBeat) * 0.5;
+            double leftBeat  = std::sin(phCarrier - phBeat * 0.5);
+            double rightBeat = std::sin(phCarrier + phBeat * 0.5);
+            double mono = (leftBeat + rightBeat) * 0.5;
 
-        buffer.setSample(0, i, static_cast<float>(mono * amp * gains.first));
-        buffer.setSample(1, i, static_cast<float>(mono * amp * gains.second));
+            voice[k] = static_cast<float>(mono * amp);
+
+            phCarrier += MathConstants<double>::twoPi * cfreq * dt;
+            phBeat += MathConstants<double>::twoPi * bfreq * dt;
+        }
 
-        phCarrier += MathConstants<double>::twoPi * cfreq * dt;
-        phBeat += MathConstants<double>::twoPi * bfreq * dt;
+        stage.process(voice, buffer, start, n, panAt(start + n), behindAt(start + n));
     }
 
+    stage.finish(buffer);
     return buffer;
 }
 
@@ -113,25 +216,36 @@ AudioBuffer<float> spatialAngleModulationMonauralBeat(double duration, double sa
     const double aOP = params.getWithDefault("sam_ampOscPhaseOffset", 0.0);
     const double spatialFreq = params.getWithDefault("spatialBeatFreq", params.getWithDefault("beatFreq", 4.0));
     const double radius      = params.getWithDefault("pathRadius", 1.0);
+    const String pathShape   = params.getWithDefault("pathShape", "circle");
+    const double arcStartDeg = params.getWithDefault("arcStartDeg", 0.0);
+    const double arcEndDeg   = params.getWithDefault("arcEndDeg", 360.0);
 
-    double phase = 0.0;
+    const SpatialPath path(SpatialPath::parseShape(pathShape), arcStartDeg, arcEndDeg);
+    SpatialStage stage(params, sampleRate, path.getPosition(0.0) * radius, false);
+    float voice[PanRamp::controlInterval];
+
+    double cycles = 0.0;
     const double dt = 1.0 / sampleRate;
-    for (int i = 0; i < N; ++i)
+    for (int start = 0; start < N; start += PanRamp::controlInterval)
     {
-        double env = 1.0;
-        if (aOD != 0.0 && aOF != 0.0)
+        const int n = jmin(PanRamp::controlInterval, N - start);
+        for (int k = 0; k < n; ++k)
         {
-            double depth = std::clamp(aOD, 0.0, 2.0);
-            env = (1.0 - depth * 0.5) + (depth * 0.5) * std::sin(MathConstants<double>::twoPi * aOF * i * dt + aOP);
+            const int i = start + k;
+            double env = 1.0;
+            if (aOD != 0.0 && aOF != 0.0)
+            {
+                double depth = std::clamp(aOD, 0.0, 2.0);
+                env = (1.0 - depth * 0.5) + (depth * 0.5) * std::sin(MathConstants<double>::twoPi * aOF * i * dt + aOP);
+            }
+            voice[k] = mono[i] * static_cast<float>(env);
         }
-        double pan = std::sin(phase) * radius;
-        auto gains = getPanGains(pan);
-        float v = mono[i] * static_cast<float>(env);
-        buffer.setSample(0, i, v * gains.first);
-        buffer.setSample(1, i, v * gains.second);
-        phase += MathConstants<double>::twoPi * spatialFreq * dt;
+
+        cycles += n * spatialFreq * dt;
+        stage.process(voice, buffer, start, n, path.getPosition(cycles) * radius, false);
     }
 
+    stage.finish(buffer);
     return buffer;
 }
 
@@ -165,32 +279,48 @@ AudioBuffer<float> spatialAngleModulationMonauralBeatTransition(double duration,
     const double eFreq = params.getWithDefault("endSpatialBeatFreq", sFreq);
     const double sRad  = params.getWithDefault("startPathRadius", params.getWithDefault("pathRadius", 1.0));
     const double eRad  = params.getWithDefault("endPathRadius", sRad);
+    const String pathShape   = params.getWithDefault("pathShape", "circle");
+    const double arcStartDeg = params.getWithDefault("arcStartDeg", 0.0);
+    const double arcEndDeg   = params.getWithDefault("arcEndDeg", 360.0);
 
-    double phase = 0.0;
+    auto fractionAt = [&](int i)
+    {
+        i = jmin(i, N - 1);
+        return alpha.empty() ? static_cast<double>(i) / (N > 1 ? N - 1 : 1) : alpha[static_cast<size_t>(i)];
+    };
+
+    const SpatialPath path(SpatialPath::parseShape(pathShape), arcStartDeg, arcEndDeg);
+    SpatialStage stage(params, sampleRate, path.getPosition(0.0) * (sRad + (eRad - sRad) * fractionAt(0)), false);
+    float voice[PanRamp::controlInterval];
+
+    double cycles = 0.0;
     const double dt = 1.0 / sampleRate;
-    for (int i = 0; i < N; ++i)
+    for (int start = 0; start < N; start += PanRamp::controlInterval)
     {
-        double a = alpha.empty() ? static_cast<double>(i) / (N > 1 ? N - 1 : 1) : alpha[i];
-        double depth = sAOD + (eAOD - sAOD) * a;
-        double freq  = sAOF + (eAOF - sAOF) * a;
-        double phOff = sAOP + (eAOP - sAOP) * a;
-        double spatialF = sFreq + (eFreq - sFreq) * a;
-        double r = sRad + (eRad - sRad) * a;
-
-        double env = 1.0;
-        if (depth != 0.0 && freq != 0.0)
+        const int n = jmin(PanRamp::controlInterval, N - start);
+        for (int k = 0; k < n; ++k)
         {
-            double clamped = std::clamp(depth, 0.0, 2.0);
-            env = (1.0 - clamped * 0.5) + (clamped * 0.5) * std::sin(MathConstants<double>::twoPi * freq * i * dt + phOff);
+            const int i = start + k;
+            double a = fractionAt(i);
+            double depth = sAOD + (eAOD - sAOD) * a;
+            double freq  = sAOF + (eAOF - sAOF) * a;
+            double phOff = sAOP + (eAOP - sAOP) * a;
+
+            double env = 1.0;
+            if (depth != 0.0 && freq != 0.0)
+            {
+                double clamped = std::clamp(depth, 0.0, 2.0);
+                env = (1.0 - clamped * 0.5) + (clamped * 0.5) * std::sin(MathConstants<double>::twoPi * freq * i * dt + phOff);
+            }
+
+            voice[k] = mono[i] * static_cast<float>(env);
+            cycles += (sFreq + (eFreq - sFreq) * a) * dt;
         }
 
-        double pan = std::sin(phase) * r;
-        auto gains = getPanGains(pan);
-        float v = mono[i] * static_cast<float>(env);
-        buffer.setSample(0, i, v * gains.first);
-        buffer.setSample(1, i, v * gains.second);
-        phase += MathConstants<double>::twoPi * spatialF * dt;
+        double r = sRad + (eRad - sRad) * fractionAt(start + n);
+        stage.process(voice, buffer, start, n, path.getPosition(cycles) * r, false);
     }
 
+    stage.finish(buffer);
     return buffer;
 }
@@ -1,8 +1,124 @@
 #include "Subliminals.h"
 #include "AudioUtils.h"
+#include <algorithm>
+#include <memory>
+#include <mutex>
 
 using namespace juce;
 
+namespace
+{
+using Segment = std::shared_ptr<const AudioBuffer<float>>;
+
+// Modulated segments kept between renders, so a track that uses the same
+// recordings in many steps decodes and modulates each one once. The oldest
+// entries are dropped beyond this many samples (about 128 MB).
+constexpr int64 maxCachedSamples = int64(1) << 25;
+
+struct SegmentCache
+{
+    struct Entry
+    {
+        String key;
+        Segment segment;
+        uint64 lastUse;
+    };
+
+    std::mutex lock;
+    std::vector<Entry> entries;
+    uint64 useCount = 0;
+};
+
+SegmentCache& getSegmentCache()
+{
+    static SegmentCache cache;
+    return cache;
+}
+
+/** Decodes @p file to mono at @p sampleRate, rings it on the carrier and
+    normalises it to full scale. Null if the file cannot be read. */
+Segment renderSegment(AudioFormatManager& fm, const File& file, double carrier, double sampleRate)
+{
+    std::unique_ptr<AudioFormatReader> reader(fm.createReaderFor(file));
+    if (! reader)
+        return nullptr;
+
+    const int len = static_cast<int>(reader->lengthInSamples);
+    AudioBuffer<float> monoBuf(1, len);
+    reader->read(&monoBuf, 0, len, 0, true, true);
+    if (reader->sampleRate != sampleRate && len > 0)
+    {
+        LagrangeInterpolator resamp;
+        const int newLen = static_cast<int>(len * sampleRate / reader->sampleRate);
+        AudioBuffer<float> tmp(1, newLen);
+        resamp.reset();
+        resamp.process(reader->sampleRate / sampleRate, monoBuf.getReadPointer(0), tmp.getWritePointer(0), newLen);
+        monoBuf = std::move(tmp);
+    }
+
+    const int segN = monoBuf.getNumSamples();
+    if (segN <= 0)
+        return nullptr;
+
+    float* data = monoBuf.getWritePointer(0);
+    double phase = 0.0;
+    const double inc = MathConstants<double>::twoPi * carrier / sampleRate;
+    for (int i = 0; i < segN; ++i)
+    {
+        data[i] *= static_cast<float>(std::sin(phase));
+        phase += inc;
+    }
+
+    const float maxAbs = monoBuf.getMagnitude(0, 0, segN);
+    if (maxAbs > 1e-6f)
+        monoBuf.applyGain(1.0f / maxAbs);
+    return std::make_shared<const AudioBuffer<float>>(std::move(monoBuf));
+}
+
+/** The modulated segment for @p file, from the cache when the file is
+    unchanged since it was rendered at this carrier and rate. */
+Segment getSegment(AudioFormatManager& fm, const File& file, double carrier, double sampleRate)
+{
+    const String key = file.getFullPathName()
+                     + "|" + String(file.getLastModificationTime().toMilliseconds())
+                     + "|" + String(file.getSize())
+                     + "|" + String(carrier) + "|" + String(sampleRate);
+
+    auto& cache = getSegmentCache();
+    {
+        std::lock_guard<std::mutex> guard(cache.lock);
+        for (auto& entry : cache.entries)
+        {
+            if (entry.key == key)
+            {
+                entry.lastUse = ++cache.useCount;
+                return entry.segment;
+            }
+        }
+    }
+
+    // Rendered outside the lock; two threads may both render a new file,
+    // which costs time but not correctness.
+    Segment segment = renderSegment(fm, file, carrier, sampleRate);
+    if (segment == nullptr)
+        return nullptr;
+
+    std::lock_guard<std::mutex> guard(cache.lock);
+    cache.entries.push_back({ key, segment, ++cache.useCount });
+    int64 total = 0;
+    for (const auto& entry : cache.entries)
+        total += entry.segment->getNumSamples();
+    while (total > maxCachedSamples && cache.entries.size() > 1)
+    {
+        auto oldest = std::min_element(cache.entries.begin(), cache.entries.end(),
+                                       [](const auto& a, const auto& b) { return a.lastUse < b.lastUse; });
+        total -= oldest->segment->getNumSamples();
+        cache.entries.erase(oldest);
+    }
+    return segment;
+}
+} // namespace
+
 AudioBuffer<float> subliminalEncode(double duration, double sampleRate, const NamedValueSet& params)
 {
     const int N = static_cast<int>(duration * sampleRate);
@@ -28,91 +144,42 @@ AudioBuffer<float> subliminalEncode(double duration, double sampleRate, const Na
     AudioFormatManager fm;
     fm.registerBasicFormats();
 
-    std::vector<AudioBuffer<float>> segments;
+    std::vector<Segment> segments;
     for (const auto& f : files)
-    {
-        std::unique_ptr<AudioFormatReader> reader(fm.createReaderFor(File(f)));
-        if (! reader)
-            continue;
-
-        const int len = static_cast<int>(reader->lengthInSamples);
-        AudioBuffer<float> monoBuf(1, len);
-        reader->read(&monoBuf, 0, len, 0, true, true);
-        if (reader->sampleRate != sampleRate && len > 0)
-        {
-            LagrangeInterpolator resamp;
-            const int newLen = static_cast<int>(len * sampleRate / reader->sampleRate);
-            AudioBuffer<float> tmp(1, newLen);
-            resamp.reset();
-            resamp.process(reader->sampleRate / sampleRate, monoBuf.getReadPointer(0), tmp.getWritePointer(0), newLen);
-            monoBuf = std::move(tmp);
-        }
-
-        const int segN = monoBuf.getNumSamples();
-        if (segN <= 0)
-            continue;
-
-        AudioBuffer<float> modBuf(1, segN);
-        double phase = 0.0;
-        const double inc = MathConstants<double>::twoPi * carrier / sampleRate;
-        for (int i = 0; i < segN; ++i)
-        {
-            float s = monoBuf.getSample(0, i);
-            modBuf.setSample(0, i, s * std::sin(phase));
-            phase += inc;
-        }
-
-        float maxAbs = 0.0f;
-        for (int i = 0; i < segN; ++i)
-            maxAbs = std::max(maxAbs, std::abs(modBuf.getSample(0, i)));
-        if (maxAbs > 1e-6f)
-            modBuf.applyGain(1.0f / maxAbs);
-        segments.push_back(std::move(modBuf));
-    }
+        if (auto segment = getSegment(fm, File(f), carrier, sampleRate))
+            segments.push_back(std::move(segment));
 
     if (segments.empty())
         return buffer;
 
+    // Both modes build the left channel from whole spans of the segments,
+    // with the output gain folded in, then copy it to the right.
     buffer.clear();
     if (mode == "stack")
     {
+        const float gain = static_cast<float>(amp / segments.size());
         for (const auto& seg : segments)
         {
-            const int segN = seg.getNumSamples();
-            for (int i = 0; i < N; ++i)
-            {
-                float v = seg.getSample(0, i % segN);
-                buffer.addSample(0, i, v);
-                buffer.addSample(1, i, v);
-            }
+            const int segN = seg->getNumSamples();
+            for (int pos = 0; pos < N; pos += segN)
+                buffer.addFrom(0, pos, seg->getReadPointer(0), std::min(segN, N - pos), gain);
         }
-        buffer.applyGain(1.0f / segments.size());
     }
     else
     {
         int pos = 0;
-        int idx = 0;
+        size_t idx = 0;
         const int pauseSamples = static_cast<int>(sampleRate);
         while (pos < N)
         {
             const auto& seg = segments[idx % segments.size()];
-            const int segN = seg.getNumSamples();
-            const int copyLen = std::min(segN, N - pos);
-            for (int i = 0; i < copyLen; ++i)
-            {
-                float v = seg.getSample(0, i);
-                buffer.setSample(0, pos + i, v);
-                buffer.setSample(1, pos + i, v);
-            }
-            pos += copyLen;
-            if (pos >= N)
-                break;
-            const int pauseLen = std::min(pauseSamples, N - pos);
-            pos += pauseLen;
+            const int copyLen = std::min(seg->getNumSamples(), N - pos);
+            buffer.copyFrom(0, pos, seg->getReadPointer(0), copyLen, static_cast<float>(amp));
+            pos += copyLen + pauseSamples;
             ++idx;
         }
     }
+    buffer.copyFrom(1, 0, buffer, 0, 0, N);
 
-    buffer.applyGain(static_cast<float>(amp));
     return buffer;
 }
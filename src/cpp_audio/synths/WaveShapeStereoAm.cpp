@@ -1,5 +1,7 @@
 #include "WaveShapeStereoAm.h"
 #include "AudioUtils.h"
+#include "FastMath.h"
+#include "OversampledTanh.h"
 #include <cmath>
 
 using namespace juce;
@@ -26,30 +28,51 @@ AudioBuffer<float> waveShapeStereoAm(double duration, double sampleRate, const N
     double shapePhase = 0.0;
     double stereoPhaseL = stereoModPhaseL;
     double stereoPhaseR = stereoModPhaseR;
-    double tanhShape = std::tanh(std::max(1e-6, shapeAmount));
+    double invTanhShape = 1.0 / fastmath::tanh(std::max(1e-6, shapeAmount));
 
-    for (int i = 0; i < totalSamples; ++i)
+    // The shaper delays its output, so run on past the end by its latency.
+    OversampledTanh shaper(OversampledTanh::getFactor(params));
+    const int latency = shaper.getLatency();
+    double drive[OversampledTanh::maxBlockSize];
+    float gainL[OversampledTanh::maxBlockSize], gainR[OversampledTanh::maxBlockSize];
+
+    for (int start = 0; start < totalSamples + latency; start += OversampledTanh::maxBlockSize)
     {
-        double carrier = std::sin(carrierPhase);
-        double shapeLFO = std::sin(shapePhase);
-        double shapeAmp = 1.0 - shapeModDepth * (1.0 - shapeLFO) * 0.5;
-        double shaped = std::tanh(carrier * shapeAmp * shapeAmount) / tanhShape;
-
-        double lfoL = std::sin(stereoPhaseL);
-        double lfoR = std::sin(stereoPhaseR);
-        double modL = 1.0 - stereoModDepthL * (1.0 - lfoL) * 0.5;
-        double modR = 1.0 - stereoModDepthR * (1.0 - lfoR) * 0.5;
-
-        float outL = static_cast<float>(shaped * modL * amp);
-        float outR = static_cast<float>(shaped * modR * amp);
-
-        buffer.setSample(0, i, outL);
-        buffer.setSample(1, i, outR);
-
-        carrierPhase += MathConstants<double>::twoPi * carrierFreq * dt;
-        shapePhase += MathConstants<double>::twoPi * shapeModFreq * dt;
-        stereoPhaseL += MathConstants<double>::twoPi * stereoModFreqL * dt;
-        stereoPhaseR += MathConstants<double>::twoPi * stereoModFreqR * dt;
+        int n = std::min(OversampledTanh::maxBlockSize, totalSamples + latency - start);
+        for (int k = 0; k < n; ++k)
+        {
+            if (start + k >= totalSamples)
+            {
+                drive[k] = 0.0;
+                gainL[k] = gainR[k] = 0.0f;
+                continue;
+            }
+
+            double carrier = fastmath::sin(carrierPhase);
+            double shapeLFO = fastmath::sin(shapePhase);
+            double shapeAmp = 1.0 - shapeModDepth * (1.0 - shapeLFO) * 0.5;
+            drive[k] = carrier * shapeAmp * shapeAmount;
+
+            double lfoL = fastmath::sin(stereoPhaseL);
+            double lfoR = fastmath::sin(stereoPhaseR);
+            double modL = 1.0 - stereoModDepthL * (1.0 - lfoL) * 0.5;
+            double modR = 1.0 - stereoModDepthR * (1.0 - lfoR) * 0.5;
+            gainL[k] = static_cast<float>(invTanhShape * modL * amp);
+            gainR[k] = static_cast<float>(invTanhShape * modR * amp);
+
+            carrierPhase += MathConstants<double>::twoPi * carrierFreq * dt;
+            shapePhase += MathConstants<double>::twoPi * shapeModFreq * dt;
+            stereoPhaseL += MathConstants<double>::twoPi * stereoModFreqL * dt;
+            stereoPhaseR += MathConstants<double>::twoPi * stereoModFreqR * dt;
+        }
+
+        shaper.process(drive, gainL, gainR, n);
+        for (int k = std::max(0, latency - start); k < n; ++k)
+        {
+            int i = start + k - latency;
+            buffer.setSample(0, i, static_cast<float>(drive[k]) * gainL[k]);
+            buffer.setSample(1, i, static_cast<float>(drive[k]) * gainR[k]);
+        }
     }
 
     return buffer;
@@ -90,42 +113,82 @@ AudioBuffer<float> waveShapeStereoAmTransition(double duration, double sampleRat
     double shapePhase = 0.0;
     double stereoPhaseL = startStereoModPhaseL;
     double stereoPhaseR = startStereoModPhaseR;
-
-    for (int i = 0; i < totalSamples; ++i)
+    // 1/tanh(shapeAmount) is worked out every shapeControlInterval samples
+    // and interpolated in between, so a shape ramp costs no tanh per sample.
+    constexpr int shapeControlInterval = 32;
+    auto invTanhShapeAt = [&](int i)
     {
         double a = alpha.empty() ? static_cast<double>(i) / (totalSamples > 1 ? totalSamples - 1 : 1)
                                  : alpha[i];
-
-        double carrierFreq = startCarrierFreq + (endCarrierFreq - startCarrierFreq) * a;
-        double shapeModFreq = startShapeModFreq + (endShapeModFreq - startShapeModFreq) * a;
-        double shapeModDepth = startShapeModDepth + (endShapeModDepth - startShapeModDepth) * a;
         double shapeAmount = startShapeAmount + (endShapeAmount - startShapeAmount) * a;
-        double stereoModFreqL = startStereoModFreqL + (endStereoModFreqL - startStereoModFreqL) * a;
-        double stereoModDepthL = startStereoModDepthL + (endStereoModDepthL - startStereoModDepthL) * a;
-        double stereoModFreqR = startStereoModFreqR + (endStereoModFreqR - startStereoModFreqR) * a;
-        double stereoModDepthR = startStereoModDepthR + (endStereoModDepthR - startStereoModDepthR) * a;
-
-        double carrier = std::sin(carrierPhase);
-        double shapeLFO = std::sin(shapePhase);
-        double shapeAmp = 1.0 - shapeModDepth * (1.0 - shapeLFO) * 0.5;
-        double tanhShape = std::tanh(std::max(1e-6, shapeAmount));
-        double shaped = std::tanh(carrier * shapeAmp * shapeAmount) / tanhShape;
-
-        double lfoL = std::sin(stereoPhaseL);
-        double lfoR = std::sin(stereoPhaseR);
-        double modL = 1.0 - stereoModDepthL * (1.0 - lfoL) * 0.5;
-        double modR = 1.0 - stereoModDepthR * (1.0 - lfoR) * 0.5;
-
-        float outL = static_cast<float>(shaped * modL * amp);
-        float outR = static_cast<float>(shaped * modR * amp);
-
-        buffer.setSample(0, i, outL);
-        buffer.setSample(1, i, outR);
-
-        carrierPhase += MathConstants<double>::twoPi * carrierFreq * dt;
-        shapePhase += MathConstants<double>::twoPi * shapeModFreq * dt;
-        stereoPhaseL += MathConstants<double>::twoPi * stereoModFreqL * dt;
-        stereoPhaseR += MathConstants<double>::twoPi * stereoModFreqR * dt;
+        return 1.0 / fastmath::tanh(std::max(1e-6, shapeAmount));
+    };
+    double invTanhFrom = invTanhShapeAt(0);
+    double invTanhTo = invTanhFrom;
+
+    OversampledTanh shaper(OversampledTanh::getFactor(params));
+    const int latency = shaper.getLatency();
+    double drive[OversampledTanh::maxBlockSize];
+    float gainL[OversampledTanh::maxBlockSize], gainR[OversampledTanh::maxBlockSize];
+
+    for (int start = 0; start < totalSamples + latency; start += OversampledTanh::maxBlockSize)
+    {
+        int n = std::min(OversampledTanh::maxBlockSize, totalSamples + latency - start);
+        for (int k = 0; k < n; ++k)
+        {
+            int i = start + k;
+            if (i >= totalSamples)
+            {
+                drive[k] = 0.0;
+                gainL[k] = gainR[k] = 0.0f;
+                continue;
+            }
+
+            double a = alpha.empty() ? static_cast<double>(i) / (totalSamples > 1 ? totalSamples - 1 : 1)
+                                     : alpha[i];
+
+            double carrierFreq = startCarrierFreq + (endCarrierFreq - startCarrierFreq) * a;
+            double shapeModFreq = startShapeModFreq + (endShapeModFreq - startShapeModFreq) * a;
+            double shapeModDepth = startShapeModDepth + (endShapeModDepth - startShapeModDepth) * a;
+            double shapeAmount = startShapeAmount + (endShapeAmount - startShapeAmount) * a;
+            double stereoModFreqL = startStereoModFreqL + (endStereoModFreqL - startStereoModFreqL) * a;
+            double stereoModDepthL = startStereoModDepthL + (endStereoModDepthL - startStereoModDepthL) * a;
+            double stereoModFreqR = startStereoModFreqR + (endStereoModFreqR - startStereoModFreqR) * a;
+            double stereoModDepthR = startStereoModDepthR + (endStereoModDepthR - startStereoModDepthR) * a;
+
+            double carrier = fastmath::sin(carrierPhase);
+            double shapeLFO = fastmath::sin(shapePhase);
+            double shapeAmp = 1.0 - shapeModDepth * (1.0 - shapeLFO) * 0.5;
+            int controlPhase = i % shapeControlInterval;
+            if (controlPhase == 0)
+            {
+                invTanhFrom = invTanhTo;
+                invTanhTo = invTanhShapeAt(std::min(i + shapeControlInterval, totalSamples - 1));
+            }
+            double invTanhShape = invTanhFrom
+                + (invTanhTo - invTanhFrom) * (controlPhase * (1.0 / shapeControlInterval));
+            drive[k] = carrier * shapeAmp * shapeAmount;
+
+            double lfoL = fastmath::sin(stereoPhaseL);
+            double lfoR = fastmath::sin(stereoPhaseR);
+            double modL = 1.0 - stereoModDepthL * (1.0 - lfoL) * 0.5;
+            double modR = 1.0 - stereoModDepthR * (1.0 - lfoR) * 0.5;
+            gainL[k] = static_cast<float>(invTanhShape * modL * amp);
+            gainR[k] = static_cast<float>(invTanhShape * modR * amp);
+
+            carrierPhase += MathConstants<double>::twoPi * carrierFreq * dt;
+            shapePhase += MathConstants<double>::twoPi * shapeModFreq * dt;
+            stereoPhaseL += MathConstants<double>::twoPi * stereoModFreqL * dt;
+            stereoPhaseR += MathConstants<double>::twoPi * stereoModFreqR * dt;
+        }
+
+        shaper.process(drive, gainL, gainR, n);
+        for (int k = std::max(0, latency - start); k < n; ++k)
+        {
+            int i = start + k - latency;
+            buffer.setSample(0, i, static_cast<float>(drive[k]) * gainL[k]);
+            buffer.setSample(1, i, static_cast<float>(drive[k]) * gainR[k]);
+        }
     }
 
     return buffer;
@@ -0,0 +1,111 @@
+#include "SynthCases.h"
+#include "../core/Track.h"
+#include <algorithm>
+
+namespace
+{
+    SynthCase makeCase(const juce::String& name, const juce::String& synth, double duration,
+                       std::initializer_list<juce::NamedValueSet::NamedValue> params,
+                       bool stochastic = false)
+    {
+        SynthCase c;
+        c.name = name;
+        c.synth = synth;
+        c.durationSeconds = duration;
+        c.params = juce::NamedValueSet(params);
+        c.stochastic = stochastic;
+        return c;
+    }
+}
+
+std::vector<SynthCase> getRepresentativeSynthCases(const juce::File& fixtureAudio)
+{
+    const juce::String fixturePath = fixtureAudio.getFullPathName();
+
+    std::vector<SynthCase> cases {
+        makeCase("binaural_beat/default", "binaural_beat", 10.0, {}),
+        makeCase("binaural_beat/modulated", "binaural_beat", 10.0,
+                 { { "ampOscDepthL", 0.3 }, { "ampOscFreqL", 0.5 },
+                   { "ampOscDepthR", 0.3 }, { "ampOscFreqR", 0.5 },
+                   { "freqOscRangeL", 2.0 }, { "freqOscFreqL", 0.1 },
+                   { "phaseOscFreq", 0.2 }, { "phaseOscRange", 0.5 } }),
+        makeCase("binaural_beat/glitch", "binaural_beat", 10.0,
+                 { { "glitchInterval", 2.0 }, { "glitchDur", 0.3 },
+                   { "glitchNoiseLevel", 0.2 }, { "glitchFocusWidth", 0.5 },
+                   { "glitchFocusExp", 2.0 } }, true),
+        makeCase("binaural_beat_transition/sweep", "binaural_beat_transition", 10.0,
+                 { { "startBaseFreq", 200.0 }, { "endBaseFreq", 150.0 },
+                   { "startBeatFreq", 10.0 }, { "endBeatFreq", 4.0 } }),
+
+        makeCase("isochronic_tone/default", "isochronic_tone", 10.0, {}),
+        makeCase("isochronic_tone_transition/sweep", "isochronic_tone_transition", 10.0,
+                 { { "startBeatFreq", 12.0 }, { "endBeatFreq", 6.0 } }),
+
+        makeCase("rhythmic_waveshaping/default", "rhythmic_waveshaping", 10.0, {}),
+        makeCase("rhythmic_waveshaping_transition/sweep", "rhythmic_waveshaping_transition", 10.0,
+                 { { "startShapeAmount", 2.0 }, { "endShapeAmount", 8.0 },
+                   { "startModFreq", 8.0 }, { "endModFreq", 4.0 } }),
+
+        makeCase("stereo_am_independent/default", "stereo_am_independent", 10.0, {}),
+        makeCase("stereo_am_independent_transition/sweep", "stereo_am_independent_transition", 10.0,
+                 { { "startModFreqL", 8.0 }, { "endModFreqL", 4.0 },
+                   { "startModFreqR", 8.5 }, { "endModFreqR", 4.5 } }),
+
+        makeCase("wave_shape_stereo_am/default", "wave_shape_stereo_am", 10.0, {}),
+        makeCase("wave_shape_stereo_am_transition/sweep", "wave_shape_stereo_am_transition", 10.0,
+                 { { "startShapeAmount", 0.2 }, { "endShapeAmount", 0.9 },
+                   { "startShapeModFreq", 8.0 }, { "endShapeModFreq", 4.0 } }),
+
+        makeCase("monaural_beat_stereo_amps/default", "monaural_beat_stereo_amps", 10.0, {}),
+        makeCase("monaural_beat_stereo_amps_transition/sweep", "monaural_beat_stereo_amps_transition", 10.0,
+                 { { "startBeatFreq", 10.0 }, { "endBeatFreq", 4.0 } }),
+
+        makeCase("qam_beat/default", "qam_beat", 10.0, {}),
+        makeCase("qam_beat/full", "qam_beat", 10.0,
+                 { { "modShapeL", 2.5 }, { "modShapeR", 2.5 },
+                   { "crossModDepth", 0.3 }, { "crossModDelay", 0.01 },
+                   { "harmonicDepth", 0.2 }, { "subHarmonicDepth", 0.1 },
+                   { "subHarmonicFreq", 2.0 }, { "beatingSidebands", true },
+                   { "phaseOscFreq", 0.2 }, { "phaseOscRange", 0.4 },
+                   { "attackTime", 1.0 }, { "releaseTime", 1.0 } }),
+        makeCase("qam_beat_transition/sweep", "qam_beat_transition", 10.0,
+                 { { "startBaseFreqR", 210.0 }, { "endBaseFreqR", 204.0 },
+                   { "startCrossModDepth", 0.0 }, { "endCrossModDepth", 0.3 } }),
+
+        makeCase("hybrid_qam_monaural_beat/default", "hybrid_qam_monaural_beat", 10.0, {}),
+        makeCase("hybrid_qam_monaural_beat_transition/sweep", "hybrid_qam_monaural_beat_transition", 10.0,
+                 { { "startQamAmFreqL", 8.0 }, { "endQamAmFreqL", 4.0 } }),
+
+        makeCase("spatial_angle_modulation/default", "spatial_angle_modulation", 10.0, {}),
+        makeCase("spatial_angle_modulation/head", "spatial_angle_modulation", 10.0,
+                 { { "spatializer", "head" } }),
+        makeCase("spatial_angle_modulation_transition/sweep", "spatial_angle_modulation_transition", 10.0,
+                 { { "startSpatialBeatFreq", 8.0 }, { "endSpatialBeatFreq", 4.0 } }),
+        makeCase("spatial_angle_modulation_monaural_beat/default",
+                 "spatial_angle_modulation_monaural_beat", 10.0, {}),
+        makeCase("spatial_angle_modulation_monaural_beat_transition/sweep",
+                 "spatial_angle_modulation_monaural_beat_transition", 10.0,
+                 { { "startBeatFreq", 8.0 }, { "endBeatFreq", 4.0 } }),
+
+        makeCase("generate_swept_notch_pink_sound/default", "generate_swept_notch_pink_sound",
+                 10.0, {}, true),
+        makeCase("generate_swept_notch_pink_sound_transition/sweep",
+                 "generate_swept_notch_pink_sound_transition", 10.0,
+                 { { "start_lfo_freq", 0.1 }, { "end_lfo_freq", 0.05 } }, true),
+
+        makeCase("subliminal_encode/sequence", "subliminal_encode", 10.0,
+                 { { "audio_path", fixturePath }, { "mode", "sequence" } }),
+        makeCase("subliminal_encode/stack", "subliminal_encode", 10.0,
+                 { { "audio_paths", fixturePath }, { "mode", "stack" } }),
+    };
+
+    for (const auto& synthName : getAvailableSynthNames())
+    {
+        bool covered = std::any_of(cases.begin(), cases.end(),
+                                   [&] (const SynthCase& c) { return c.synth == synthName; });
+        if (! covered)
+            cases.push_back(makeCase(synthName + "/default", synthName, 10.0, {}));
+    }
+
+    return cases;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <vector>
+
+/** A named synth invocation shared by the benchmark and regression tools. */
+struct SynthCase
+{
+    juce::String name;                    // Unique label, e.g. "binaural_beat/glitch"
+    juce::String synth;                   // Registry name for findSynthFunction()
+    double durationSeconds { 10.0 };
+    juce::NamedValueSet params;
+    bool stochastic { false };            // Output depends on an unseeded RNG
+};
+
+/** Returns representative parameter sets for every registered synth.
+    Registry entries without a hand-written case get a default-parameter
+    case so nothing in synthMap is skipped. @p fixtureAudio is a short
+    audio file handed to synths that read from disk. */
+std::vector<SynthCase> getRepresentativeSynthCases(const juce::File& fixtureAudio);
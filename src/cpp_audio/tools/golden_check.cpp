@@ -0,0 +1,363 @@
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_core/juce_core.h>
+#include <juce_dsp/juce_dsp.h>
+#include "core/AudioUtils.h"
+#include "core/FastMath.h"
+#include "core/Track.h"
+#include "tools/SynthCases.h"
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+// Golden-reference accuracy check for the synths. Run once with --update on
+// a known-good commit to store reference renders (tools/make_golden_refs.sh
+// does this for the committed golden_refs), then run without it after
+// changing DSP code. Deterministic synths are compared sample-wise; synths
+// driven by an unseeded RNG are compared by level and averaged spectrum.
+// The core/FastMath.h kernels are also checked against libm over the input
+// ranges their accuracy contracts state.
+// Exits with a non-zero status if any case is outside its tolerance.
+
+namespace
+{
+    constexpr double renderSeconds = 4.0;
+    constexpr int spectrumOrder = 12;               // 4096-point FFT
+    constexpr double spectrumFloorDb = -80.0;       // bins below this (re. peak) are ignored
+
+    struct Tolerance
+    {
+        double maxAbs { 1.0e-4 };
+        double rms { 1.0e-5 };
+        double spectralDb { 0.1 };
+        double levelDb { 0.05 };
+    };
+
+    /** Per-synth overrides, keyed by registry name. Anything not listed uses
+        the default (deterministic) or statistical tolerances. */
+    Tolerance getTolerance(const SynthCase& c)
+    {
+        if (c.stochastic)
+        {
+            Tolerance t;
+            t.maxAbs = -1.0;   // sample-wise comparison disabled
+            t.rms = -1.0;
+            t.spectralDb = 1.5;
+            t.levelDb = 0.5;
+            return t;
+        }
+
+        static const std::map<juce::String, Tolerance> overrides {
+            // Resampled speech/audio input goes through the interpolator.
+            { "subliminal_encode", { 5.0e-4, 5.0e-5, 0.2, 0.05 } },
+        };
+
+        auto it = overrides.find(c.synth);
+        return it != overrides.end() ? it->second : Tolerance {};
+    }
+
+    struct Metrics
+    {
+        double maxAbs { 0.0 };
+        double rms { 0.0 };
+        double spectralDb { 0.0 };
+        double levelDb { 0.0 };
+    };
+
+    /** Averaged magnitude spectrum (Hann-windowed, 50% overlap) in dB. */
+    std::vector<double> averagedSpectrumDb(const juce::AudioBuffer<float>& buffer, int channel)
+    {
+        const int fftSize = 1 << spectrumOrder;
+        juce::dsp::FFT fft(spectrumOrder);
+        std::vector<float> window(static_cast<size_t>(fftSize));
+        for (int i = 0; i < fftSize; ++i)
+            window[static_cast<size_t>(i)] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * i / (fftSize - 1));
+
+        std::vector<double> sum(static_cast<size_t>(fftSize / 2 + 1), 0.0);
+        std::vector<float> frame(static_cast<size_t>(fftSize * 2));
+        const float* data = buffer.getReadPointer(channel);
+        int frames = 0;
+
+        for (int start = 0; start + fftSize <= buffer.getNumSamples(); start += fftSize / 2)
+        {
+            std::fill(frame.begin(), frame.end(), 0.0f);
+            for (int i = 0; i < fftSize; ++i)
+                frame[static_cast<size_t>(i)] = data[start + i] * window[static_cast<size_t>(i)];
+            fft.performFrequencyOnlyForwardTransform(frame.data());
+            for (size_t k = 0; k < sum.size(); ++k)
+                sum[k] += static_cast<double>(frame[k]) * frame[k];
+            ++frames;
+        }
+
+        for (auto& v : sum)
+            v = 10.0 * std::log10(v / juce::jmax(1, frames) + 1.0e-20);
+        return sum;
+    }
+
+    double levelDb(const juce::AudioBuffer<float>& buffer)
+    {
+        double energy = 0.0;
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            const float* d = buffer.getReadPointer(ch);
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                energy += static_cast<double>(d[i]) * d[i];
+        }
+        double n = static_cast<double>(buffer.getNumSamples()) * juce::jmax(1, buffer.getNumChannels());
+        return 10.0 * std::log10(energy / juce::jmax(1.0, n) + 1.0e-20);
+    }
+
+    Metrics compare(const juce::AudioBuffer<float>& ref, const juce::AudioBuffer<float>& out)
+    {
+        Metrics m;
+        const int channels = juce::jmin(ref.getNumChannels(), out.getNumChannels());
+        const int samples = juce::jmin(ref.getNumSamples(), out.getNumSamples());
+
+        double sq = 0.0;
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            const float* a = ref.getReadPointer(ch);
+            const float* b = out.getReadPointer(ch);
+            for (int i = 0; i < samples; ++i)
+            {
+                double d = static_cast<double>(a[i]) - b[i];
+                m.maxAbs = juce::jmax(m.maxAbs, std::abs(d));
+                sq += d * d;
+            }
+        }
+        m.rms = std::sqrt(sq / juce::jmax(1.0, static_cast<double>(samples) * channels));
+
+        // RMS of the dB difference over the bins that carry energy in the reference.
+        double specSq = 0.0;
+        int specBins = 0;
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            auto refSpec = averagedSpectrumDb(ref, ch);
+            auto outSpec = averagedSpectrumDb(out, ch);
+            double peak = *std::max_element(refSpec.begin(), refSpec.end());
+            for (size_t k = 0; k < refSpec.size(); ++k)
+            {
+                if (refSpec[k] < peak + spectrumFloorDb)
+                    continue;
+                double d = refSpec[k] - outSpec[k];
+                specSq += d * d;
+                ++specBins;
+            }
+        }
+        m.spectralDb = specBins > 0 ? std::sqrt(specSq / specBins) : 0.0;
+        m.levelDb = std::abs(levelDb(ref) - levelDb(out));
+        return m;
+    }
+
+    bool writeFloatWav(const juce::File& file, const juce::AudioBuffer<float>& buffer, double sampleRate)
+    {
+        file.deleteFile();
+        juce::WavAudioFormat format;
+        std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+        if (! stream)
+            return false;
+        std::unique_ptr<juce::AudioFormatWriter> writer(format.createWriterFor(
+            stream.get(), sampleRate, static_cast<unsigned int>(buffer.getNumChannels()), 32, {}, 0));
+        if (! writer)
+            return false;
+        stream.release();
+        return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+    }
+
+    bool readWav(const juce::File& file, juce::AudioBuffer<float>& buffer)
+    {
+        juce::WavAudioFormat format;
+        std::unique_ptr<juce::AudioFormatReader> reader(format.createReaderFor(file.createInputStream().release(), true));
+        if (! reader)
+            return false;
+        buffer.setSize(static_cast<int>(reader->numChannels), static_cast<int>(reader->lengthInSamples));
+        return reader->read(&buffer, 0, buffer.getNumSamples(), 0, true, true);
+    }
+
+    juce::String referenceFileName(const SynthCase& c, double sampleRate)
+    {
+        return c.name.replace("/", "__") + "_" + juce::String(static_cast<int>(sampleRate)) + ".wav";
+    }
+
+    bool withinTolerance(double value, double limit)
+    {
+        return limit < 0.0 || value <= limit;
+    }
+
+    /** Largest error of @p fast against @p reference over [lo, hi). With
+        @p relative, errors are relative to the reference value. */
+    template <typename Fast, typename Reference>
+    double kernelError(Fast fast, Reference reference, double lo, double hi, double step, bool relative)
+    {
+        double worst = 0.0;
+        for (double x = lo; x < hi; x += step)
+        {
+            double ref = reference(x);
+            double err = std::abs(fast(x) - ref);
+            worst = juce::jmax(worst, relative ? err / std::abs(ref) : err);
+        }
+        return worst;
+    }
+
+    /** Checks every kernel against its contract; returns the number failed. */
+    int checkFastMathContracts(int& checked)
+    {
+        struct Contract
+        {
+            const char* name;
+            double error;
+            double limit;
+        };
+
+        const Contract contracts[] = {
+            { "fastmath/sin (|x| < 1e5)", kernelError([](double x) { return fastmath::sin(x); },
+                                                     [](double x) { return std::sin(x); },
+                                                     -1.0e5, 1.0e5, 0.0137, false), 5.0e-10 },
+            { "fastmath/cos (|x| < 1e5)", kernelError([](double x) { return fastmath::cos(x); },
+                                                     [](double x) { return std::cos(x); },
+                                                     -1.0e5, 1.0e5, 0.0137, false), 5.0e-10 },
+            { "fastmath/tanh", kernelError([](double x) { return fastmath::tanh(x); },
+                                          [](double x) { return std::tanh(x); },
+                                          -20.0, 20.0, 1.0e-4, false), 1.0e-7 },
+            { "fastmath/exp2 (relative)", kernelError([](double x) { return fastmath::exp2(x); },
+                                                     [](double x) { return std::exp2(x); },
+                                                     -1000.0, 1000.0, 1.17e-3, true), 1.0e-8 },
+            { "fastmath/log2", kernelError([](double x) { return fastmath::log2(std::exp2(x)); },
+                                          [](double x) { return x; },
+                                          -1000.0, 1000.0, 1.17e-3, false), 2.0e-9 },
+            // The shaped-cosine case: |cos| in (0, 1] raised to 1/shape up to 10.
+            { "fastmath/pow (relative)", kernelError([](double x) { return fastmath::pow(x, 1.0 / 0.1); },
+                                                    [](double x) { return std::pow(x, 1.0 / 0.1); },
+                                                    1.0e-3, 1.0, 1.3e-5, true), 1.0e-8 * (1.0 + 10.0 * 10.0) },
+        };
+
+        int failed = 0;
+        for (const auto& c : contracts)
+        {
+            ++checked;
+            bool ok = c.error <= c.limit;
+            if (! ok)
+                ++failed;
+            std::cout << (ok ? "ok      " : "FAIL    ") << std::left << std::setw(64) << c.name
+                      << std::right << std::scientific << std::setprecision(2)
+                      << " error " << c.error << "  limit " << c.limit << std::endl;
+        }
+        return failed;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::File refDir = juce::File::getCurrentWorkingDirectory().getChildFile("golden_refs");
+    bool update = false;
+    juce::String filter;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        juce::String arg (argv[i]);
+        if (arg == "--update")
+            update = true;
+        else if (arg == "--refs" && i + 1 < argc)
+            refDir = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+        else if (arg == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else
+        {
+            std::cout << "Usage: golden_check [--refs DIR] [--update] [--filter TEXT]" << std::endl;
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (update)
+        refDir.createDirectory();
+    else if (! refDir.isDirectory())
+    {
+        std::cerr << "Reference directory not found: " << refDir.getFullPathName()
+                  << " (run with --update on a known-good build first)" << std::endl;
+        return 1;
+    }
+
+    // The subliminal fixture is regenerated identically on every run.
+    juce::File fixtureAudio = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                                  .getChildFile("diy_av_golden_fixture.wav");
+    writeWavFile(fixtureAudio, generateSine(330.0, 0.5, 2.0, 44100.0), 44100.0);
+
+    int failures = 0;
+    int checked = 0;
+
+    if (! update && (filter.isEmpty() || juce::String("fastmath").containsIgnoreCase(filter)))
+        failures += checkFastMathContracts(checked);
+
+    for (double sampleRate : { 44100.0, 48000.0 })
+    {
+        for (const auto& c : getRepresentativeSynthCases(fixtureAudio))
+        {
+            if (filter.isNotEmpty() && ! c.name.containsIgnoreCase(filter))
+                continue;
+
+            SynthFunc fn = findSynthFunction(c.synth);
+            if (fn == nullptr)
+                continue;
+
+            const double seconds = juce::jmin(c.durationSeconds, renderSeconds);
+            juce::AudioBuffer<float> out = fn(seconds, sampleRate, c.params);
+            juce::File refFile = refDir.getChildFile(referenceFileName(c, sampleRate));
+            juce::String label = c.name + " @" + juce::String(static_cast<int>(sampleRate));
+
+            if (update)
+            {
+                if (! writeFloatWav(refFile, out, sampleRate))
+                {
+                    std::cerr << "Failed to write " << refFile.getFullPathName() << std::endl;
+                    ++failures;
+                }
+                continue;
+            }
+
+            ++checked;
+            juce::AudioBuffer<float> ref;
+            if (! readWav(refFile, ref))
+            {
+                std::cout << "MISSING " << label << std::endl;
+                ++failures;
+                continue;
+            }
+
+            if (ref.getNumSamples() != out.getNumSamples() || ref.getNumChannels() != out.getNumChannels())
+            {
+                std::cout << "FAIL    " << label << "  shape " << ref.getNumChannels() << "x"
+                          << ref.getNumSamples() << " -> " << out.getNumChannels() << "x"
+                          << out.getNumSamples() << std::endl;
+                ++failures;
+                continue;
+            }
+
+            Metrics m = compare(ref, out);
+            Tolerance tol = getTolerance(c);
+            bool ok = withinTolerance(m.maxAbs, tol.maxAbs)
+                      && withinTolerance(m.rms, tol.rms)
+                      && withinTolerance(m.spectralDb, tol.spectralDb)
+                      && withinTolerance(m.levelDb, tol.levelDb);
+            if (! ok)
+                ++failures;
+
+            std::cout << (ok ? "ok      " : "FAIL    ") << std::left << std::setw(64) << label.toStdString()
+                      << std::right << std::scientific << std::setprecision(2)
+                      << " maxAbs " << m.maxAbs << "  rms " << m.rms
+                      << std::fixed << std::setprecision(3)
+                      << "  spec " << m.spectralDb << " dB  level " << m.levelDb << " dB"
+                      << (c.stochastic ? "  (statistical)" : "") << std::endl;
+        }
+    }
+
+    fixtureAudio.deleteFile();
+
+    if (update)
+    {
+        std::cout << "References written to " << refDir.getFullPathName() << std::endl;
+        return failures == 0 ? 0 : 1;
+    }
+
+    std::cout << checked - failures << "/" << checked << " cases within tolerance" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
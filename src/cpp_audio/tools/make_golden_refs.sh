@@ -0,0 +1,36 @@
+#!/usr/bin/env bash
+set -e
+
+# make_golden_refs.sh - Regenerate the SynthGoldenCheck reference renders
+# Builds SynthGoldenCheck from a known-good commit in a temporary worktree and
+# writes its renders to src/cpp_audio/golden_refs, ready to be committed.
+#
+# Usage: src/cpp_audio/tools/make_golden_refs.sh [COMMIT]
+# COMMIT defaults to the commit that added the check, which predates every
+# DSP rewrite it guards.
+
+REPO_ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/../../.." && pwd)"
+cd "$REPO_ROOT"
+
+REF_COMMIT="${1:-$(git log --diff-filter=A --format=%H -- src/cpp_audio/tools/golden_check.cpp | tail -n 1)}"
+REF_DIR="$REPO_ROOT/src/cpp_audio/golden_refs"
+JUCE_DIR="$REPO_ROOT/src/cpp_audio/JUCE"
+
+if [ ! -d "$JUCE_DIR" ]; then
+    echo "JUCE not found at $JUCE_DIR (run setup.sh first)" >&2
+    exit 1
+fi
+
+WORKTREE="$(mktemp -d)"
+trap 'git worktree remove --force "$WORKTREE"' EXIT
+git worktree add --detach "$WORKTREE" "$REF_COMMIT"
+ln -s "$JUCE_DIR" "$WORKTREE/src/cpp_audio/JUCE"
+
+cmake -S "$WORKTREE" -B "$WORKTREE/build" -DCMAKE_BUILD_TYPE=Release
+cmake --build "$WORKTREE/build" --target SynthGoldenCheck --config Release
+
+rm -rf "$REF_DIR"
+"$WORKTREE/build/SynthGoldenCheck" --update --refs "$REF_DIR"
+git rev-parse "$REF_COMMIT" > "$REF_DIR/COMMIT"
+
+echo "References from $REF_COMMIT written to $REF_DIR"
@@ -0,0 +1,214 @@
+#include <juce_audio_devices/juce_audio_devices.h>
+#include <juce_core/juce_core.h>
+#include "core/AudioUtils.h"
+#include "core/BufferAudioSource.h"
+#include "core/LivePreviewSource.h"
+#include "core/OfflineAudioDevice.h"
+#include "core/RealtimePlayer.h"
+#include "core/RealtimeSafety.h"
+#include "core/StreamingStepSource.h"
+#include "core/Track.h"
+#include <iostream>
+
+// Drives the audio callbacks through an OfflineAudioDevice for a given
+// amount of audio time with the realtime-safety hooks linked in. It exits
+// non-zero if any callback allocates or frees memory, or takes a mutex when
+// --fail-on-locks is given. Covered:
+//   * RealtimePlayer::audioDeviceIOCallback
+//   * BufferAudioSource -> AudioTransportSource -> AudioSourcePlayer
+//   * StreamingStepSource -> AudioTransportSource -> AudioSourcePlayer
+//     (the StepPreviewer transport chain)
+//   * LivePreviewSource -> AudioTransportSource -> AudioSourcePlayer, with
+//     parameter edits queued halfway through (live-edit preview)
+
+namespace
+{
+    struct CheckOptions
+    {
+        double minutes { 1.0 };
+        double speed { 8.0 };
+        double sampleRate { 44100.0 };
+        int bufferSize { 512 };
+        bool failOnLocks { false };
+        juce::File trackFile;
+    };
+
+    Track makeCheckTrack(double sampleRate)
+    {
+        Track track;
+        track.settings.sampleRate = sampleRate;
+        track.settings.crossfadeDuration = 0.0;
+        const char* synths[] = { "binaural_beat", "isochronic_tone", "qam_beat" };
+        for (int s = 0; s < 3; ++s)
+        {
+            Step step;
+            step.durationSeconds = 20.0;
+            Voice voice;
+            voice.synthFunction = synths[s];
+            step.voices.push_back(voice);
+            track.steps.push_back(step);
+        }
+        return track;
+    }
+
+    int blocksFor(const CheckOptions& o, double minutes)
+    {
+        return static_cast<int>(minutes * 60.0 * o.sampleRate / o.bufferSize);
+    }
+
+    void runRealtimePlayer(const CheckOptions& o, Track track)
+    {
+        OfflineAudioDevice device(o.sampleRate, o.bufferSize);
+        RealtimePlayer player(std::move(track));
+        device.start(&player);
+        device.processBlocks(blocksFor(o, o.minutes), o.speed);
+        device.stop();
+    }
+
+    void runTransportChain(const CheckOptions& o, juce::PositionableAudioSource& source,
+                           std::function<void()> midway = nullptr)
+    {
+        juce::AudioTransportSource transport;
+        transport.setSource(&source, 0, nullptr, o.sampleRate);
+        juce::AudioSourcePlayer player;
+        player.setSource(&transport);
+
+        OfflineAudioDevice device(o.sampleRate, o.bufferSize);
+        device.start(&player);
+        transport.start();
+
+        // Lazy first-callback setup inside JUCE is not ours to fix; run one
+        // block before counting.
+        device.processBlocks(1);
+        clearRealtimeViolations();
+        int blocks = blocksFor(o, o.minutes);
+        device.processBlocks(blocks / 2, o.speed);
+        if (midway)
+            midway();
+        device.processBlocks(blocks - blocks / 2, o.speed);
+
+        transport.stop();
+        device.stop();
+        player.setSource(nullptr);
+        transport.setSource(nullptr);
+    }
+
+    int report(const juce::String& name, bool failOnLocks)
+    {
+        using Kind = RealtimeViolation::Kind;
+        int allocs = getRealtimeViolationCount(Kind::allocation);
+        int frees = getRealtimeViolationCount(Kind::deallocation);
+        int locks = getRealtimeViolationCount(Kind::lock);
+        bool failed = allocs > 0 || frees > 0 || (failOnLocks && locks > 0);
+
+        std::cout << (failed ? "FAIL " : "ok   ") << name
+                  << "  allocations " << allocs << "  frees " << frees
+                  << "  locks " << locks << std::endl;
+
+        for (const auto& v : getRecordedRealtimeViolations())
+        {
+            if (v.kind == Kind::lock && ! failOnLocks && ! failed)
+                continue;
+            std::cout << "  -- " << realtimeViolationKindToString(v.kind) << " at:\n"
+                      << v.stack << std::endl;
+        }
+
+        clearRealtimeViolations();
+        return failed ? 1 : 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    CheckOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        juce::String arg (argv[i]);
+        bool hasValue = i + 1 < argc;
+        if (arg == "--minutes" && hasValue)
+            options.minutes = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--speed" && hasValue)
+            options.speed = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--sample-rate" && hasValue)
+            options.sampleRate = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--buffer-size" && hasValue)
+            options.bufferSize = juce::jmax(16, juce::String(argv[++i]).getIntValue());
+        else if (arg == "--track" && hasValue)
+            options.trackFile = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+        else if (arg == "--fail-on-locks")
+            options.failOnLocks = true;
+        else
+        {
+            std::cout << "Usage: realtime_safety_check [--minutes N] [--speed X] [--track file.json]\n"
+                         "                             [--sample-rate SR] [--buffer-size N] [--fail-on-locks]\n"
+                         "  --speed 0 runs callbacks back to back (no pacing)" << std::endl;
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    Track track;
+    if (options.trackFile != juce::File())
+    {
+        if (! options.trackFile.existsAsFile())
+        {
+            std::cerr << "Track file not found: " << options.trackFile.getFullPathName() << std::endl;
+            return 1;
+        }
+        track = loadTrackFromJson(options.trackFile);
+        track.settings.sampleRate = options.sampleRate;
+    }
+    else
+    {
+        track = makeCheckTrack(options.sampleRate);
+    }
+
+    int failures = 0;
+
+    clearRealtimeViolations();
+    runRealtimePlayer(options, std::move(track));
+    failures += report("RealtimePlayer", options.failOnLocks);
+
+    {
+        BufferAudioSource source;
+        source.setBuffer(generateSine(220.0, 0.5, 10.0, options.sampleRate));
+        source.setLooping(true);
+        runTransportChain(options, source);
+        failures += report("BufferAudioSource/AudioTransportSource", options.failOnLocks);
+    }
+
+    {
+        // Long enough that the preview is still rendering while it plays.
+        Track previewTrack = makeCheckTrack(options.sampleRate);
+        Step step = previewTrack.steps.front();
+        step.durationSeconds = options.minutes * 60.0;
+        StreamingStepSource source(step, options.sampleRate, options.minutes * 60.0);
+        source.setLooping(true);
+        while (! source.isReady())
+            juce::Thread::sleep(1);
+        runTransportChain(options, source);
+        failures += report("StreamingStepSource/AudioTransportSource", options.failOnLocks);
+    }
+
+    {
+        Step step;
+        step.durationSeconds = options.minutes * 60.0;
+        Voice voice;
+        voice.synthFunction = "binaural_beat";
+        step.voices.push_back(voice);
+        step.voices.push_back(voice);
+        LivePreviewSource source(step, options.sampleRate, step.durationSeconds);
+        runTransportChain(options, source, [&source]
+        {
+            for (int v = 0; v < 2; ++v)
+            {
+                source.setParameter(v, "baseFreq", 150.0 + 50.0 * v);
+                source.setParameter(v, "beatFreq", 7.0);
+                source.setParameter(v, "ampL", 0.3);
+                source.setParameter(v, "ampOscDepthR", 0.5);
+            }
+        });
+        failures += report("LivePreviewSource/AudioTransportSource", options.failOnLocks);
+    }
+
+    return failures == 0 ? 0 : 1;
+}
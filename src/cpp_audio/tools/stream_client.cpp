@@ -0,0 +1,399 @@
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Test client for render_server. Posts a track, streams it back on one or
+// more concurrent sessions and reports the time to first byte and the
+// throughput of each. With --controls it instead checks that stop, seek,
+// start and delete take effect on a live stream.
+// Exits with a non-zero status if a stream ends short or a check fails.
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr int ioTimeoutMs = 10000;
+    constexpr int bytesPerFrame = 4;   // 16-bit stereo
+
+    struct Options
+    {
+        juce::String host { "127.0.0.1" };
+        int port { 8765 };
+        int listeners { 1 };
+        double seconds { 0.0 };        // audio to read per listener; 0 = whole track
+        bool controls { false };
+    };
+
+    double msSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    /** Buffered reads from a socket; every wait times out. */
+    class SocketReader
+    {
+    public:
+        explicit SocketReader(juce::StreamingSocket& s) : socket(s) {}
+
+        /** Reads a CRLF-terminated line, without the terminator. */
+        bool readLine(juce::String& line)
+        {
+            std::string text;
+            for (;;)
+            {
+                if (start == end && ! fill())
+                    return false;
+                char c = buffer[start++];
+                if (c == '\n')
+                    break;
+                if (c != '\r')
+                    text += c;
+            }
+            line = juce::String(text);
+            return true;
+        }
+
+        /** Reads up to @p maxBytes; 0 at the end of the connection. */
+        int read(char* dest, int maxBytes)
+        {
+            if (start == end && ! fill())
+                return 0;
+            int n = std::min(maxBytes, static_cast<int>(end - start));
+            std::copy(buffer.data() + start, buffer.data() + start + n, dest);
+            start += static_cast<size_t>(n);
+            return n;
+        }
+
+    private:
+        bool fill()
+        {
+            if (socket.waitUntilReady(true, ioTimeoutMs) != 1)
+                return false;
+            int n = socket.read(buffer.data(), static_cast<int>(buffer.size()), false);
+            if (n <= 0)
+                return false;
+            start = 0;
+            end = static_cast<size_t>(n);
+            return true;
+        }
+
+        juce::StreamingSocket& socket;
+        std::vector<char> buffer = std::vector<char>(64 * 1024);
+        size_t start = 0, end = 0;
+    };
+
+    /** Connects, sends a request and reads the status line and headers.
+        @return the status, or 0 if the server could not be reached. */
+    int openRequest(const Options& options, juce::StreamingSocket& socket, SocketReader& reader,
+                    const juce::String& method, const juce::String& target,
+                    const juce::String& body, juce::int64& contentLength)
+    {
+        if (! socket.connect(options.host, options.port, ioTimeoutMs))
+            return 0;
+
+        juce::String request;
+        request << method << " " << target << " HTTP/1.1\r\n"
+                << "Host: " << options.host << ":" << options.port << "\r\n"
+                << "Content-Length: " << static_cast<int>(body.getNumBytesAsUTF8()) << "\r\n"
+                << "Connection: close\r\n\r\n"
+                << body;
+        const int size = static_cast<int>(request.getNumBytesAsUTF8());
+        if (socket.write(request.toRawUTF8(), size) != size)
+            return 0;
+
+        juce::String line;
+        if (! reader.readLine(line))
+            return 0;
+        const int status = line.fromFirstOccurrenceOf(" ", false, false).getIntValue();
+
+        contentLength = -1;
+        while (reader.readLine(line) && line.isNotEmpty())
+            if (line.upToFirstOccurrenceOf(":", false, false).trim().equalsIgnoreCase("content-length"))
+                contentLength = line.fromFirstOccurrenceOf(":", false, false).trim().getLargeIntValue();
+        return status;
+    }
+
+    /** A whole request/response with a JSON reply. */
+    int request(const Options& options, const juce::String& method, const juce::String& target,
+                juce::var& reply, const juce::String& body = {})
+    {
+        juce::StreamingSocket socket;
+        SocketReader reader(socket);
+        juce::int64 contentLength = -1;
+        int status = openRequest(options, socket, reader, method, target, body, contentLength);
+        if (status == 0)
+            return 0;
+
+        std::string text;
+        char chunk[4096];
+        while (contentLength < 0 || static_cast<juce::int64>(text.size()) < contentLength)
+        {
+            int n = reader.read(chunk, sizeof(chunk));
+            if (n <= 0)
+                break;
+            text.append(chunk, static_cast<size_t>(n));
+        }
+        reply = juce::JSON::parse(juce::String::fromUTF8(text.data(), static_cast<int>(text.size())));
+        return status;
+    }
+
+    struct StreamResult
+    {
+        bool connected { false };
+        bool cleanEnd { false };           // saw the last chunk
+        double firstByteMs { -1.0 };       // from sending the request to the first audio byte
+        double totalMs { 0.0 };
+        juce::int64 bytes { 0 };
+    };
+
+    /** Reads a session's stream until it ends, @p maxBytes have arrived
+        (if positive) or @p stop is set. @p received is kept up to date. */
+    StreamResult readStream(const Options& options, const juce::String& id, juce::int64 maxBytes,
+                            std::atomic<juce::int64>* received = nullptr,
+                            const std::atomic<bool>* stop = nullptr)
+    {
+        StreamResult result;
+        const auto startTime = Clock::now();
+        juce::StreamingSocket socket;
+        SocketReader reader(socket);
+        juce::int64 ignored;
+        if (openRequest(options, socket, reader, "GET", "/sessions/" + id + "/stream", {}, ignored) != 200)
+            return result;
+        result.connected = true;
+
+        std::vector<char> scratch(64 * 1024);
+        juce::String line;
+        while (stop == nullptr || ! stop->load())
+        {
+            if (! reader.readLine(line))
+                break;
+            const juce::int64 size = line.upToFirstOccurrenceOf(";", false, false).trim().getHexValue64();
+            if (size == 0)
+            {
+                result.cleanEnd = true;
+                break;
+            }
+
+            for (juce::int64 left = size; left > 0;)
+            {
+                int n = reader.read(scratch.data(), static_cast<int>(std::min<juce::int64>(left, scratch.size())));
+                if (n <= 0)
+                    break;
+                if (result.firstByteMs < 0.0)
+                    result.firstByteMs = msSince(startTime);
+                left -= n;
+                result.bytes += n;
+                if (received != nullptr)
+                    received->store(result.bytes);
+            }
+            if (! reader.readLine(line) || (maxBytes > 0 && result.bytes >= maxBytes))
+                break;
+        }
+        result.totalMs = msSince(startTime);
+        return result;
+    }
+
+    struct Session
+    {
+        juce::String id;
+        double sampleRate { 44100.0 };
+        double durationSeconds { 0.0 };
+    };
+
+    bool createSession(const Options& options, const juce::String& trackJson, Session& session)
+    {
+        juce::var reply;
+        int status = request(options, "POST", "/sessions", reply, trackJson);
+        if (status != 201)
+        {
+            std::cerr << "Creating a session failed (" << status << "): "
+                      << reply.getProperty("error", "no reply").toString() << std::endl;
+            return false;
+        }
+        session.id = reply.getProperty("id", {}).toString();
+        session.sampleRate = reply.getProperty("sample_rate", 44100.0);
+        session.durationSeconds = reply.getProperty("duration_seconds", 0.0);
+        return true;
+    }
+
+    int runThroughput(const Options& options, const juce::String& trackJson)
+    {
+        std::vector<Session> sessions(static_cast<size_t>(options.listeners));
+        const auto createStart = Clock::now();
+        for (auto& session : sessions)
+            if (! createSession(options, trackJson, session))
+                return 1;
+        const double createMs = msSince(createStart) / options.listeners;
+
+        std::vector<StreamResult> results(sessions.size());
+        std::vector<std::thread> threads;
+        const auto start = Clock::now();
+        for (size_t i = 0; i < sessions.size(); ++i)
+        {
+            threads.emplace_back([&, i] {
+                const auto maxBytes = static_cast<juce::int64>(options.seconds * sessions[i].sampleRate) * bytesPerFrame;
+                results[i] = readStream(options, sessions[i].id, maxBytes);
+            });
+        }
+        for (auto& t : threads)
+            t.join();
+        const double wallSeconds = msSince(start) / 1000.0;
+
+        int failures = 0;
+        double audioSeconds = 0.0;
+        std::vector<double> firstByte;
+        std::cout << std::fixed << std::setprecision(2)
+                  << "Session setup: " << createMs << " ms each" << std::endl;
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const auto& r = results[i];
+            const auto& s = sessions[i];
+            const double seconds = static_cast<double>(r.bytes / bytesPerFrame) / s.sampleRate;
+            const double expected = options.seconds > 0.0 ? std::min(options.seconds, s.durationSeconds)
+                                                          : s.durationSeconds;
+            const bool ok = r.connected && r.bytes % bytesPerFrame == 0
+                            && seconds >= expected - 0.01 * expected - 0.1;
+            failures += ok ? 0 : 1;
+            audioSeconds += seconds;
+            if (r.firstByteMs >= 0.0)
+                firstByte.push_back(r.firstByteMs);
+
+            std::cout << (ok ? "ok   " : "FAIL ") << "listener " << i + 1
+                      << ": first byte " << r.firstByteMs << " ms, "
+                      << seconds << " s of audio in " << r.totalMs / 1000.0 << " s ("
+                      << (r.totalMs > 0.0 ? seconds * 1000.0 / r.totalMs : 0.0) << "x realtime, "
+                      << (r.totalMs > 0.0 ? r.bytes / (r.totalMs * 1000.0) : 0.0) << " MB/s)" << std::endl;
+        }
+
+        if (! firstByte.empty())
+        {
+            std::sort(firstByte.begin(), firstByte.end());
+            std::cout << "First byte min/median/max: " << firstByte.front() << " / "
+                      << firstByte[firstByte.size() / 2] << " / " << firstByte.back() << " ms" << std::endl;
+        }
+        std::cout << "Total: " << audioSeconds << " s of audio in " << wallSeconds << " s ("
+                  << (wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0) << "x realtime across "
+                  << options.listeners << " listener" << (options.listeners == 1 ? "" : "s") << ")" << std::endl;
+
+        for (const auto& s : sessions)
+        {
+            juce::var reply;
+            request(options, "DELETE", "/sessions/" + s.id, reply);
+        }
+        return failures == 0 ? 0 : 1;
+    }
+
+    bool waitFor(const std::function<bool()>& condition, int timeoutMs)
+    {
+        const auto start = Clock::now();
+        while (! condition())
+        {
+            if (msSince(start) > timeoutMs)
+                return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return true;
+    }
+
+    int runControls(const Options& options, const juce::String& trackJson)
+    {
+        Session session;
+        if (! createSession(options, trackJson, session))
+            return 1;
+        if (session.durationSeconds < 2.0)
+        {
+            std::cerr << "The control checks need a track of at least 2 seconds" << std::endl;
+            return 1;
+        }
+
+        int failures = 0;
+        auto check = [&](bool ok, const char* what) {
+            std::cout << (ok ? "ok   " : "FAIL ") << what << std::endl;
+            failures += ok ? 0 : 1;
+        };
+
+        const juce::String base = "/sessions/" + session.id;
+        juce::var reply;
+        check(request(options, "POST", base + "/stop", reply) == 200, "stop before listening");
+
+        std::atomic<juce::int64> received { 0 };
+        std::atomic<bool> stopReading { false };
+        StreamResult result;
+        std::thread reader([&] { result = readStream(options, session.id, 0, &received, &stopReading); });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        check(received.load() == 0, "a stopped session sends no audio");
+
+        const double target = session.durationSeconds / 2.0;
+        check(request(options, "POST", base + "/seek?t=" + juce::String(target), reply) == 200, "seek");
+
+        check(request(options, "POST", base + "/start", reply) == 200, "start");
+        check(waitFor([&] { return received.load() > 0; }, ioTimeoutMs), "audio arrives after start");
+
+        request(options, "GET", base, reply);
+        const double position = reply.getProperty("position_seconds", 0.0);
+        check(position >= target - 0.01, "playback carries on from the seek position");
+
+        check(request(options, "DELETE", base, reply) == 200, "delete");
+        std::atomic<bool> done { false };
+        std::thread watcher([&] { reader.join(); done = true; });
+        bool ended = waitFor([&] { return done.load(); }, 2000);
+        if (! ended)
+            stopReading = true;
+        watcher.join();
+        check(ended && result.cleanEnd, "delete ends the stream cleanly");
+        check(request(options, "GET", base, reply) == 404, "a deleted session is gone");
+
+        return failures == 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    juce::File trackFile;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        juce::String arg (argv[i]);
+        if (arg == "--host" && i + 1 < argc)
+            options.host = argv[++i];
+        else if (arg == "--port" && i + 1 < argc)
+            options.port = juce::String(argv[++i]).getIntValue();
+        else if (arg == "--listeners" && i + 1 < argc)
+            options.listeners = juce::jmax(1, juce::String(argv[++i]).getIntValue());
+        else if (arg == "--seconds" && i + 1 < argc)
+            options.seconds = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--controls")
+            options.controls = true;
+        else if (! arg.startsWith("-") && trackFile == juce::File())
+            trackFile = juce::File::getCurrentWorkingDirectory().getChildFile(arg);
+        else
+        {
+            std::cout << "Usage: stream_client <track.json> [--host H] [--port N]\n"
+                         "                     [--listeners N] [--seconds S] [--controls]" << std::endl;
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (trackFile == juce::File())
+    {
+        std::cout << "Usage: stream_client <track.json> [--host H] [--port N]\n"
+                     "                     [--listeners N] [--seconds S] [--controls]" << std::endl;
+        return 1;
+    }
+    if (! trackFile.existsAsFile())
+    {
+        std::cerr << "Track file not found: " << trackFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    const juce::String trackJson = trackFile.loadFileAsString();
+    return options.controls ? runControls(options, trackJson) : runThroughput(options, trackJson);
+}
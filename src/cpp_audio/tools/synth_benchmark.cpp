@@ -0,0 +1,556 @@
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_core/juce_core.h>
+#include "core/AudioUtils.h"
+#include "core/Common.h"
+#include "core/Kernels.h"
+#include "core/Trace.h"
+#include "core/Track.h"
+#include "tools/SynthCases.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+ #include <psapi.h>
+#else
+ #include <sys/resource.h>
+#endif
+
+// Micro-benchmarks for every registered synth plus the mixer, crossfade,
+// transition curves, JSON loading, the Common.cpp filters and the DSP
+// kernels at every SIMD level the CPU supports. Results are
+// printed as a table and optionally written as JSON so runs can be compared
+// across commits.
+
+//==============================================================================
+// Global allocation counter. Only this executable replaces the allocator, so
+// the engine code is measured exactly as it ships.
+static std::atomic<long long> allocationCount { 0 };
+static std::atomic<long long> allocatedBytes { 0 };
+
+static void countAllocation(std::size_t size) noexcept
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(static_cast<long long>(size), std::memory_order_relaxed);
+}
+
+#if defined(__GLIBC__)
+
+// glibc: interpose the malloc family, as core/RealtimeSafetyHooks.cpp does,
+// so JUCE's HeapBlock (malloc/realloc) is counted along with operator new,
+// which ends up here too.
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+
+    void* malloc(size_t size)
+    {
+        countAllocation(size);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        countAllocation(count * size);
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* ptr, size_t size)
+    {
+        countAllocation(size);
+        return __libc_realloc(ptr, size);
+    }
+}
+
+#else
+
+// Other platforms: only operator new is counted; malloc and realloc calls
+// (JUCE's HeapBlock) are not.
+void* operator new (std::size_t size)
+{
+    countAllocation(size);
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    return operator new (size);
+}
+
+void operator delete (void* p) noexcept { std::free(p); }
+void operator delete[] (void* p) noexcept { std::free(p); }
+void operator delete (void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[] (void* p, std::size_t) noexcept { std::free(p); }
+
+#endif
+
+static long long getPeakRssKb()
+{
+#if JUCE_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return static_cast<long long>(counters.PeakWorkingSetSize / 1024);
+    return 0;
+#else
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+   #if JUCE_MAC
+    return static_cast<long long>(usage.ru_maxrss / 1024); // bytes on macOS
+   #else
+    return static_cast<long long>(usage.ru_maxrss);        // kilobytes on Linux
+   #endif
+#endif
+}
+
+//==============================================================================
+struct BenchmarkResult
+{
+    juce::String name;
+    juce::String category;
+    juce::String unit;              // what "items" counts: frames, steps, ...
+    double itemsPerIteration { 0.0 };
+    double audioSecondsPerIteration { 0.0 };
+    double medianSeconds { 0.0 };
+    double minSeconds { 0.0 };
+    double allocationsPerIteration { 0.0 };
+    double bytesPerIteration { 0.0 };
+    long long peakRssKb { 0 };
+
+    double itemsPerSecond() const  { return medianSeconds > 0.0 ? itemsPerIteration / medianSeconds : 0.0; }
+    double timesRealtime() const   { return medianSeconds > 0.0 ? audioSecondsPerIteration / medianSeconds : 0.0; }
+};
+
+struct BenchmarkOptions
+{
+    int iterations { 5 };
+    double sampleRate { 44100.0 };
+    juce::String filter;
+    juce::File jsonOutput;
+    juce::File traceOutput;
+    bool jsonToStdout { false };
+    juce::String label;
+};
+
+class BenchmarkRunner
+{
+public:
+    explicit BenchmarkRunner(const BenchmarkOptions& o) : options(o) {}
+
+    /** Times @p body over the configured number of iterations after one
+        untimed warm-up run. */
+    void run(const juce::String& name, const juce::String& category,
+             const juce::String& unit, double items, double audioSeconds,
+             const std::function<void()>& body)
+    {
+        if (options.filter.isNotEmpty() && ! name.containsIgnoreCase(options.filter))
+            return;
+
+        body(); // warm-up: page in code, prime caches and lazy statics
+
+        std::vector<double> times;
+        times.reserve(static_cast<size_t>(options.iterations));
+        long long allocStart = allocationCount.load();
+        long long bytesStart = allocatedBytes.load();
+
+        for (int i = 0; i < options.iterations; ++i)
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            body();
+            auto t1 = std::chrono::steady_clock::now();
+            times.push_back(std::chrono::duration<double>(t1 - t0).count());
+        }
+
+        long long allocs = allocationCount.load() - allocStart;
+        long long bytes = allocatedBytes.load() - bytesStart;
+        std::sort(times.begin(), times.end());
+
+        BenchmarkResult r;
+        r.name = name;
+        r.category = category;
+        r.unit = unit;
+        r.itemsPerIteration = items;
+        r.audioSecondsPerIteration = audioSeconds;
+        r.medianSeconds = times[times.size() / 2];
+        r.minSeconds = times.front();
+        r.allocationsPerIteration = static_cast<double>(allocs) / options.iterations;
+        r.bytesPerIteration = static_cast<double>(bytes) / options.iterations;
+        r.peakRssKb = getPeakRssKb();
+        results.push_back(r);
+
+        if (! options.jsonToStdout)
+            printRow(r);
+    }
+
+    const std::vector<BenchmarkResult>& getResults() const { return results; }
+
+    static void printHeader()
+    {
+        std::cout << std::left << std::setw(58) << "benchmark"
+                  << std::right << std::setw(12) << "median ms"
+                  << std::setw(16) << "items/s"
+                  << std::setw(10) << "x rt"
+                  << std::setw(12) << "allocs"
+                  << std::setw(12) << "peak KB" << std::endl;
+    }
+
+private:
+    static void printRow(const BenchmarkResult& r)
+    {
+        std::cout << std::left << std::setw(58) << r.name.toStdString()
+                  << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << r.medianSeconds * 1000.0
+                  << std::setprecision(0) << std::setw(16) << r.itemsPerSecond()
+                  << std::setprecision(1) << std::setw(10) << r.timesRealtime()
+                  << std::setprecision(0) << std::setw(12) << r.allocationsPerIteration
+                  << std::setw(12) << r.peakRssKb << std::endl;
+    }
+
+    BenchmarkOptions options;
+    std::vector<BenchmarkResult> results;
+};
+
+//==============================================================================
+static Track makeSyntheticTrack(int numSteps, double stepDuration, double sampleRate)
+{
+    static const char* const synths[] = { "binaural_beat", "isochronic_tone",
+                                          "qam_beat", "monaural_beat_stereo_amps" };
+    Track track;
+    track.settings.sampleRate = sampleRate;
+    track.settings.crossfadeDuration = 1.0;
+    track.settings.crossfadeCurve = "equal_power";
+
+    for (int s = 0; s < numSteps; ++s)
+    {
+        Step step;
+        step.durationSeconds = stepDuration;
+        for (int v = 0; v < 2; ++v)
+        {
+            Voice voice;
+            voice.synthFunction = synths[(s + v) % 4];
+            voice.params.set("baseFreq", 150.0 + 25.0 * s);
+            voice.params.set("beatFreq", 4.0 + v);
+            step.voices.push_back(std::move(voice));
+        }
+        track.steps.push_back(std::move(step));
+    }
+    return track;
+}
+
+static void runSynthBenchmarks(BenchmarkRunner& runner, const BenchmarkOptions& options,
+                               const juce::File& fixtureAudio)
+{
+    for (const auto& c : getRepresentativeSynthCases(fixtureAudio))
+    {
+        SynthFunc fn = findSynthFunction(c.synth);
+        if (fn == nullptr)
+        {
+            std::cerr << "Unknown synth in case table: " << c.synth << std::endl;
+            continue;
+        }
+
+        double frames = std::floor(c.durationSeconds * options.sampleRate);
+        runner.run("synth/" + c.name, "synth", "frames", frames, c.durationSeconds,
+                   [&] { juce::ignoreUnused(fn(c.durationSeconds, options.sampleRate, c.params)); });
+    }
+}
+
+static void runMixerBenchmarks(BenchmarkRunner& runner, const BenchmarkOptions& options,
+                               const juce::File& tempDir)
+{
+    const double sr = options.sampleRate;
+
+    // crossfade -----------------------------------------------------------
+    {
+        const double fadeSeconds = 5.0;
+        auto a = generateSine(200.0, 0.5, fadeSeconds, sr);
+        auto b = generateSine(210.0, 0.5, fadeSeconds, sr);
+        double frames = a.getNumSamples();
+        for (const char* curve : { "linear", "equal_power", "s_curve" })
+            runner.run(juce::String("crossfade/") + curve, "mixer", "frames", frames, fadeSeconds,
+                       [&] { juce::ignoreUnused(crossfade(a, b, fadeSeconds, sr, curve)); });
+
+        // The kernel assembleTrack uses: no allocation once the table is sized.
+        juce::AudioBuffer<float> out(a);
+        CrossfadeTable table(CrossfadeCurve::equalPower);
+        runner.run("crossfade_in_place/equal_power", "mixer", "frames", frames, fadeSeconds,
+                   [&] { crossfadeInPlace(out, 0, b, 0, a.getNumSamples(), table); });
+
+        for (double windowMs : { 25.0, 250.0 })
+        {
+            int maxOffset = static_cast<int>(windowMs * 0.001 * sr);
+            runner.run("splice_search/" + juce::String(static_cast<int>(windowMs)) + "ms", "mixer", "frames",
+                       frames, fadeSeconds,
+                       [&] { juce::ignoreUnused(findSpliceOffset(a, 0, b, a.getNumSamples() - maxOffset, maxOffset)); });
+        }
+    }
+
+    // calculateTransitionAlpha -------------------------------------------
+    {
+        const double seconds = 60.0;
+        double frames = std::floor(seconds * sr);
+        for (const char* curve : { "linear", "logarithmic", "exponential" })
+            runner.run(juce::String("transition_alpha/") + curve, "mixer", "frames", frames, seconds,
+                       [&] { juce::ignoreUnused(calculateTransitionAlpha(seconds, sr, 2.0, 2.0, curve)); });
+    }
+
+    // assembleTrack ------------------------------------------------------
+    for (int numSteps : { 4, 12 })
+    {
+        Track track = makeSyntheticTrack(numSteps, 10.0, sr);
+        double seconds = numSteps * 10.0 - (numSteps - 1) * track.settings.crossfadeDuration;
+        runner.run("assemble_track/" + juce::String(numSteps) + "_steps", "mixer", "frames",
+                   std::floor(seconds * sr), seconds,
+                   [&] { juce::ignoreUnused(assembleTrack(track)); });
+
+        track.settings.renderQuality = "draft";
+        runner.run("assemble_track/" + juce::String(numSteps) + "_steps_draft", "mixer", "frames",
+                   std::floor(seconds * sr), seconds,
+                   [&] { juce::ignoreUnused(assembleTrack(track)); });
+    }
+
+    // loadTrackFromJson --------------------------------------------------
+    {
+        Track track = makeSyntheticTrack(200, 30.0, sr);
+        juce::File jsonFile = tempDir.getChildFile("benchmark_track.json");
+        if (saveTrackToJson(track, jsonFile))
+            runner.run("load_track_json/200_steps", "io", "steps", 200.0, 0.0,
+                       [&] { juce::ignoreUnused(loadTrackFromJson(jsonFile)); });
+    }
+}
+
+static void runFilterBenchmarks(BenchmarkRunner& runner, const BenchmarkOptions& options)
+{
+    const double sr = options.sampleRate;
+    const double seconds = 10.0;
+    const int n = static_cast<int>(seconds * sr);
+
+    std::vector<double> t(static_cast<size_t>(n));
+    for (int i = 0; i < n; ++i)
+        t[static_cast<size_t>(i)] = i / sr;
+    std::vector<double> signal = sineWave(220.0, t);
+    for (size_t i = 0; i < signal.size(); ++i)
+        signal[i] += 0.3 * std::sin(2.0 * juce::MathConstants<double>::pi * 3100.0 * t[i]);
+
+    runner.run("common/bandpass_filter", "filter", "frames", n, seconds,
+               [&] { juce::ignoreUnused(bandpassFilter(signal, 1000.0, 2.0, sr)); });
+    runner.run("common/bandreject_filter", "filter", "frames", n, seconds,
+               [&] { juce::ignoreUnused(bandrejectFilter(signal, 1000.0, 2.0, sr)); });
+    runner.run("common/lowpass_filter", "filter", "frames", n, seconds,
+               [&] { juce::ignoreUnused(lowpassFilter(signal, 2000.0, sr)); });
+    runner.run("common/apply_filters", "filter", "frames", n, seconds,
+               [&] { juce::ignoreUnused(applyFilters(signal, sr)); });
+
+    // The same high-pass and low-pass run in place, a block at a time.
+    std::vector<float> block(signal.begin(), signal.end());
+    runner.run("common/biquad_cascade_blocks", "filter", "frames", n, seconds, [&] {
+        BiquadCascade filters;
+        filters.add(Biquad::highPass(30.0, sr));
+        filters.add(Biquad::lowPass(sr * 0.45, sr));
+        for (int start = 0; start < n; start += 512)
+            filters.process(block.data() + start, std::min(512, n - start));
+    });
+    runner.run("common/pink_noise", "filter", "frames", n, seconds,
+               [&] { juce::ignoreUnused(pinkNoise(n)); });
+    runner.run("common/brown_noise", "filter", "frames", n, seconds,
+               [&] { juce::ignoreUnused(brownNoise(n)); });
+}
+
+static void runKernelBenchmarks(BenchmarkRunner& runner, const BenchmarkOptions& options)
+{
+    const double sr = options.sampleRate;
+    const double seconds = 10.0;
+    const int n = static_cast<int>(seconds * sr);
+
+    std::vector<float> src(static_cast<size_t>(n)), out(src.size()), left(src.size()), right(src.size());
+    std::vector<float> fadeIn(src.size()), fadeOut(src.size());
+    for (int i = 0; i < n; ++i)
+    {
+        src[static_cast<size_t>(i)] = static_cast<float>(std::sin(i * 0.01));
+        fadeIn[static_cast<size_t>(i)] = static_cast<float>(i) / static_cast<float>(n);
+        fadeOut[static_cast<size_t>(i)] = 1.0f - fadeIn[static_cast<size_t>(i)];
+    }
+    const auto lowPass = Biquad::lowPass(2000.0, sr);
+    const double coefficients[5] = { lowPass.b0, lowPass.b1, lowPass.b2, lowPass.a1, lowPass.a2 };
+    const double increment = juce::MathConstants<double>::twoPi * 440.0 / sr;
+
+    using Body = std::function<void(const DspKernels&)>;
+    const std::pair<const char*, Body> kernels[] = {
+        { "sine",            [&](const DspKernels& k) { k.sine(out.data(), 0.0, increment, n); } },
+        { "gain",            [&](const DspKernels& k) { k.applyGain(out.data(), 0.999f, n); } },
+        { "add_with_gain",   [&](const DspKernels& k) { k.addWithGain(out.data(), src.data(), 0.5f, n); } },
+        { "pan",             [&](const DspKernels& k) { k.pan(src.data(), left.data(), right.data(), 0.6f, 0.8f, n); } },
+        { "crossfade",       [&](const DspKernels& k) { k.crossfade(out.data(), src.data(), fadeOut.data(), fadeIn.data(), n); } },
+        { "biquad",          [&](const DspKernels& k) { double state[4] {}; k.biquad(out.data(), n, coefficients, state); } },
+        { "resample_linear", [&](const DspKernels& k) { k.resampleLinear(src.data(), n, out.data(), n / 2, 0.0, 1.5); } },
+    };
+
+    for (const auto& kernel : kernels)
+    {
+        for (int i = 0; i < static_cast<int>(SimdLevel::numLevels); ++i)
+        {
+            auto level = static_cast<SimdLevel>(i);
+            if (const DspKernels* k = getKernelsFor(level))
+                runner.run(juce::String("kernel/") + kernel.first + "/" + getSimdLevelName(level),
+                           "kernel", "frames", n, seconds, [&] { kernel.second(*k); });
+        }
+    }
+}
+
+/** For a kernel result, how many times faster it ran than the same kernel
+    at the scalar level; 0 for anything else. */
+static double speedupVsScalar(const std::vector<BenchmarkResult>& results, const BenchmarkResult& r)
+{
+    if (r.category != "kernel" || r.medianSeconds <= 0.0)
+        return 0.0;
+    const juce::String scalarName = r.name.upToLastOccurrenceOf("/", true, false)
+                                  + getSimdLevelName(SimdLevel::scalar);
+    for (const auto& other : results)
+        if (other.name == scalarName)
+            return other.medianSeconds / r.medianSeconds;
+    return 0.0;
+}
+
+static void printKernelSummary(const std::vector<BenchmarkResult>& results)
+{
+    std::cout << "\nSIMD level in use: " << getSimdLevelName(getSimdLevel())
+              << " (set DIY_AV_SIMD to force another)" << std::endl;
+    for (const auto& r : results)
+        if (double speedup = speedupVsScalar(results, r); speedup > 0.0)
+            std::cout << "  " << std::left << std::setw(40) << r.name.toStdString()
+                      << std::right << std::fixed << std::setprecision(2)
+                      << std::setw(8) << speedup << "x vs scalar" << std::endl;
+}
+
+//==============================================================================
+static juce::var resultsToJson(const std::vector<BenchmarkResult>& results,
+                               const BenchmarkOptions& options)
+{
+    auto* root = new juce::DynamicObject();
+    root->setProperty("label", options.label);
+    root->setProperty("timestamp", juce::Time::getCurrentTime().toISO8601(true));
+    root->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    root->setProperty("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty("sample_rate", options.sampleRate);
+    root->setProperty("iterations", options.iterations);
+    root->setProperty("simd_level", getSimdLevelName(getSimdLevel()));
+
+    juce::Array<juce::var> arr;
+    for (const auto& r : results)
+    {
+        auto* obj = new juce::DynamicObject();
+        obj->setProperty("name", r.name);
+        obj->setProperty("category", r.category);
+        obj->setProperty("unit", r.unit);
+        obj->setProperty("items_per_iteration", r.itemsPerIteration);
+        obj->setProperty("audio_seconds", r.audioSecondsPerIteration);
+        obj->setProperty("median_seconds", r.medianSeconds);
+        obj->setProperty("min_seconds", r.minSeconds);
+        obj->setProperty("items_per_second", r.itemsPerSecond());
+        obj->setProperty("times_realtime", r.timesRealtime());
+        obj->setProperty("allocations", r.allocationsPerIteration);
+        obj->setProperty("allocated_bytes", r.bytesPerIteration);
+        obj->setProperty("peak_rss_kb", static_cast<juce::int64>(r.peakRssKb));
+        if (double speedup = speedupVsScalar(results, r); speedup > 0.0)
+            obj->setProperty("speedup_vs_scalar", speedup);
+        arr.add(juce::var(obj));
+    }
+    root->setProperty("results", arr);
+    return juce::var(root);
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: synth_benchmark [--iterations N] [--sample-rate SR]\n"
+                 "                       [--filter TEXT] [--json FILE|-] [--label TEXT]\n"
+                 "                       [--trace FILE]\n";
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        juce::String arg (argv[i]);
+        bool hasValue = i + 1 < argc;
+        if (arg == "--iterations" && hasValue)
+            options.iterations = juce::jmax(1, juce::String(argv[++i]).getIntValue());
+        else if (arg == "--sample-rate" && hasValue)
+            options.sampleRate = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--filter" && hasValue)
+            options.filter = argv[++i];
+        else if (arg == "--label" && hasValue)
+            options.label = argv[++i];
+        else if (arg == "--trace" && hasValue)
+            options.traceOutput = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+        else if (arg == "--json" && hasValue)
+        {
+            juce::String target (argv[++i]);
+            if (target == "-")
+                options.jsonToStdout = true;
+            else
+                options.jsonOutput = juce::File::getCurrentWorkingDirectory().getChildFile(target);
+        }
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (options.sampleRate <= 0.0)
+    {
+        std::cerr << "Sample rate must be positive" << std::endl;
+        return 1;
+    }
+
+    juce::File tempDir = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                             .getChildFile("diy_av_benchmark");
+    tempDir.createDirectory();
+    juce::File fixtureAudio = tempDir.getChildFile("fixture.wav");
+    writeWavFile(fixtureAudio, generateSine(330.0, 0.5, 2.0, options.sampleRate), options.sampleRate);
+
+    BenchmarkRunner runner(options);
+    if (! options.jsonToStdout)
+        BenchmarkRunner::printHeader();
+
+    runSynthBenchmarks(runner, options, fixtureAudio);
+    runMixerBenchmarks(runner, options, tempDir);
+    runFilterBenchmarks(runner, options);
+    runKernelBenchmarks(runner, options);
+
+    tempDir.deleteRecursively();
+    if (! options.jsonToStdout)
+        printKernelSummary(runner.getResults());
+
+    if (options.traceOutput != juce::File())
+    {
+        if (! isTracingEnabled())
+            std::cerr << "Tracing not compiled in; rebuild with -DDIY_AV_ENABLE_TRACING=ON" << std::endl;
+        else if (exportChromeTrace(options.traceOutput))
+            std::cerr << "Trace written to " << options.traceOutput.getFullPathName() << std::endl;
+    }
+
+    juce::var json = resultsToJson(runner.getResults(), options);
+    if (options.jsonToStdout)
+        std::cout << juce::JSON::toString(json).toStdString() << std::endl;
+    else if (options.jsonOutput != juce::File())
+    {
+        if (! options.jsonOutput.replaceWithText(juce::JSON::toString(json)))
+        {
+            std::cerr << "Failed to write " << options.jsonOutput.getFullPathName() << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << options.jsonOutput.getFullPathName() << std::endl;
+    }
+    return 0;
+}
@@ -3,16 +3,17 @@
 
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_audio_devices/juce_audio_devices.h>
-#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <atomic>
 #include <cmath>
-#include "../synths/SynthFunctions.h"
+#include "../core/LiveVoice.h"
+#include "../core/RealtimeSafety.h"
 #include "Preferences.h"
 
 using namespace juce;
 
 namespace {
 constexpr int MAX_VOICES = 10;
-constexpr double SEGMENT_DURATION_S = 60.0;
 constexpr double MIN_DB = -60.0;
 
 inline double amplitudeToDb (double amp)
@@ -26,56 +27,107 @@ inline double dbToAmplitude (double db)
 }
 
 
-class BufferAudioSource : public AudioSource
+// Runs one LiveBinauralVoice per tester row for as long as playback lasts.
+// The UI writes each row's settings to atomics; every block the audio
+// thread hands them to the voices, which glide to the new values. A
+// disabled row is faded to silence rather than stopped, so toggling and
+// retuning are click-free.
+class OscillatorBankSource : public AudioSource
 {
 public:
-    BufferAudioSource() = default;
-
-    void setBuffer (AudioBuffer<float> newBuffer)
+    void setVoice (int index, bool enabled, double base, double beat, double amp)
     {
-        buffer = std::move (newBuffer);
-        position = 0;
+        auto& s = settings[(size_t) index];
+        s.base.store (base);
+        s.beat.store (beat);
+        s.amp.store (amp);
+        s.enabled.store (enabled);
     }
 
-    void prepareToPlay (int /*samplesPerBlockExpected*/, double /*sr*/) override
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override
     {
-        position = 0;
+        voices.clear();
+        for (auto& s : settings)
+        {
+            NamedValueSet params;
+            params.set ("baseFreq", s.base.load());
+            params.set ("beatFreq", s.beat.load());
+            params.set ("ampL", s.enabled.load() ? s.amp.load() : 0.0);
+            params.set ("ampR", s.enabled.load() ? s.amp.load() : 0.0);
+            voices.push_back (std::make_unique<LiveBinauralVoice> (sampleRate, params));
+        }
+        scratch.setSize (2, jmax (samplesPerBlockExpected, 512));
+        masterGain.reset (sampleRate, LiveVoice::smoothingSeconds);
+        masterGain.setCurrentAndTargetValue (headroomGain());
     }
 
     void releaseResources() override {}
 
     void getNextAudioBlock (const AudioSourceChannelInfo& info) override
     {
-        if (buffer.getNumSamples() == 0)
+        REALTIME_SECTION();
+        if (voices.empty())
         {
             info.clearActiveBufferRegion();
             return;
         }
 
-        int remaining = buffer.getNumSamples() - position;
-        int toCopy = jmin (remaining, info.numSamples);
-
-        for (int ch = 0; ch < info.buffer->getNumChannels(); ++ch)
-            info.buffer->copyFrom (ch, info.startSample, buffer, ch % buffer.getNumChannels(), position, toCopy);
-
-        if (toCopy < info.numSamples)
+        for (size_t i = 0; i < voices.size(); ++i)
         {
-            int left = info.numSamples - toCopy;
-            for (int ch = 0; ch < info.buffer->getNumChannels(); ++ch)
-                info.buffer->copyFrom (ch, info.startSample + toCopy, buffer, ch % buffer.getNumChannels(), 0, left);
-            position = left;
+            const auto& s = settings[i];
+            double amp = s.enabled.load() ? s.amp.load() : 0.0;
+            auto& voice = *voices[i];
+            voice.setParameter (LiveBinauralVoice::baseFreq, s.base.load());
+            voice.setParameter (LiveBinauralVoice::beatFreq, s.beat.load());
+            voice.setParameter (LiveBinauralVoice::ampL, amp);
+            voice.setParameter (LiveBinauralVoice::ampR, amp);
         }
-        else
+        masterGain.setTargetValue (headroomGain());
+
+        for (int done = 0; done < info.numSamples;)
         {
-            position += toCopy;
-            if (position >= buffer.getNumSamples())
-                position = 0; // loop
+            int n = jmin (scratch.getNumSamples(), info.numSamples - done);
+            scratch.clear (0, n);
+            for (auto& voice : voices)
+                voice->process (scratch.getWritePointer (0), scratch.getWritePointer (1), n);
+
+            float g0 = (float) masterGain.getCurrentValue();
+            float g1 = (float) masterGain.skip (n);
+            scratch.applyGainRamp (0, n, g0, g1);
+
+            for (int ch = 0; ch < info.buffer->getNumChannels(); ++ch)
+            {
+                float* dest = info.buffer->getWritePointer (ch, info.startSample + done);
+                FloatVectorOperations::copy (dest, scratch.getReadPointer (ch % 2), n);
+                FloatVectorOperations::clip (dest, dest, -1.0f, 1.0f, n);
+            }
+            done += n;
         }
     }
 
 private:
-    AudioBuffer<float> buffer;
-    int position = 0;
+    struct VoiceSettings
+    {
+        std::atomic<bool> enabled { false };
+        std::atomic<double> base { 200.0 };
+        std::atomic<double> beat { 4.0 };
+        std::atomic<double> amp { 0.5 };
+    };
+
+    // Stands in for the peak normalisation of the old rendered mix.
+    double headroomGain() const
+    {
+        double sum = 0.0;
+        for (const auto& s : settings)
+            if (s.enabled.load())
+                sum += s.amp.load();
+        return 1.0 / jmax (1.0, sum);
+    }
+
+    std::array<VoiceSettings, MAX_VOICES> settings;
+    std::vector<std::unique_ptr<LiveBinauralVoice>> voices;
+    AudioBuffer<float> scratch;
+    SmoothedValue<double> masterGain;
 };
 }
 
@@ -124,6 +176,11 @@ public:
                 vc->amp.setRange (0.0, 1.0, 0.01);
                 vc->amp.setValue (0.5);
             }
+
+            vc->enable.onClick = [this, i] { updateVoice (i); };
+            vc->base.onValueChange = [this, i] { updateVoice (i); };
+            vc->beat.onValueChange = [this, i] { updateVoice (i); };
+            vc->amp.onValueChange = [this, i] { updateVoice (i); };
         }
 
         startButton.setButtonText ("Start");
@@ -181,7 +238,7 @@ private:
     TextButton startButton, stopButton;
     AudioDeviceManager& deviceManager;
     std::unique_ptr<AudioSourcePlayer> player;
-    std::unique_ptr<BufferAudioSource> bufferSource;
+    std::unique_ptr<OscillatorBankSource> bankSource;
     Preferences prefs;
 
     void buttonClicked (Button* b) override
@@ -194,26 +251,14 @@ private:
 
     void startPlayback()
     {
-        // Ensure the device manager is using the same sample rate as the
-        // generated audio buffer. Otherwise the pitch will be scaled by the
-        // ratio between device and buffer sample rates.
-        AudioDeviceManager::AudioDeviceSetup setup;
-        deviceManager.getAudioDeviceSetup (setup);
-        if (std::abs (setup.sampleRate - prefs.sampleRate) > 1.0)
-        {
-            setup.sampleRate = prefs.sampleRate;
-            deviceManager.setAudioDeviceSetup (setup, true);
-        }
-
-        auto audio = generateAudio();
-        if (audio.getNumSamples() == 0)
-            return;
-
-        bufferSource.reset (new BufferAudioSource());
-        bufferSource->setBuffer (std::move (audio));
+        // The oscillators run at whatever rate the device is using, so the
+        // device setup is left alone.
+        bankSource.reset (new OscillatorBankSource());
+        for (int i = 0; i < voiceControls.size(); ++i)
+            updateVoice (i);
 
         player.reset (new AudioSourcePlayer());
-        player->setSource (bufferSource.get());
+        player->setSource (bankSource.get());
 
         deviceManager.addAudioCallback (player.get());
 
@@ -226,64 +271,23 @@ private:
         if (player)
             deviceManager.removeAudioCallback (player.get());
         player.reset();
-        bufferSource.reset();
+        bankSource.reset();
         startButton.setEnabled (true);
         stopButton.setEnabled (false);
     }
 
-    AudioBuffer<float> generateAudio()
+    void updateVoice (int index)
     {
-        int sampleRate = prefs.sampleRate;
-        int totalSamples = static_cast<int> (SEGMENT_DURATION_S * sampleRate);
-        AudioBuffer<float> mix (2, totalSamples);
-        mix.clear();
-
-        bool anyEnabled = false;
-
-        for (auto* vc : voiceControls)
-        {
-            if (vc->enable.getToggleState())
-            {
-                anyEnabled = true;
-                double base = vc->base.getValue();
-                double beat = vc->beat.getValue();
-                double amp = vc->amp.getValue();
-
-                if (prefs.amplitudeDisplayMode == "dB")
-                    amp = dbToAmplitude (amp);
-
-                NamedValueSet params;
-                params.set ("ampL", amp);
-                params.set ("ampR", amp);
-                params.set ("baseFreq", base);
-                params.set ("beatFreq", beat);
-
-                auto voiceBuf = binauralBeat (SEGMENT_DURATION_S, (double) sampleRate, params);
-                if (voiceBuf.getNumSamples() < totalSamples)
-                {
-                    AudioBuffer<float> padded (2, totalSamples);
-                    padded.clear();
-                    padded.copyFrom (0, 0, voiceBuf, 0, 0, voiceBuf.getNumSamples());
-                    padded.copyFrom (1, 0, voiceBuf, 1, 0, voiceBuf.getNumSamples());
-                    voiceBuf = std::move (padded);
-                }
-
-                for (int ch = 0; ch < 2; ++ch)
-                    mix.addFrom (ch, 0, voiceBuf, ch, 0, totalSamples);
-            }
-        }
-
-        if (! anyEnabled)
-            return {};
-
-        float peak = 0.0f;
-        for (int ch = 0; ch < 2; ++ch)
-            peak = jmax (peak, mix.getMagnitude (ch, 0, mix.getNumSamples()));
+        if (bankSource == nullptr)
+            return;
 
-        if (peak > 1.0f)
-            mix.applyGain (1.0f / peak);
+        auto* vc = voiceControls[index];
+        double amp = vc->amp.getValue();
+        if (prefs.amplitudeDisplayMode == "dB")
+            amp = dbToAmplitude (amp);
 
-        return mix;
+        bankSource->setVoice (index, vc->enable.getToggleState(),
+                              vc->base.getValue(), vc->beat.getValue(), amp);
     }
 };
 
@@ -2,6 +2,7 @@
 #include "GlobalSettingsComponent.h"
 #include "NoiseGeneratorDialog.h" // Include the full dialog implementation here
 #include "FrequencyTesterDialog.h"
+#include "../core/RenderQuality.h"
 
 using namespace juce;
 
@@ -44,6 +45,14 @@ GlobalSettingsComponent::GlobalSettingsComponent(juce::AudioDeviceManager& dm)
   addAndMakeVisible(&noiseAmpEdit);
   noiseAmpEdit.setText("0.0");
 
+  addAndMakeVisible(&qualityLabel);
+  qualityLabel.setText("Render Quality:", dontSendNotification);
+  addAndMakeVisible(&qualityBox);
+  qualityBox.addItem("Draft", 1);
+  qualityBox.addItem("Normal", 2);
+  qualityBox.addItem("Master", 3);
+  qualityBox.setSelectedId(2, dontSendNotification);
+
   addAndMakeVisible(&noiseGenButton);
   noiseGenButton.setButtonText("Generate Noise Preset...");
   noiseGenButton.addListener(this);
@@ -67,6 +76,7 @@ GlobalSettingsComponent::Settings GlobalSettingsComponent::getSettings() const {
   s.outputFile = outFileEdit.getText();
   s.noiseFile = noiseFileEdit.getText();
   s.noiseAmp = noiseAmpEdit.getText().getDoubleValue();
+  s.renderQuality = qualityBox.getText().toLowerCase();
   return s;
 }
 
@@ -76,6 +86,9 @@ void GlobalSettingsComponent::setSettings(const Settings &s) {
   outFileEdit.setText(s.outputFile);
   noiseFileEdit.setText(s.noiseFile);
   noiseAmpEdit.setText(String(s.noiseAmp));
+  qualityBox.setSelectedId(
+      static_cast<int>(parseRenderQuality(s.renderQuality)) + 1,
+      dontSendNotification);
 }
 
 void GlobalSettingsComponent::resized() {
@@ -115,6 +128,12 @@ void GlobalSettingsComponent::resized() {
   noiseAmpLabel.setBounds(row5.removeFromLeft(labelW));
   noiseAmpEdit.setBounds(row5);
 
+  area.removeFromTop(gap);
+
+  auto row6 = area.removeFromTop(rowH);
+  qualityLabel.setBounds(row6.removeFromLeft(labelW));
+  qualityBox.setBounds(row6);
+
   noiseGenButton.setBounds(area.removeFromTop(rowH));
   freqTestButton.setBounds(area.removeFromTop(rowH));
 }
@@ -17,6 +17,7 @@ public:
     juce::String outputFile;
     juce::String noiseFile;
     double noiseAmp = 0.0;
+    juce::String renderQuality = "normal";
   };
 
   explicit GlobalSettingsComponent(juce::AudioDeviceManager& dm);
@@ -34,8 +35,10 @@ private:
 
   juce::AudioDeviceManager& deviceManager;
 
-  juce::Label srLabel, cfLabel, outFileLabel, noiseFileLabel, noiseAmpLabel;
+  juce::Label srLabel, cfLabel, outFileLabel, noiseFileLabel, noiseAmpLabel,
+      qualityLabel;
   juce::TextEditor srEdit, cfEdit, outFileEdit, noiseFileEdit, noiseAmpEdit;
+  juce::ComboBox qualityBox;
   juce::TextButton browseOutButton, browseNoiseButton, noiseGenButton,
       freqTestButton;
 
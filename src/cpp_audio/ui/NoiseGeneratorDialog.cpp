@@ -1,5 +1,5 @@
 #include "NoiseGeneratorDialog.h"
-#include "../synths/SynthFunctions.h"
+#include "../synths/NoiseFlanger.h"
 #include <nlohmann/json.hpp>
 
 using namespace juce;
@@ -90,7 +90,7 @@ static bool loadNoiseParams(const File &file, NoiseParams &p) {
   return true;
 }
 
-static AudioBuffer<float> generateNoiseBuffer(const NoiseParams &p) {
+static SweptNotchProcessor::Settings makeNoiseSettings(const NoiseParams &p) {
   NamedValueSet params;
   params.set("noise_type", p.noiseType);
   params.set("lfo_waveform", p.lfoWaveform);
@@ -140,8 +140,7 @@ static AudioBuffer<float> generateNoiseBuffer(const NoiseParams &p) {
                startCasc.size() > 1 ? var(startCasc) : startCasc[0]);
     params.set("end_cascade_count",
                endCasc.size() > 1 ? var(endCasc) : endCasc[0]);
-    return generateSweptNotchPinkSoundTransition(p.durationSeconds,
-                                                 p.sampleRate, params);
+    return SweptNotchProcessor::Settings::fromParams(params, true);
   } else {
     params.set("lfo_freq", p.lfoFreq);
     params.set("filter_sweeps", sweeps);
@@ -150,12 +149,69 @@ static AudioBuffer<float> generateNoiseBuffer(const NoiseParams &p) {
                startCasc.size() > 1 ? var(startCasc) : startCasc[0]);
     params.set("lfo_phase_offset_deg", p.startLfoPhaseOffsetDeg);
     params.set("intra_phase_offset_deg", p.startIntraPhaseOffsetDeg);
-    return generateSweptNotchPinkSound(p.durationSeconds, p.sampleRate, params);
+    return SweptNotchProcessor::Settings::fromParams(params, false);
   }
 }
 
 } // namespace
 
+//==============================================================================
+// RenderJob: renders either straight to a WAV file or into a buffer for the
+// Test button, reporting progress and stopping when cancelled.
+//==============================================================================
+class NoiseGeneratorDialog::RenderJob : public ThreadWithProgressWindow {
+public:
+  RenderJob(NoiseGeneratorDialog &ownerIn, const NoiseParams &p, File out)
+      : ThreadWithProgressWindow(out == File() ? "Rendering test noise..."
+                                               : "Generating noise...",
+                                 true, true),
+        owner(ownerIn), settings(makeNoiseSettings(p)),
+        duration(p.durationSeconds), sampleRate(p.sampleRate),
+        outputFile(std::move(out)) {}
+
+  void run() override {
+    auto progress = [this](double fraction) {
+      setProgress(fraction);
+      return !threadShouldExit();
+    };
+
+    if (outputFile == File()) {
+      buffer = renderSweptNotchBuffer(settings, duration, sampleRate, progress);
+      succeeded = buffer.getNumSamples() > 0;
+      return;
+    }
+
+    // FileOutputStream appends, so start from an empty file.
+    outputFile.deleteFile();
+    WavAudioFormat format;
+    std::unique_ptr<AudioFormatWriter> writer(format.createWriterFor(
+        outputFile.createOutputStream().release(), sampleRate, 2, 16, {}, 0));
+    if (writer == nullptr)
+      return;
+    succeeded = renderSweptNotchToWriter(settings, duration, sampleRate,
+                                         *writer, progress);
+    writer.reset();
+    if (!succeeded)
+      outputFile.deleteFile();
+  }
+
+  void threadComplete(bool userPressedCancel) override {
+    cancelled = userPressedCancel;
+    owner.renderFinished(*this);
+  }
+
+  bool isTest() const { return outputFile == File(); }
+
+  NoiseGeneratorDialog &owner;
+  SweptNotchProcessor::Settings settings;
+  double duration;
+  double sampleRate;
+  File outputFile;
+  AudioBuffer<float> buffer;
+  bool succeeded = false;
+  bool cancelled = false;
+};
+
 //==============================================================================
 // NoiseGeneratorDialog Implementation
 //==============================================================================
@@ -269,10 +325,17 @@ NoiseGeneratorDialog::NoiseGeneratorDialog() {
 
   setSize(600, 700);
   deviceManager.initialise(0, 2, nullptr, true);
+  player.setSource(&transport);
+  deviceManager.addAudioCallback(&player);
 }
 
 NoiseGeneratorDialog::~NoiseGeneratorDialog() {
+  if (renderJob != nullptr)
+    renderJob->stopThread(10000);
   transport.stop();
+  deviceManager.removeAudioCallback(&player);
+  player.setSource(nullptr);
+  transport.setSource(nullptr);
   deviceManager.closeAudioDevice();
 }
 
@@ -440,36 +503,61 @@ void NoiseGeneratorDialog::buttonClicked(Button *b) {
     if (fc.browseForFileToSave(true))
       saveNoiseParams(getParams(), fc.getResult());
   } else if (b == &generateButton) {
-    auto p = getParams();
-    auto buffer = generateNoiseBuffer(p);
-    File out(fileEdit.getText());
-    WavAudioFormat format;
-    std::unique_ptr<AudioFormatWriter> writer(format.createWriterFor(
-        out.createOutputStream().release(), p.sampleRate, 2, 16, {}, 0));
-    if (writer != nullptr)
-      writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+    NoiseParams p = getParams();
+    // With an input recording the whole file is processed.
+    if (p.inputAudioPath.isNotEmpty()) {
+      File input =
+          File::getCurrentWorkingDirectory().getChildFile(p.inputAudioPath);
+      if (!input.existsAsFile()) {
+        AlertWindow::showMessageBoxAsync(AlertWindow::WarningIcon,
+                                         "Noise Generator",
+                                         "Could not find the input " +
+                                             input.getFullPathName());
+        return;
+      }
+      p.inputAudioPath = input.getFullPathName();
+      p.durationSeconds = 0.0;
+    }
+    startRender(std::make_unique<RenderJob>(*this, p, File(fileEdit.getText())));
   } else if (b == &testButton) {
     NoiseParams p = getParams();
     p.durationSeconds = 30.0;
-    auto buffer = generateNoiseBuffer(p);
-    MemoryOutputStream mem;
-    WavAudioFormat wav;
-    std::unique_ptr<AudioFormatWriter> writer(
-        wav.createWriterFor(&mem, p.sampleRate, 2, 16, {}, 0));
-    if (writer) {
-      writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
-    }
-    auto stream = std::make_unique<MemoryInputStream>(mem.getData(),
-                                                      mem.getDataSize(), false);
-    AudioFormatManager formatManager;
-    formatManager.registerBasicFormats();
-    std::unique_ptr<AudioFormatReader> reader(
-        formatManager.createReaderFor(std::move(stream)));
-    if (reader != nullptr) {
-      readerSource.reset(new AudioFormatReaderSource(reader.release(), true));
-      transport.setSource(readerSource.get(), 0, nullptr, p.sampleRate);
-      transport.start();
-    }
+    startRender(std::make_unique<RenderJob>(*this, p, File()));
+  }
+}
+
+void NoiseGeneratorDialog::startRender(std::unique_ptr<RenderJob> job) {
+  if (renderJob != nullptr && renderJob->isThreadRunning())
+    return;
+  generateButton.setEnabled(false);
+  testButton.setEnabled(false);
+  renderJob = std::move(job);
+  renderJob->launchThread();
+}
+
+void NoiseGeneratorDialog::renderFinished(RenderJob &job) {
+  generateButton.setEnabled(true);
+  testButton.setEnabled(true);
+  if (job.cancelled)
+    return;
+
+  if (!job.succeeded) {
+    AlertWindow::showMessageBoxAsync(
+        AlertWindow::WarningIcon, "Noise Generator",
+        job.isTest() ? String("Rendering the test noise failed.")
+                     : "Could not read the input or write " +
+                           job.outputFile.getFullPathName());
+    return;
+  }
+
+  if (job.isTest()) {
+    // Play the rendered buffer directly; no WAV round trip.
+    transport.stop();
+    transport.setSource(nullptr);
+    testSource = std::make_unique<BufferAudioSource>();
+    testSource->setBuffer(std::move(job.buffer));
+    transport.setSource(testSource.get(), 0, nullptr, job.sampleRate);
+    transport.start();
   }
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../core/BufferAudioSource.h"
 #include "../models/NoiseParams.h" // Assuming NoiseParams is separated or defined here
 #include <juce_audio_utils/juce_audio_utils.h>
 #include <juce_gui_extra/juce_gui_extra.h>
@@ -74,10 +75,17 @@ private:
   juce::TextButton loadButton{"Load"}, saveButton{"Save"}, testButton{"Test"},
       generateButton{"Generate"};
 
+  // Renders on a background thread behind a cancellable progress window.
+  class RenderJob;
+  void startRender(std::unique_ptr<RenderJob> job);
+  void renderFinished(RenderJob &job);
+  std::unique_ptr<RenderJob> renderJob;
+
   // Audio members
   juce::AudioDeviceManager deviceManager;
+  juce::AudioSourcePlayer player;
   juce::AudioTransportSource transport;
-  std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
+  std::unique_ptr<BufferAudioSource> testSource;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NoiseGeneratorDialog)
 };
@@ -125,7 +125,11 @@ public:
         addAndMakeVisible (&crossfadeCurveCombo);
         crossfadeCurveCombo.addItem ("linear", 1);
         crossfadeCurveCombo.addItem ("equal_power", 2);
-        crossfadeCurveCombo.setSelectedId (prefs.crossfadeCurve == "equal_power" ? 2 : 1);
+        crossfadeCurveCombo.addItem ("s_curve", 3);
+        crossfadeCurveCombo.addItem ("constant_power", 4);
+        crossfadeCurveCombo.setSelectedId (prefs.crossfadeCurve == "equal_power" ? 2
+                                           : prefs.crossfadeCurve == "s_curve" ? 3
+                                           : prefs.crossfadeCurve == "constant_power" ? 4 : 1);
 
         trackMetadataToggle.setButtonText ("Include track export metadata");
         trackMetadataToggle.setToggleState (prefs.trackMetadata, dontSendNotification);
@@ -118,7 +118,15 @@ void StepConfigPanel::addVoice()
         if (onVoicesChanged)
             onVoicesChanged();
     };
-    editor->onCancel = [this]() { editor.reset(); resized(); };
+    editor->onCancel = [this]()
+    {
+        editor.reset();
+        resized();
+        // Live edits already reached the preview; resend the saved voices
+        // so it goes back to them.
+        if (onVoicesChanged)
+            onVoicesChanged();
+    };
     resized();
 }
 
@@ -182,7 +190,20 @@ void StepConfigPanel::editVoice()
         if (onVoicesChanged)
             onVoicesChanged();
     };
-    editor->onCancel = [this]() { editor.reset(); resized(); };
+    editor->onCancel = [this]()
+    {
+        editor.reset();
+        resized();
+        // Live edits already reached the preview; resend the saved voices
+        // so it goes back to them.
+        if (onVoicesChanged)
+            onVoicesChanged();
+    };
+    editor->onParameterEdited = [this, row](const juce::String& name, double value)
+    {
+        if (onVoiceParameterEdited)
+            onVoiceParameterEdited(row, name, value);
+    };
     resized();
 }
 
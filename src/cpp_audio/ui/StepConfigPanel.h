@@ -19,6 +19,8 @@ public:
     juce::Array<VoiceEditorComponent::VoiceData> getVoices() const;
 
     std::function<void()> onVoicesChanged;
+    /** Forwarded from the voice editor while an existing voice is edited. */
+    std::function<void(int voiceIndex, const juce::String& name, double value)> onVoiceParameterEdited;
 
 private:
     juce::ListBox voiceList;
@@ -153,6 +153,7 @@ void StepListPanel::loadExternalSteps() {
                   vd.params = vobj->getProperty("params");
                   vd.volumeEnvelope = vobj->getProperty("volume_envelope");
                   vd.description = vobj->getProperty("description").toString();
+                  vd.voiceId = vobj->getProperty("voice_id").toString();
                   sd.voices.add(std::move(vd));
                 }
               }
@@ -345,6 +346,7 @@ void StepListPanel::setSteps(const std::vector<Step> &newSteps) {
       vd.isTransition = v.isTransition;
       vd.params = namedValueSetToVar(v.params);
       vd.description = v.description;
+      vd.voiceId = v.voiceId;
       sd.voices.add(std::move(vd));
     }
     steps.add(std::move(sd));
@@ -369,6 +371,7 @@ std::vector<Step> StepListPanel::toTrackSteps() const {
       v.isTransition = vd.isTransition;
       v.description = vd.description;
       v.params = varToNamedValueSet(vd.params);
+      v.voiceId = vd.voiceId;
       s.voices.push_back(std::move(v));
     }
     out.push_back(std::move(s));
@@ -15,6 +15,12 @@ StepPreviewComponent::StepPreviewComponent(juce::AudioDeviceManager& dm)
     addAndMakeVisible(&resetButton);
     resetButton.addListener(this);
 
+    addAndMakeVisible(&liveToggle);
+    liveToggle.addListener(this);
+
+    addAndMakeVisible(&draftToggle);
+    draftToggle.addListener(this);
+
     addAndMakeVisible(&positionSlider);
     positionSlider.setSliderStyle(juce::Slider::LinearHorizontal);
     positionSlider.addListener(this);
@@ -29,6 +35,18 @@ StepPreviewComponent::StepPreviewComponent(juce::AudioDeviceManager& dm)
 
 void StepPreviewComponent::loadStep(const Step& step, const GlobalSettings& settings, double previewDuration)
 {
+    loadedStep = step;
+    loadedSettings = settings;
+    loadedDuration = previewDuration;
+
+    if (stepReady && previewer.updateStep(step, previewDuration))
+    {
+        loadedStepName = step.description;
+        stepLabel.setText((previewer.isPlaying() ? "Live: " : "Ready: ") + loadedStepName,
+                          juce::dontSendNotification);
+        return;
+    }
+
     previewer.stop();
     playPauseButton.setButtonText("Play");
     previewer.loadStep(step, settings, previewDuration);
@@ -43,6 +61,11 @@ void StepPreviewComponent::loadStep(const Step& step, const GlobalSettings& sett
     startTimerHz(30);
 }
 
+bool StepPreviewComponent::updateVoiceParameter(int voiceIndex, const juce::String& name, double value)
+{
+    return previewer.updateVoiceParameter(voiceIndex, name, value);
+}
+
 void StepPreviewComponent::resized()
 {
     auto area = getLocalBounds().reduced(4);
@@ -50,6 +73,8 @@ void StepPreviewComponent::resized()
     playPauseButton.setBounds(top.removeFromLeft(60));
     stopButton.setBounds(top.removeFromLeft(60));
     resetButton.setBounds(top.removeFromLeft(60));
+    liveToggle.setBounds(top.removeFromRight(90));
+    draftToggle.setBounds(top.removeFromRight(70));
     top.removeFromLeft(4);
     stepLabel.setBounds(top);
 
@@ -88,6 +113,17 @@ void StepPreviewComponent::buttonClicked(juce::Button* b)
     {
         reset();
     }
+    else if (b == &liveToggle || b == &draftToggle)
+    {
+        previewer.setLiveEditing(liveToggle.getToggleState());
+        previewer.setRenderQuality(draftToggle.getToggleState() ? RenderQuality::draft
+                                                                : RenderQuality::normal);
+        if (! loadedStep.voices.empty())
+        {
+            stepReady = false;
+            loadStep(loadedStep, loadedSettings, loadedDuration);
+        }
+    }
 }
 
 void StepPreviewComponent::sliderValueChanged(juce::Slider* s)
@@ -144,6 +180,7 @@ void StepPreviewComponent::reset()
 {
     previewer.stop();
     loadedStepName.clear();
+    loadedStep = {};
     stepReady = false;
     playPauseButton.setButtonText("Play");
     playPauseButton.setEnabled(false);
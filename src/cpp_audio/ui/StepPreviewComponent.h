@@ -10,7 +10,11 @@ class StepPreviewComponent : public juce::Component,
 public:
     explicit StepPreviewComponent(juce::AudioDeviceManager& dm);
 
+    /** Loads @p step, or in live-edit mode moves the running preview to it
+        if only live parameters differ. */
     void loadStep(const Step& step, const GlobalSettings& settings, double previewDuration);
+    /** Forwards an edit to the live preview; false if it needs a reload. */
+    bool updateVoiceParameter(int voiceIndex, const juce::String& name, double value);
     void reset();
     void resized() override;
 
@@ -25,10 +29,15 @@ private:
     juce::TextButton playPauseButton {"Play"};
     juce::TextButton stopButton {"Stop"};
     juce::TextButton resetButton {"Reset"};
+    juce::ToggleButton liveToggle {"Live edit"};
+    juce::ToggleButton draftToggle {"Draft"};
     juce::Slider positionSlider;
     juce::Label timeLabel;
     juce::Label stepLabel;
     juce::String loadedStepName;
+    Step loadedStep;
+    GlobalSettings loadedSettings;
+    double loadedDuration { 0.0 };
     bool stepReady { false };
 };
 
@@ -28,10 +28,10 @@ static std::map<juce::String, juce::StringArray> synthParamNames{
         "startGlitchFocusExp","endGlitchFocusExp","initial_offset","post_offset",
         "transition_curve"}},
     {"isochronic_tone", juce::StringArray{
-        "amp","baseFreq","beatFreq","rampPercent","gapPercent","pan"}},
+        "amp","baseFreq","beatFreq","rampPercent","gapPercent","pan","rampShape"}},
     {"isochronic_tone_transition", juce::StringArray{
         "amp","startBaseFreq","endBaseFreq","startBeatFreq","endBeatFreq",
-        "rampPercent","gapPercent","pan","initial_offset","post_offset",
+        "rampPercent","gapPercent","pan","rampShape","initial_offset","post_offset",
         "transition_curve"}},
     {"monaural_beat_stereo_amps", juce::StringArray{
         "amp_lower_L","amp_upper_L","amp_lower_R","amp_upper_R","baseFreq","beatFreq",
@@ -114,6 +114,7 @@ VoiceEditorComponent::ParameterRow::ParameterRow(const String& name, const Strin
     nameLabel.setText(name, dontSendNotification);
     addAndMakeVisible(&valueEditor);
     valueEditor.setText(value);
+    valueEditor.onTextChange = [this] { if (onValueChange) onValueChange(); };
 }
 
 void VoiceEditorComponent::ParameterRow::resized()
@@ -311,6 +312,7 @@ void VoiceEditorComponent::rebuildParamUI(const var& paramsVar)
         for (const auto& p : obj->getProperties())
         {
             auto* row = new ParameterRow(p.name.toString(), p.value.toString());
+            row->onValueChange = [this, row] { parameterEdited(*row); };
             paramRows.add(row);
             paramsContainer.addAndMakeVisible(row);
         }
@@ -330,12 +332,22 @@ void VoiceEditorComponent::rebuildParamUIWithNames(const var& paramsVar,
     {
         String val = obj ? obj->getProperty(name).toString() : String();
         auto* row = new ParameterRow(name, val);
+        row->onValueChange = [this, row] { parameterEdited(*row); };
         paramRows.add(row);
         paramsContainer.addAndMakeVisible(row);
     }
     layoutParamRows();
 }
 
+void VoiceEditorComponent::parameterEdited(const ParameterRow& row)
+{
+    auto text = row.getValue().trim();
+    if (onParameterEdited == nullptr || text.isEmpty()
+        || ! text.containsOnly("0123456789.-+eE"))
+        return;
+    onParameterEdited(row.getName(), text.getDoubleValue());
+}
+
 void VoiceEditorComponent::layoutParamRows()
 {
     int y = 0;
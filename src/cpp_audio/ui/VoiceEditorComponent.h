@@ -15,6 +15,7 @@ public:
         juce::var params;
         juce::var volumeEnvelope;
         juce::String description;
+        juce::String voiceId;
     };
 
     VoiceEditorComponent(const juce::StringArray& synthNames,
@@ -27,6 +28,9 @@ public:
 
     std::function<void(const VoiceData&)> onSave;
     std::function<void()> onCancel;
+    /** Called as a numeric parameter is typed, before the voice is saved,
+        so a live preview can follow the edit. */
+    std::function<void(const juce::String& name, double value)> onParameterEdited;
 
 private:
     class ParameterRow : public juce::Component
@@ -37,6 +41,7 @@ private:
         juce::String getName() const;
         juce::String getValue() const;
         void setValue(const juce::String& v);
+        std::function<void()> onValueChange;
     private:
         juce::Label nameLabel;
         juce::TextEditor valueEditor;
@@ -49,6 +54,7 @@ private:
     void rebuildParamUIWithNames(const juce::var& paramsVar,
                                  const juce::StringArray& names);
     void layoutParamRows();
+    void parameterEdited(const ParameterRow& row);
     juce::var collectParamsVar();
     void rebuildEnvelopeUI(const juce::var& envVar = juce::var());
     void layoutEnvRows();
@@ -28,10 +28,10 @@ static std::map<juce::String, juce::StringArray> synthParamNames{
         "startGlitchFocusExp","endGlitchFocusExp","initial_offset","post_offset",
         "transition_curve"}},
     {"isochronic_tone", juce::StringArray{
-        "amp","baseFreq","beatFreq","rampPercent","gapPercent","pan"}},
+        "amp","baseFreq","beatFreq","rampPercent","gapPercent","pan","rampShape"}},
     {"isochronic_tone_transition", juce::StringArray{
         "amp","startBaseFreq","endBaseFreq","startBeatFreq","endBeatFreq",
-        "rampPercent","gapPercent","pan","initial_offset","post_offset",
+        "rampPercent","gapPercent","pan","rampShape","initial_offset","post_offset",
         "transition_curve"}},
     {"monaural_beat_stereo_amps", juce::StringArray{
         "amp_lower_L","amp_upper_L","amp_lower_R","amp_upper_R","baseFreq","beatFreq",